@@ -0,0 +1,141 @@
+/*
+ * AllocationCounter.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_ALLOCATIONCOUNTER_HPP
+#define GLOWL_ALLOCATIONCOUNTER_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "Exceptions.hpp"
+
+namespace glowl
+{
+    namespace debug
+    {
+
+        /**
+         * \brief Number of heap allocations made by the calling thread since program start.
+         *
+         * Only counts if exactly one translation unit of the program (e.g. the test executable) contains
+         * GLOWL_DEFINE_ALLOCATION_COUNTER, which replaces the global operator new. Counting per thread keeps
+         * allocations of unrelated worker threads out of the measurement.
+         */
+        inline std::uint64_t& allocationCount()
+        {
+            static thread_local std::uint64_t count = 0;
+            return count;
+        }
+
+        inline bool& allocationCounterInstalled()
+        {
+            static bool installed = false;
+            return installed;
+        }
+
+        /**
+         * \brief Returns the number of heap allocations made on the calling thread while running the given callable.
+         */
+        template<typename Callable>
+        inline std::uint64_t countAllocations(Callable&& callable)
+        {
+            std::uint64_t start = allocationCount();
+            callable();
+            return allocationCount() - start;
+        }
+
+        /**
+         * \brief Runs the given callable and throws an AllocationException if it allocated on the heap.
+         * Used to guard designated hot-path calls in tests. Throws as well if the counter is not installed,
+         * since such a check would pass silently.
+         *
+         * \param label Name of the checked call used in the exception message
+         */
+        template<typename Callable>
+        inline void expectNoAllocation(std::string const& label, Callable&& callable)
+        {
+            if (!allocationCounterInstalled())
+            {
+                throw AllocationException("glowl::debug::expectNoAllocation - " + label +
+                                          " - GLOWL_DEFINE_ALLOCATION_COUNTER missing in program");
+            }
+
+            std::uint64_t allocations = countAllocations(callable);
+            if (allocations != 0)
+            {
+                throw AllocationException("glowl::debug::expectNoAllocation - " + label + " - " +
+                                          std::to_string(allocations) + " heap allocation(s)");
+            }
+        }
+
+        // not inlined into the replaced operators, otherwise GCC pairs the malloc/free calls with new/delete
+        // expressions and reports them as mismatched
+#if defined(__GNUC__)
+#define GLOWL_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define GLOWL_NOINLINE __declspec(noinline)
+#else
+#define GLOWL_NOINLINE
+#endif
+
+        GLOWL_NOINLINE inline void* countedAllocate(std::size_t size)
+        {
+            ++allocationCount();
+            void* ptr = std::malloc(size != 0 ? size : 1);
+            if (ptr == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            return ptr;
+        }
+
+        GLOWL_NOINLINE inline void countedFree(void* ptr) noexcept
+        {
+            std::free(ptr);
+        }
+
+    } // namespace debug
+} // namespace glowl
+
+/**
+ * Replaces the global operator new/delete with counting versions. Put this into exactly one source file
+ * at global scope, e.g. next to the main function of a test executable.
+ */
+#define GLOWL_DEFINE_ALLOCATION_COUNTER                                                                                \
+    void* operator new(std::size_t size)                                                                               \
+    {                                                                                                                  \
+        return ::glowl::debug::countedAllocate(size);                                                                  \
+    }                                                                                                                  \
+    void* operator new[](std::size_t size)                                                                             \
+    {                                                                                                                  \
+        return ::glowl::debug::countedAllocate(size);                                                                  \
+    }                                                                                                                  \
+    void operator delete(void* ptr) noexcept                                                                           \
+    {                                                                                                                  \
+        ::glowl::debug::countedFree(ptr);                                                                              \
+    }                                                                                                                  \
+    void operator delete[](void* ptr) noexcept                                                                         \
+    {                                                                                                                  \
+        ::glowl::debug::countedFree(ptr);                                                                              \
+    }                                                                                                                  \
+    void operator delete(void* ptr, std::size_t) noexcept                                                              \
+    {                                                                                                                  \
+        ::glowl::debug::countedFree(ptr);                                                                              \
+    }                                                                                                                  \
+    void operator delete[](void* ptr, std::size_t) noexcept                                                            \
+    {                                                                                                                  \
+        ::glowl::debug::countedFree(ptr);                                                                              \
+    }                                                                                                                  \
+    static bool const glowl_allocation_counter_installed = (::glowl::debug::allocationCounterInstalled() = true)
+
+/**
+ * Throws glowl::AllocationException if the given statement allocates on the heap.
+ */
+#define GLOWL_EXPECT_NO_ALLOCATION(...) ::glowl::debug::expectNoAllocation(#__VA_ARGS__, [&]() { __VA_ARGS__; })
+
+#endif // GLOWL_ALLOCATIONCOUNTER_HPP
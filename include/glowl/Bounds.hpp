@@ -0,0 +1,162 @@
+/*
+ * Bounds.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_BOUNDS_HPP
+#define GLOWL_BOUNDS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLOWL_BOUNDS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace glowl
+{
+
+    /**
+     * \struct Bounds
+     *
+     * \brief Axis-aligned bounding box and bounding sphere of a point set.
+     *
+     * The sphere is centered at the center of the box, its radius is the largest distance of a point to the center.
+     * Empty bounds have min > max and radius 0.
+     */
+    struct Bounds
+    {
+        float min[3] = {std::numeric_limits<float>::max(),
+                        std::numeric_limits<float>::max(),
+                        std::numeric_limits<float>::max()};
+        float max[3] = {std::numeric_limits<float>::lowest(),
+                        std::numeric_limits<float>::lowest(),
+                        std::numeric_limits<float>::lowest()};
+        float center[3] = {0.0f, 0.0f, 0.0f};
+        float radius = 0.0f;
+
+        bool isEmpty() const
+        {
+            return min[0] > max[0];
+        }
+    };
+
+    /**
+     * \brief Computes the bounds of float positions stored in a (possibly interleaved) vertex stream.
+     *
+     * \param data Vertex data, containing byte_size / stride vertices
+     * \param stride Byte distance between two vertices
+     * \param offset Byte offset of the position within a vertex
+     * \param components Number of float components of a position, 2 to 4 (missing z is 0, w is ignored)
+     */
+    inline Bounds computeBounds(void const* data, size_t byte_size, size_t stride, size_t offset, int components)
+    {
+        Bounds bounds;
+
+        if (data == nullptr || stride == 0 || components < 2)
+        {
+            return bounds;
+        }
+
+        auto const*  base = static_cast<unsigned char const*>(data) + offset;
+        size_t const vertex_cnt = byte_size >= offset + components * sizeof(float) ? byte_size / stride : 0;
+
+        auto load = [base, stride, components](size_t i, float* position) {
+            std::memcpy(position, base + i * stride, std::min(components, 3) * sizeof(float));
+            if (components == 2)
+            {
+                position[2] = 0.0f;
+            }
+        };
+
+        size_t first_scalar = 0;
+
+#ifdef GLOWL_BOUNDS_SSE2
+        // 16 byte loads are used for all vertices where they stay within the data, lane 3 is ignored
+        size_t const simd_cnt =
+            byte_size >= offset + 16 ? std::min(vertex_cnt, (byte_size - offset - 16) / stride + 1) : 0;
+        __m128 const z_mask = _mm_castsi128_ps(_mm_set_epi32(0, components == 2 ? 0 : -1, -1, -1));
+
+        __m128 min_v = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128 max_v = _mm_set1_ps(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < simd_cnt; ++i)
+        {
+            __m128 p = _mm_and_ps(_mm_loadu_ps(reinterpret_cast<float const*>(base + i * stride)), z_mask);
+            min_v = _mm_min_ps(min_v, p);
+            max_v = _mm_max_ps(max_v, p);
+        }
+
+        float simd_min[4];
+        float simd_max[4];
+        _mm_storeu_ps(simd_min, min_v);
+        _mm_storeu_ps(simd_max, max_v);
+        std::copy(simd_min, simd_min + 3, bounds.min);
+        std::copy(simd_max, simd_max + 3, bounds.max);
+
+        first_scalar = simd_cnt;
+#endif
+
+        for (size_t i = first_scalar; i < vertex_cnt; ++i)
+        {
+            float p[3];
+            load(i, p);
+            for (int k = 0; k < 3; ++k)
+            {
+                bounds.min[k] = std::min(bounds.min[k], p[k]);
+                bounds.max[k] = std::max(bounds.max[k], p[k]);
+            }
+        }
+
+        if (bounds.isEmpty())
+        {
+            return bounds;
+        }
+
+        for (int k = 0; k < 3; ++k)
+        {
+            bounds.center[k] = 0.5f * (bounds.min[k] + bounds.max[k]);
+        }
+
+        float max_sq_dist = 0.0f;
+
+#ifdef GLOWL_BOUNDS_SSE2
+        __m128 const center_v = _mm_setr_ps(bounds.center[0], bounds.center[1], bounds.center[2], 0.0f);
+        __m128 const xyz_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+
+        __m128 max_sq_dist_v = _mm_setzero_ps();
+        for (size_t i = 0; i < simd_cnt; ++i)
+        {
+            __m128 p = _mm_and_ps(_mm_loadu_ps(reinterpret_cast<float const*>(base + i * stride)), z_mask);
+            __m128 d = _mm_and_ps(_mm_sub_ps(p, center_v), xyz_mask);
+            __m128 sq = _mm_mul_ps(d, d);
+            // x + y + z in lane 0
+            sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+            sq = _mm_add_ss(sq, _mm_movehl_ps(sq, sq));
+            max_sq_dist_v = _mm_max_ss(max_sq_dist_v, sq);
+        }
+        max_sq_dist = _mm_cvtss_f32(max_sq_dist_v);
+#endif
+
+        for (size_t i = first_scalar; i < vertex_cnt; ++i)
+        {
+            float p[3];
+            load(i, p);
+            float dx = p[0] - bounds.center[0];
+            float dy = p[1] - bounds.center[1];
+            float dz = p[2] - bounds.center[2];
+            max_sq_dist = std::max(max_sq_dist, dx * dx + dy * dy + dz * dz);
+        }
+
+        bounds.radius = std::sqrt(max_sq_dist);
+
+        return bounds;
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_BOUNDS_HPP
@@ -8,7 +8,11 @@
 #ifndef GLOWL_BUFFEROBJECT_HPP
 #define GLOWL_BUFFEROBJECT_HPP
 
+#include <vector>
+
 #include "Exceptions.hpp"
+#include "NamePool.hpp"
+#include "Trace.hpp"
 #include "glinclude.h"
 
 namespace glowl
@@ -24,6 +28,12 @@ namespace glowl
     class BufferObject
     {
     public:
+        enum class StorageMode
+        {
+            Mutable, ///< Regular buffer storage created with glNamedBufferData
+            Sparse   ///< Virtual buffer storage (ARB_sparse_buffer), pages are committed on demand
+        };
+
         /**
          * \brief BufferObject constructor that uses std containers as input.
          *
@@ -41,6 +51,18 @@ namespace glowl
          */
         BufferObject(GLenum target, GLvoid const* data, GLsizeiptr byte_size, GLenum usage = GL_DYNAMIC_DRAW);
 
+        /**
+         * \brief Bufferobject constructor that creates an uninitialized buffer of the given byte size.
+         *
+         * In sparse mode, only a virtual address range is reserved (rounded up to the sparse page size) and no
+         * memory is committed. Use commit() and decommit() to manage physical pages, offsets within the buffer
+         * stay stable for the lifetime of the buffer. The usage hint is ignored in sparse mode.
+         *
+         * Note: Active OpenGL context required for construction.
+         * Use std::unqiue_ptr (or shared_ptr) for delayed construction of class member variables of this type.
+         */
+        BufferObject(GLenum target, GLsizeiptr byte_size, StorageMode storage_mode, GLenum usage = GL_DYNAMIC_DRAW);
+
         ~BufferObject();
 
         BufferObject(const BufferObject& cpy) = delete;
@@ -58,6 +80,14 @@ namespace glowl
 
         void rebuffer(GLvoid const* data, GLsizeiptr byte_size);
 
+        /**
+         * \brief Map a byte range of the buffer into client memory (see glMapNamedBufferRange).
+         * The returned pointer stays valid until unmap() and may be accessed from any thread.
+         */
+        void* map(GLintptr byte_offset, GLsizeiptr byte_size, GLbitfield access) const;
+
+        void unmap() const;
+
         void bind() const;
 
         void bind(GLuint index) const;
@@ -78,11 +108,48 @@ namespace glowl
 
         GLsizeiptr getByteSize() const;
 
+        StorageMode getStorageMode() const;
+
+        /**
+         * \brief Commit physical memory for all sparse pages touched by the given byte range.
+         * Pages that are already resident are skipped.
+         */
+        void commit(GLintptr byte_offset, GLsizeiptr byte_size);
+
+        /**
+         * \brief Release physical memory of all sparse pages fully contained in the given byte range.
+         * Partially covered pages at the range borders stay resident.
+         */
+        void decommit(GLintptr byte_offset, GLsizeiptr byte_size);
+
+        /**
+         * \brief Check whether all pages touched by the given byte range are committed.
+         * Always true for non-sparse buffers.
+         */
+        bool isResident(GLintptr byte_offset, GLsizeiptr byte_size) const;
+
+        /**
+         * \brief Sparse page size in bytes, 0 for non-sparse buffers.
+         */
+        GLsizeiptr getPageSize() const;
+
+        /**
+         * \brief Physically backed bytes, i.e. the full size for non-sparse buffers.
+         */
+        GLsizeiptr getCommittedByteSize() const;
+
     private:
+        void setPageCommitment(size_t first_page, size_t page_cnt, bool commit);
+
         GLenum     m_target;
         GLuint     m_name;
         GLsizeiptr m_byte_size;
         GLenum     m_usage;
+
+        StorageMode       m_storage_mode;
+        GLsizeiptr        m_page_size;
+        std::vector<bool> m_resident_pages; ///< Residency of each sparse page
+        size_t            m_resident_page_cnt;
     };
 
     template<typename Container>
@@ -90,12 +157,21 @@ namespace glowl
         : m_target(target),
           m_name(0),
           m_byte_size(static_cast<GLsizeiptr>(datastorage.size() * sizeof(typename Container::value_type))),
-          m_usage(usage)
+          m_usage(usage),
+          m_storage_mode(StorageMode::Mutable),
+          m_page_size(0),
+          m_resident_page_cnt(0)
     {
-        glCreateBuffers(1, &m_name);
+        m_name = getNamePool(NameType::Buffer).acquire();
         glNamedBufferData(m_name, m_byte_size, datastorage.data(), m_usage);
 
-        auto err = glGetError();
+        GLOWL_TRACE(Opcode::CreateBuffer, {m_name, m_target});
+        GLOWL_TRACE(Opcode::NamedBufferData,
+                    {m_name, m_byte_size, m_usage},
+                    datastorage.data(),
+                    static_cast<size_t>(m_byte_size));
+
+        auto err = DeferredErrorCheck::isActive() ? GL_NO_ERROR : glGetError();
         if (err != GL_NO_ERROR)
         {
             throw BufferObjectException("BufferObject::BufferObject - OpenGL error " + std::to_string(err));
@@ -103,12 +179,72 @@ namespace glowl
     }
 
     inline BufferObject::BufferObject(GLenum target, GLvoid const* data, GLsizeiptr byte_size, GLenum usage)
-        : m_target(target), m_name(0), m_byte_size(byte_size), m_usage(usage)
+        : m_target(target),
+          m_name(0),
+          m_byte_size(byte_size),
+          m_usage(usage),
+          m_storage_mode(StorageMode::Mutable),
+          m_page_size(0),
+          m_resident_page_cnt(0)
     {
-        glCreateBuffers(1, &m_name);
+        m_name = getNamePool(NameType::Buffer).acquire();
         glNamedBufferData(m_name, m_byte_size, data, m_usage);
 
-        auto err = glGetError();
+        GLOWL_TRACE(Opcode::CreateBuffer, {m_name, m_target});
+        GLOWL_TRACE(Opcode::NamedBufferData, {m_name, m_byte_size, m_usage}, data, static_cast<size_t>(m_byte_size));
+
+        auto err = DeferredErrorCheck::isActive() ? GL_NO_ERROR : glGetError();
+        if (err != GL_NO_ERROR)
+        {
+            throw BufferObjectException("BufferObject::BufferObject - OpenGL error " + std::to_string(err));
+        }
+    }
+
+    inline BufferObject::BufferObject(GLenum target, GLsizeiptr byte_size, StorageMode storage_mode, GLenum usage)
+        : m_target(target),
+          m_name(0),
+          m_byte_size(byte_size),
+          m_usage(usage),
+          m_storage_mode(storage_mode),
+          m_page_size(0),
+          m_resident_page_cnt(0)
+    {
+        if (m_storage_mode == StorageMode::Sparse)
+        {
+#ifndef GLOWL_NO_ARB_SPARSE_BUFFER
+            GLint page_size = 0;
+            glGetIntegerv(GL_SPARSE_BUFFER_PAGE_SIZE_ARB, &page_size);
+            if (page_size <= 0)
+            {
+                throw BufferObjectException("BufferObject::BufferObject - sparse buffers not supported");
+            }
+            m_page_size = page_size;
+
+            // round up to full pages, commitment works on page granularity only
+            m_byte_size = ((m_byte_size + m_page_size - 1) / m_page_size) * m_page_size;
+            m_resident_pages.assign(static_cast<size_t>(m_byte_size / m_page_size), false);
+
+            m_name = getNamePool(NameType::Buffer).acquire();
+            glNamedBufferStorage(m_name, m_byte_size, nullptr, GL_SPARSE_STORAGE_BIT_ARB | GL_DYNAMIC_STORAGE_BIT);
+
+            GLOWL_TRACE(Opcode::CreateBuffer, {m_name, m_target});
+            GLOWL_TRACE(Opcode::NamedBufferStorage,
+                        {m_name, m_byte_size, GL_SPARSE_STORAGE_BIT_ARB | GL_DYNAMIC_STORAGE_BIT});
+#else
+            throw BufferObjectException(
+                "BufferObject::BufferObject - sparse buffers disabled (GLOWL_NO_ARB_SPARSE_BUFFER)");
+#endif
+        }
+        else
+        {
+            m_name = getNamePool(NameType::Buffer).acquire();
+            glNamedBufferData(m_name, m_byte_size, nullptr, m_usage);
+
+            GLOWL_TRACE(Opcode::CreateBuffer, {m_name, m_target});
+            GLOWL_TRACE(Opcode::NamedBufferData, {m_name, m_byte_size, m_usage});
+        }
+
+        auto err = DeferredErrorCheck::isActive() ? GL_NO_ERROR : glGetError();
         if (err != GL_NO_ERROR)
         {
             throw BufferObjectException("BufferObject::BufferObject - OpenGL error " + std::to_string(err));
@@ -117,7 +253,9 @@ namespace glowl
 
     inline BufferObject::~BufferObject()
     {
-        glDeleteBuffers(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteBuffer, {m_name});
+        // sparse storage is immutable, only mutable buffers can be respecified by the next owner of the name
+        getNamePool(NameType::Buffer).release(m_name, m_storage_mode == StorageMode::Mutable);
     }
 
     template<typename Container>
@@ -131,8 +269,19 @@ namespace glowl
             throw BufferObjectException("BufferObject::bufferSubData - given data too large for buffer");
         }
 
+        if (!isResident(byte_offset,
+                        static_cast<GLsizeiptr>(datastorage.size() * sizeof(typename Container::value_type))))
+        {
+            throw BufferObjectException("BufferObject::bufferSubData - sparse pages not committed");
+        }
+
         glNamedBufferSubData(
             m_name, byte_offset, datastorage.size() * sizeof(typename Container::value_type), datastorage.data());
+
+        GLOWL_TRACE(Opcode::NamedBufferSubData,
+                    {m_name, byte_offset},
+                    datastorage.data(),
+                    datastorage.size() * sizeof(typename Container::value_type));
     }
 
     inline void BufferObject::bufferSubData(GLvoid const* data, GLsizeiptr byte_size, GLsizeiptr byte_offset) const
@@ -144,15 +293,32 @@ namespace glowl
             throw BufferObjectException("BufferObject::bufferSubData - given data too large for buffer");
         }
 
+        if (!isResident(byte_offset, byte_size))
+        {
+            throw BufferObjectException("BufferObject::bufferSubData - sparse pages not committed");
+        }
+
         glNamedBufferSubData(m_name, byte_offset, byte_size, data);
+
+        GLOWL_TRACE(Opcode::NamedBufferSubData, {m_name, byte_offset}, data, static_cast<size_t>(byte_size));
     }
 
     template<typename Container>
     inline void BufferObject::rebuffer(Container const& datastorage)
     {
+        if (m_storage_mode == StorageMode::Sparse)
+        {
+            throw BufferObjectException("BufferObject::rebuffer - sparse buffers have immutable storage");
+        }
+
         m_byte_size = static_cast<GLsizeiptr>(datastorage.size() * sizeof(typename Container::value_type));
         glNamedBufferData(m_name, m_byte_size, datastorage.data(), m_usage);
 
+        GLOWL_TRACE(Opcode::NamedBufferData,
+                    {m_name, m_byte_size, m_usage},
+                    datastorage.data(),
+                    static_cast<size_t>(m_byte_size));
+
         auto err = glGetError();
         if (err != GL_NO_ERROR)
         {
@@ -162,9 +328,16 @@ namespace glowl
 
     inline void BufferObject::rebuffer(GLvoid const* data, GLsizeiptr byte_size)
     {
+        if (m_storage_mode == StorageMode::Sparse)
+        {
+            throw BufferObjectException("BufferObject::rebuffer - sparse buffers have immutable storage");
+        }
+
         m_byte_size = byte_size;
         glNamedBufferData(m_name, m_byte_size, data, m_usage);
 
+        GLOWL_TRACE(Opcode::NamedBufferData, {m_name, m_byte_size, m_usage}, data, static_cast<size_t>(m_byte_size));
+
         auto err = glGetError();
         if (err != GL_NO_ERROR)
         {
@@ -172,18 +345,43 @@ namespace glowl
         }
     }
 
+    inline void* BufferObject::map(GLintptr byte_offset, GLsizeiptr byte_size, GLbitfield access) const
+    {
+        if ((byte_offset + byte_size) > m_byte_size)
+        {
+            throw BufferObjectException("BufferObject::map - given range too large for buffer");
+        }
+
+        void* data = glMapNamedBufferRange(m_name, byte_offset, byte_size, access);
+
+        if (data == nullptr)
+        {
+            throw BufferObjectException("BufferObject::map - OpenGL error " + std::to_string(glGetError()));
+        }
+
+        return data;
+    }
+
+    inline void BufferObject::unmap() const
+    {
+        glUnmapNamedBuffer(m_name);
+    }
+
     inline void BufferObject::bind() const
     {
+        GLOWL_TRACE(Opcode::BindBuffer, {m_target, m_name});
         glBindBuffer(m_target, m_name);
     }
 
     inline void BufferObject::bind(GLuint index) const
     {
+        GLOWL_TRACE(Opcode::BindBufferBase, {m_target, index, m_name});
         glBindBufferBase(m_target, index, m_name);
     }
 
     inline void BufferObject::bindAs(GLenum target, GLuint index) const
     {
+        GLOWL_TRACE(Opcode::BindBufferBase, {target, index, m_name});
         glBindBufferBase(target, index, m_name);
         auto err = glGetError();
         if (err != GL_NO_ERROR)
@@ -199,6 +397,7 @@ namespace glowl
             throw BufferObjectException("BufferObject::copy - target buffer smaller than source");
         }
 
+        GLOWL_TRACE(Opcode::CopyNamedBufferSubData, {src->m_name, tgt->m_name, 0, 0, src->m_byte_size});
         glCopyNamedBufferSubData(src->m_name, tgt->m_name, 0, 0, src->m_byte_size);
     }
 
@@ -217,6 +416,7 @@ namespace glowl
             throw BufferObjectException("BufferObject::copy - target buffer out of bounds");
         }
 
+        GLOWL_TRACE(Opcode::CopyNamedBufferSubData, {src->m_name, tgt->m_name, readOffset, writeOffset, size});
         glCopyNamedBufferSubData(src->m_name, tgt->m_name, readOffset, writeOffset, size);
     }
 
@@ -235,6 +435,144 @@ namespace glowl
         return m_byte_size;
     }
 
+    inline BufferObject::StorageMode BufferObject::getStorageMode() const
+    {
+        return m_storage_mode;
+    }
+
+    inline void BufferObject::commit(GLintptr byte_offset, GLsizeiptr byte_size)
+    {
+        if (m_storage_mode != StorageMode::Sparse)
+        {
+            throw BufferObjectException("BufferObject::commit - not a sparse buffer");
+        }
+        if (byte_offset < 0 || byte_size < 0 || (byte_offset + byte_size) > m_byte_size)
+        {
+            throw BufferObjectException("BufferObject::commit - range out of bounds");
+        }
+        if (byte_size == 0)
+        {
+            return;
+        }
+
+        size_t first_page = static_cast<size_t>(byte_offset / m_page_size);
+        size_t end_page = static_cast<size_t>((byte_offset + byte_size + m_page_size - 1) / m_page_size);
+
+        // commit contiguous runs of non-resident pages with a single call each
+        size_t page = first_page;
+        while (page < end_page)
+        {
+            if (m_resident_pages[page])
+            {
+                ++page;
+                continue;
+            }
+            size_t run_begin = page;
+            while (page < end_page && !m_resident_pages[page])
+            {
+                ++page;
+            }
+            setPageCommitment(run_begin, page - run_begin, true);
+        }
+    }
+
+    inline void BufferObject::decommit(GLintptr byte_offset, GLsizeiptr byte_size)
+    {
+        if (m_storage_mode != StorageMode::Sparse)
+        {
+            throw BufferObjectException("BufferObject::decommit - not a sparse buffer");
+        }
+        if (byte_offset < 0 || byte_size < 0 || (byte_offset + byte_size) > m_byte_size)
+        {
+            throw BufferObjectException("BufferObject::decommit - range out of bounds");
+        }
+
+        size_t first_page = static_cast<size_t>((byte_offset + m_page_size - 1) / m_page_size);
+        size_t end_page = static_cast<size_t>((byte_offset + byte_size) / m_page_size);
+
+        size_t page = first_page;
+        while (page < end_page)
+        {
+            if (!m_resident_pages[page])
+            {
+                ++page;
+                continue;
+            }
+            size_t run_begin = page;
+            while (page < end_page && m_resident_pages[page])
+            {
+                ++page;
+            }
+            setPageCommitment(run_begin, page - run_begin, false);
+        }
+    }
+
+    inline bool BufferObject::isResident(GLintptr byte_offset, GLsizeiptr byte_size) const
+    {
+        if (m_storage_mode != StorageMode::Sparse)
+        {
+            return true;
+        }
+        if (byte_size <= 0)
+        {
+            return true;
+        }
+
+        size_t first_page = static_cast<size_t>(byte_offset / m_page_size);
+        size_t end_page = static_cast<size_t>((byte_offset + byte_size + m_page_size - 1) / m_page_size);
+
+        if (end_page - first_page > m_resident_page_cnt)
+        {
+            return false;
+        }
+
+        for (size_t page = first_page; page < end_page; ++page)
+        {
+            if (!m_resident_pages[page])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    inline GLsizeiptr BufferObject::getPageSize() const
+    {
+        return m_page_size;
+    }
+
+    inline GLsizeiptr BufferObject::getCommittedByteSize() const
+    {
+        if (m_storage_mode == StorageMode::Sparse)
+        {
+            return static_cast<GLsizeiptr>(m_resident_page_cnt) * m_page_size;
+        }
+        return m_byte_size;
+    }
+
+    inline void BufferObject::setPageCommitment(size_t first_page, size_t page_cnt, bool commit)
+    {
+#ifndef GLOWL_NO_ARB_SPARSE_BUFFER
+        glNamedBufferPageCommitmentARB(m_name,
+                                       static_cast<GLintptr>(first_page) * m_page_size,
+                                       static_cast<GLsizeiptr>(page_cnt) * m_page_size,
+                                       commit ? GL_TRUE : GL_FALSE);
+
+        GLOWL_TRACE(Opcode::NamedBufferPageCommitment,
+                    {m_name,
+                     static_cast<GLintptr>(first_page) * m_page_size,
+                     static_cast<GLsizeiptr>(page_cnt) * m_page_size,
+                     commit ? 1 : 0});
+#endif
+
+        for (size_t page = first_page; page < first_page + page_cnt; ++page)
+        {
+            m_resident_pages[page] = commit;
+        }
+        m_resident_page_cnt = commit ? m_resident_page_cnt + page_cnt : m_resident_page_cnt - page_cnt;
+    }
+
 } // namespace glowl
 
 #endif // GLOWL_BUFFEROBJECT_HPP
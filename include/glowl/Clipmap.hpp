@@ -0,0 +1,323 @@
+/*
+ * Clipmap.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_CLIPMAP_HPP
+#define GLOWL_CLIPMAP_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "Texture2DArray.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class Clipmap
+     *
+     * \brief Clipmap stored in the layers of a Texture2DArray with toroidal (wrap around) addressing.
+     *
+     * Each layer holds a window of width x height texels of one clipmap level, positioned by its origin in world
+     * texel coordinates of that level. A world texel (x, y) is stored at (x mod width, y mod height), so moving the
+     * window only requires uploading the newly exposed L-shaped region instead of the whole layer.
+     * The texture has to use GL_REPEAT wrapping (the OpenGL default).
+     *
+     * Shaders get the window of each level from getShaderOffsets() as ivec4(wrap_x, wrap_y, origin_x, origin_y),
+     * wrap being origin mod size. Since origins are 64 bit, the origin is passed modulo a period P, the largest
+     * multiple of the window size not exceeding 2^30 (see getShaderPeriodX()). A world texel coordinate p of
+     * level l, reduced modulo P as well, is inside the window if (p - origin) mod P < size and can then be sampled
+     * with the texture coordinate p / size.
+     */
+    class Clipmap
+    {
+    public:
+        /**
+         * Fills data with width x height tightly packed texels of the given level, starting at world texel (x, y).
+         */
+        using Loader = std::function<
+            void(unsigned int level, std::int64_t x, std::int64_t y, GLsizei width, GLsizei height, void* data)>;
+
+        /**
+         * \brief Clipmap constructor.
+         *
+         * \param layout Layout of the texture array, width and height give the window size, depth the level count
+         * \param loader Callable that provides the texels of newly exposed regions
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        Clipmap(std::string const& id, TextureLayout const& layout, Loader loader);
+        Clipmap(const Clipmap&) = delete;
+        Clipmap& operator=(const Clipmap&) = delete;
+
+        /**
+         * \brief Moves the window of a level to the given origin and uploads the newly exposed regions.
+         */
+        void setOrigin(unsigned int level, std::int64_t x, std::int64_t y);
+
+        /**
+         * \brief Centers the windows of all levels on the given position in world texel coordinates of level 0,
+         * each level covering twice the area of the previous one.
+         */
+        void setCenter(double x, double y);
+
+        /**
+         * \brief Marks all levels as invalid, e.g. after the source data changed. The next setOrigin() or setCenter()
+         * reloads them completely.
+         */
+        void invalidate();
+
+        Texture2DArray const& getTexture() const;
+
+        std::int64_t getOriginX(unsigned int level) const;
+        std::int64_t getOriginY(unsigned int level) const;
+
+        /**
+         * \brief Per level ivec4(wrap_x, wrap_y, origin_x, origin_y), e.g. for glUniform4iv.
+         */
+        std::vector<GLint> const& getShaderOffsets() const;
+
+        /**
+         * \brief Period of the origins in getShaderOffsets() along x and y.
+         */
+        GLint getShaderPeriodX() const;
+        GLint getShaderPeriodY() const;
+
+        /**
+         * \brief Number of texels uploaded since construction.
+         */
+        std::uint64_t getUploadedTexelCount() const;
+
+    private:
+        struct Level
+        {
+            std::int64_t origin_x;
+            std::int64_t origin_y;
+            bool         valid;
+        };
+
+        /** Uploads a region given in world texel coordinates, splitting it at the texture borders */
+        void uploadRegion(unsigned int level, std::int64_t x, std::int64_t y, GLsizei width, GLsizei height);
+
+        void uploadTile(unsigned int level, std::int64_t x, std::int64_t y, GLsizei width, GLsizei height);
+
+        static GLint wrap(std::int64_t x, GLsizei size);
+
+        static GLsizei shaderPeriod(GLsizei size);
+
+        std::unique_ptr<Texture2DArray> m_texture;
+        Loader                          m_loader;
+
+        GLsizei m_width;
+        GLsizei m_height;
+        size_t  m_texel_byte_size;
+
+        std::vector<Level>         m_levels;
+        std::vector<GLint>         m_shader_offsets;
+        std::vector<unsigned char> m_staging; ///< Reused for all uploads, only grows
+        std::uint64_t              m_uploaded_texel_cnt;
+    };
+
+    inline Clipmap::Clipmap(std::string const& id, TextureLayout const& layout, Loader loader)
+        : m_texture(std::make_unique<Texture2DArray>(id, layout, nullptr)),
+          m_loader(loader),
+          m_width(layout.width),
+          m_height(layout.height),
+          m_texel_byte_size(trace::computeImageByteSize(layout.format, layout.type, 1, 1, 1)),
+          m_levels(static_cast<size_t>(layout.depth), {0, 0, false}),
+          m_shader_offsets(static_cast<size_t>(layout.depth) * 4, 0),
+          m_uploaded_texel_cnt(0)
+    {
+        if (!m_loader)
+        {
+            throw TextureException("Clipmap::Clipmap - texture id: " + id + " - no loader given");
+        }
+    }
+
+    inline void Clipmap::setOrigin(unsigned int level, std::int64_t x, std::int64_t y)
+    {
+        if (level >= m_levels.size())
+        {
+            throw TextureException("Clipmap::setOrigin - texture id: " + m_texture->getId() + " - level " +
+                                   std::to_string(level) + " out of range");
+        }
+
+        Level& state = m_levels[level];
+
+        std::int64_t dx = x - state.origin_x;
+        std::int64_t dy = y - state.origin_y;
+
+        if (state.valid && dx == 0 && dy == 0)
+        {
+            return;
+        }
+
+        // rows are uploaded unpadded
+        GLint unpack_alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        if (!state.valid || std::abs(dx) >= m_width || std::abs(dy) >= m_height)
+        {
+            uploadRegion(level, x, y, m_width, m_height);
+        }
+        else
+        {
+            // columns that entered the window, over its full new height
+            if (dx > 0)
+            {
+                uploadRegion(level, state.origin_x + m_width, y, static_cast<GLsizei>(dx), m_height);
+            }
+            else if (dx < 0)
+            {
+                uploadRegion(level, x, y, static_cast<GLsizei>(-dx), m_height);
+            }
+
+            // rows that entered the window, without the corner already covered by the columns
+            GLsizei      row_width = m_width - static_cast<GLsizei>(std::abs(dx));
+            std::int64_t row_x = std::max(x, state.origin_x);
+            if (dy > 0)
+            {
+                uploadRegion(level, row_x, state.origin_y + m_height, row_width, static_cast<GLsizei>(dy));
+            }
+            else if (dy < 0)
+            {
+                uploadRegion(level, row_x, y, row_width, static_cast<GLsizei>(-dy));
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+        state.origin_x = x;
+        state.origin_y = y;
+        state.valid = true;
+
+        m_shader_offsets[level * 4 + 0] = wrap(x, m_width);
+        m_shader_offsets[level * 4 + 1] = wrap(y, m_height);
+        m_shader_offsets[level * 4 + 2] = wrap(x, shaderPeriod(m_width));
+        m_shader_offsets[level * 4 + 3] = wrap(y, shaderPeriod(m_height));
+    }
+
+    inline void Clipmap::setCenter(double x, double y)
+    {
+        for (unsigned int level = 0; level < m_levels.size(); ++level)
+        {
+            double scale = std::ldexp(1.0, -static_cast<int>(level));
+            setOrigin(level,
+                      static_cast<std::int64_t>(std::floor(x * scale)) - m_width / 2,
+                      static_cast<std::int64_t>(std::floor(y * scale)) - m_height / 2);
+        }
+    }
+
+    inline void Clipmap::invalidate()
+    {
+        for (auto& level : m_levels)
+        {
+            level.valid = false;
+        }
+    }
+
+    inline Texture2DArray const& Clipmap::getTexture() const
+    {
+        return *m_texture;
+    }
+
+    inline std::int64_t Clipmap::getOriginX(unsigned int level) const
+    {
+        return m_levels[level].origin_x;
+    }
+
+    inline std::int64_t Clipmap::getOriginY(unsigned int level) const
+    {
+        return m_levels[level].origin_y;
+    }
+
+    inline std::vector<GLint> const& Clipmap::getShaderOffsets() const
+    {
+        return m_shader_offsets;
+    }
+
+    inline GLint Clipmap::getShaderPeriodX() const
+    {
+        return shaderPeriod(m_width);
+    }
+
+    inline GLint Clipmap::getShaderPeriodY() const
+    {
+        return shaderPeriod(m_height);
+    }
+
+    inline std::uint64_t Clipmap::getUploadedTexelCount() const
+    {
+        return m_uploaded_texel_cnt;
+    }
+
+    inline void Clipmap::uploadRegion(unsigned int level,
+                                      std::int64_t x,
+                                      std::int64_t y,
+                                      GLsizei      width,
+                                      GLsizei      height)
+    {
+        // a region smaller than the window wraps around each texture border at most once
+        GLsizei first_width = std::min(width, m_width - wrap(x, m_width));
+        GLsizei first_height = std::min(height, m_height - wrap(y, m_height));
+
+        uploadTile(level, x, y, first_width, first_height);
+
+        if (first_width < width)
+        {
+            uploadTile(level, x + first_width, y, width - first_width, first_height);
+        }
+        if (first_height < height)
+        {
+            uploadTile(level, x, y + first_height, first_width, height - first_height);
+
+            if (first_width < width)
+            {
+                uploadTile(level, x + first_width, y + first_height, width - first_width, height - first_height);
+            }
+        }
+    }
+
+    inline void Clipmap::uploadTile(unsigned int level, std::int64_t x, std::int64_t y, GLsizei width, GLsizei height)
+    {
+        size_t byte_size = static_cast<size_t>(width) * static_cast<size_t>(height) * m_texel_byte_size;
+        if (m_staging.size() < byte_size)
+        {
+            m_staging.resize(byte_size);
+        }
+
+        m_loader(level, x, y, width, height, m_staging.data());
+
+        m_texture->subImage(
+            0, wrap(x, m_width), wrap(y, m_height), static_cast<GLint>(level), width, height, 1, m_staging.data());
+
+        m_uploaded_texel_cnt += static_cast<std::uint64_t>(width) * static_cast<std::uint64_t>(height);
+    }
+
+    inline GLint Clipmap::wrap(std::int64_t x, GLsizei size)
+    {
+        std::int64_t wrapped = x % size;
+        return static_cast<GLint>(wrapped < 0 ? wrapped + size : wrapped);
+    }
+
+    inline GLsizei Clipmap::shaderPeriod(GLsizei size)
+    {
+        // a multiple of the size keeps origin mod size intact
+        return ((1 << 30) / size) * size;
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_CLIPMAP_HPP
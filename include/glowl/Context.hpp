@@ -0,0 +1,234 @@
+/*
+ * Context.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_CONTEXT_HPP
+#define GLOWL_CONTEXT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * Application defined identifier of an OpenGL context, e.g. the address of the window or native context handle.
+     * glowl cannot query the current context on its own, so applications that use glowl objects from more than
+     * one context call setCurrentContext() whenever they make a context current on a thread.
+     * Single-context applications can ignore this, all threads default to context id 0.
+     */
+    typedef std::uintptr_t ContextId;
+
+    namespace detail
+    {
+        inline ContextId& currentContextId()
+        {
+            static thread_local ContextId context_id = 0;
+            return context_id;
+        }
+    } // namespace detail
+
+    /**
+     * \brief Tell glowl which context is current on the calling thread.
+     */
+    inline void setCurrentContext(ContextId context_id)
+    {
+        detail::currentContextId() = context_id;
+    }
+
+    /**
+     * \brief Returns the context id last set on the calling thread (0 by default).
+     */
+    inline ContextId getCurrentContext()
+    {
+        return detail::currentContextId();
+    }
+
+    /**
+     * \class PerContextObject
+     *
+     * \brief Keeps one instance of a non-shareable OpenGL container object (VAO, FBO) per context.
+     *
+     * Instances are created lazily on first use in a context. Changes to the object description are propagated
+     * by invalidate(), which lets every context update its instance on its next use.
+     * Container objects can only be deleted in their own context, see release().
+     *
+     * The instance used last is cached and read without locking, so objects used from a single context (or
+     * repeatedly from the same one) never touch the mutex after the first use.
+     */
+    class PerContextObject
+    {
+    public:
+        PerContextObject()
+            : m_version(0), m_cache_sequence(0), m_cache_context(0), m_cache_name(0), m_cache_version(0)
+        {
+        }
+        PerContextObject(const PerContextObject&) = delete;
+        PerContextObject& operator=(const PerContextObject&) = delete;
+
+        /**
+         * \brief Returns the instance of the current context.
+         *
+         * \param create Callable that creates and sets up a new instance and returns its name
+         * \param update Callable that brings an outdated instance (given by name) up to date
+         */
+        template<typename Create, typename Update>
+        GLuint get(Create create, Update update);
+
+        /**
+         * \brief Returns the instance of the current context.
+         *
+         * \param create Callable that creates and sets up a new instance and returns its name
+         */
+        template<typename Create>
+        GLuint get(Create create);
+
+        /**
+         * \brief Mark the instances of all contexts as outdated.
+         */
+        void invalidate();
+
+        /**
+         * \brief Removes the instance of the current context and returns its name (0 if none exists).
+         * The caller is responsible for deleting the OpenGL object.
+         */
+        GLuint release();
+
+        /**
+         * \brief Returns the number of contexts that own an instance.
+         */
+        size_t size() const;
+
+    private:
+        struct Instance
+        {
+            ContextId     context;
+            GLuint        name;
+            std::uint64_t version;
+        };
+
+        /**
+         * \brief Publishes an instance as the cached one (name 0 clears the cache). Requires m_mutex to be held.
+         */
+        void setCache(ContextId context, GLuint name, std::uint64_t version);
+
+        mutable std::mutex         m_mutex;
+        std::vector<Instance>      m_instances;
+        std::atomic<std::uint64_t> m_version;
+
+        // last used instance, guarded by a sequence lock (odd while written)
+        std::atomic<std::uint64_t> m_cache_sequence;
+        std::atomic<ContextId>     m_cache_context;
+        std::atomic<GLuint>        m_cache_name;
+        std::atomic<std::uint64_t> m_cache_version;
+    };
+
+    template<typename Create, typename Update>
+    inline GLuint PerContextObject::get(Create create, Update update)
+    {
+        ContextId context = getCurrentContext();
+
+        std::uint64_t sequence = m_cache_sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) == 0)
+        {
+            ContextId     cache_context = m_cache_context.load(std::memory_order_relaxed);
+            GLuint        cache_name = m_cache_name.load(std::memory_order_relaxed);
+            std::uint64_t cache_version = m_cache_version.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (m_cache_sequence.load(std::memory_order_relaxed) == sequence && cache_name != 0 &&
+                cache_context == context && cache_version == m_version.load(std::memory_order_acquire))
+            {
+                return cache_name;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::uint64_t version = m_version.load(std::memory_order_relaxed);
+
+        // only a handful of contexts is expected, so a linear search is the fastest lookup
+        for (auto& instance : m_instances)
+        {
+            if (instance.context == context)
+            {
+                if (instance.version != version)
+                {
+                    update(instance.name);
+                    instance.version = version;
+                }
+                setCache(context, instance.name, version);
+                return instance.name;
+            }
+        }
+
+        Instance instance = {context, create(), version};
+        m_instances.push_back(instance);
+        setCache(context, instance.name, version);
+
+        return instance.name;
+    }
+
+    template<typename Create>
+    inline GLuint PerContextObject::get(Create create)
+    {
+        return get(create, [](GLuint) {});
+    }
+
+    inline void PerContextObject::invalidate()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_version.fetch_add(1, std::memory_order_release);
+    }
+
+    inline GLuint PerContextObject::release()
+    {
+        ContextId context = getCurrentContext();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (auto it = m_instances.begin(); it != m_instances.end(); ++it)
+        {
+            if (it->context == context)
+            {
+                GLuint name = it->name;
+                m_instances.erase(it);
+                if (m_cache_context.load(std::memory_order_relaxed) == context)
+                {
+                    setCache(0, 0, 0);
+                }
+                return name;
+            }
+        }
+
+        return 0;
+    }
+
+    inline void PerContextObject::setCache(ContextId context, GLuint name, std::uint64_t version)
+    {
+        std::uint64_t sequence = m_cache_sequence.load(std::memory_order_relaxed);
+        m_cache_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_cache_context.store(context, std::memory_order_relaxed);
+        m_cache_name.store(name, std::memory_order_relaxed);
+        m_cache_version.store(version, std::memory_order_relaxed);
+
+        m_cache_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    inline size_t PerContextObject::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_instances.size();
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_CONTEXT_HPP
@@ -0,0 +1,317 @@
+/*
+ * DynamicResolution.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_DYNAMICRESOLUTION_HPP
+#define GLOWL_DYNAMICRESOLUTION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Context.hpp"
+#include "FramebufferObject.hpp"
+#include "GLSLProgram.hpp"
+#include "GpuTimer.hpp"
+#include "NamePool.hpp"
+#include "Sampler.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class DynamicResolution
+     *
+     * \brief Adapts the render resolution of framebuffer objects to keep the measured GPU frame time at a target.
+     *
+     * The GPU time between beginFrame() and endFrame() is measured with timer queries (results arrive a few frames
+     * later, the controller never waits for them). From these, the cost per rendered pixel is estimated and the
+     * render scale of all added framebuffer objects is chosen such that the next frames meet the target time.
+     * The scale is lowered immediately on overload but raised in small steps to avoid oscillation.
+     *
+     * The framebuffer objects keep their attachments at full size and only render to a sub-area (see
+     * FramebufferObject::setRenderSize), which upscale() stretches to the current viewport.
+     *
+     * Usage per frame: beginFrame(), bind the framebuffers and call applyViewport() before rendering into them,
+     * bind the output framebuffer, upscale(), endFrame().
+     */
+    class DynamicResolution
+    {
+    public:
+        /**
+         * \brief DynamicResolution constructor.
+         *
+         * \param target_milliseconds GPU time per frame to aim for
+         * \param min_scale Lower bound of the render scale (per dimension)
+         * \param max_scale Upper bound of the render scale (per dimension)
+         * \param upscale_program Optional upscaling program replacing the built-in bilinear one. It is drawn as a
+         * fullscreen triangle without vertex attributes and receives the source at texture unit 0 ("src_tx"),
+         * the extent of the render area in texture coordinates ("uv_scale") and the largest texture coordinate
+         * that does not filter texels outside of the render area ("uv_max").
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        DynamicResolution(double                       target_milliseconds,
+                          float                        min_scale = 0.5f,
+                          float                        max_scale = 1.0f,
+                          std::shared_ptr<GLSLProgram> upscale_program = nullptr);
+
+        /**
+         * Deletes the vertex array of the current context, see releaseContext().
+         */
+        ~DynamicResolution();
+
+        DynamicResolution(const DynamicResolution&) = delete;
+        DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+        /**
+         * \brief Let the render size of the given framebuffer object follow the render scale.
+         */
+        void addFramebuffer(std::shared_ptr<FramebufferObject> const& fbo);
+
+        /**
+         * \brief Applies the current render scale to all framebuffer objects and starts the GPU timer.
+         */
+        void beginFrame();
+
+        /**
+         * \brief Stops the GPU timer and updates the render scale from all measurements available so far.
+         */
+        void endFrame();
+
+        /**
+         * \brief Draws the render area of a color attachment stretched over the current viewport.
+         */
+        void upscale(FramebufferObject const& fbo, unsigned int color_attachment = 0);
+
+        void   setTargetMilliseconds(double target_milliseconds);
+        double getTargetMilliseconds() const;
+
+        /**
+         * \brief Overrides the current render scale, the controller continues from there.
+         */
+        void  setScale(float scale);
+        float getScale() const;
+
+        /**
+         * \brief Most recent GPU frame time measurement (0 until the first result arrived).
+         */
+        double getLastMilliseconds() const;
+
+        /**
+         * \brief Deletes the vertex array of the current context.
+         * Vertex arrays are not shared between contexts, call this with every additional context current before
+         * destroying the controller.
+         */
+        void releaseContext();
+
+    private:
+        static constexpr unsigned int latency = 4;
+
+        void update(float measured_scale, double milliseconds);
+
+        double m_target_milliseconds;
+        float  m_min_scale;
+        float  m_max_scale;
+        float  m_scale;
+
+        double m_cost;              ///< Smoothed GPU milliseconds per frame at scale 1
+        double m_last_milliseconds; ///< Last measurement
+
+        GpuTimer           m_timer;
+        std::vector<float> m_frame_scales; ///< Render scale of the measurements in flight, by sequence number
+
+        std::vector<std::shared_ptr<FramebufferObject>> m_framebuffers;
+
+        std::shared_ptr<GLSLProgram> m_upscale_program;
+        Sampler                      m_sampler;
+        PerContextObject             m_vertex_arrays; ///< Empty vertex array for attribute-less drawing
+    };
+
+    inline DynamicResolution::DynamicResolution(double                       target_milliseconds,
+                                                float                        min_scale,
+                                                float                        max_scale,
+                                                std::shared_ptr<GLSLProgram> upscale_program)
+        : m_target_milliseconds(target_milliseconds),
+          m_min_scale(min_scale),
+          m_max_scale(max_scale),
+          m_scale(max_scale),
+          m_cost(0.0),
+          m_last_milliseconds(0.0),
+          m_timer(latency),
+          m_frame_scales(latency, max_scale),
+          m_upscale_program(upscale_program),
+          m_sampler("dynamic_resolution_upscale",
+                    std::vector<std::pair<GLenum, GLint>>{{GL_TEXTURE_MIN_FILTER, GL_LINEAR},
+                                                          {GL_TEXTURE_MAG_FILTER, GL_LINEAR},
+                                                          {GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE},
+                                                          {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE}})
+    {
+        if (m_upscale_program == nullptr)
+        {
+            m_upscale_program = std::make_shared<GLSLProgram>(GLSLProgram::ShaderSourceList{
+                {GLSLProgram::ShaderType::Vertex,
+                 "#version 450\n"
+                 "out vec2 uv;\n"
+                 "void main()\n"
+                 "{\n"
+                 "    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+                 "    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);\n"
+                 "}\n"},
+                {GLSLProgram::ShaderType::Fragment,
+                 "#version 450\n"
+                 "uniform sampler2D src_tx;\n"
+                 "uniform vec2 uv_scale;\n"
+                 "uniform vec2 uv_max;\n"
+                 "in vec2 uv;\n"
+                 "out vec4 frag_color;\n"
+                 "void main()\n"
+                 "{\n"
+                 "    frag_color = texture(src_tx, min(uv * uv_scale, uv_max));\n"
+                 "}\n"}});
+        }
+    }
+
+    inline DynamicResolution::~DynamicResolution()
+    {
+        releaseContext();
+    }
+
+    inline void DynamicResolution::addFramebuffer(std::shared_ptr<FramebufferObject> const& fbo)
+    {
+        m_framebuffers.push_back(fbo);
+    }
+
+    inline void DynamicResolution::beginFrame()
+    {
+        for (auto const& fbo : m_framebuffers)
+        {
+            fbo->setRenderSize(static_cast<int>(std::lround(fbo->getWidth() * m_scale)),
+                               static_cast<int>(std::lround(fbo->getHeight() * m_scale)));
+        }
+
+        std::uint64_t sequence = 0;
+        if (m_timer.begin(sequence))
+        {
+            m_frame_scales[sequence % latency] = m_scale;
+        }
+    }
+
+    inline void DynamicResolution::endFrame()
+    {
+        m_timer.end();
+
+        std::uint64_t sequence = 0;
+        double        milliseconds = 0.0;
+        while (m_timer.poll(sequence, milliseconds))
+        {
+            update(m_frame_scales[sequence % latency], milliseconds);
+        }
+    }
+
+    inline void DynamicResolution::upscale(FramebufferObject const& fbo, unsigned int color_attachment)
+    {
+        auto source = fbo.getColorAttachment(color_attachment);
+        if (source == nullptr)
+        {
+            throw FramebufferObjectException("DynamicResolution::upscale - color attachment " +
+                                             std::to_string(color_attachment) + " does not exist");
+        }
+
+        GLfloat width = static_cast<GLfloat>(fbo.getWidth());
+        GLfloat height = static_cast<GLfloat>(fbo.getHeight());
+        GLfloat render_width = static_cast<GLfloat>(fbo.getRenderWidth());
+        GLfloat render_height = static_cast<GLfloat>(fbo.getRenderHeight());
+
+        m_upscale_program->use();
+        m_upscale_program->setUniform("src_tx", 0);
+        m_upscale_program->setUniform("uv_scale", render_width / width, render_height / height);
+        m_upscale_program->setUniform("uv_max", (render_width - 0.5f) / width, (render_height - 0.5f) / height);
+
+        GLOWL_TRACE(Opcode::BindTextureUnit, {0, source->getName()});
+        glBindTextureUnit(0, source->getName());
+        m_sampler.bindSampler(0);
+
+        GLuint va_handle = m_vertex_arrays.get([]() {
+            GLuint name = getNamePool(NameType::VertexArray).acquire();
+            GLOWL_TRACE(Opcode::CreateVertexArray, {name});
+            return name;
+        });
+        GLOWL_TRACE(Opcode::BindVertexArray, {va_handle});
+        glBindVertexArray(va_handle);
+        GLOWL_TRACE(Opcode::DrawArrays, {GL_TRIANGLES, 0, 3});
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        GLOWL_TRACE(Opcode::BindVertexArray, {0});
+        glBindVertexArray(0);
+
+        glBindSampler(0, 0);
+    }
+
+    inline void DynamicResolution::setTargetMilliseconds(double target_milliseconds)
+    {
+        m_target_milliseconds = target_milliseconds;
+    }
+
+    inline double DynamicResolution::getTargetMilliseconds() const
+    {
+        return m_target_milliseconds;
+    }
+
+    inline void DynamicResolution::setScale(float scale)
+    {
+        m_scale = std::min(std::max(scale, m_min_scale), m_max_scale);
+    }
+
+    inline float DynamicResolution::getScale() const
+    {
+        return m_scale;
+    }
+
+    inline double DynamicResolution::getLastMilliseconds() const
+    {
+        return m_last_milliseconds;
+    }
+
+    inline void DynamicResolution::releaseContext()
+    {
+        GLuint va_handle = m_vertex_arrays.release();
+        if (va_handle != 0)
+        {
+            GLOWL_TRACE(Opcode::DeleteVertexArray, {va_handle});
+            getNamePool(NameType::VertexArray).release(va_handle);
+        }
+    }
+
+    inline void DynamicResolution::update(float measured_scale, double milliseconds)
+    {
+        m_last_milliseconds = milliseconds;
+
+        // GPU time is assumed to be proportional to the number of rendered pixels, i.e. the squared scale
+        double cost = milliseconds / (static_cast<double>(measured_scale) * measured_scale);
+        m_cost = m_cost > 0.0 ? m_cost + 0.3 * (cost - m_cost) : cost;
+
+        if (m_cost <= 0.0)
+        {
+            return;
+        }
+
+        float scale = static_cast<float>(std::sqrt(m_target_milliseconds / m_cost));
+
+        if (std::abs(scale - m_scale) < 0.02f)
+        {
+            return;
+        }
+
+        // react to overload at once, but grow slowly since the measurements lag behind by a few frames
+        setScale(scale < m_scale ? scale : std::min(scale, m_scale + 0.05f));
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_DYNAMICRESOLUTION_HPP
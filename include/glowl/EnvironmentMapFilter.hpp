@@ -0,0 +1,716 @@
+/*
+ * EnvironmentMapFilter.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_ENVIRONMENTMAPFILTER_HPP
+#define GLOWL_ENVIRONMENTMAPFILTER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "GLSLProgram.hpp"
+#include "MemoryBarrierTracker.hpp"
+#include "Sampler.hpp"
+#include "Texture2D.hpp"
+#include "TextureCache.hpp"
+#include "TextureCubemapArray.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class EnvironmentMapFilter
+     *
+     * \brief Prefilters environment probes for image based lighting, stored in cubemap arrays (one cube per probe).
+     *
+     * Each probe has a radiance cube with a full mipmap chain, either converted from an equirectangular image or
+     * rendered by the application, and two filtered results:
+     * - specular: level 0 is a copy of the radiance, level l is convolved with the GGX distribution of roughness
+     *   l / (levels - 1), i.e. sample it with lod = roughness * (getSpecularLevels() - 1).
+     * - irradiance: cosine weighted average of the incoming radiance, multiply by the albedo for diffuse lighting.
+     *
+     * Both are computed with importance sampling, each sample reading a radiance mipmap level that matches its
+     * solid angle (filtered importance sampling), and written via bindImage one level and face at a time.
+     * Filtering is incremental: update() processes a limited number of faces per call and probes are queued in
+     * the order they were invalidated. Enable GL_TEXTURE_CUBE_MAP_SEAMLESS for filtering across cube edges.
+     *
+     * With a TextureCache, results of probes with a cache key are stored once all faces are done and can be
+     * restored with loadCached() instead of filtering again. Supported formats are GL_RGBA16F, GL_RGBA32F and
+     * GL_R11F_G11F_B10F.
+     */
+    class EnvironmentMapFilter
+    {
+    public:
+        /**
+         * \param probe_cnt Number of probes, i.e. cubes in each array
+         * \param size Face size of the radiance and specular cubes, a power of two
+         * \param specular_levels Number of specular mipmap levels (roughness steps)
+         * \param irradiance_size Face size of the irradiance cubes
+         * \param sample_cnt Importance samples per texel
+         * \param cache Optional cache for filtered probes, has to outlive the filter
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        EnvironmentMapFilter(GLsizei             probe_cnt,
+                             GLsizei             size,
+                             GLsizei             specular_levels = 6,
+                             GLsizei             irradiance_size = 32,
+                             GLuint              sample_cnt = 256,
+                             GLenum              internal_format = GL_RGBA16F,
+                             TextureCache const* cache = nullptr);
+        EnvironmentMapFilter(const EnvironmentMapFilter&) = delete;
+        EnvironmentMapFilter& operator=(const EnvironmentMapFilter&) = delete;
+
+        /**
+         * \brief Cache key of a probe filtered from the given source data (e.g. the HDR file) with the settings of
+         * this filter.
+         */
+        std::uint64_t computeKey(void const* source, size_t byte_size) const;
+
+        /**
+         * \brief Restores the filtered results of a probe from the cache. Returns false if there is no cache or no
+         * valid entry for the key. The radiance of the probe is not restored.
+         */
+        bool loadCached(GLsizei probe, std::uint64_t key);
+
+        /**
+         * \brief Converts an equirectangular image into the radiance cube of a probe and queues it for filtering.
+         *
+         * The image covers all directions, longitude along u starting at -x, and latitude along v with the first
+         * row pointing up (+y), as images are usually stored. Mipmaps of the image are used if it is minified.
+         *
+         * \param key Cache key for the filtered results, 0 to not cache them
+         */
+        void setEquirectangular(GLsizei probe, Texture2D const& equirect, std::uint64_t key = 0);
+
+        /**
+         * \brief Queues a probe for filtering after its radiance (level 0 of getRadiance()) was changed, e.g. by
+         * rendering into it. A probe that is already queued starts over.
+         */
+        void invalidate(GLsizei probe, std::uint64_t key = 0);
+
+        /**
+         * \brief Filters up to face_budget faces (all specular levels and the irradiance of a face) of the queued
+         * probes.
+         */
+        void update(GLuint face_budget = 1);
+
+        bool isPending(GLsizei probe) const;
+
+        size_t getPendingCount() const;
+
+        TextureCubemapArray&       getRadiance();
+        TextureCubemapArray const& getSpecular() const;
+        TextureCubemapArray const& getIrradiance() const;
+
+        GLsizei getSpecularLevels() const;
+
+    private:
+        struct Job
+        {
+            GLsizei       probe;
+            int           face; ///< Next face to filter, -1 if the radiance mipmaps are outdated
+            std::uint64_t key;
+        };
+
+        static std::uint64_t getIrradianceKey(std::uint64_t key);
+
+        void checkProbe(GLsizei probe, char const* function) const;
+
+        void updateRadianceMipmaps(GLsizei probe);
+
+        void filterFace(GLsizei probe, int face);
+
+        void storeCached(GLsizei probe, std::uint64_t key) const;
+
+        /** Dispatches 8x8 work groups covering a face */
+        static void dispatch(GLSLProgram& program, GLsizei face_size);
+
+        GLsizei             m_probe_cnt;
+        GLsizei             m_size;
+        GLsizei             m_specular_levels;
+        GLsizei             m_irradiance_size;
+        GLuint              m_sample_cnt;
+        GLenum              m_internal_format;
+        GLenum              m_format;
+        GLenum              m_type;
+        TextureCache const* m_cache;
+
+        std::unique_ptr<TextureCubemapArray> m_radiance;
+        std::unique_ptr<TextureCubemapArray> m_specular;
+        std::unique_ptr<TextureCubemapArray> m_irradiance;
+
+        std::unique_ptr<GLSLProgram> m_equirect_program;
+        std::unique_ptr<GLSLProgram> m_downsample_program;
+        std::unique_ptr<GLSLProgram> m_specular_program;
+        std::unique_ptr<GLSLProgram> m_irradiance_program;
+
+        Sampler m_equirect_sampler;
+        Sampler m_cube_sampler;
+
+        std::deque<Job> m_jobs;
+    };
+
+    namespace detail
+    {
+        static constexpr GLsizei environment_filter_group_size = 8;
+
+        /** Common header of all kernels, FORMAT is replaced by the image format qualifier */
+        static char const* const environment_filter_common_source = R"(
+#version 450
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(FORMAT, binding = 0) writeonly uniform image2D dst;
+
+uniform int face;
+
+const float pi = 3.14159265358979;
+
+// direction through the center of a texel of the face, following the cube map face orientations of OpenGL
+vec3 getDirection(ivec2 texel, int size)
+{
+    vec2 st = (vec2(texel) + 0.5) / float(size) * 2.0 - 1.0;
+    vec3 dir;
+    switch (face)
+    {
+    case 0: dir = vec3(1.0, -st.y, -st.x); break;
+    case 1: dir = vec3(-1.0, -st.y, st.x); break;
+    case 2: dir = vec3(st.x, 1.0, st.y); break;
+    case 3: dir = vec3(st.x, -1.0, -st.y); break;
+    case 4: dir = vec3(st.x, -st.y, 1.0); break;
+    default: dir = vec3(-st.x, -st.y, -1.0); break;
+    }
+    return normalize(dir);
+}
+
+mat3 getTangentFrame(vec3 n)
+{
+    vec3 up = abs(n.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 t = normalize(cross(up, n));
+    return mat3(t, cross(n, t), n);
+}
+
+vec2 hammersley(uint i, uint n)
+{
+    return vec2(float(i) / float(n), float(bitfieldReverse(i)) * 2.3283064365386963e-10);
+}
+)";
+
+        static char const* const environment_filter_equirect_source = R"(
+uniform sampler2D equirect;
+uniform float lod;
+
+void main()
+{
+    ivec2 size = imageSize(dst);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y) return;
+
+    vec3 dir = getDirection(texel, size.x);
+    vec2 uv = vec2(atan(dir.z, dir.x) / (2.0 * pi) + 0.5, acos(clamp(dir.y, -1.0, 1.0)) / pi);
+    imageStore(dst, texel, vec4(textureLod(equirect, uv, lod).rgb, 1.0));
+}
+)";
+
+        static char const* const environment_filter_downsample_source = R"(
+uniform samplerCubeArray src;
+uniform float cube;
+uniform float lod;
+
+void main()
+{
+    ivec2 size = imageSize(dst);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y) return;
+
+    // the texel center lies between four texels of the finer level, bilinear filtering averages them
+    imageStore(dst, texel, textureLod(src, vec4(getDirection(texel, size.x), cube), lod));
+}
+)";
+
+        static char const* const environment_filter_specular_source = R"(
+uniform samplerCubeArray src;
+uniform float cube;
+uniform float roughness;
+uniform uint sample_cnt;
+uniform float texel_solid_angle; // of the finest radiance level
+uniform float max_lod;
+
+void main()
+{
+    ivec2 size = imageSize(dst);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y) return;
+
+    // view direction equals the normal, as usual for prefiltered environment maps
+    vec3 n = getDirection(texel, size.x);
+    mat3 frame = getTangentFrame(n);
+    float a2 = roughness * roughness * roughness * roughness;
+
+    vec3 sum = vec3(0.0);
+    float weight = 0.0;
+    for (uint i = 0u; i < sample_cnt; ++i)
+    {
+        vec2 xi = hammersley(i, sample_cnt);
+        float phi = 2.0 * pi * xi.x;
+        float cos_theta = sqrt((1.0 - xi.y) / (1.0 + (a2 - 1.0) * xi.y));
+        float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+        vec3 h = frame * vec3(sin_theta * cos(phi), sin_theta * sin(phi), cos_theta);
+        vec3 l = 2.0 * dot(n, h) * h - n;
+
+        float n_dot_l = dot(n, l);
+        if (n_dot_l <= 0.0) continue;
+
+        // pdf of l is D * n_dot_h / (4 * v_dot_h), which reduces to D / 4 for v = n
+        float denom = cos_theta * cos_theta * (a2 - 1.0) + 1.0;
+        float pdf = a2 / (pi * denom * denom) * 0.25;
+        float sample_solid_angle = 1.0 / (float(sample_cnt) * pdf);
+        float lod = clamp(0.5 * log2(sample_solid_angle / texel_solid_angle) + 1.0, 0.0, max_lod);
+
+        sum += textureLod(src, vec4(l, cube), lod).rgb * n_dot_l;
+        weight += n_dot_l;
+    }
+
+    imageStore(dst, texel, vec4(sum / max(weight, 1e-6), 1.0));
+}
+)";
+
+        static char const* const environment_filter_irradiance_source = R"(
+uniform samplerCubeArray src;
+uniform float cube;
+uniform uint sample_cnt;
+uniform float texel_solid_angle;
+uniform float max_lod;
+
+void main()
+{
+    ivec2 size = imageSize(dst);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= size.x || texel.y >= size.y) return;
+
+    vec3 n = getDirection(texel, size.x);
+    mat3 frame = getTangentFrame(n);
+
+    // cosine weighted samples, their plain average is the irradiance divided by pi
+    vec3 sum = vec3(0.0);
+    for (uint i = 0u; i < sample_cnt; ++i)
+    {
+        vec2 xi = hammersley(i, sample_cnt);
+        float phi = 2.0 * pi * xi.x;
+        float cos_theta = sqrt(1.0 - xi.y);
+        float sin_theta = sqrt(xi.y);
+        vec3 l = frame * vec3(sin_theta * cos(phi), sin_theta * sin(phi), cos_theta);
+
+        float pdf = max(cos_theta, 1e-4) / pi;
+        float sample_solid_angle = 1.0 / (float(sample_cnt) * pdf);
+        float lod = clamp(0.5 * log2(sample_solid_angle / texel_solid_angle) + 1.0, 0.0, max_lod);
+
+        sum += textureLod(src, vec4(l, cube), lod).rgb;
+    }
+
+    imageStore(dst, texel, vec4(sum / float(sample_cnt), 1.0));
+}
+)";
+    } // namespace detail
+
+    inline EnvironmentMapFilter::EnvironmentMapFilter(GLsizei             probe_cnt,
+                                                      GLsizei             size,
+                                                      GLsizei             specular_levels,
+                                                      GLsizei             irradiance_size,
+                                                      GLuint              sample_cnt,
+                                                      GLenum              internal_format,
+                                                      TextureCache const* cache)
+        : m_probe_cnt(probe_cnt),
+          m_size(size),
+          m_specular_levels(specular_levels),
+          m_irradiance_size(irradiance_size),
+          m_sample_cnt(sample_cnt),
+          m_internal_format(internal_format),
+          m_format(GL_RGBA),
+          m_type(GL_HALF_FLOAT),
+          m_cache(cache),
+          m_equirect_sampler("environment_filter_equirect",
+                             std::vector<std::pair<GLenum, GLint>>{{GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR},
+                                                                   {GL_TEXTURE_MAG_FILTER, GL_LINEAR},
+                                                                   {GL_TEXTURE_WRAP_S, GL_REPEAT},
+                                                                   {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE}}),
+          m_cube_sampler("environment_filter_cube",
+                         std::vector<std::pair<GLenum, GLint>>{{GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR},
+                                                               {GL_TEXTURE_MAG_FILTER, GL_LINEAR},
+                                                               {GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE},
+                                                               {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE},
+                                                               {GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE}})
+    {
+        char const* qualifier = nullptr;
+        switch (internal_format)
+        {
+        case GL_RGBA16F:
+            qualifier = "rgba16f";
+            break;
+        case GL_RGBA32F:
+            qualifier = "rgba32f";
+            m_type = GL_FLOAT;
+            break;
+        case GL_R11F_G11F_B10F:
+            qualifier = "r11f_g11f_b10f";
+            m_format = GL_RGB;
+            m_type = GL_UNSIGNED_INT_10F_11F_11F_REV;
+            break;
+        default:
+            throw TextureException("EnvironmentMapFilter::EnvironmentMapFilter - unsupported internal format " +
+                                   std::to_string(internal_format));
+        }
+
+        GLsizei radiance_levels = 1;
+        while ((size >> radiance_levels) > 0)
+        {
+            ++radiance_levels;
+        }
+
+        if (probe_cnt <= 0 || size <= 0 || (size & (size - 1)) != 0 || irradiance_size <= 0 || sample_cnt == 0 ||
+            specular_levels <= 0 || specular_levels > radiance_levels)
+        {
+            throw TextureException("EnvironmentMapFilter::EnvironmentMapFilter - invalid probe count, sizes, levels "
+                                   "or sample count");
+        }
+
+        m_radiance = std::make_unique<TextureCubemapArray>(
+            "environment_radiance", internal_format, size, size, probe_cnt * 6, m_format, m_type, radiance_levels,
+            nullptr);
+        m_specular = std::make_unique<TextureCubemapArray>(
+            "environment_specular", internal_format, size, size, probe_cnt * 6, m_format, m_type, specular_levels,
+            nullptr);
+        m_irradiance = std::make_unique<TextureCubemapArray>("environment_irradiance",
+                                                             internal_format,
+                                                             irradiance_size,
+                                                             irradiance_size,
+                                                             probe_cnt * 6,
+                                                             m_format,
+                                                             m_type,
+                                                             1,
+                                                             nullptr);
+
+        for (auto texture : {m_radiance.get(), m_specular.get(), m_irradiance.get()})
+        {
+            texture->texParameteri(GL_TEXTURE_MIN_FILTER,
+                                   texture->getLevels() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            texture->texParameteri(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        std::string common_source(detail::environment_filter_common_source);
+        common_source.replace(common_source.find("FORMAT"), 6, qualifier);
+
+        auto createProgram = [&common_source](char const* source) {
+            return std::make_unique<GLSLProgram>(
+                GLSLProgram::ShaderSourceList{{GLSLProgram::ShaderType::Compute, common_source + source}});
+        };
+        m_equirect_program = createProgram(detail::environment_filter_equirect_source);
+        m_downsample_program = createProgram(detail::environment_filter_downsample_source);
+        m_specular_program = createProgram(detail::environment_filter_specular_source);
+        m_irradiance_program = createProgram(detail::environment_filter_irradiance_source);
+    }
+
+    inline std::uint64_t EnvironmentMapFilter::computeKey(void const* source, size_t byte_size) const
+    {
+        std::string settings = "EnvironmentMapFilter 1 " + std::to_string(m_size) + " " +
+                               std::to_string(m_specular_levels) + " " + std::to_string(m_irradiance_size) + " " +
+                               std::to_string(m_sample_cnt) + " " + std::to_string(m_internal_format);
+        return TextureCache::computeKey(source, byte_size, settings);
+    }
+
+    inline bool EnvironmentMapFilter::loadCached(GLsizei probe, std::uint64_t key)
+    {
+        checkProbe(probe, "loadCached");
+        if (m_cache == nullptr)
+        {
+            return false;
+        }
+
+        std::unique_ptr<Texture> specular = m_cache->load("environment_specular_cached", key);
+        std::unique_ptr<Texture> irradiance = m_cache->load("environment_irradiance_cached", getIrradianceKey(key));
+
+        auto matches = [](std::unique_ptr<Texture> const& texture, TextureCubemapArray const& target) {
+            if (texture == nullptr || texture->getTarget() != GL_TEXTURE_CUBE_MAP_ARRAY)
+            {
+                return false;
+            }
+            TextureLayout layout = texture->getTextureLayout();
+            return layout.internal_format == static_cast<GLint>(target.getInternalFormat()) &&
+                   layout.width == static_cast<GLsizei>(target.getWidth()) && layout.depth == 6 &&
+                   layout.levels == target.getLevels();
+        };
+        if (!matches(specular, *m_specular) || !matches(irradiance, *m_irradiance))
+        {
+            return false;
+        }
+
+        std::vector<TextureCopyRegion> regions;
+        for (GLint level = 0; level < m_specular_levels; ++level)
+        {
+            GLsizei level_size = std::max(1, m_size >> level);
+            regions.push_back({level, 0, 0, 0, level, 0, 0, probe * 6, level_size, level_size, 6});
+        }
+        Texture::copy(*specular, *m_specular, regions);
+        Texture::copy(*irradiance,
+                      *m_irradiance,
+                      {{0, 0, 0, 0, 0, 0, 0, probe * 6, m_irradiance_size, m_irradiance_size, 6}});
+
+        auto isProbe = [probe](Job const& job) { return job.probe == probe; };
+        m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(), isProbe), m_jobs.end());
+
+        return true;
+    }
+
+    inline void EnvironmentMapFilter::setEquirectangular(GLsizei probe, Texture2D const& equirect, std::uint64_t key)
+    {
+        checkProbe(probe, "setEquirectangular");
+
+        // the image spans four faces horizontally
+        float lod = std::max(0.0f, std::log2(static_cast<float>(equirect.getWidth()) / (4.0f * m_size)));
+
+        m_equirect_program->use();
+        m_equirect_program->setUniform("equirect", 0);
+        m_equirect_program->setUniform("lod", lod);
+        glBindTextureUnit(0, equirect.getName());
+        m_equirect_sampler.bindSampler(0);
+
+        for (int face = 0; face < 6; ++face)
+        {
+            m_radiance->bindImage(0, 0, GL_FALSE, probe * 6 + face, GL_WRITE_ONLY);
+            m_equirect_program->setUniform("face", face);
+            dispatch(*m_equirect_program, m_size);
+        }
+
+        glBindSampler(0, 0);
+
+        invalidate(probe, key);
+    }
+
+    inline void EnvironmentMapFilter::invalidate(GLsizei probe, std::uint64_t key)
+    {
+        checkProbe(probe, "invalidate");
+
+        for (auto& job : m_jobs)
+        {
+            if (job.probe == probe)
+            {
+                job.face = -1;
+                job.key = key;
+                return;
+            }
+        }
+        m_jobs.push_back({probe, -1, key});
+    }
+
+    inline void EnvironmentMapFilter::update(GLuint face_budget)
+    {
+        for (GLuint i = 0; i < face_budget && !m_jobs.empty(); ++i)
+        {
+            Job& job = m_jobs.front();
+            if (job.face < 0)
+            {
+                updateRadianceMipmaps(job.probe);
+                job.face = 0;
+            }
+
+            filterFace(job.probe, job.face);
+
+            if (++job.face == 6)
+            {
+                Job done = job;
+                m_jobs.pop_front();
+                if (done.key != 0 && m_cache != nullptr)
+                {
+                    storeCached(done.probe, done.key);
+                }
+            }
+        }
+    }
+
+    inline bool EnvironmentMapFilter::isPending(GLsizei probe) const
+    {
+        return std::any_of(m_jobs.begin(), m_jobs.end(), [probe](Job const& job) { return job.probe == probe; });
+    }
+
+    inline size_t EnvironmentMapFilter::getPendingCount() const
+    {
+        return m_jobs.size();
+    }
+
+    inline TextureCubemapArray& EnvironmentMapFilter::getRadiance()
+    {
+        return *m_radiance;
+    }
+
+    inline TextureCubemapArray const& EnvironmentMapFilter::getSpecular() const
+    {
+        return *m_specular;
+    }
+
+    inline TextureCubemapArray const& EnvironmentMapFilter::getIrradiance() const
+    {
+        return *m_irradiance;
+    }
+
+    inline GLsizei EnvironmentMapFilter::getSpecularLevels() const
+    {
+        return m_specular_levels;
+    }
+
+    inline std::uint64_t EnvironmentMapFilter::getIrradianceKey(std::uint64_t key)
+    {
+        return TextureCache::hash("irradiance", 10, key);
+    }
+
+    inline void EnvironmentMapFilter::checkProbe(GLsizei probe, char const* function) const
+    {
+        if (probe < 0 || probe >= m_probe_cnt)
+        {
+            throw TextureException(std::string("EnvironmentMapFilter::") + function + " - invalid probe " +
+                                   std::to_string(probe));
+        }
+    }
+
+    inline void EnvironmentMapFilter::updateRadianceMipmaps(GLsizei probe)
+    {
+        // radiance written by setEquirectangular or by the application, read by texture fetches and copies
+        MemoryBarrierTracker::barrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+        m_downsample_program->use();
+        m_downsample_program->setUniform("src", 0);
+        m_downsample_program->setUniform("cube", static_cast<GLfloat>(probe));
+        glBindTextureUnit(0, m_radiance->getName());
+        m_cube_sampler.bindSampler(0);
+
+        for (GLint level = 1; level < m_radiance->getLevels(); ++level)
+        {
+            m_downsample_program->setUniform("lod", static_cast<GLfloat>(level - 1));
+            for (int face = 0; face < 6; ++face)
+            {
+                m_radiance->bindImage(0, level, GL_FALSE, probe * 6 + face, GL_WRITE_ONLY);
+                m_downsample_program->setUniform("face", face);
+                dispatch(*m_downsample_program, std::max(1, m_size >> level));
+            }
+            MemoryBarrierTracker::barrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+
+        glBindSampler(0, 0);
+    }
+
+    inline void EnvironmentMapFilter::filterFace(GLsizei probe, int face)
+    {
+        GLint layer = probe * 6 + face;
+
+        // roughness 0 is a plain copy of the radiance
+        Texture::copy(*m_radiance, *m_specular, {{0, 0, 0, layer, 0, 0, 0, layer, m_size, m_size, 1}});
+
+        GLfloat texel_solid_angle = 4.0f * 3.14159265358979f / (6.0f * m_size * m_size);
+        GLfloat max_lod = static_cast<GLfloat>(m_radiance->getLevels() - 1);
+
+        glBindTextureUnit(0, m_radiance->getName());
+        m_cube_sampler.bindSampler(0);
+
+        m_specular_program->use();
+        m_specular_program->setUniform("src", 0);
+        m_specular_program->setUniform("cube", static_cast<GLfloat>(probe));
+        m_specular_program->setUniform("face", face);
+        m_specular_program->setUniform("sample_cnt", m_sample_cnt);
+        m_specular_program->setUniform("texel_solid_angle", texel_solid_angle);
+        m_specular_program->setUniform("max_lod", max_lod);
+        for (GLint level = 1; level < m_specular_levels; ++level)
+        {
+            m_specular->bindImage(0, level, GL_FALSE, layer, GL_WRITE_ONLY);
+            m_specular_program->setUniform("roughness",
+                                           static_cast<GLfloat>(level) / static_cast<GLfloat>(m_specular_levels - 1));
+            dispatch(*m_specular_program, std::max(1, m_size >> level));
+        }
+
+        m_irradiance_program->use();
+        m_irradiance_program->setUniform("src", 0);
+        m_irradiance_program->setUniform("cube", static_cast<GLfloat>(probe));
+        m_irradiance_program->setUniform("face", face);
+        m_irradiance_program->setUniform("sample_cnt", m_sample_cnt);
+        m_irradiance_program->setUniform("texel_solid_angle", texel_solid_angle);
+        m_irradiance_program->setUniform("max_lod", max_lod);
+        m_irradiance->bindImage(0, 0, GL_FALSE, layer, GL_WRITE_ONLY);
+        dispatch(*m_irradiance_program, m_irradiance_size);
+
+        glBindSampler(0, 0);
+
+        MemoryBarrierTracker::barrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    inline void EnvironmentMapFilter::storeCached(GLsizei probe, std::uint64_t key) const
+    {
+        MemoryBarrierTracker::barrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+        GLint pack_alignment = 4;
+        glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        auto store = [this, probe](TextureCubemapArray const& texture, std::uint64_t entry_key) {
+            TextureLayout layout(static_cast<GLint>(m_internal_format),
+                                 texture.getWidth(),
+                                 texture.getHeigth(),
+                                 6,
+                                 m_format,
+                                 m_type,
+                                 texture.getLevels());
+
+            std::vector<std::vector<unsigned char>> data(layout.levels);
+            std::vector<TextureCache::LevelData>    levels(layout.levels);
+            for (GLint level = 0; level < layout.levels; ++level)
+            {
+                GLsizei level_size = std::max(1, layout.width >> level);
+                data[level].resize(trace::computeImageByteSize(m_format, m_type, level_size, level_size, 6));
+                glGetTextureSubImage(texture.getName(),
+                                     level,
+                                     0,
+                                     0,
+                                     probe * 6,
+                                     level_size,
+                                     level_size,
+                                     6,
+                                     m_format,
+                                     m_type,
+                                     static_cast<GLsizei>(data[level].size()),
+                                     data[level].data());
+                levels[level] = {data[level].data(), data[level].size()};
+            }
+
+            m_cache->store(entry_key, GL_TEXTURE_CUBE_MAP_ARRAY, layout, levels);
+        };
+
+        store(*m_specular, key);
+        store(*m_irradiance, getIrradianceKey(key));
+
+        glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+
+        auto err = glGetError();
+        if (err != GL_NO_ERROR)
+        {
+            throw TextureException("EnvironmentMapFilter::storeCached - probe " + std::to_string(probe) +
+                                   " - OpenGL error " + std::to_string(err));
+        }
+    }
+
+    inline void EnvironmentMapFilter::dispatch(GLSLProgram& program, GLsizei face_size)
+    {
+        GLuint group_cnt = static_cast<GLuint>((face_size + detail::environment_filter_group_size - 1) /
+                                               detail::environment_filter_group_size);
+        program.dispatchCompute(group_cnt, group_cnt);
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_ENVIRONMENTMAPFILTER_HPP
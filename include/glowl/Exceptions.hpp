@@ -26,6 +26,12 @@ namespace glowl
         std::string m_message;
     };
 
+    class AllocationException : public BaseException
+    {
+    public:
+        using BaseException::BaseException;
+    };
+
     class BufferObjectException : public BaseException
     {
     public:
@@ -9,13 +9,18 @@
 #define GLOWL_FRAMEBUFFEROBJECT_HPP
 
 /* Include system libraries */
+#include <algorithm>
+#include <initializer_list>
 #include <memory>
 #include <string>
 #include <vector>
 
 /* Include glowl files */
+#include "Context.hpp"
 #include "Exceptions.hpp"
+#include "NamePool.hpp"
 #include "Texture2D.hpp"
+#include "Trace.hpp"
 #include "glinclude.h"
 
 namespace glowl
@@ -34,14 +39,20 @@ namespace glowl
     class FramebufferObject
     {
     private:
-        /** Handle of the FBO */
-        GLuint m_handle;
+        /** Handles of the FBO, one per context since framebuffer objects are not shareable */
+        mutable PerContextObject m_handles;
         /** Colorbuffers attached to the FBO */
         std::vector<std::shared_ptr<Texture2D>> m_colorbuffers;
 
+        /** Layouts of the colorbuffers, kept to resize without rebuilding the parameter lists */
+        std::vector<TextureLayout> m_colorbuffer_layouts;
+
         /** Optional depth (and stencil) buffer texture */
         std::shared_ptr<Texture2D> m_depth_stencil;
 
+        /** Layout of the depth (and stencil) buffer texture */
+        TextureLayout m_depth_stencil_layout;
+
         //TODO additional Texture2DView for read access of stencil buffer
 
         /** Width of the framebuffer i.e. it's color attachments */
@@ -49,6 +60,11 @@ namespace glowl
         /** Height of the framebuffer i.e. it's color attachments */
         int m_height;
 
+        /** Width of the area that is rendered to, at most the width of the attachments */
+        int m_render_width;
+        /** Height of the area that is rendered to, at most the height of the attachments */
+        int m_render_height;
+
         /** List of all draw buffer targets (i.e. all color attachments) */
         std::vector<GLenum> m_drawBufs;
 
@@ -57,6 +73,12 @@ namespace glowl
 
         std::string m_log;
 
+        /** Returns the FBO handle of the current context, creating or updating it as needed */
+        GLuint getHandle() const;
+
+        /** (Re-)attaches all color and depth/stencil textures to the given FBO */
+        void attachTextures(GLuint handle) const;
+
     public:
 
         enum DepthStencilType {
@@ -87,6 +109,9 @@ namespace glowl
                           int                height,
                           DepthStencilType   depth_stencil_type = DEPTH24);
 
+        /**
+         * \brief Deletes the FBO of the current context, see releaseContext().
+         */
         ~FramebufferObject();
 
         /* Deleted copy constructor (C++11). Don't wanna go around copying objects with OpenGL handles. */
@@ -125,6 +150,12 @@ namespace glowl
         void bind(const std::vector<GLenum>& draw_buffers);
         void bind(std::vector<GLenum>&& draw_buffers);
 
+        /**
+         * \brief Bind this framebuffer object with a given set of draw buffers, without allocating
+         */
+        void bind(std::initializer_list<GLenum> draw_buffers);
+        void bind(GLenum const* draw_buffers, GLsizei draw_buffer_cnt);
+
         /**
          * \brief Bind the framebuffer to GL_READ_FRAMEBUFFER
          * \param index Set glReadBuffer to color attachment #index or 0, if index > #color attachments
@@ -160,6 +191,15 @@ namespace glowl
          */
         GLenum checkStatus(GLenum target) const;
 
+        /**
+         * \brief Deletes the FBO of the current context.
+         *
+         * Framebuffer objects are created lazily per context (see setCurrentContext) while the attached textures
+         * are shared. FBOs can only be deleted in their own context, thus call this with every additional context
+         * current before destroying the framebuffer object.
+         */
+        void releaseContext();
+
         /**
          * \brief Resize the framebuffer object, i.e. it's color attachments.
          * \note Might be a bit costly to use often.
@@ -168,6 +208,27 @@ namespace glowl
          */
         void resize(int new_width, int new_height);
 
+        /**
+         * \brief Restrict rendering to the lower left sub-area of the attachments, e.g. for dynamic resolution.
+         * Unlike resize(), this does not reallocate the attachments. Clamped to the attachment size.
+         */
+        void setRenderSize(int width, int height);
+
+        /**
+         * \brief Calls glViewport for the render area, see setRenderSize().
+         */
+        void applyViewport() const;
+
+        int getRenderWidth() const
+        {
+            return m_render_width;
+        }
+
+        int getRenderHeight() const
+        {
+            return m_render_height;
+        }
+
         /**
          * \brief Get the width of the framebuffer object's color attachments
          * \return Returns widths.
@@ -202,10 +263,8 @@ namespace glowl
     };
 
     inline FramebufferObject::FramebufferObject(int width, int height, DepthStencilType depth_stencil_type)
-        : m_width(width), m_height(height)
+        : m_width(width), m_height(height), m_render_width(width), m_render_height(height)
     {
-        glCreateFramebuffers(1, &m_handle);
-
         if (depth_stencil_type != FramebufferObject::DepthStencilType::NONE) {
             GLint  internal_format;
             GLenum format = GL_DEPTH_COMPONENT;
@@ -237,33 +296,23 @@ namespace glowl
                 break;
             }
 
-            TextureLayout depth_stencil_layout(internal_format,
-                                               m_width,
-                                               m_height,
-                                               1,
-                                               format,
-                                               type,
-                                               1,
-                                               {{GL_TEXTURE_MIN_FILTER, GL_NEAREST},
-                                                {GL_TEXTURE_MAG_FILTER, GL_NEAREST},
-                                                {GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE},
-                                                {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE}},
-                                               {});
-
-            m_depth_stencil = std::make_shared<Texture2D>("",depth_stencil_layout,nullptr);
-
-            if (depth_stencil_type == FramebufferObject::DepthStencilType::DEPTH24_STENCIL8 ||
-                depth_stencil_type == FramebufferObject::DepthStencilType::DEPTH32F_STENCIL8)
-            {
-                glNamedFramebufferTexture(m_handle, GL_DEPTH_STENCIL_ATTACHMENT, m_depth_stencil->getName(), 0);
-            }
-            else
-            {
-                glNamedFramebufferTexture(m_handle, GL_DEPTH_ATTACHMENT, m_depth_stencil->getName(), 0);
-            }
-
+            m_depth_stencil_layout = TextureLayout(internal_format,
+                                                   m_width,
+                                                   m_height,
+                                                   1,
+                                                   format,
+                                                   type,
+                                                   1,
+                                                   {{GL_TEXTURE_MIN_FILTER, GL_NEAREST},
+                                                    {GL_TEXTURE_MAG_FILTER, GL_NEAREST},
+                                                    {GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE},
+                                                    {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE}},
+                                                   {});
+
+            m_depth_stencil = std::make_shared<Texture2D>("",m_depth_stencil_layout,nullptr);
         }
-        
+
+        getHandle();
     }
 
     inline FramebufferObject::FramebufferObject(std::string const& debug_label,
@@ -275,14 +324,60 @@ namespace glowl
         m_debug_label = debug_label;
 #if _DEBUG
         glObjectLabel(
-            GL_FRAMEBUFFER, this->m_handle, static_cast<GLsizei>(m_debug_label.length()), m_debug_label.c_str());
+            GL_FRAMEBUFFER, getHandle(), static_cast<GLsizei>(m_debug_label.length()), m_debug_label.c_str());
 #endif
     }
 
     inline FramebufferObject::~FramebufferObject()
     {
         /* Delete framebuffer object */
-        glDeleteFramebuffers(1, &m_handle);
+        releaseContext();
+    }
+
+    inline GLuint FramebufferObject::getHandle() const
+    {
+        return m_handles.get(
+            [this]() {
+                GLuint handle = getNamePool(NameType::Framebuffer).acquire();
+                GLOWL_TRACE(Opcode::CreateFramebuffer, {handle});
+                attachTextures(handle);
+                return handle;
+            },
+            [this](GLuint handle) { attachTextures(handle); });
+    }
+
+    inline void FramebufferObject::attachTextures(GLuint handle) const
+    {
+        GLenum attachment_point = GL_COLOR_ATTACHMENT0;
+
+        for (auto& colorbuffer : m_colorbuffers)
+        {
+            GLOWL_TRACE(Opcode::NamedFramebufferTexture, {handle, attachment_point, colorbuffer->getName(), 0});
+            glNamedFramebufferTexture(handle, attachment_point++, colorbuffer->getName(), 0);
+        }
+
+        if (m_depth_stencil != nullptr)
+        {
+            GLenum depth_attachment = GL_DEPTH_ATTACHMENT;
+            if (m_depth_stencil->getInternalFormat() == GL_DEPTH24_STENCIL8 ||
+                m_depth_stencil->getInternalFormat() == GL_DEPTH32F_STENCIL8)
+            {
+                depth_attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+            }
+
+            GLOWL_TRACE(Opcode::NamedFramebufferTexture, {handle, depth_attachment, m_depth_stencil->getName(), 0});
+            glNamedFramebufferTexture(handle, depth_attachment, m_depth_stencil->getName(), 0);
+        }
+    }
+
+    inline void FramebufferObject::releaseContext()
+    {
+        GLuint handle = m_handles.release();
+        if (handle != 0)
+        {
+            GLOWL_TRACE(Opcode::DeleteFramebuffer, {handle});
+            getNamePool(NameType::Framebuffer).release(handle);
+        }
     }
 
     inline void FramebufferObject::createColorAttachment(GLenum internalFormat, GLenum format, GLenum type)
@@ -313,13 +408,15 @@ namespace glowl
                              {});
         m_colorbuffers.push_back(
             std::make_shared<Texture2D>(
-                "fbo_" + std::to_string(m_handle) + "_color_attachment_" +
+                "fbo_" + std::to_string(getHandle()) + "_color_attachment_" +
                 std::to_string(bufsSize),
                 color_attach_layout,
                 nullptr)
         );
+        m_colorbuffer_layouts.push_back(color_attach_layout);
 
-        glNamedFramebufferTexture(m_handle, GL_COLOR_ATTACHMENT0 + bufsSize, m_colorbuffers.back()->getName(), 0);
+        // attach new texture to the FBOs of all contexts on their next use
+        m_handles.invalidate();
 
         m_drawBufs.push_back(GL_COLOR_ATTACHMENT0 + bufsSize);
     }
@@ -336,45 +433,63 @@ namespace glowl
 
     inline void FramebufferObject::bind()
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_handle);
+        GLuint handle = getHandle();
+        GLOWL_TRACE(Opcode::BindFramebuffer, {GL_FRAMEBUFFER, handle});
+        GLOWL_TRACE(Opcode::DrawBuffers, std::vector<std::int64_t>(m_drawBufs.begin(), m_drawBufs.end()));
+
+        glBindFramebuffer(GL_FRAMEBUFFER, handle);
 
         glDrawBuffers(static_cast<unsigned int>(m_drawBufs.size()), m_drawBufs.data());
     }
 
     inline void FramebufferObject::bind(const std::vector<GLenum>& draw_buffers)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_handle);
-
-        glDrawBuffers(static_cast<unsigned int>(draw_buffers.size()), draw_buffers.data());
+        bind(draw_buffers.data(), static_cast<GLsizei>(draw_buffers.size()));
     }
 
     inline void FramebufferObject::bind(std::vector<GLenum>&& draw_buffers)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_handle);
+        bind(draw_buffers.data(), static_cast<GLsizei>(draw_buffers.size()));
+    }
+
+    inline void FramebufferObject::bind(std::initializer_list<GLenum> draw_buffers)
+    {
+        bind(draw_buffers.begin(), static_cast<GLsizei>(draw_buffers.size()));
+    }
+
+    inline void FramebufferObject::bind(GLenum const* draw_buffers, GLsizei draw_buffer_cnt)
+    {
+        GLuint handle = getHandle();
+        GLOWL_TRACE(Opcode::BindFramebuffer, {GL_FRAMEBUFFER, handle});
+        GLOWL_TRACE(Opcode::DrawBuffers, std::vector<std::int64_t>(draw_buffers, draw_buffers + draw_buffer_cnt));
 
-        glDrawBuffers(static_cast<unsigned int>(draw_buffers.size()), draw_buffers.data());
+        glBindFramebuffer(GL_FRAMEBUFFER, handle);
+
+        glDrawBuffers(draw_buffer_cnt, draw_buffers);
     }
 
     inline void FramebufferObject::bindToRead(unsigned int index)
     {
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, m_handle);
+        GLuint handle = getHandle();
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, handle);
         GLenum readBuffer;
         if (index < static_cast<unsigned int>(m_colorbuffers.size()))
             readBuffer = (GL_COLOR_ATTACHMENT0 + index);
 
+        GLOWL_TRACE(Opcode::BindFramebuffer, {GL_READ_FRAMEBUFFER, handle});
+        GLOWL_TRACE(Opcode::ReadBuffer, {readBuffer});
         glReadBuffer(readBuffer);
     }
 
     inline void FramebufferObject::bindToDraw()
     {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_handle);
-        unsigned int bufsSize = static_cast<unsigned int>(m_colorbuffers.size());
-        GLenum*      drawBufs = new GLenum[bufsSize];
-        for (GLuint i = 0; i < bufsSize; i++)
-        {
-            drawBufs[i] = (GL_COLOR_ATTACHMENT0 + i);
-        }
-        glDrawBuffers(bufsSize, drawBufs);
+        GLuint handle = getHandle();
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, handle);
+
+        // m_drawBufs holds GL_COLOR_ATTACHMENTi for all color attachments
+        GLOWL_TRACE(Opcode::BindFramebuffer, {GL_DRAW_FRAMEBUFFER, handle});
+        GLOWL_TRACE(Opcode::DrawBuffers, std::vector<std::int64_t>(m_drawBufs.begin(), m_drawBufs.end()));
+        glDrawBuffers(static_cast<GLsizei>(m_drawBufs.size()), m_drawBufs.data());
     }
 
     inline void FramebufferObject::bindColorbuffer(unsigned int index)
@@ -390,65 +505,48 @@ namespace glowl
 
     inline GLenum FramebufferObject::checkStatus(GLenum target) const
     {
-        return glCheckNamedFramebufferStatus(m_handle,GL_FRAMEBUFFER);
+        return glCheckNamedFramebufferStatus(getHandle(), GL_FRAMEBUFFER);
     }
 
     inline void FramebufferObject::resize(int new_width, int new_height)
     {
         m_width = new_width;
         m_height = new_height;
+        m_render_width = new_width;
+        m_render_height = new_height;
 
-        GLenum attachment_point = GL_COLOR_ATTACHMENT0;
-
-        for (auto& colorbuffer : m_colorbuffers)
+        // stored layouts are updated in place, so resizing does not rebuild the parameter lists
+        for (size_t i = 0; i < m_colorbuffers.size(); ++i)
         {
-            // TODO add more convienient method
-            TextureLayout color_attach_layout(colorbuffer->getInternalFormat(),
-                                              m_width,
-                                              m_height,
-                                              1,
-                                              colorbuffer->getFormat(),
-                                              colorbuffer->getType(),
-                                              1,
-                                              {{GL_TEXTURE_MIN_FILTER, GL_NEAREST},
-                                               {GL_TEXTURE_MAG_FILTER, GL_NEAREST},
-                                               {GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE},
-                                               {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE}},
-                                              {});
-
-            colorbuffer->reload(color_attach_layout, nullptr);
-
-            glNamedFramebufferTexture(m_handle, attachment_point++, colorbuffer->getName(), 0);
+            m_colorbuffer_layouts[i].width = m_width;
+            m_colorbuffer_layouts[i].height = m_height;
+
+            m_colorbuffers[i]->reload(m_colorbuffer_layouts[i], nullptr);
         }
 
         // resize depth buffer
         if (m_depth_stencil != nullptr)
         {
-            TextureLayout stencil_depth_layout(m_depth_stencil->getInternalFormat(),
-                                               m_width,
-                                               m_height,
-                                               1,
-                                               m_depth_stencil->getFormat(),
-                                               m_depth_stencil->getType(),
-                                               1,
-                                               {{GL_TEXTURE_MIN_FILTER, GL_NEAREST},
-                                                {GL_TEXTURE_MAG_FILTER, GL_NEAREST},
-                                                {GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE},
-                                                {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE}},
-                                               {});
-
-            m_depth_stencil->reload(stencil_depth_layout, nullptr);
+            m_depth_stencil_layout.width = m_width;
+            m_depth_stencil_layout.height = m_height;
 
-            if (m_depth_stencil->getInternalFormat() == GL_DEPTH24_STENCIL8 ||
-                m_depth_stencil->getInternalFormat() == GL_DEPTH32F_STENCIL8)
-            {
-                glNamedFramebufferTexture(m_handle, GL_DEPTH_STENCIL_ATTACHMENT, m_depth_stencil->getName(), 0);
-            }
-            else
-            {
-                glNamedFramebufferTexture(m_handle, GL_DEPTH_ATTACHMENT, m_depth_stencil->getName(), 0);
-            }
+            m_depth_stencil->reload(m_depth_stencil_layout, nullptr);
         }
+
+        // reloading recreates the textures, reattach them to the FBOs of all contexts on their next use
+        m_handles.invalidate();
+    }
+
+    inline void FramebufferObject::setRenderSize(int width, int height)
+    {
+        m_render_width = std::max(1, std::min(width, m_width));
+        m_render_height = std::max(1, std::min(height, m_height));
+    }
+
+    inline void FramebufferObject::applyViewport() const
+    {
+        GLOWL_TRACE(Opcode::Viewport, {0, 0, m_render_width, m_render_height});
+        glViewport(0, 0, m_render_width, m_render_height);
     }
 
 } // namespace glowl
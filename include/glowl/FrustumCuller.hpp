@@ -0,0 +1,538 @@
+/*
+ * FrustumCuller.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_FRUSTUMCULLER_HPP
+#define GLOWL_FRUSTUMCULLER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX__)
+#define GLOWL_CULL_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLOWL_CULL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace glowl
+{
+
+    namespace detail
+    {
+        namespace cull_simd
+        {
+#if defined(GLOWL_CULL_AVX)
+            using Float = __m256;
+            static constexpr size_t width = 8;
+
+            inline Float load(float const* p)
+            {
+                return _mm256_loadu_ps(p);
+            }
+            inline Float set1(float v)
+            {
+                return _mm256_set1_ps(v);
+            }
+            inline Float mul(Float a, Float b)
+            {
+                return _mm256_mul_ps(a, b);
+            }
+            inline Float add(Float a, Float b)
+            {
+                return _mm256_add_ps(a, b);
+            }
+            inline Float greaterEqual(Float a, Float b)
+            {
+                return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+            }
+            inline Float logicalAnd(Float a, Float b)
+            {
+                return _mm256_and_ps(a, b);
+            }
+            inline Float allTrue()
+            {
+                return _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            }
+            inline int mask(Float a)
+            {
+                return _mm256_movemask_ps(a);
+            }
+#elif defined(GLOWL_CULL_SSE2)
+            using Float = __m128;
+            static constexpr size_t width = 4;
+
+            inline Float load(float const* p)
+            {
+                return _mm_loadu_ps(p);
+            }
+            inline Float set1(float v)
+            {
+                return _mm_set1_ps(v);
+            }
+            inline Float mul(Float a, Float b)
+            {
+                return _mm_mul_ps(a, b);
+            }
+            inline Float add(Float a, Float b)
+            {
+                return _mm_add_ps(a, b);
+            }
+            inline Float greaterEqual(Float a, Float b)
+            {
+                return _mm_cmpge_ps(a, b);
+            }
+            inline Float logicalAnd(Float a, Float b)
+            {
+                return _mm_and_ps(a, b);
+            }
+            inline Float allTrue()
+            {
+                return _mm_castsi128_ps(_mm_set1_epi32(-1));
+            }
+            inline int mask(Float a)
+            {
+                return _mm_movemask_ps(a);
+            }
+#endif
+
+            /** Byte i of the result is bit i of the mask, i.e. a lane mask expanded to 0/1 bytes (little endian) */
+            inline std::uint64_t expandMask(int mask)
+            {
+                static std::array<std::uint64_t, 256> const table = []() {
+                    std::array<std::uint64_t, 256> bytes{};
+                    for (unsigned int m = 0; m < 256; ++m)
+                    {
+                        for (unsigned int k = 0; k < 8; ++k)
+                        {
+                            bytes[m] |= static_cast<std::uint64_t>((m >> k) & 1u) << (8 * k);
+                        }
+                    }
+                    return bytes;
+                }();
+                return table[static_cast<unsigned int>(mask) & 0xFFu];
+            }
+        } // namespace cull_simd
+    }     // namespace detail
+
+    /**
+     * \class FrustumCuller
+     *
+     * \brief Tests large arrays of bounding spheres or boxes against the six planes of a view frustum.
+     *
+     * Bounds are given in structure-of-arrays form (one array per coordinate) and tested with AVX (8 wide) or SSE2
+     * (4 wide), depending on the instruction sets enabled for the compilation. Large arrays are split into chunks
+     * that are processed in parallel by the calling thread and a set of worker threads owned by the culler.
+     *
+     * Culling is conservative: bounds that intersect the frustum are visible, bounds that are outside of one plane
+     * are culled.
+     */
+    class FrustumCuller
+    {
+    public:
+        /**
+         * \brief FrustumCuller constructor.
+         *
+         * \param thread_cnt Number of threads processing a cull call, including the calling thread.
+         * 0 uses the number of hardware threads.
+         */
+        FrustumCuller(unsigned int thread_cnt = 0);
+        ~FrustumCuller();
+        FrustumCuller(const FrustumCuller&) = delete;
+        FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+        /**
+         * \brief Extracts the frustum planes from a view projection matrix in OpenGL (column-major) layout,
+         * e.g. glm::value_ptr(projection * view).
+         */
+        void setFrustum(float const* view_projection);
+
+        /**
+         * \brief Sets the frustum planes directly, a point (x,y,z) is inside if a*x + b*y + c*z + d >= 0 for
+         * all planes (a,b,c,d). The plane normals (a,b,c) have to be normalized for sphere culling.
+         */
+        void setPlanes(float const planes[6][4]);
+
+        /**
+         * \brief Culls bounding spheres.
+         *
+         * \param visible Receives 1 for each visible and 0 for each culled sphere
+         * \return Number of visible spheres
+         */
+        size_t cullSpheres(float const*  x,
+                           float const*  y,
+                           float const*  z,
+                           float const*  radius,
+                           size_t        cnt,
+                           std::uint8_t* visible);
+
+        /**
+         * \brief Culls axis-aligned bounding boxes.
+         *
+         * \param visible Receives 1 for each visible and 0 for each culled box
+         * \return Number of visible boxes
+         */
+        size_t cullBoxes(float const*  min_x,
+                         float const*  min_y,
+                         float const*  min_z,
+                         float const*  max_x,
+                         float const*  max_y,
+                         float const*  max_z,
+                         size_t        cnt,
+                         std::uint8_t* visible);
+
+    private:
+        /** Elements per chunk, a multiple of all SIMD widths */
+        static constexpr size_t chunk_size = 16384;
+
+        struct SphereJob
+        {
+            float const*  x;
+            float const*  y;
+            float const*  z;
+            float const*  radius;
+            std::uint8_t* visible;
+        };
+
+        struct BoxJob
+        {
+            float const*  min[3];
+            float const*  max[3];
+            std::uint8_t* visible;
+        };
+
+        using Kernel = size_t (*)(float const (*planes)[4], void const* job, size_t begin, size_t end);
+
+        static size_t cullSpheresRange(float const (*planes)[4], void const* job, size_t begin, size_t end);
+        static size_t cullBoxesRange(float const (*planes)[4], void const* job, size_t begin, size_t end);
+
+        /** Runs the kernel over all chunks, on the calling thread and the workers */
+        size_t run(Kernel kernel, void const* job, size_t cnt);
+
+        /** Processes chunks of the current job until none are left */
+        void processChunks();
+
+        void work();
+
+        float m_planes[6][4];
+
+        std::vector<std::thread> m_workers;
+        std::mutex               m_mutex;
+        std::condition_variable  m_start_condition;
+        std::condition_variable  m_done_condition;
+        std::uint64_t            m_generation; ///< Incremented for every job handed to the workers
+        unsigned int             m_busy_cnt;   ///< Workers still processing the current job
+        bool                     m_stop;
+
+        Kernel              m_kernel;
+        void const*         m_job;
+        size_t              m_cnt;
+        std::atomic<size_t> m_next_chunk;
+        std::atomic<size_t> m_visible_cnt;
+    };
+
+    inline FrustumCuller::FrustumCuller(unsigned int thread_cnt)
+        : m_planes{},
+          m_generation(0),
+          m_busy_cnt(0),
+          m_stop(false),
+          m_kernel(nullptr),
+          m_job(nullptr),
+          m_cnt(0),
+          m_next_chunk(0),
+          m_visible_cnt(0)
+    {
+        if (thread_cnt == 0)
+        {
+            thread_cnt = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // everything is inside until a frustum is set
+        for (auto& plane : m_planes)
+        {
+            plane[3] = 1.0f;
+        }
+
+        for (unsigned int i = 1; i < thread_cnt; ++i)
+        {
+            m_workers.emplace_back(&FrustumCuller::work, this);
+        }
+    }
+
+    inline FrustumCuller::~FrustumCuller()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_start_condition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    inline void FrustumCuller::setFrustum(float const* view_projection)
+    {
+        auto row = [view_projection](int r, int c) { return view_projection[c * 4 + r]; };
+
+        // Gribb/Hartmann: left, right, bottom, top, near, far
+        for (int i = 0; i < 6; ++i)
+        {
+            int   axis = i / 2;
+            float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                m_planes[i][c] = row(3, c) + sign * row(axis, c);
+            }
+
+            float length = std::sqrt(m_planes[i][0] * m_planes[i][0] + m_planes[i][1] * m_planes[i][1] +
+                                     m_planes[i][2] * m_planes[i][2]);
+            if (length > 0.0f)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    m_planes[i][c] /= length;
+                }
+            }
+        }
+    }
+
+    inline void FrustumCuller::setPlanes(float const planes[6][4])
+    {
+        std::copy(&planes[0][0], &planes[0][0] + 24, &m_planes[0][0]);
+    }
+
+    inline size_t FrustumCuller::cullSpheres(float const*  x,
+                                             float const*  y,
+                                             float const*  z,
+                                             float const*  radius,
+                                             size_t        cnt,
+                                             std::uint8_t* visible)
+    {
+        SphereJob job{x, y, z, radius, visible};
+        return run(&FrustumCuller::cullSpheresRange, &job, cnt);
+    }
+
+    inline size_t FrustumCuller::cullBoxes(float const*  min_x,
+                                           float const*  min_y,
+                                           float const*  min_z,
+                                           float const*  max_x,
+                                           float const*  max_y,
+                                           float const*  max_z,
+                                           size_t        cnt,
+                                           std::uint8_t* visible)
+    {
+        BoxJob job{{min_x, min_y, min_z}, {max_x, max_y, max_z}, visible};
+        return run(&FrustumCuller::cullBoxesRange, &job, cnt);
+    }
+
+    inline size_t FrustumCuller::cullSpheresRange(float const (*planes)[4], void const* job, size_t begin, size_t end)
+    {
+        auto const& spheres = *static_cast<SphereJob const*>(job);
+
+        size_t visible_cnt = 0;
+        size_t i = begin;
+
+#if defined(GLOWL_CULL_AVX) || defined(GLOWL_CULL_SSE2)
+        namespace simd = detail::cull_simd;
+
+        simd::Float const zero = simd::set1(0.0f);
+        simd::Float       plane_v[6][4];
+        for (int p = 0; p < 6; ++p)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                plane_v[p][k] = simd::set1(planes[p][k]);
+            }
+        }
+
+        for (; i + simd::width <= end; i += simd::width)
+        {
+            simd::Float x = simd::load(spheres.x + i);
+            simd::Float y = simd::load(spheres.y + i);
+            simd::Float z = simd::load(spheres.z + i);
+            simd::Float r = simd::load(spheres.radius + i);
+
+            simd::Float inside = simd::allTrue();
+            for (int p = 0; p < 6; ++p)
+            {
+                simd::Float d = simd::add(
+                    simd::add(simd::add(simd::mul(plane_v[p][0], x), simd::mul(plane_v[p][1], y)),
+                              simd::mul(plane_v[p][2], z)),
+                    simd::add(plane_v[p][3], r));
+                inside = simd::logicalAnd(inside, simd::greaterEqual(d, zero));
+            }
+
+            int           mask = simd::mask(inside);
+            std::uint64_t bytes = simd::expandMask(mask);
+            std::memcpy(spheres.visible + i, &bytes, simd::width);
+            visible_cnt += std::bitset<simd::width>(static_cast<unsigned long long>(mask)).count();
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            bool inside = true;
+            for (int p = 0; p < 6; ++p)
+            {
+                float d = planes[p][0] * spheres.x[i] + planes[p][1] * spheres.y[i] + planes[p][2] * spheres.z[i] +
+                          (planes[p][3] + spheres.radius[i]);
+                inside &= d >= 0.0f;
+            }
+            spheres.visible[i] = inside ? 1 : 0;
+            visible_cnt += inside ? 1 : 0;
+        }
+
+        return visible_cnt;
+    }
+
+    inline size_t FrustumCuller::cullBoxesRange(float const (*planes)[4], void const* job, size_t begin, size_t end)
+    {
+        auto const& boxes = *static_cast<BoxJob const*>(job);
+
+        // per plane, the box corner furthest along the plane normal decides
+        float const* corner[6][3];
+        for (int p = 0; p < 6; ++p)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                corner[p][k] = planes[p][k] >= 0.0f ? boxes.max[k] : boxes.min[k];
+            }
+        }
+
+        size_t visible_cnt = 0;
+        size_t i = begin;
+
+#if defined(GLOWL_CULL_AVX) || defined(GLOWL_CULL_SSE2)
+        namespace simd = detail::cull_simd;
+
+        simd::Float const zero = simd::set1(0.0f);
+        simd::Float       plane_v[6][4];
+        for (int p = 0; p < 6; ++p)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                plane_v[p][k] = simd::set1(planes[p][k]);
+            }
+        }
+
+        for (; i + simd::width <= end; i += simd::width)
+        {
+            simd::Float inside = simd::allTrue();
+            for (int p = 0; p < 6; ++p)
+            {
+                simd::Float d = simd::add(simd::add(simd::add(simd::mul(plane_v[p][0], simd::load(corner[p][0] + i)),
+                                                              simd::mul(plane_v[p][1], simd::load(corner[p][1] + i))),
+                                                    simd::mul(plane_v[p][2], simd::load(corner[p][2] + i))),
+                                          plane_v[p][3]);
+                inside = simd::logicalAnd(inside, simd::greaterEqual(d, zero));
+            }
+
+            int           mask = simd::mask(inside);
+            std::uint64_t bytes = simd::expandMask(mask);
+            std::memcpy(boxes.visible + i, &bytes, simd::width);
+            visible_cnt += std::bitset<simd::width>(static_cast<unsigned long long>(mask)).count();
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            bool inside = true;
+            for (int p = 0; p < 6; ++p)
+            {
+                float d = planes[p][0] * corner[p][0][i] + planes[p][1] * corner[p][1][i] +
+                          planes[p][2] * corner[p][2][i] + planes[p][3];
+                inside &= d >= 0.0f;
+            }
+            boxes.visible[i] = inside ? 1 : 0;
+            visible_cnt += inside ? 1 : 0;
+        }
+
+        return visible_cnt;
+    }
+
+    inline size_t FrustumCuller::run(Kernel kernel, void const* job, size_t cnt)
+    {
+        // small arrays are not worth waking the workers
+        if (m_workers.empty() || cnt <= chunk_size)
+        {
+            return kernel(m_planes, job, 0, cnt);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_kernel = kernel;
+            m_job = job;
+            m_cnt = cnt;
+            m_next_chunk = 0;
+            m_visible_cnt = 0;
+            m_busy_cnt = static_cast<unsigned int>(m_workers.size());
+            ++m_generation;
+        }
+        m_start_condition.notify_all();
+
+        processChunks();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_condition.wait(lock, [this]() { return m_busy_cnt == 0; });
+
+        return m_visible_cnt;
+    }
+
+    inline void FrustumCuller::processChunks()
+    {
+        size_t visible_cnt = 0;
+
+        for (size_t chunk = m_next_chunk++; chunk * chunk_size < m_cnt; chunk = m_next_chunk++)
+        {
+            size_t begin = chunk * chunk_size;
+            visible_cnt += m_kernel(m_planes, m_job, begin, std::min(begin + chunk_size, m_cnt));
+        }
+
+        m_visible_cnt += visible_cnt;
+    }
+
+    inline void FrustumCuller::work()
+    {
+        std::uint64_t generation = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_start_condition.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+                if (m_stop)
+                {
+                    return;
+                }
+                generation = m_generation;
+            }
+
+            processChunks();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                --m_busy_cnt;
+            }
+            m_done_condition.notify_one();
+        }
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_FRUSTUMCULLER_HPP
@@ -8,6 +8,8 @@
 #ifndef GLOWL_GLSLPROGRAM_HPP
 #define GLOWL_GLSLPROGRAM_HPP
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -23,6 +25,7 @@
 #endif
 
 #include "Exceptions.hpp"
+#include "Trace.hpp"
 #include "glinclude.h"
 
 namespace glowl
@@ -81,6 +84,19 @@ namespace glowl
          */
         void use();
 
+        /**
+         * \brief Calls glDispatchCompute. The program has to be in use.
+         */
+        void dispatchCompute(GLuint num_groups_x, GLuint num_groups_y = 1, GLuint num_groups_z = 1);
+
+        /**
+         * \brief Dispatches group_cnt work groups, using the y dimension when the count exceeds the 65535 groups
+         * guaranteed per dimension. Shaders get the linear group index as
+         * gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x and have to skip indices beyond their range.
+         * Does nothing for a count of 0. The program has to be in use.
+         */
+        void dispatchComputeGroups(GLuint group_cnt);
+
         /**
          * \brief Returns the OpenGL handle of the program. Handle with care!
          */
@@ -138,6 +154,7 @@ namespace glowl
 
         /**
          * \brief Return the position of a uniform.
+         * Locations are cached per program, only the first lookup of a name after linking queries OpenGL.
          */
         GLint getUniformLocation(GLchar const* name);
 
@@ -176,11 +193,15 @@ namespace glowl
 
         GLuint      m_handle;      ///< OpenGL program handle
         std::string m_debug_label; ///< An optional label string that is used as glObjectLabel in debug.
+
+        /** Cached uniform locations, searched linearly since programs only have a few uniforms */
+        std::vector<std::pair<std::string, GLint>> m_uniform_locations;
     };
 
     inline GLSLProgram::GLSLProgram(ShaderSourceList const& shaderList)
     {
         m_handle = glCreateProgram();
+        GLOWL_TRACE(Opcode::CreateProgram, {m_handle});
 
         try
         {
@@ -201,6 +222,7 @@ namespace glowl
 
     inline GLSLProgram::~GLSLProgram()
     {
+        GLOWL_TRACE(Opcode::DeleteProgram, {m_handle});
         glDeleteProgram(m_handle);
     }
 
@@ -243,6 +265,7 @@ namespace glowl
 
         // Attach shader to program.
         glAttachShader(m_handle, shader);
+        GLOWL_TRACE(Opcode::ShaderSource, {m_handle, static_cast<GLenum>(shaderType)}, source);
 
         // Flag shader program for deletion. It will only be actually deleted after the program is deleted.
         glDeleteShader(shader);
@@ -250,7 +273,9 @@ namespace glowl
 
     inline void GLSLProgram::link()
     {
+        GLOWL_TRACE(Opcode::LinkProgram, {m_handle});
         glLinkProgram(m_handle);
+        m_uniform_locations.clear();
 
         GLint link_status = GL_FALSE;
         glGetProgramiv(m_handle, GL_LINK_STATUS, &link_status);
@@ -273,9 +298,27 @@ namespace glowl
 
     inline void GLSLProgram::use()
     {
+        GLOWL_TRACE(Opcode::UseProgram, {m_handle});
         glUseProgram(m_handle);
     }
 
+    inline void GLSLProgram::dispatchCompute(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z)
+    {
+        GLOWL_TRACE(Opcode::DispatchCompute, {num_groups_x, num_groups_y, num_groups_z});
+        glDispatchCompute(num_groups_x, num_groups_y, num_groups_z);
+    }
+
+    inline void GLSLProgram::dispatchComputeGroups(GLuint group_cnt)
+    {
+        if (group_cnt == 0)
+        {
+            return;
+        }
+
+        GLuint group_cnt_x = std::min<GLuint>(group_cnt, 65535);
+        dispatchCompute(group_cnt_x, (group_cnt + group_cnt_x - 1) / group_cnt_x);
+    }
+
     inline GLuint GLSLProgram::getHandle()
     {
         return m_handle;
@@ -283,6 +326,7 @@ namespace glowl
 
     inline void GLSLProgram::bindAttribLocation(GLuint location, GLchar const* name)
     {
+        GLOWL_TRACE(Opcode::BindAttribLocation, {m_handle, location}, std::string(name));
         glBindAttribLocation(m_handle, location, name);
         link(); // relink program to apply attrib location binding 
     }
@@ -290,6 +334,7 @@ namespace glowl
     inline void GLSLProgram::bindAttribLocations(std::vector<std::pair<GLuint, std::string>> const& location_name_pairs)
     {
         for (auto& location_name : location_name_pairs) {
+            GLOWL_TRACE(Opcode::BindAttribLocation, {m_handle, location_name.first}, location_name.second);
             glBindAttribLocation(m_handle, location_name.first, location_name.second.c_str());
         }
         link(); // relink program to apply attrib location binding 
@@ -297,6 +342,7 @@ namespace glowl
 
     inline void GLSLProgram::bindFragDataLocation(GLuint location, char const* name)
     {
+        GLOWL_TRACE(Opcode::BindFragDataLocation, {m_handle, location}, std::string(name));
         glBindFragDataLocation(m_handle, location, name);
         link(); // relink program to apply frag data location binding 
     }
@@ -305,6 +351,7 @@ namespace glowl
     {
         for (auto& location_name : location_name_pairs)
         {
+            GLOWL_TRACE(Opcode::BindFragDataLocation, {m_handle, location_name.first}, location_name.second);
             glBindFragDataLocation(m_handle, location_name.first, location_name.second.c_str());
         }
         link(); // relink program to apply frag data location binding 
@@ -312,114 +359,145 @@ namespace glowl
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLfloat v0)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformFloat, {v0}));
         glUniform1f(getUniformLocation(name), v0);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLfloat v0, GLfloat v1)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformFloat, {v0, v1}));
         glUniform2f(getUniformLocation(name), v0, v1);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLfloat v0, GLfloat v1, GLfloat v2)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformFloat, {v0, v1, v2}));
         glUniform3f(getUniformLocation(name), v0, v1, v2);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformFloat, {v0, v1, v2, v3}));
         glUniform4f(getUniformLocation(name), v0, v1, v2, v3);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLint v0)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformInt, {v0}));
         glUniform1i(getUniformLocation(name), v0);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLint v0, GLint v1)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformInt, {v0, v1}));
         glUniform2i(getUniformLocation(name), v0, v1);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLint v0, GLint v1, GLint v2)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformInt, {v0, v1, v2}));
         glUniform3i(getUniformLocation(name), v0, v1, v2);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLint v0, GLint v1, GLint v2, GLint v3)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformInt, {v0, v1, v2, v3}));
         glUniform4i(getUniformLocation(name), v0, v1, v2, v3);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLuint v0)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformUInt, {v0}));
         glUniform1ui(getUniformLocation(name), v0);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLuint v0, GLuint v1)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformUInt, {v0, v1}));
         glUniform2ui(getUniformLocation(name), v0, v1);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLuint v0, GLuint v1, GLuint v2)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformUInt, {v0, v1, v2}));
         glUniform3ui(getUniformLocation(name), v0, v1, v2);
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, GLuint v0, GLuint v1, GLuint v2, GLuint v3)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformUInt, {v0, v1, v2, v3}));
         glUniform4ui(getUniformLocation(name), v0, v1, v2, v3);
     }
 
 #if GLOWL_USE_GLM
     inline void GLSLProgram::setUniform(GLchar const* name, glm::vec2 const& v)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformFloat, glm::value_ptr(v), 2));
         glUniform2fv(getUniformLocation(name), 1, glm::value_ptr(v));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::vec3 const& v)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformFloat, glm::value_ptr(v), 3));
         glUniform3fv(getUniformLocation(name), 1, glm::value_ptr(v));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::vec4 const& v)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformFloat, glm::value_ptr(v), 4));
         glUniform4fv(getUniformLocation(name), 1, glm::value_ptr(v));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::ivec2 const& v)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformInt, glm::value_ptr(v), 2));
         glUniform2iv(getUniformLocation(name), 1, glm::value_ptr(v));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::ivec3 const& v)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformInt, glm::value_ptr(v), 3));
         glUniform3iv(getUniformLocation(name), 1, glm::value_ptr(v));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::ivec4 const& v)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformInt, glm::value_ptr(v), 4));
         glUniform4iv(getUniformLocation(name), 1, glm::value_ptr(v));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::mat2 const& m)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformMatrix2, glm::value_ptr(m), 4));
         glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(m));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::mat3 const& m)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformMatrix3, glm::value_ptr(m), 9));
         glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(m));
     }
 
     inline void GLSLProgram::setUniform(GLchar const* name, glm::mat4 const& m)
     {
+        GLOWL_TRACE_CALL(trace::traceUniform(m_handle, name, trace::UniformMatrix4, glm::value_ptr(m), 16));
         glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, glm::value_ptr(m));
     }
 #endif
 
     inline GLint GLSLProgram::getUniformLocation(GLchar const* name)
     {
-        return glGetUniformLocation(m_handle, name);
+        for (auto const& uniform : m_uniform_locations)
+        {
+            if (std::strcmp(uniform.first.c_str(), name) == 0)
+            {
+                return uniform.second;
+            }
+        }
+
+        GLint location = glGetUniformLocation(m_handle, name);
+        m_uniform_locations.emplace_back(name, location);
+        return location;
     }
 
     inline std::string GLSLProgram::getActiveUniforms()
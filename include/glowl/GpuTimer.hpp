@@ -0,0 +1,158 @@
+/*
+ * GpuTimer.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_GPUTIMER_HPP
+#define GLOWL_GPUTIMER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class GpuTimer
+     *
+     * \brief Measures GPU execution time of command ranges with timestamp queries, without ever waiting for results.
+     *
+     * Up to latency measurements can be in flight. Results are fetched in order with poll() once the GPU has
+     * finished them, usually a few frames later. If all query pairs are still in flight, begin() skips the
+     * measurement instead of stalling.
+     */
+    class GpuTimer
+    {
+    public:
+        /**
+         * \brief GpuTimer constructor.
+         *
+         * \param latency Maximum number of measurements in flight
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        GpuTimer(unsigned int latency = 4);
+        ~GpuTimer();
+        GpuTimer(const GpuTimer&) = delete;
+        GpuTimer& operator=(const GpuTimer&) = delete;
+
+        /**
+         * \brief Starts a measurement.
+         *
+         * \param sequence Set to the sequence number of the measurement, as reported by poll()
+         * \return False if the measurement was skipped, end() then does nothing.
+         */
+        bool begin(std::uint64_t& sequence);
+        bool begin();
+
+        void end();
+
+        /**
+         * \brief Fetches the oldest finished measurement, if any.
+         */
+        bool poll(std::uint64_t& sequence, double& milliseconds);
+
+        bool poll(double& milliseconds);
+
+    private:
+        unsigned int        m_latency;
+        std::vector<GLuint> m_queries;  ///< Pairs of start and end timestamp queries
+        std::uint64_t       m_begun;    ///< Measurements started so far
+        std::uint64_t       m_finished; ///< Measurements fetched by poll() so far
+        bool                m_active;
+    };
+
+    inline GpuTimer::GpuTimer(unsigned int latency)
+        : m_latency(latency), m_queries(static_cast<size_t>(latency) * 2), m_begun(0), m_finished(0), m_active(false)
+    {
+        if (m_latency == 0)
+        {
+            throw BaseException("GpuTimer::GpuTimer - latency has to be at least 1");
+        }
+
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(m_queries.size()), m_queries.data());
+    }
+
+    inline GpuTimer::~GpuTimer()
+    {
+        glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+    }
+
+    inline bool GpuTimer::begin(std::uint64_t& sequence)
+    {
+        if (m_begun - m_finished == m_latency)
+        {
+            m_active = false;
+            return false;
+        }
+
+        sequence = m_begun;
+        m_active = true;
+
+        glQueryCounter(m_queries[(m_begun % m_latency) * 2], GL_TIMESTAMP);
+
+        return true;
+    }
+
+    inline bool GpuTimer::begin()
+    {
+        std::uint64_t sequence;
+        return begin(sequence);
+    }
+
+    inline void GpuTimer::end()
+    {
+        if (!m_active)
+        {
+            return;
+        }
+
+        glQueryCounter(m_queries[(m_begun % m_latency) * 2 + 1], GL_TIMESTAMP);
+
+        m_active = false;
+        ++m_begun;
+    }
+
+    inline bool GpuTimer::poll(std::uint64_t& sequence, double& milliseconds)
+    {
+        if (m_finished == m_begun)
+        {
+            return false;
+        }
+
+        GLuint end_query = m_queries[(m_finished % m_latency) * 2 + 1];
+
+        // queries complete in order, the end timestamp being available implies the start is as well
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+        {
+            return false;
+        }
+
+        GLuint64 start_time = 0;
+        GLuint64 end_time = 0;
+        glGetQueryObjectui64v(m_queries[(m_finished % m_latency) * 2], GL_QUERY_RESULT, &start_time);
+        glGetQueryObjectui64v(end_query, GL_QUERY_RESULT, &end_time);
+
+        sequence = m_finished;
+        milliseconds = static_cast<double>(end_time - start_time) * 1.0e-6;
+
+        ++m_finished;
+
+        return true;
+    }
+
+    inline bool GpuTimer::poll(double& milliseconds)
+    {
+        std::uint64_t sequence;
+        return poll(sequence, milliseconds);
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_GPUTIMER_HPP
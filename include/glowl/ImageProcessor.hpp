@@ -0,0 +1,1122 @@
+/*
+ * ImageProcessor.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_IMAGEPROCESSOR_HPP
+#define GLOWL_IMAGEPROCESSOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BufferObject.hpp"
+#include "Exceptions.hpp"
+#include "GLSLProgram.hpp"
+#include "MemoryBarrierTracker.hpp"
+#include "Texture2D.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class ImageFilterChain
+     *
+     * \brief Describes a sequence of image filters, executed by ImageProcessor::apply().
+     *
+     * Neighborhood filters (convolutions, morphology, gradients) need one pass each per dimension, point-wise
+     * filters are fused into the load of the first pass or the store of the preceding pass and never need a pass or
+     * an intermediate texture of their own. Borders are handled by clamping to the edge.
+     */
+    class ImageFilterChain
+    {
+    public:
+        enum class Channel
+        {
+            Red,
+            Green,
+            Blue,
+            Alpha,
+            Luminance ///< Rec. 709 luminance of the rgb channels
+        };
+
+        /** Largest radius of a neighborhood filter, limited by the shared memory of the tiled passes */
+        static constexpr int max_radius = 32;
+
+        /**
+         * \brief Separable convolution with a horizontal and a vertical kernel of odd length, centered on the texel.
+         */
+        ImageFilterChain& convolve(std::vector<float> const& horizontal, std::vector<float> const& vertical);
+
+        /**
+         * \brief Gaussian blur, the kernel is cut off at three standard deviations.
+         */
+        ImageFilterChain& gaussian(float sigma);
+
+        ImageFilterChain& box(int radius);
+
+        /**
+         * \brief Minimum (erode) or maximum (dilate) of every channel over a square of (2 * radius + 1) texels.
+         */
+        ImageFilterChain& erode(int radius);
+        ImageFilterChain& dilate(int radius);
+
+        /**
+         * \brief Sobel gradient magnitude of the rgb channels in units per texel, alpha is kept.
+         */
+        ImageFilterChain& gradient();
+
+        /**
+         * \brief Custom point-wise filter. The GLSL statements modify "vec4 value" and can read the parameters as
+         * "vec4 params", e.g. "value.rgb = mix(value.rgb, vec3(dot(value.rgb, vec3(1.0 / 3.0))), params.x);".
+         */
+        ImageFilterChain& map(std::string const& source,
+                              float              param0 = 0.0f,
+                              float              param1 = 0.0f,
+                              float              param2 = 0.0f,
+                              float              param3 = 0.0f);
+
+        ImageFilterChain& scaleBias(float scale, float bias);
+
+        /** Every channel becomes 1 if it is at least the threshold, 0 otherwise */
+        ImageFilterChain& threshold(float threshold);
+
+        ImageFilterChain& gamma(float gamma);
+
+        /** Reinhard tone mapping of the rgb channels */
+        ImageFilterChain& toneMap(float exposure);
+
+        /**
+         * \brief Histogram equalization with a table computed by ImageProcessor::equalizationTable(). The channel
+         * and range have to match the histogram. For the luminance, the rgb channels are scaled.
+         *
+         * \param table Buffer that has to stay alive until the chain was applied
+         */
+        ImageFilterChain&
+        equalize(BufferObject const& table, GLuint bin_cnt, float min, float max, Channel channel = Channel::Luminance);
+
+    private:
+        friend class ImageProcessor;
+
+        struct Stage
+        {
+            enum Type
+            {
+                Convolution,
+                Erosion,
+                Dilation,
+                Gradient,
+                Pointwise
+            };
+
+            Type                type;
+            std::vector<float>  horizontal;
+            std::vector<float>  vertical;
+            std::string         source; ///< GLSL statements of point-wise stages, TABLE names the table buffer
+            float               params[4];
+            BufferObject const* table;
+        };
+
+        ImageFilterChain& addMorphology(Stage::Type type, int radius, char const* function);
+
+        ImageFilterChain& addPointwise(std::string const& source,
+                                       float              param0,
+                                       float              param1,
+                                       float              param2,
+                                       float              param3,
+                                       BufferObject const* table = nullptr);
+
+        std::vector<Stage> m_stages;
+    };
+
+    /**
+     * \class ImageProcessor
+     *
+     * \brief Compute shader image processing on Texture2D: filter chains, histograms and reductions.
+     *
+     * Separable filters run as a horizontal and a vertical pass that load their tile of the image including the
+     * filter radius into shared memory once, so every texel is fetched about once per pass regardless of the radius.
+     * Intermediate results between passes are kept in two textures of the target format that are reused across
+     * calls. Programs are generated per chain structure and cached, filter weights and parameters are uniforms, so
+     * changing them does not recompile.
+     *
+     * Histograms and reductions use a bounded number of work groups that iterate over the image and combine their
+     * results in shared memory before touching global memory.
+     */
+    class ImageProcessor
+    {
+    public:
+        /** Largest number of histogram bins, limited by shared memory */
+        static constexpr GLuint max_bin_cnt = 4096;
+
+        /**
+         * \param barrier_tracker Optional tracker that reads of inputs and writes of outputs are reported to.
+         * Without one, each operation issues the barriers for its results itself.
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        ImageProcessor(MemoryBarrierTracker* barrier_tracker = nullptr);
+        ImageProcessor(const ImageProcessor&) = delete;
+        ImageProcessor& operator=(const ImageProcessor&) = delete;
+
+        /**
+         * \brief Applies a filter chain. Source and target have the same size and are different textures, the target
+         * format has to support image stores (e.g. GL_R8, GL_R32F, GL_RGBA8, GL_RGBA16F, ...).
+         */
+        void apply(ImageFilterChain const& chain, Texture2D const& source, Texture2D const& target);
+
+        /**
+         * \brief Counts the texels per bin of a channel into bin_cnt GLuints of the buffer. Values outside of
+         * [min, max] are counted in the first or last bin.
+         */
+        void histogram(Texture2D const&         source,
+                       BufferObject const&      bins,
+                       GLuint                   bin_cnt,
+                       float                    min,
+                       float                    max,
+                       ImageFilterChain::Channel channel = ImageFilterChain::Channel::Luminance);
+
+        /**
+         * \brief Computes the equalization table of a histogram, bin_cnt floats in [0, 1].
+         */
+        void equalizationTable(BufferObject const& bins, BufferObject const& table, GLuint bin_cnt);
+
+        /**
+         * \brief Computes the minimum, maximum and sum of every channel, stored as three vec4 in the buffer.
+         */
+        void reduce(Texture2D const& source, BufferObject const& result);
+
+    private:
+        struct Pass
+        {
+            enum Kind
+            {
+                Pointwise,
+                Horizontal,
+                Vertical,
+                Gradient
+            };
+
+            Kind                             kind;
+            ImageFilterChain::Stage const*   stage; ///< Neighborhood stage of the pass, if any
+            std::vector<float> const*        weights;
+            std::vector<ImageFilterChain::Stage const*> pre;
+            std::vector<ImageFilterChain::Stage const*> post;
+        };
+
+        /** Work groups of the histogram and reduction kernels */
+        static constexpr GLuint max_group_cnt = 1024;
+
+        static std::vector<Pass> createPasses(ImageFilterChain const& chain);
+
+        static std::string createPassSource(Pass const& pass, char const* qualifier);
+
+        static char const* getImageFormatQualifier(GLenum internal_format);
+
+        GLSLProgram& getProgram(std::string const& source);
+
+        /** Returns the intermediate texture of the index, (re-)created for the layout if necessary */
+        Texture2D const& getIntermediate(int index, TextureLayout const& layout);
+
+        static GLuint getGroupCount(Texture2D const& source);
+
+        /** Returns the uniform name of an array element, built once and kept in names */
+        static GLchar const* getElementName(std::vector<std::string>& names, char const* array, size_t index);
+
+        std::unordered_map<std::string, std::unique_ptr<GLSLProgram>> m_programs;
+
+        std::vector<std::string> m_stage_param_names;
+        std::vector<std::string> m_weight_names;
+
+        std::unique_ptr<Texture2D>    m_intermediates[2];
+        std::unique_ptr<BufferObject> m_partials; ///< Per work group results of the reduction
+
+        MemoryBarrierTracker* m_barrier_tracker;
+    };
+
+    namespace detail
+    {
+        static char const* const image_processor_separable_source = R"(
+vec4 combine(int first)
+{
+#if defined(OP_MIN)
+    vec4 value = tile[first];
+    for (int k = 1; k <= 2 * RADIUS; ++k) value = min(value, tile[first + k * TAP_STRIDE]);
+#elif defined(OP_MAX)
+    vec4 value = tile[first];
+    for (int k = 1; k <= 2 * RADIUS; ++k) value = max(value, tile[first + k * TAP_STRIDE]);
+#else
+    vec4 value = tile[first] * weights[0];
+    for (int k = 1; k <= 2 * RADIUS; ++k) value += tile[first + k * TAP_STRIDE] * weights[k];
+#endif
+    return value;
+}
+)";
+
+        static char const* const image_processor_horizontal_source = R"(
+// one row segment of 256 texels per work group
+shared vec4 tile[256 + 2 * RADIUS];
+uniform int row_offset; // images higher than the group count limit take several dispatches
+#define TAP_STRIDE 1
+COMBINE
+void main()
+{
+    int x0 = int(gl_WorkGroupID.x) * 256;
+    int y = row_offset + int(gl_WorkGroupID.y);
+    int lx = int(gl_LocalInvocationID.x);
+
+    for (int i = lx; i < 256 + 2 * RADIUS; i += 256)
+    {
+        tile[i] = pre(fetch(ivec2(x0 - RADIUS + i, y)));
+    }
+    barrier();
+
+    if (x0 + lx < size.x) imageStore(dst, ivec2(x0 + lx, y), post(combine(lx)));
+}
+)";
+
+        static char const* const image_processor_vertical_source = R"(
+// 16 columns of 64 texels per work group, the tile takes 32 kB of shared memory at the maximum radius of 32
+shared vec4 tile[(64 + 2 * RADIUS) * 16];
+#define TAP_STRIDE 16
+COMBINE
+void main()
+{
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * ivec2(16, 64);
+    int lx = int(gl_LocalInvocationID.x);
+    int ly = int(gl_LocalInvocationID.y);
+
+    for (int row = ly; row < 64 + 2 * RADIUS; row += 16)
+    {
+        tile[row * 16 + lx] = pre(fetch(origin + ivec2(lx, row - RADIUS)));
+    }
+    barrier();
+
+    for (int row = ly; row < 64; row += 16)
+    {
+        ivec2 p = origin + ivec2(lx, row);
+        if (p.x < size.x && p.y < size.y) imageStore(dst, p, post(combine(row * 16 + lx)));
+    }
+}
+)";
+
+        static char const* const image_processor_gradient_source = R"(
+// 16 x 16 texels per work group plus a border of one texel
+shared vec4 tile[18 * 18];
+
+void main()
+{
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * 16;
+    for (int i = int(gl_LocalInvocationIndex); i < 18 * 18; i += 256)
+    {
+        tile[i] = pre(fetch(origin + ivec2(i % 18, i / 18) - 1));
+    }
+    barrier();
+
+    ivec2 l = ivec2(gl_LocalInvocationID.xy);
+    ivec2 p = origin + l;
+    if (p.x >= size.x || p.y >= size.y) return;
+
+    int c = (l.y + 1) * 18 + l.x + 1;
+    vec4 gx = tile[c - 17] + 2.0 * tile[c + 1] + tile[c + 19] - tile[c - 19] - 2.0 * tile[c - 1] - tile[c + 17];
+    vec4 gy = tile[c + 17] + 2.0 * tile[c + 18] + tile[c + 19] - tile[c - 19] - 2.0 * tile[c - 18] - tile[c - 17];
+    vec4 value = vec4(sqrt(gx.rgb * gx.rgb + gy.rgb * gy.rgb) * 0.125, tile[c].a);
+    imageStore(dst, p, post(value));
+}
+)";
+
+        static char const* const image_processor_pointwise_source = R"(
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (p.x >= size.x || p.y >= size.y) return;
+    imageStore(dst, p, post(pre(fetch(p))));
+}
+)";
+
+        static char const* const image_processor_histogram_source = R"(
+#version 450
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) buffer BinBuffer { uint bins[]; };
+
+uniform sampler2D src;
+uniform ivec2 size;
+uniform int channel;
+uniform vec2 range;
+
+shared uint local_bins[BIN_CNT];
+
+void main()
+{
+    for (uint i = gl_LocalInvocationID.x; i < BIN_CNT; i += 256u) local_bins[i] = 0u;
+    barrier();
+
+    uint texel_cnt = uint(size.x) * uint(size.y);
+    uint stride = gl_NumWorkGroups.x * 256u;
+    for (uint i = gl_GlobalInvocationID.x; i < texel_cnt; i += stride)
+    {
+        vec4 texel = texelFetch(src, ivec2(i % uint(size.x), i / uint(size.x)), 0);
+        float value = channel == 4 ? dot(texel.rgb, vec3(0.2126, 0.7152, 0.0722)) : texel[channel];
+        int bin = clamp(int((value - range.x) / (range.y - range.x) * float(BIN_CNT)), 0, BIN_CNT - 1);
+        atomicAdd(local_bins[bin], 1u);
+    }
+    barrier();
+
+    for (uint i = gl_LocalInvocationID.x; i < BIN_CNT; i += 256u)
+    {
+        if (local_bins[i] != 0u) atomicAdd(bins[i], local_bins[i]);
+    }
+}
+)";
+
+        static char const* const image_processor_equalization_source = R"(
+#version 450
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly buffer BinBuffer { uint bins[]; };
+layout(std430, binding = 1) writeonly buffer TableBuffer { float table[]; };
+
+uniform uint bin_cnt;
+
+shared uint sums[256];
+shared uint first_used_bin;
+
+void main()
+{
+    uint lx = gl_LocalInvocationID.x;
+    uint chunk = (bin_cnt + 255u) / 256u;
+    uint first = min(lx * chunk, bin_cnt);
+    uint last = min(first + chunk, bin_cnt);
+
+    if (lx == 0u) first_used_bin = bin_cnt;
+    barrier();
+
+    uint sum = 0u;
+    for (uint i = first; i < last; ++i)
+    {
+        if (bins[i] != 0u && sum == 0u) atomicMin(first_used_bin, i);
+        sum += bins[i];
+    }
+    sums[lx] = sum;
+    barrier();
+
+    // inclusive prefix sum over the chunks
+    for (uint offset = 1u; offset < 256u; offset <<= 1u)
+    {
+        uint value = lx >= offset ? sums[lx - offset] : 0u;
+        barrier();
+        sums[lx] += value;
+        barrier();
+    }
+
+    // the classic mapping (cdf - cdf_min) / (total - cdf_min), the first used bin maps to 0
+    float total = float(sums[255]);
+    float cdf_min = first_used_bin < bin_cnt ? float(bins[first_used_bin]) : 0.0;
+    float scale = total > cdf_min ? 1.0 / (total - cdf_min) : 0.0;
+
+    uint cdf = sums[lx] - sum;
+    for (uint i = first; i < last; ++i)
+    {
+        cdf += bins[i];
+        table[i] = max(float(cdf) - cdf_min, 0.0) * scale;
+    }
+}
+)";
+
+        static char const* const image_processor_reduction_source = R"(
+#version 450
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) buffer PartialBuffer { vec4 partials[]; }; // minimum, maximum and sum per work group
+layout(std430, binding = 1) writeonly buffer ResultBuffer { vec4 result[]; };
+
+uniform sampler2D src;
+uniform ivec2 size;
+uniform uint partial_cnt;
+
+shared vec4 minima[256];
+shared vec4 maxima[256];
+shared vec4 sums[256];
+
+void main()
+{
+    uint lx = gl_LocalInvocationID.x;
+    vec4 minimum = vec4(3.402823e38);
+    vec4 maximum = vec4(-3.402823e38);
+    vec4 sum = vec4(0.0);
+
+#ifdef FINAL_PASS
+    for (uint i = lx; i < partial_cnt; i += 256u)
+    {
+        minimum = min(minimum, partials[3u * i]);
+        maximum = max(maximum, partials[3u * i + 1u]);
+        sum += partials[3u * i + 2u];
+    }
+#else
+    uint texel_cnt = uint(size.x) * uint(size.y);
+    uint stride = gl_NumWorkGroups.x * 256u;
+    for (uint i = gl_GlobalInvocationID.x; i < texel_cnt; i += stride)
+    {
+        vec4 texel = texelFetch(src, ivec2(i % uint(size.x), i / uint(size.x)), 0);
+        minimum = min(minimum, texel);
+        maximum = max(maximum, texel);
+        sum += texel;
+    }
+#endif
+
+    minima[lx] = minimum;
+    maxima[lx] = maximum;
+    sums[lx] = sum;
+    barrier();
+
+    for (uint offset = 128u; offset > 0u; offset >>= 1u)
+    {
+        if (lx < offset)
+        {
+            minima[lx] = min(minima[lx], minima[lx + offset]);
+            maxima[lx] = max(maxima[lx], maxima[lx + offset]);
+            sums[lx] += sums[lx + offset];
+        }
+        barrier();
+    }
+
+    if (lx == 0u)
+    {
+#ifdef FINAL_PASS
+        result[0] = minima[0];
+        result[1] = maxima[0];
+        result[2] = sums[0];
+#else
+        partials[3u * gl_WorkGroupID.x] = minima[0];
+        partials[3u * gl_WorkGroupID.x + 1u] = maxima[0];
+        partials[3u * gl_WorkGroupID.x + 2u] = sums[0];
+#endif
+    }
+}
+)";
+    } // namespace detail
+
+    inline ImageFilterChain& ImageFilterChain::convolve(std::vector<float> const& horizontal,
+                                                        std::vector<float> const& vertical)
+    {
+        auto checkKernel = [](std::vector<float> const& kernel) {
+            if (kernel.size() % 2 == 0 || kernel.size() > 2 * max_radius + 1)
+            {
+                throw BaseException("ImageFilterChain::convolve - kernel of " + std::to_string(kernel.size()) +
+                                    " taps, expected an odd number up to " + std::to_string(2 * max_radius + 1));
+            }
+        };
+        checkKernel(horizontal);
+        checkKernel(vertical);
+
+        m_stages.push_back({Stage::Convolution, horizontal, vertical, {}, {}, nullptr});
+        return *this;
+    }
+
+    inline ImageFilterChain& ImageFilterChain::gaussian(float sigma)
+    {
+        int const radius_limit = max_radius;
+        int       radius = std::min(static_cast<int>(std::ceil(3.0f * sigma)), radius_limit);
+        if (sigma <= 0.0f)
+        {
+            throw BaseException("ImageFilterChain::gaussian - sigma has to be positive");
+        }
+
+        std::vector<float> kernel(2 * radius + 1);
+        float              sum = 0.0f;
+        for (int i = -radius; i <= radius; ++i)
+        {
+            kernel[i + radius] = std::exp(-0.5f * i * i / (sigma * sigma));
+            sum += kernel[i + radius];
+        }
+        for (auto& weight : kernel)
+        {
+            weight /= sum;
+        }
+
+        return convolve(kernel, kernel);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::box(int radius)
+    {
+        if (radius < 0)
+        {
+            throw BaseException("ImageFilterChain::box - negative radius");
+        }
+        std::vector<float> kernel(2 * radius + 1, 1.0f / (2 * radius + 1));
+        return convolve(kernel, kernel);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::erode(int radius)
+    {
+        return addMorphology(Stage::Erosion, radius, "erode");
+    }
+
+    inline ImageFilterChain& ImageFilterChain::dilate(int radius)
+    {
+        return addMorphology(Stage::Dilation, radius, "dilate");
+    }
+
+    inline ImageFilterChain& ImageFilterChain::gradient()
+    {
+        m_stages.push_back({Stage::Gradient, {}, {}, {}, {}, nullptr});
+        return *this;
+    }
+
+    inline ImageFilterChain&
+    ImageFilterChain::map(std::string const& source, float param0, float param1, float param2, float param3)
+    {
+        return addPointwise(source, param0, param1, param2, param3);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::scaleBias(float scale, float bias)
+    {
+        return addPointwise("value = value * params.x + params.y;", scale, bias, 0.0f, 0.0f);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::threshold(float threshold)
+    {
+        return addPointwise("value = step(vec4(params.x), value);", threshold, 0.0f, 0.0f, 0.0f);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::gamma(float gamma)
+    {
+        return addPointwise("value.rgb = pow(max(value.rgb, vec3(0.0)), vec3(params.x));", gamma, 0.0f, 0.0f, 0.0f);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::toneMap(float exposure)
+    {
+        return addPointwise("value.rgb *= params.x; value.rgb /= vec3(1.0) + value.rgb;", exposure, 0.0f, 0.0f, 0.0f);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::equalize(
+        BufferObject const& table, GLuint bin_cnt, float min, float max, Channel channel)
+    {
+        // params: range minimum, range size, bin count
+        std::string lookup =
+            "TABLE[clamp(int((v - params.x) / params.y * params.z), 0, int(params.z) - 1)] * params.y + params.x";
+        std::string source;
+        if (channel == Channel::Luminance)
+        {
+            source = "float v = dot(value.rgb, vec3(0.2126, 0.7152, 0.0722)); float equalized = " + lookup +
+                     "; value.rgb = v > 0.0 ? value.rgb * (equalized / v) : vec3(equalized);";
+        }
+        else
+        {
+            char const* const components[] = {"value.r", "value.g", "value.b", "value.a"};
+            std::string       component = components[static_cast<int>(channel)];
+            source = "float v = " + component + "; " + component + " = " + lookup + ";";
+        }
+
+        return addPointwise(source, min, max - min, static_cast<float>(bin_cnt), 0.0f, &table);
+    }
+
+    inline ImageFilterChain& ImageFilterChain::addMorphology(Stage::Type type, int radius, char const* function)
+    {
+        if (radius < 0 || radius > max_radius)
+        {
+            throw BaseException(std::string("ImageFilterChain::") + function + " - radius " + std::to_string(radius) +
+                                " out of range");
+        }
+
+        // only the tap count matters for morphology
+        std::vector<float> taps(2 * radius + 1, 1.0f);
+        m_stages.push_back({type, taps, taps, {}, {}, nullptr});
+        return *this;
+    }
+
+    inline ImageFilterChain& ImageFilterChain::addPointwise(std::string const&  source,
+                                                            float               param0,
+                                                            float               param1,
+                                                            float               param2,
+                                                            float               param3,
+                                                            BufferObject const* table)
+    {
+        m_stages.push_back({Stage::Pointwise, {}, {}, source, {param0, param1, param2, param3}, table});
+        return *this;
+    }
+
+    inline ImageProcessor::ImageProcessor(MemoryBarrierTracker* barrier_tracker)
+        : m_partials(std::make_unique<BufferObject>(
+              GL_SHADER_STORAGE_BUFFER,
+              static_cast<GLvoid const*>(nullptr),
+              static_cast<GLsizeiptr>(max_group_cnt * 3 * 4 * sizeof(GLfloat)))),
+          m_barrier_tracker(barrier_tracker)
+    {
+    }
+
+    inline void ImageProcessor::apply(ImageFilterChain const& chain, Texture2D const& source, Texture2D const& target)
+    {
+        if (source.getWidth() != target.getWidth() || source.getHeight() != target.getHeight() ||
+            source.getName() == target.getName())
+        {
+            throw TextureException("ImageProcessor::apply - texture ids: " + source.getId() + "," + target.getId() +
+                                   " - expected different textures of the same size");
+        }
+
+        char const* qualifier = getImageFormatQualifier(target.getInternalFormat());
+        if (qualifier == nullptr)
+        {
+            throw TextureException("ImageProcessor::apply - texture id: " + target.getId() +
+                                   " - internal format does not support image stores");
+        }
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->read(source, MemoryBarrierTracker::Read::TextureFetch);
+            m_barrier_tracker->read(target, MemoryBarrierTracker::Read::ImageAccess);
+            m_barrier_tracker->flush();
+        }
+
+        std::vector<Pass> passes = createPasses(chain);
+
+        TextureLayout intermediate_layout(target.getInternalFormat(),
+                                          target.getWidth(),
+                                          target.getHeight(),
+                                          1,
+                                          target.getFormat(),
+                                          target.getType(),
+                                          1);
+
+        GLint width = static_cast<GLint>(target.getWidth());
+        GLint height = static_cast<GLint>(target.getHeight());
+
+        for (size_t i = 0; i < passes.size(); ++i)
+        {
+            Pass const& pass = passes[i];
+            bool        last = i + 1 == passes.size();
+
+            Texture const& input = i == 0 ? static_cast<Texture const&>(source)
+                                          : getIntermediate(static_cast<int>((i - 1) % 2), intermediate_layout);
+            Texture const& output = last ? static_cast<Texture const&>(target)
+                                         : getIntermediate(static_cast<int>(i % 2), intermediate_layout);
+
+            GLSLProgram& program = getProgram(createPassSource(pass, qualifier));
+            program.use();
+            program.setUniform("src", 0);
+            program.setUniform("size", width, height);
+
+            GLuint stage_idx = 0;
+            for (auto const* stages : {&pass.pre, &pass.post})
+            {
+                for (auto const* stage : *stages)
+                {
+                    program.setUniform(getElementName(m_stage_param_names, "stage_params", stage_idx),
+                                       stage->params[0],
+                                       stage->params[1],
+                                       stage->params[2],
+                                       stage->params[3]);
+                    if (stage->table != nullptr)
+                    {
+                        stage->table->bindAs(GL_SHADER_STORAGE_BUFFER, 1 + stage_idx);
+                    }
+                    ++stage_idx;
+                }
+            }
+
+            if (pass.weights != nullptr && pass.stage->type == ImageFilterChain::Stage::Convolution)
+            {
+                for (size_t k = 0; k < pass.weights->size(); ++k)
+                {
+                    program.setUniform(getElementName(m_weight_names, "weights", k), (*pass.weights)[k]);
+                }
+            }
+
+            glBindTextureUnit(0, input.getName());
+            output.bindImage(0, 0, GL_FALSE, 0, GL_WRITE_ONLY);
+
+            switch (pass.kind)
+            {
+            case Pass::Horizontal:
+                // one work group per row segment, the group count along y is limited to 65535
+                for (GLint row_offset = 0; row_offset < height; row_offset += 65535)
+                {
+                    program.setUniform("row_offset", row_offset);
+                    program.dispatchCompute((width + 255) / 256, std::min(height - row_offset, 65535));
+                }
+                break;
+            case Pass::Vertical:
+                program.dispatchCompute((width + 15) / 16, (height + 63) / 64);
+                break;
+            default:
+                program.dispatchCompute((width + 15) / 16, (height + 15) / 16);
+                break;
+            }
+
+            if (!last)
+            {
+                MemoryBarrierTracker::barrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            }
+        }
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->write(target, MemoryBarrierTracker::Write::ImageStore);
+        }
+        else
+        {
+            MemoryBarrierTracker::barrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                                          GL_TEXTURE_UPDATE_BARRIER_BIT);
+        }
+    }
+
+    inline void ImageProcessor::histogram(Texture2D const&          source,
+                                          BufferObject const&       bins,
+                                          GLuint                    bin_cnt,
+                                          float                     min,
+                                          float                     max,
+                                          ImageFilterChain::Channel channel)
+    {
+        if (bin_cnt == 0 || bin_cnt > max_bin_cnt ||
+            bins.getByteSize() < static_cast<GLsizeiptr>(bin_cnt * sizeof(GLuint)) || !(max > min))
+        {
+            throw BufferObjectException("ImageProcessor::histogram - invalid bin count, buffer size or range");
+        }
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->read(source, MemoryBarrierTracker::Read::TextureFetch);
+            m_barrier_tracker->read(bins, MemoryBarrierTracker::Read::BufferUpdate);
+            m_barrier_tracker->flush();
+        }
+
+        bins.bufferSubData(std::vector<GLuint>(bin_cnt, 0));
+
+        std::string source_code(detail::image_processor_histogram_source);
+        source_code.insert(source_code.find('\n', 1) + 1, "#define BIN_CNT " + std::to_string(bin_cnt) + "\n");
+
+        GLSLProgram& program = getProgram(source_code);
+        program.use();
+        program.setUniform("src", 0);
+        program.setUniform("size", static_cast<GLint>(source.getWidth()), static_cast<GLint>(source.getHeight()));
+        program.setUniform("channel", static_cast<GLint>(channel));
+        program.setUniform("range", min, max);
+
+        glBindTextureUnit(0, source.getName());
+        bins.bindAs(GL_SHADER_STORAGE_BUFFER, 0);
+        program.dispatchCompute(getGroupCount(source));
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->write(bins, MemoryBarrierTracker::Write::ShaderStorage);
+        }
+        else
+        {
+            MemoryBarrierTracker::barrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        }
+    }
+
+    inline void ImageProcessor::equalizationTable(BufferObject const& bins, BufferObject const& table, GLuint bin_cnt)
+    {
+        if (bin_cnt == 0 || bins.getByteSize() < static_cast<GLsizeiptr>(bin_cnt * sizeof(GLuint)) ||
+            table.getByteSize() < static_cast<GLsizeiptr>(bin_cnt * sizeof(GLfloat)))
+        {
+            throw BufferObjectException("ImageProcessor::equalizationTable - invalid bin count or buffer size");
+        }
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->read(bins, MemoryBarrierTracker::Read::ShaderStorage);
+            m_barrier_tracker->read(table, MemoryBarrierTracker::Read::ShaderStorage);
+            m_barrier_tracker->flush();
+        }
+
+        GLSLProgram& program = getProgram(detail::image_processor_equalization_source);
+        program.use();
+        program.setUniform("bin_cnt", bin_cnt);
+
+        bins.bindAs(GL_SHADER_STORAGE_BUFFER, 0);
+        table.bindAs(GL_SHADER_STORAGE_BUFFER, 1);
+        program.dispatchCompute(1);
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->write(table, MemoryBarrierTracker::Write::ShaderStorage);
+        }
+        else
+        {
+            MemoryBarrierTracker::barrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        }
+    }
+
+    inline void ImageProcessor::reduce(Texture2D const& source, BufferObject const& result)
+    {
+        if (result.getByteSize() < static_cast<GLsizeiptr>(3 * 4 * sizeof(GLfloat)))
+        {
+            throw BufferObjectException("ImageProcessor::reduce - result buffer smaller than three vec4");
+        }
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->read(source, MemoryBarrierTracker::Read::TextureFetch);
+            m_barrier_tracker->read(result, MemoryBarrierTracker::Read::ShaderStorage);
+            m_barrier_tracker->flush();
+        }
+
+        std::string final_source(detail::image_processor_reduction_source);
+        final_source.insert(final_source.find('\n', 1) + 1, "#define FINAL_PASS\n");
+
+        GLuint group_cnt = getGroupCount(source);
+
+        GLSLProgram& partial_program = getProgram(detail::image_processor_reduction_source);
+        partial_program.use();
+        partial_program.setUniform("src", 0);
+        partial_program.setUniform(
+            "size", static_cast<GLint>(source.getWidth()), static_cast<GLint>(source.getHeight()));
+
+        glBindTextureUnit(0, source.getName());
+        m_partials->bindAs(GL_SHADER_STORAGE_BUFFER, 0);
+        result.bindAs(GL_SHADER_STORAGE_BUFFER, 1);
+        partial_program.dispatchCompute(group_cnt);
+
+        MemoryBarrierTracker::barrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        GLSLProgram& final_program = getProgram(final_source);
+        final_program.use();
+        final_program.setUniform("partial_cnt", group_cnt);
+        final_program.dispatchCompute(1);
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->write(result, MemoryBarrierTracker::Write::ShaderStorage);
+        }
+        else
+        {
+            MemoryBarrierTracker::barrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+        }
+    }
+
+    inline std::vector<ImageProcessor::Pass> ImageProcessor::createPasses(ImageFilterChain const& chain)
+    {
+        using Stage = ImageFilterChain::Stage;
+
+        std::vector<Pass>           passes;
+        std::vector<Stage const*>   leading; ///< Point-wise stages before the first pass
+        for (auto const& stage : chain.m_stages)
+        {
+            if (stage.type == Stage::Pointwise)
+            {
+                if (passes.empty())
+                {
+                    leading.push_back(&stage);
+                }
+                else
+                {
+                    passes.back().post.push_back(&stage);
+                }
+                continue;
+            }
+
+            if (stage.type == Stage::Gradient)
+            {
+                passes.push_back({Pass::Gradient, &stage, nullptr, {}, {}});
+            }
+            else
+            {
+                // a single tap of weight 1 (or any single tap for morphology) leaves the image unchanged
+                auto isIdentity = [&stage](std::vector<float> const& kernel) {
+                    return kernel.size() == 1 && (stage.type != Stage::Convolution || kernel[0] == 1.0f);
+                };
+                if (!isIdentity(stage.horizontal))
+                {
+                    passes.push_back({Pass::Horizontal, &stage, &stage.horizontal, {}, {}});
+                }
+                if (!isIdentity(stage.vertical))
+                {
+                    passes.push_back({Pass::Vertical, &stage, &stage.vertical, {}, {}});
+                }
+            }
+
+            if (!passes.empty() && !leading.empty())
+            {
+                passes.front().pre = leading;
+                leading.clear();
+            }
+        }
+
+        if (passes.empty())
+        {
+            passes.push_back({Pass::Pointwise, nullptr, nullptr, leading, {}});
+        }
+
+        return passes;
+    }
+
+    inline std::string ImageProcessor::createPassSource(Pass const& pass, char const* qualifier)
+    {
+        std::string source = "#version 450\n";
+        source += pass.kind == Pass::Horizontal ? "layout(local_size_x = 256) in;\n"
+                                                : "layout(local_size_x = 16, local_size_y = 16) in;\n";
+        source += "layout(" + std::string(qualifier) + ", binding = 0) writeonly uniform image2D dst;\n";
+        source += "uniform sampler2D src;\nuniform ivec2 size;\n";
+
+        size_t stage_cnt = pass.pre.size() + pass.post.size();
+        if (stage_cnt > 0)
+        {
+            source += "uniform vec4 stage_params[" + std::to_string(stage_cnt) + "];\n";
+        }
+
+        if (pass.weights != nullptr)
+        {
+            source += "#define RADIUS " + std::to_string(pass.weights->size() / 2) + "\n";
+            if (pass.stage->type == ImageFilterChain::Stage::Erosion)
+            {
+                source += "#define OP_MIN\n";
+            }
+            else if (pass.stage->type == ImageFilterChain::Stage::Dilation)
+            {
+                source += "#define OP_MAX\n";
+            }
+            else
+            {
+                source += "uniform float weights[" + std::to_string(pass.weights->size()) + "];\n";
+            }
+        }
+
+        source += "vec4 fetch(ivec2 p) { return texelFetch(src, clamp(p, ivec2(0), size - 1), 0); }\n";
+
+        size_t stage_idx = 0;
+        auto   addFunction = [&source, &stage_idx](char const* name,
+                                                 std::vector<ImageFilterChain::Stage const*> const& stages) {
+            std::string body;
+            for (auto const* stage : stages)
+            {
+                // table buffers are bound after the target image, see apply()
+                std::string index = std::to_string(stage_idx);
+                std::string binding = std::to_string(1 + stage_idx);
+                std::string statements = stage->source;
+                ++stage_idx;
+                if (stage->table != nullptr)
+                {
+                    source += "layout(std430, binding = " + binding + ") readonly buffer TableBuffer" + binding +
+                              " { float table_" + binding + "[]; };\n";
+                    for (size_t pos = statements.find("TABLE"); pos != std::string::npos;
+                         pos = statements.find("TABLE", pos))
+                    {
+                        statements.replace(pos, 5, "table_" + binding);
+                    }
+                }
+                body += "    {\n        vec4 params = stage_params[" + index + "];\n        " + statements +
+                        "\n    }\n";
+            }
+            source += std::string("vec4 ") + name + "(vec4 value)\n{\n" + body + "    return value;\n}\n";
+        };
+        addFunction("pre", pass.pre);
+        addFunction("post", pass.post);
+
+        std::string body;
+        switch (pass.kind)
+        {
+        case Pass::Horizontal:
+            body = detail::image_processor_horizontal_source;
+            break;
+        case Pass::Vertical:
+            body = detail::image_processor_vertical_source;
+            break;
+        case Pass::Gradient:
+            body = detail::image_processor_gradient_source;
+            break;
+        default:
+            body = detail::image_processor_pointwise_source;
+            break;
+        }
+
+        size_t combine_pos = body.find("COMBINE");
+        if (combine_pos != std::string::npos)
+        {
+            body.replace(combine_pos, 7, detail::image_processor_separable_source);
+        }
+
+        return source + body;
+    }
+
+    inline char const* ImageProcessor::getImageFormatQualifier(GLenum internal_format)
+    {
+        switch (internal_format)
+        {
+        case GL_R8:
+            return "r8";
+        case GL_R16:
+            return "r16";
+        case GL_R16F:
+            return "r16f";
+        case GL_R32F:
+            return "r32f";
+        case GL_RG8:
+            return "rg8";
+        case GL_RG16:
+            return "rg16";
+        case GL_RG16F:
+            return "rg16f";
+        case GL_RG32F:
+            return "rg32f";
+        case GL_RGBA8:
+            return "rgba8";
+        case GL_RGBA16:
+            return "rgba16";
+        case GL_RGBA16F:
+            return "rgba16f";
+        case GL_RGBA32F:
+            return "rgba32f";
+        case GL_R11F_G11F_B10F:
+            return "r11f_g11f_b10f";
+        case GL_RGB10_A2:
+            return "rgb10_a2";
+        default:
+            return nullptr;
+        }
+    }
+
+    inline GLSLProgram& ImageProcessor::getProgram(std::string const& source)
+    {
+        auto& program = m_programs[source];
+        if (program == nullptr)
+        {
+            program = std::make_unique<GLSLProgram>(
+                GLSLProgram::ShaderSourceList{{GLSLProgram::ShaderType::Compute, source}});
+        }
+        return *program;
+    }
+
+    inline Texture2D const& ImageProcessor::getIntermediate(int index, TextureLayout const& layout)
+    {
+        auto& texture = m_intermediates[index];
+        if (texture == nullptr || texture->getInternalFormat() != static_cast<GLenum>(layout.internal_format) ||
+            texture->getWidth() != static_cast<unsigned int>(layout.width) ||
+            texture->getHeight() != static_cast<unsigned int>(layout.height))
+        {
+            texture =
+                std::make_unique<Texture2D>("image_processor_intermediate_" + std::to_string(index), layout, nullptr);
+        }
+        return *texture;
+    }
+
+    inline GLchar const* ImageProcessor::getElementName(std::vector<std::string>& names,
+                                                        char const*               array,
+                                                        size_t                    index)
+    {
+        while (names.size() <= index)
+        {
+            names.push_back(std::string(array) + "[" + std::to_string(names.size()) + "]");
+        }
+        return names[index].c_str();
+    }
+
+    inline GLuint ImageProcessor::getGroupCount(Texture2D const& source)
+    {
+        std::uint64_t texel_cnt = static_cast<std::uint64_t>(source.getWidth()) * source.getHeight();
+        std::uint64_t const group_limit = max_group_cnt;
+        return static_cast<GLuint>(std::max<std::uint64_t>(1, std::min(group_limit, (texel_cnt + 255) / 256)));
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_IMAGEPROCESSOR_HPP
@@ -0,0 +1,166 @@
+/*
+ * MappedFile.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_MAPPEDFILE_HPP
+#define GLOWL_MAPPEDFILE_HPP
+
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Exceptions.hpp"
+
+namespace glowl
+{
+
+    namespace detail
+    {
+        /**
+         * \class MappedFile
+         *
+         * \brief Read-only memory mapping of a whole file.
+         */
+        class MappedFile
+        {
+        public:
+            explicit MappedFile(std::string const& path);
+            ~MappedFile();
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            unsigned char const* getData() const;
+            size_t               getByteSize() const;
+
+            /**
+             * \brief Ask the OS to read the given byte range ahead of its first access.
+             */
+            void prefetch(size_t byte_offset, size_t byte_size) const;
+
+        private:
+            unsigned char const* m_data;
+            size_t               m_byte_size;
+#ifdef _WIN32
+            HANDLE m_file;
+            HANDLE m_mapping;
+#endif
+        };
+
+#ifdef _WIN32
+        inline MappedFile::MappedFile(std::string const& path)
+            : m_data(nullptr), m_byte_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+        {
+            m_file = CreateFileA(path.c_str(),
+                                 GENERIC_READ,
+                                 FILE_SHARE_READ,
+                                 nullptr,
+                                 OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                                 nullptr);
+            LARGE_INTEGER file_size;
+            if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &file_size))
+            {
+                if (m_file != INVALID_HANDLE_VALUE)
+                {
+                    CloseHandle(m_file);
+                }
+                throw BaseException("MappedFile::MappedFile - cannot open " + path);
+            }
+            m_byte_size = static_cast<size_t>(file_size.QuadPart);
+
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping != nullptr)
+            {
+                m_data = static_cast<unsigned char const*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+            if (m_data == nullptr)
+            {
+                if (m_mapping != nullptr)
+                {
+                    CloseHandle(m_mapping);
+                }
+                CloseHandle(m_file);
+                throw BaseException("MappedFile::MappedFile - cannot map " + path);
+            }
+        }
+
+        inline MappedFile::~MappedFile()
+        {
+            UnmapViewOfFile(m_data);
+            CloseHandle(m_mapping);
+            CloseHandle(m_file);
+        }
+
+        inline void MappedFile::prefetch(size_t byte_offset, size_t byte_size) const
+        {
+            // read-ahead is left to FILE_FLAG_SEQUENTIAL_SCAN
+            (void)byte_offset;
+            (void)byte_size;
+        }
+#else
+        inline MappedFile::MappedFile(std::string const& path) : m_data(nullptr), m_byte_size(0)
+        {
+            int         fd = open(path.c_str(), O_RDONLY);
+            struct stat file_stat;
+            if (fd < 0 || fstat(fd, &file_stat) != 0)
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                throw BaseException("MappedFile::MappedFile - cannot open " + path);
+            }
+            m_byte_size = static_cast<size_t>(file_stat.st_size);
+
+            void* data = m_byte_size > 0 ? mmap(nullptr, m_byte_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+            close(fd);
+
+            if (data == MAP_FAILED)
+            {
+                throw BaseException("MappedFile::MappedFile - cannot map " + path);
+            }
+            m_data = static_cast<unsigned char const*>(data);
+        }
+
+        inline MappedFile::~MappedFile()
+        {
+            munmap(const_cast<unsigned char*>(m_data), m_byte_size);
+        }
+
+        inline void MappedFile::prefetch(size_t byte_offset, size_t byte_size) const
+        {
+            // madvise requires a page aligned address
+            size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            size_t aligned_offset = byte_offset - (byte_offset % page_size);
+            madvise(const_cast<unsigned char*>(m_data) + aligned_offset,
+                    byte_size + (byte_offset - aligned_offset),
+                    MADV_WILLNEED);
+        }
+#endif
+
+        inline unsigned char const* MappedFile::getData() const
+        {
+            return m_data;
+        }
+
+        inline size_t MappedFile::getByteSize() const
+        {
+            return m_byte_size;
+        }
+    } // namespace detail
+
+} // namespace glowl
+
+#endif // GLOWL_MAPPEDFILE_HPP
@@ -0,0 +1,283 @@
+/*
+ * MemoryBarrierTracker.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_MEMORYBARRIERTRACKER_HPP
+#define GLOWL_MEMORYBARRIERTRACKER_HPP
+
+#include <bitset>
+#include <cstdint>
+#include <unordered_map>
+
+#include "BufferObject.hpp"
+#include "Texture.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class MemoryBarrierTracker
+     *
+     * \brief Tracks the last write access of buffers and textures and issues minimal glMemoryBarrier calls.
+     *
+     * Usage: report shader writes with write() after a dispatch or draw, report the way a resource is consumed
+     * with read() before the next pass, then call flush() once to issue a single barrier with exactly the bits
+     * required by all reads of that pass. A subsequent write through images or SSBOs also counts as a read
+     * (ImageAccess or ShaderStorage), since it has to be ordered after the previous write.
+     */
+    class MemoryBarrierTracker
+    {
+    public:
+        /** Kind of write access */
+        enum class Write
+        {
+            ImageStore,       ///< imageStore/imageAtomic* via Texture::bindImage
+            ShaderStorage,    ///< SSBO writes
+            AtomicCounter,    ///< atomic counter buffer writes
+            TransformFeedback ///< transform feedback, coherent with later commands and thus needs no barrier
+        };
+
+        /** Kind of read access, each mapping to a single barrier bit */
+        enum class Read
+        {
+            VertexAttrib,       ///< GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+            ElementArray,       ///< GL_ELEMENT_ARRAY_BARRIER_BIT
+            Uniform,            ///< GL_UNIFORM_BARRIER_BIT
+            TextureFetch,       ///< GL_TEXTURE_FETCH_BARRIER_BIT
+            ImageAccess,        ///< GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+            Command,            ///< GL_COMMAND_BARRIER_BIT, i.e. indirect draw/dispatch commands
+            PixelBuffer,        ///< GL_PIXEL_BUFFER_BARRIER_BIT
+            TextureUpdate,      ///< GL_TEXTURE_UPDATE_BARRIER_BIT, e.g. texture readback
+            BufferUpdate,       ///< GL_BUFFER_UPDATE_BARRIER_BIT, e.g. buffer readback or copies
+            Framebuffer,        ///< GL_FRAMEBUFFER_BARRIER_BIT
+            TransformFeedback,  ///< GL_TRANSFORM_FEEDBACK_BARRIER_BIT
+            AtomicCounter,      ///< GL_ATOMIC_COUNTER_BARRIER_BIT
+            ShaderStorage,      ///< GL_SHADER_STORAGE_BARRIER_BIT
+            ClientMappedBuffer, ///< GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT
+            QueryBuffer         ///< GL_QUERY_BUFFER_BARRIER_BIT
+        };
+
+        struct Statistics
+        {
+            std::uint64_t barrier_calls = 0;  ///< glMemoryBarrier calls issued
+            std::uint64_t read_requests = 0;  ///< read() calls that were tracked
+            std::uint64_t avoided_calls = 0;  ///< read requests that did not result in a barrier call of their own
+            std::uint64_t issued_bits = 0;    ///< sum of barrier bits over all issued calls
+            std::uint64_t avoided_bits = 0;   ///< bits not issued compared to using GL_ALL_BARRIER_BITS per call
+        };
+
+        MemoryBarrierTracker() : m_pending_bits(0), m_pending_reads(0) {}
+        MemoryBarrierTracker(const MemoryBarrierTracker&) = delete;
+        MemoryBarrierTracker& operator=(const MemoryBarrierTracker&) = delete;
+
+        void write(BufferObject const& buffer, Write access);
+        void write(Texture const& texture, Write access);
+
+        /**
+         * \brief Record a read access. The required barrier bit is collected until the next flush().
+         */
+        void read(BufferObject const& buffer, Read access);
+        void read(Texture const& texture, Read access);
+
+        /**
+         * \brief Issue a single glMemoryBarrier for all reads recorded since the last flush, if any.
+         */
+        void flush();
+
+        /**
+         * \brief Forget all tracked writes, e.g. after an external glMemoryBarrier(GL_ALL_BARRIER_BITS).
+         */
+        void reset();
+
+        Statistics const& getStatistics() const;
+
+        void resetStatistics();
+
+        static GLbitfield getBarrierBit(Read access);
+
+        /**
+         * \brief Issues the given barrier bits immediately, for code paths that run without a tracker.
+         */
+        static void barrier(GLbitfield barrier_bits);
+
+    private:
+        /** Buffers and textures have separate name spaces, so the object type is part of the key */
+        static std::uint64_t key(GLuint name, bool is_texture);
+
+        void recordWrite(std::uint64_t key, Write access);
+        void recordRead(std::uint64_t key, Read access);
+
+        /** Union of all barrier bits that can be requested through Read */
+        static constexpr GLbitfield all_bits =
+            GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT |
+            GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_COMMAND_BARRIER_BIT |
+            GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT |
+            GL_FRAMEBUFFER_BARRIER_BIT | GL_TRANSFORM_FEEDBACK_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT |
+            GL_SHADER_STORAGE_BARRIER_BIT | GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT | GL_QUERY_BUFFER_BARRIER_BIT;
+
+        /** Barrier bits each written resource still requires before it may be read in the corresponding way */
+        std::unordered_map<std::uint64_t, GLbitfield> m_unsynced_writes;
+
+        GLbitfield    m_pending_bits;  ///< Bits collected for the next flush
+        std::uint64_t m_pending_reads; ///< Read requests collected for the next flush
+
+        Statistics m_statistics;
+    };
+
+    inline void MemoryBarrierTracker::write(BufferObject const& buffer, Write access)
+    {
+        recordWrite(key(buffer.getName(), false), access);
+    }
+
+    inline void MemoryBarrierTracker::write(Texture const& texture, Write access)
+    {
+        recordWrite(key(texture.getName(), true), access);
+    }
+
+    inline void MemoryBarrierTracker::read(BufferObject const& buffer, Read access)
+    {
+        recordRead(key(buffer.getName(), false), access);
+    }
+
+    inline void MemoryBarrierTracker::read(Texture const& texture, Read access)
+    {
+        recordRead(key(texture.getName(), true), access);
+    }
+
+    inline void MemoryBarrierTracker::flush()
+    {
+        if (m_pending_bits == 0)
+        {
+            return;
+        }
+
+        barrier(m_pending_bits);
+
+        // a barrier orders all prior incoherent writes, not only those of the resources that requested it
+        for (auto it = m_unsynced_writes.begin(); it != m_unsynced_writes.end();)
+        {
+            it->second &= ~m_pending_bits;
+            if (it->second == 0)
+            {
+                it = m_unsynced_writes.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        auto issued_bits = std::bitset<32>(m_pending_bits).count();
+
+        m_statistics.barrier_calls += 1;
+        m_statistics.avoided_calls += m_pending_reads - 1;
+        m_statistics.issued_bits += issued_bits;
+        m_statistics.avoided_bits += std::bitset<32>(all_bits).count() - issued_bits;
+
+        m_pending_bits = 0;
+        m_pending_reads = 0;
+    }
+
+    inline void MemoryBarrierTracker::reset()
+    {
+        m_unsynced_writes.clear();
+        m_pending_bits = 0;
+        m_pending_reads = 0;
+    }
+
+    inline MemoryBarrierTracker::Statistics const& MemoryBarrierTracker::getStatistics() const
+    {
+        return m_statistics;
+    }
+
+    inline void MemoryBarrierTracker::resetStatistics()
+    {
+        m_statistics = Statistics();
+    }
+
+    inline GLbitfield MemoryBarrierTracker::getBarrierBit(Read access)
+    {
+        switch (access)
+        {
+        case Read::VertexAttrib:
+            return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+        case Read::ElementArray:
+            return GL_ELEMENT_ARRAY_BARRIER_BIT;
+        case Read::Uniform:
+            return GL_UNIFORM_BARRIER_BIT;
+        case Read::TextureFetch:
+            return GL_TEXTURE_FETCH_BARRIER_BIT;
+        case Read::ImageAccess:
+            return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+        case Read::Command:
+            return GL_COMMAND_BARRIER_BIT;
+        case Read::PixelBuffer:
+            return GL_PIXEL_BUFFER_BARRIER_BIT;
+        case Read::TextureUpdate:
+            return GL_TEXTURE_UPDATE_BARRIER_BIT;
+        case Read::BufferUpdate:
+            return GL_BUFFER_UPDATE_BARRIER_BIT;
+        case Read::Framebuffer:
+            return GL_FRAMEBUFFER_BARRIER_BIT;
+        case Read::TransformFeedback:
+            return GL_TRANSFORM_FEEDBACK_BARRIER_BIT;
+        case Read::AtomicCounter:
+            return GL_ATOMIC_COUNTER_BARRIER_BIT;
+        case Read::ShaderStorage:
+            return GL_SHADER_STORAGE_BARRIER_BIT;
+        case Read::ClientMappedBuffer:
+            return GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT;
+        case Read::QueryBuffer:
+            return GL_QUERY_BUFFER_BARRIER_BIT;
+        }
+        return GL_ALL_BARRIER_BITS;
+    }
+
+    inline void MemoryBarrierTracker::barrier(GLbitfield barrier_bits)
+    {
+        GLOWL_TRACE(Opcode::MemoryBarrier, {barrier_bits});
+        glMemoryBarrier(barrier_bits);
+    }
+
+    inline std::uint64_t MemoryBarrierTracker::key(GLuint name, bool is_texture)
+    {
+        return (static_cast<std::uint64_t>(is_texture ? 1 : 0) << 32) | name;
+    }
+
+    inline void MemoryBarrierTracker::recordWrite(std::uint64_t key, Write access)
+    {
+        if (access == Write::TransformFeedback)
+        {
+            m_unsynced_writes.erase(key);
+        }
+        else
+        {
+            m_unsynced_writes[key] = all_bits;
+        }
+    }
+
+    inline void MemoryBarrierTracker::recordRead(std::uint64_t key, Read access)
+    {
+        m_statistics.read_requests += 1;
+
+        auto query = m_unsynced_writes.find(key);
+        GLbitfield bit = getBarrierBit(access);
+
+        if (query == m_unsynced_writes.end() || (query->second & bit) == 0 || (m_pending_bits & bit) != 0)
+        {
+            // no barrier required or already part of the pending barrier
+            m_statistics.avoided_calls += 1;
+            return;
+        }
+
+        m_pending_bits |= bit;
+        m_pending_reads += 1;
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_MEMORYBARRIERTRACKER_HPP
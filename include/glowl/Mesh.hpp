@@ -9,12 +9,20 @@
 #define GLOWL_MESH_HPP
 
 // Include std libs
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
 // Include glowl files
+#include "Bounds.hpp"
 #include "BufferObject.hpp"
+#include "Context.hpp"
+#include "NamePool.hpp"
+#include "Trace.hpp"
 #include "VertexLayout.hpp"
 #include "glinclude.h"
 
@@ -46,7 +54,7 @@ namespace glowl
     class Mesh
     {
     public:
-        typedef std::unique_ptr<BufferObject> BufferObjectPtr;
+        typedef std::shared_ptr<BufferObject> BufferObjectPtr;
 
         using VertexPtrData = std::tuple<void const*, std::size_t, VertexLayout>;
 
@@ -58,6 +66,31 @@ namespace glowl
         template<typename VertexDataType>
         using VertexDataList = std::vector<VertexData<VertexDataType>>;
 
+        /**
+         * \brief Range of the index buffer drawn with a single material, see setSubmeshes().
+         */
+        struct Submesh
+        {
+            GLuint        first_idx;   ///< First index, counted in indices (not bytes)
+            GLuint        index_cnt;
+            GLint         base_vertex; ///< Added to each index before fetching the vertex
+            std::uint32_t material;    ///< Tag for grouping draws, e.g. a material index
+        };
+
+        /**
+         * \brief Description of a single mesh for bulk construction, see createBatch().
+         */
+        struct Description
+        {
+            VertexPtrDataList vertex_data;
+            void const*       index_data;
+            std::size_t       index_data_byte_size;
+            GLenum            index_type = GL_UNSIGNED_INT;
+            GLenum            primitive_type = GL_TRIANGLES;
+            bool              compute_bounds = false; ///< Compute bounds from the vertex data, see getBounds()
+            GLuint            position_attrib = 0;    ///< Vertex attribute used for the bounds
+        };
+
         /**
          * \brief Mesh constructor that requires data pointers and byte sizes as input.
          *
@@ -119,9 +152,39 @@ namespace glowl
              GLenum const                          primitive_type = GL_TRIANGLES,
              GLenum const                          usage = GL_STATIC_DRAW);
 
+        /**
+         * \brief Mesh constructor that uses existing buffers, e.g. to share the index buffer (or some of the vertex
+         * buffers) between meshes.
+         *
+         * \param vbos Vertex buffers, one for each entry of vertex_descriptor
+         * \param ibo Index buffer, the index count is derived from its byte size
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        Mesh(std::vector<BufferObjectPtr> const& vbos,
+             std::vector<VertexLayout> const&    vertex_descriptor,
+             BufferObjectPtr const&              ibo,
+             GLenum const                        index_type = GL_UNSIGNED_INT,
+             GLenum const                        primitive_type = GL_TRIANGLES);
+
+        /**
+         * \brief Creates a mesh for each of the given descriptions.
+         *
+         * Compared to constructing the meshes one by one, the input of the whole batch is validated up front,
+         * the names of all buffers and vertex arrays are created by a single call per object type (see NamePool)
+         * and OpenGL errors are checked once for the whole batch.
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        static std::vector<std::unique_ptr<Mesh>> createBatch(std::vector<Description> const& descriptions,
+                                                              GLenum const usage = GL_STATIC_DRAW);
+
+        /**
+         * Deletes the vertex array of the current context, see releaseContext().
+         */
         ~Mesh()
         {
-            glDeleteVertexArrays(1, &m_va_handle);
+            releaseContext();
         }
 
         Mesh(const Mesh& cpy) = delete;
@@ -136,34 +199,149 @@ namespace glowl
 
         void bufferVertexSubData(std::size_t vbo_idx, GLvoid const* data, GLsizeiptr byte_size, GLsizeiptr byte_offset);
 
+        /**
+         * \brief Updates a single vertex attribute of a range of vertices.
+         *
+         * Only the bytes of the given attribute are written, the other attributes interleaved in the same vertex
+         * buffer are left untouched. For interleaved layouts, the values are scattered into a mapped range of the
+         * vertex buffer instead of re-uploading the complete vertices. The mapping is synchronized, i.e. it waits
+         * for the GPU to finish pending draws that read the vertex buffer. Attributes updated every frame are
+         * better kept in a vertex buffer of their own, which is updated by a pipelined glNamedBufferSubData.
+         *
+         * \param attrib_idx Vertex attribute index (as numbered in the vertex array, see getAttributeBufferIndex)
+         * \param values Tightly packed attribute values, one for each vertex
+         */
+        template<typename AttribDataType>
+        void bufferVertexAttribSubData(GLuint                             attrib_idx,
+                                       GLuint                             first_vertex,
+                                       std::vector<AttribDataType> const& values);
+
+        void bufferVertexAttribSubData(GLuint attrib_idx, GLuint first_vertex, GLuint vertex_cnt, GLvoid const* data);
+
         template<typename IndexDataType>
         void bufferIndexSubData(std::vector<IndexDataType> const& indices, GLsizeiptr byte_offset);
 
         void bufferIndexSubData(GLvoid const* data, GLsizeiptr byte_size, GLsizeiptr byte_offset);
 
+        /**
+         * Binds the vertex array of the current context (see setCurrentContext),
+         * which is created on first use in a context. Buffers are shared between all contexts.
+         */
         void bindVertexArray() const
         {
-            glBindVertexArray(m_va_handle);
+            GLuint va_handle = getVertexArray();
+            GLOWL_TRACE(Opcode::BindVertexArray, {va_handle});
+            glBindVertexArray(va_handle);
+        }
+
+        /**
+         * Deletes the vertex array of the current context.
+         * Vertex arrays are not shared between contexts and can only be deleted in their own context, thus
+         * call this with every additional context current before destroying the mesh.
+         */
+        void releaseContext()
+        {
+            GLuint va_handle = m_vertex_arrays.release();
+            if (va_handle != 0)
+            {
+                GLOWL_TRACE(Opcode::DeleteVertexArray, {va_handle});
+                getNamePool(NameType::VertexArray).release(va_handle);
+            }
         }
 
         /**
          * Draw function for your conveniences.
          * If you need/want to work with sth. different from glDrawElementsInstanced,
          * use bindVertexArray() and do your own thing.
+         * Meshes with more indices than the draw chunk size (see setDrawChunkSize) are drawn with several calls.
          */
         void draw(GLsizei instance_cnt = 1)
         {
-            glBindVertexArray(m_va_handle);
-            glDrawElementsInstanced(m_primitive_type, m_indices_cnt, m_index_type, nullptr, instance_cnt);
-            glBindVertexArray(0);
+            drawElements(0, m_indices_cnt, 0, instance_cnt);
         }
 
-        std::vector<VertexLayout> getVertexLayouts() const
+        /**
+         * \brief Draws a single entry of the submesh table.
+         */
+        void drawSubmesh(std::size_t submesh_idx, GLsizei instance_cnt = 1);
+
+        /**
+         * \brief Draws an arbitrary range of the index buffer, first_idx is counted in indices.
+         */
+        void drawRange(GLsizeiptr first_idx, GLsizeiptr index_cnt, GLint base_vertex = 0, GLsizei instance_cnt = 1);
+
+        /**
+         * \brief Sets the maximum number of indices per draw call, larger draws are split into several calls.
+         *
+         * Defaults to the largest count a single call accepts. Pass e.g. the value of GL_MAX_ELEMENTS_INDICES to
+         * stay within the recommended limits of the driver. Splitting is supported for lists of points, lines and
+         * triangles (also with adjacency) as well as line and triangle strips.
+         */
+        void setDrawChunkSize(GLsizeiptr max_indices);
+
+        GLsizeiptr getDrawChunkSize() const
+        {
+            return m_draw_chunk_size;
+        }
+
+        /**
+         * \brief Draws the commands stored in an indirect buffer with a single glMultiDrawElementsIndirect call.
+         *
+         * \param byte_offset Byte offset of the first command, commands are tightly packed DrawElementsCommands
+         */
+        void drawIndirect(BufferObject const& commands, GLsizei draw_cnt, GLintptr byte_offset = 0);
+
+        /**
+         * \brief Replaces the submesh table, e.g. with the material groups of an imported model.
+         */
+        void setSubmeshes(std::vector<Submesh> const& submeshes);
+
+        std::vector<Submesh> const& getSubmeshes() const
+        {
+            return m_submeshes;
+        }
+
+        /**
+         * \brief Appends a DrawElementsCommand for each submesh, e.g. to fill an indirect buffer for drawIndirect().
+         */
+        void emitDrawCommands(std::vector<DrawElementsCommand>& commands,
+                              GLuint                            instance_cnt = 1,
+                              GLuint                            base_instance = 0) const;
+
+        /**
+         * \brief Appends a DrawElementsCommand for each submesh with the given material tag.
+         */
+        void emitDrawCommands(std::vector<DrawElementsCommand>& commands,
+                              std::uint32_t                     material,
+                              GLuint                            instance_cnt,
+                              GLuint                            base_instance) const;
+
+        /**
+         * \brief Computes the bounds from the given position attribute (float, 2 to 4 components).
+         * The vertex buffer is read back from the GPU, prefer computing the bounds from the vertex data on the CPU
+         * (see computeBounds in Bounds.hpp and setBounds(), or Description::compute_bounds) where it is available.
+         */
+        void computeBounds(GLuint position_attrib = 0);
+
+        void setBounds(Bounds const& bounds)
+        {
+            m_bounds = bounds;
+        }
+
+        /**
+         * \brief Bounds of the mesh, empty unless computed or set.
+         */
+        Bounds const& getBounds() const
+        {
+            return m_bounds;
+        }
+
+        std::vector<VertexLayout> const& getVertexLayouts() const
         {
             return m_vertex_descriptor;
         }
 
-        GLuint getIndicesCount() const
+        GLsizeiptr getIndicesCount() const
         {
             return m_indices_cnt;
         }
@@ -189,33 +367,59 @@ namespace glowl
 
         GLsizeiptr getIndexBufferByteSize() const
         {
-            return m_ibo.getByteSize();
+            return m_ibo->getByteSize();
         }
 
+        /**
+         * \brief Number of vertices stored in the given vertex buffer, i.e. its byte size divided by the stride.
+         */
+        GLuint getVertexCount(std::size_t vbo_idx = 0) const;
+
+        /**
+         * \brief Index of the vertex buffer (and vertex layout) that holds the given vertex attribute.
+         * Attributes are numbered consecutively over all vertex layouts, as are the attribute indices of the
+         * vertex array.
+         */
+        std::size_t getAttributeBufferIndex(GLuint attrib_idx) const;
+
+        VertexLayout::Attribute const& getAttribute(GLuint attrib_idx) const;
+
         std::vector<BufferObjectPtr> const& getVbos() const
         {
             return m_vbos;
         }
 
         BufferObject const& getIbo() const
+        {
+            return *m_ibo;
+        }
+
+        BufferObjectPtr const& getIboPtr() const
         {
             return m_ibo;
         }
 
     private:
-        GLuint                       m_va_handle;
+        mutable PerContextObject     m_vertex_arrays; ///< One vertex array per context, VAOs are not shareable
         std::vector<BufferObjectPtr> m_vbos;
-        BufferObject                 m_ibo;
+        BufferObjectPtr              m_ibo;
 
         std::vector<VertexLayout> m_vertex_descriptor;
+        std::vector<Submesh>      m_submeshes;
+        Bounds                    m_bounds;
 
-        GLuint m_indices_cnt;
+        GLsizeiptr m_indices_cnt;
+        GLsizeiptr m_draw_chunk_size;
         GLenum m_index_type;
         GLenum m_primitive_type;
         GLenum m_usage;
 
-        void createVertexArray();
-        void setIndicesCount(GLuint index_data_byte_size);
+        GLuint getVertexArray() const;
+        GLuint createVertexArray() const;
+        void setIndicesCount(GLsizeiptr index_data_byte_size);
+
+        /** Draws an index range, split into chunks if necessary */
+        void drawElements(GLsizeiptr first_idx, GLsizeiptr index_cnt, GLint base_vertex, GLsizei instance_cnt);
         void checkError();
     };
 
@@ -227,10 +431,10 @@ namespace glowl
                       GLenum const                     index_type,
                       GLenum const                     primitive_type,
                       GLenum const                     usage)
-        : m_va_handle(0),
-          m_ibo(GL_ELEMENT_ARRAY_BUFFER, index_data, index_data_byte_size, usage),
+        : m_ibo(std::make_shared<BufferObject>(GL_ELEMENT_ARRAY_BUFFER, index_data, index_data_byte_size, usage)),
           m_vertex_descriptor(vertex_descriptor),
           m_indices_cnt(0),
+          m_draw_chunk_size(std::numeric_limits<GLsizei>::max()),
           m_index_type(index_type),
           m_primitive_type(primitive_type),
           m_usage(usage)
@@ -243,11 +447,11 @@ namespace glowl
         for (unsigned int i = 0; i < vertex_data.size(); ++i)
         {
             m_vbos.emplace_back(
-                std::make_unique<BufferObject>(GL_ARRAY_BUFFER, vertex_data[i], vertex_data_byte_sizes[i], usage));
+                std::make_shared<BufferObject>(GL_ARRAY_BUFFER, vertex_data[i], vertex_data_byte_sizes[i], usage));
         }
 
-        createVertexArray();
-        setIndicesCount(index_data_byte_size);
+        getVertexArray();
+        setIndicesCount(static_cast<GLsizeiptr>(index_data_byte_size));
 
         checkError();
     }
@@ -258,25 +462,25 @@ namespace glowl
                       GLenum const             index_type,
                       GLenum const             primitive_type,
                       GLenum const             usage)
-        : m_va_handle(0),
-          m_ibo(GL_ELEMENT_ARRAY_BUFFER, index_data, index_data_byte_size, usage),
+        : m_ibo(std::make_shared<BufferObject>(GL_ELEMENT_ARRAY_BUFFER, index_data, index_data_byte_size, usage)),
           m_vertex_descriptor(),
           m_indices_cnt(0),
+          m_draw_chunk_size(std::numeric_limits<GLsizei>::max()),
           m_index_type(index_type),
           m_primitive_type(primitive_type),
           m_usage(usage)
     {
         for (unsigned int i = 0; i < vertex_data.size(); ++i)
         {
-            m_vbos.emplace_back(std::make_unique<BufferObject>(GL_ARRAY_BUFFER,
+            m_vbos.emplace_back(std::make_shared<BufferObject>(GL_ARRAY_BUFFER,
                                                                std::get<0>(vertex_data[i]),
                                                                std::get<1>(vertex_data[i]),
                                                                usage));
             m_vertex_descriptor.push_back(std::get<2>(vertex_data[i]));
         }
 
-        createVertexArray();
-        setIndicesCount(index_data_byte_size);
+        getVertexArray();
+        setIndicesCount(static_cast<GLsizeiptr>(index_data_byte_size));
 
         checkError();
     }
@@ -288,12 +492,12 @@ namespace glowl
                       GLenum const                                    index_type,
                       GLenum const                                    primitive_type,
                       GLenum const                                    usage)
-        : m_va_handle(0),
-          m_ibo(GL_ELEMENT_ARRAY_BUFFER,
-                index_data,
-                usage), // TODO ibo generation in constructor might fail? needs a bound vao?
+        : m_ibo(std::make_shared<BufferObject>(GL_ELEMENT_ARRAY_BUFFER,
+                                               index_data,
+                                               usage)), // TODO ibo generation in constructor might fail? needs vao?
           m_vertex_descriptor(vertex_descriptor),
           m_indices_cnt(0),
+          m_draw_chunk_size(std::numeric_limits<GLsizei>::max()),
           m_index_type(index_type),
           m_primitive_type(primitive_type),
           m_usage(usage)
@@ -305,13 +509,13 @@ namespace glowl
 
         for (unsigned int i = 0; i < vertex_data.size(); ++i)
         {
-            m_vbos.emplace_back(std::make_unique<BufferObject>(GL_ARRAY_BUFFER, vertex_data[i], m_usage));
+            m_vbos.emplace_back(std::make_shared<BufferObject>(GL_ARRAY_BUFFER, vertex_data[i], m_usage));
         }
 
-        createVertexArray();
+        getVertexArray();
 
-        GLuint vi_size =
-            static_cast<GLuint>(index_data.size() * sizeof(typename std::vector<IndexDataType>::value_type));
+        GLsizeiptr vi_size =
+            static_cast<GLsizeiptr>(index_data.size() * sizeof(typename std::vector<IndexDataType>::value_type));
         setIndicesCount(vi_size);
 
         checkError();
@@ -323,28 +527,134 @@ namespace glowl
                       GLenum const                          index_type,
                       GLenum const                          primitive_type,
                       GLenum const                          usage)
-        : m_va_handle(0),
-          m_ibo(GL_ELEMENT_ARRAY_BUFFER, index_data, usage),
+        : m_ibo(std::make_shared<BufferObject>(GL_ELEMENT_ARRAY_BUFFER, index_data, usage)),
           m_indices_cnt(0),
+          m_draw_chunk_size(std::numeric_limits<GLsizei>::max()),
           m_index_type(index_type),
           m_primitive_type(primitive_type),
           m_usage(usage)
     {
         for (auto const& vertex_data : vertex_data_list)
         {
-            m_vbos.emplace_back(std::make_unique<BufferObject>(GL_ARRAY_BUFFER, vertex_data.first, m_usage));
+            m_vbos.emplace_back(std::make_shared<BufferObject>(GL_ARRAY_BUFFER, vertex_data.first, m_usage));
             m_vertex_descriptor.push_back(vertex_data.second);
         }
 
-        createVertexArray();
+        getVertexArray();
 
-        GLuint vi_size =
-            static_cast<GLuint>(index_data.size() * sizeof(typename std::vector<IndexDataType>::value_type));
+        GLsizeiptr vi_size =
+            static_cast<GLsizeiptr>(index_data.size() * sizeof(typename std::vector<IndexDataType>::value_type));
         setIndicesCount(vi_size);
 
         checkError();
     }
 
+    inline Mesh::Mesh(std::vector<BufferObjectPtr> const& vbos,
+                      std::vector<VertexLayout> const&    vertex_descriptor,
+                      BufferObjectPtr const&              ibo,
+                      GLenum const                        index_type,
+                      GLenum const                        primitive_type)
+        : m_vbos(vbos),
+          m_ibo(ibo),
+          m_vertex_descriptor(vertex_descriptor),
+          m_indices_cnt(0),
+          m_draw_chunk_size(std::numeric_limits<GLsizei>::max()),
+          m_index_type(index_type),
+          m_primitive_type(primitive_type),
+          m_usage(GL_STATIC_DRAW)
+    {
+        if (vbos.size() != vertex_descriptor.size())
+        {
+            throw std::invalid_argument("Mesh::Mesh - Vector parameters of different size!");
+        }
+
+        if (m_ibo == nullptr || std::find(m_vbos.begin(), m_vbos.end(), nullptr) != m_vbos.end())
+        {
+            throw MeshException("Mesh::Mesh - missing vertex or index buffer");
+        }
+
+        getVertexArray();
+        setIndicesCount(m_ibo->getByteSize());
+
+        checkError();
+    }
+
+    inline std::vector<std::unique_ptr<Mesh>> Mesh::createBatch(std::vector<Description> const& descriptions,
+                                                                GLenum const                    usage)
+    {
+        // validate up front, the per mesh checks of the constructors are skipped for the batch
+        GLsizei buffer_cnt = 0;
+        for (auto const& description : descriptions)
+        {
+            if (description.index_type != GL_UNSIGNED_INT && description.index_type != GL_UNSIGNED_SHORT &&
+                description.index_type != GL_UNSIGNED_BYTE)
+            {
+                throw MeshException("Mesh::createBatch - invalid index type given");
+            }
+
+            for (auto const& vertex_data : description.vertex_data)
+            {
+                for (auto const& attribute : std::get<2>(vertex_data).attributes)
+                {
+                    if (attribute.shader_input_type != GL_FLOAT && attribute.shader_input_type != GL_INT &&
+                        attribute.shader_input_type != GL_DOUBLE)
+                    {
+                        throw MeshException(
+                            "Mesh::createBatch - invalid vertex shader input type given (use float, double or int)");
+                    }
+                }
+            }
+
+            buffer_cnt += static_cast<GLsizei>(description.vertex_data.size()) + 1;
+        }
+
+        getNamePool(NameType::Buffer).reserve(buffer_cnt);
+        getNamePool(NameType::VertexArray).reserve(static_cast<GLsizei>(descriptions.size()));
+
+        std::vector<std::unique_ptr<Mesh>> meshes;
+        meshes.reserve(descriptions.size());
+
+        {
+            DeferredErrorCheck deferred_error_check;
+
+            for (auto const& description : descriptions)
+            {
+                meshes.emplace_back(std::make_unique<Mesh>(description.vertex_data,
+                                                           description.index_data,
+                                                           description.index_data_byte_size,
+                                                           description.index_type,
+                                                           description.primitive_type,
+                                                           usage));
+
+                if (description.compute_bounds)
+                {
+                    auto&       mesh = *meshes.back();
+                    std::size_t vbo_idx = mesh.getAttributeBufferIndex(description.position_attrib);
+                    auto const& attribute = mesh.getAttribute(description.position_attrib);
+
+                    if (attribute.type != GL_FLOAT)
+                    {
+                        throw MeshException("Mesh::createBatch - bounds require a float position attribute");
+                    }
+
+                    mesh.setBounds(glowl::computeBounds(std::get<0>(description.vertex_data[vbo_idx]),
+                                                        std::get<1>(description.vertex_data[vbo_idx]),
+                                                        static_cast<size_t>(mesh.m_vertex_descriptor[vbo_idx].stride),
+                                                        static_cast<size_t>(attribute.offset),
+                                                        attribute.size));
+                }
+            }
+        }
+
+        auto err = glGetError();
+        if (err != GL_NO_ERROR)
+        {
+            throw MeshException("Mesh::createBatch - OpenGL error " + std::to_string(err));
+        }
+
+        return meshes;
+    }
+
     template<typename VertexDataType>
     inline void Mesh::bufferVertexSubData(std::size_t                        vbo_idx,
                                           std::vector<VertexDataType> const& vertices,
@@ -369,42 +679,279 @@ namespace glowl
         m_vbos[vbo_idx]->bufferSubData(data, byte_size, byte_offset);
     }
 
+    template<typename AttribDataType>
+    inline void Mesh::bufferVertexAttribSubData(GLuint                             attrib_idx,
+                                                GLuint                             first_vertex,
+                                                std::vector<AttribDataType> const& values)
+    {
+        std::size_t byte_size = values.size() * sizeof(AttribDataType);
+        std::size_t attrib_byte_size = computeAttributeByteSize(getAttribute(attrib_idx));
+
+        if (attrib_byte_size == 0 || byte_size % attrib_byte_size != 0)
+        {
+            throw MeshException("Mesh::bufferVertexAttribSubData - data size does not match the vertex attribute");
+        }
+
+        bufferVertexAttribSubData(
+            attrib_idx, first_vertex, static_cast<GLuint>(byte_size / attrib_byte_size), values.data());
+    }
+
+    inline void Mesh::bufferVertexAttribSubData(GLuint        attrib_idx,
+                                                GLuint        first_vertex,
+                                                GLuint        vertex_cnt,
+                                                GLvoid const* data)
+    {
+        std::size_t vbo_idx = getAttributeBufferIndex(attrib_idx);
+        auto const& attribute = getAttribute(attrib_idx);
+        auto const& vbo = *m_vbos[vbo_idx];
+
+        GLsizeiptr stride = m_vertex_descriptor[vbo_idx].stride;
+        GLsizeiptr attrib_byte_size = static_cast<GLsizeiptr>(computeAttributeByteSize(attribute));
+
+        if (static_cast<std::uint64_t>(first_vertex) + vertex_cnt > getVertexCount(vbo_idx))
+        {
+            throw MeshException("Mesh::bufferVertexAttribSubData - vertex range out of bounds");
+        }
+
+        if (vertex_cnt == 0)
+        {
+            return;
+        }
+
+        GLintptr byte_offset = static_cast<GLintptr>(first_vertex) * stride + attribute.offset;
+
+        // attribute not interleaved with others, the values are contiguous in the buffer
+        if (attrib_byte_size == stride)
+        {
+            vbo.bufferSubData(data, static_cast<GLsizeiptr>(vertex_cnt) * stride, byte_offset);
+            return;
+        }
+
+        // the mapped range spans from the first to the last value written, everything in between is preserved
+        GLsizeiptr byte_size = static_cast<GLsizeiptr>(vertex_cnt - 1) * stride + attrib_byte_size;
+        auto       dst = static_cast<unsigned char*>(vbo.map(byte_offset, byte_size, GL_MAP_WRITE_BIT));
+        auto       src = static_cast<unsigned char const*>(data);
+
+        for (GLuint i = 0; i < vertex_cnt; ++i)
+        {
+            std::memcpy(dst + i * stride, src + i * attrib_byte_size, static_cast<size_t>(attrib_byte_size));
+        }
+
+        vbo.unmap();
+
+        GLOWL_TRACE(Opcode::MapNamedBufferRange,
+                    {vbo.getName(), byte_offset, stride, attrib_byte_size},
+                    src,
+                    static_cast<size_t>(vertex_cnt) * static_cast<size_t>(attrib_byte_size));
+    }
+
+    inline void Mesh::drawSubmesh(std::size_t submesh_idx, GLsizei instance_cnt)
+    {
+        if (submesh_idx >= m_submeshes.size())
+        {
+            throw MeshException("Mesh::drawSubmesh - submesh index out of range");
+        }
+
+        auto const& submesh = m_submeshes[submesh_idx];
+        drawRange(submesh.first_idx, submesh.index_cnt, submesh.base_vertex, instance_cnt);
+    }
+
+    inline void Mesh::drawRange(GLsizeiptr first_idx, GLsizeiptr index_cnt, GLint base_vertex, GLsizei instance_cnt)
+    {
+        if (first_idx < 0 || index_cnt < 0 || first_idx + index_cnt > m_indices_cnt)
+        {
+            throw MeshException("Mesh::drawRange - index range out of bounds");
+        }
+
+        drawElements(first_idx, index_cnt, base_vertex, instance_cnt);
+    }
+
+    inline void Mesh::setDrawChunkSize(GLsizeiptr max_indices)
+    {
+        m_draw_chunk_size =
+            std::min<GLsizeiptr>(std::max<GLsizeiptr>(max_indices, 1), std::numeric_limits<GLsizei>::max());
+    }
+
+    inline void Mesh::drawIndirect(BufferObject const& commands, GLsizei draw_cnt, GLintptr byte_offset)
+    {
+        GLuint va_handle = getVertexArray();
+
+        GLOWL_TRACE(Opcode::BindVertexArray, {va_handle});
+        GLOWL_TRACE(Opcode::MultiDrawElementsIndirect,
+                    {m_primitive_type,
+                     m_index_type,
+                     commands.getName(),
+                     byte_offset,
+                     draw_cnt,
+                     static_cast<std::int64_t>(sizeof(DrawElementsCommand))});
+        GLOWL_TRACE(Opcode::BindVertexArray, {0});
+
+        glBindVertexArray(va_handle);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getName());
+        glMultiDrawElementsIndirect(m_primitive_type,
+                                    m_index_type,
+                                    reinterpret_cast<void const*>(static_cast<std::uintptr_t>(byte_offset)),
+                                    draw_cnt,
+                                    sizeof(DrawElementsCommand));
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    inline void Mesh::computeBounds(GLuint position_attrib)
+    {
+        std::size_t vbo_idx = getAttributeBufferIndex(position_attrib);
+        auto const& attribute = getAttribute(position_attrib);
+
+        if (attribute.type != GL_FLOAT)
+        {
+            throw MeshException("Mesh::computeBounds - position attribute has to be float");
+        }
+
+        std::vector<unsigned char> data(static_cast<size_t>(m_vbos[vbo_idx]->getByteSize()));
+        glGetNamedBufferSubData(
+            m_vbos[vbo_idx]->getName(), 0, static_cast<GLsizeiptr>(data.size()), data.data());
+
+        m_bounds = glowl::computeBounds(data.data(),
+                                        data.size(),
+                                        static_cast<size_t>(m_vertex_descriptor[vbo_idx].stride),
+                                        static_cast<size_t>(attribute.offset),
+                                        attribute.size);
+    }
+
+    inline void Mesh::setSubmeshes(std::vector<Submesh> const& submeshes)
+    {
+        for (auto const& submesh : submeshes)
+        {
+            if (static_cast<GLsizeiptr>(submesh.first_idx) + submesh.index_cnt > m_indices_cnt)
+            {
+                throw MeshException("Mesh::setSubmeshes - submesh exceeds the index buffer");
+            }
+        }
+
+        m_submeshes = submeshes;
+    }
+
+    inline void Mesh::emitDrawCommands(std::vector<DrawElementsCommand>& commands,
+                                       GLuint                            instance_cnt,
+                                       GLuint                            base_instance) const
+    {
+        for (auto const& submesh : m_submeshes)
+        {
+            commands.push_back({submesh.index_cnt,
+                                instance_cnt,
+                                submesh.first_idx,
+                                static_cast<GLuint>(submesh.base_vertex),
+                                base_instance});
+        }
+    }
+
+    inline void Mesh::emitDrawCommands(std::vector<DrawElementsCommand>& commands,
+                                       std::uint32_t                     material,
+                                       GLuint                            instance_cnt,
+                                       GLuint                            base_instance) const
+    {
+        for (auto const& submesh : m_submeshes)
+        {
+            if (submesh.material == material)
+            {
+                commands.push_back({submesh.index_cnt,
+                                    instance_cnt,
+                                    submesh.first_idx,
+                                    static_cast<GLuint>(submesh.base_vertex),
+                                    base_instance});
+            }
+        }
+    }
+
     template<typename IndexDataType>
     inline void Mesh::bufferIndexSubData(std::vector<IndexDataType> const& indices, GLsizeiptr byte_offset)
     {
-        m_ibo.bufferSubData<std::vector<IndexDataType>>(indices, byte_offset);
+        m_ibo->bufferSubData<std::vector<IndexDataType>>(indices, byte_offset);
     }
 
     inline void Mesh::bufferIndexSubData(GLvoid const* data, GLsizeiptr byte_size, GLsizeiptr byte_offset)
     {
-        m_ibo.bufferSubData(data, byte_size, byte_offset);
+        m_ibo->bufferSubData(data, byte_size, byte_offset);
     }
 
-    inline void Mesh::createVertexArray()
+    inline GLuint Mesh::getVertexCount(std::size_t vbo_idx) const
     {
-        glCreateVertexArrays(1, &m_va_handle);
+        if (vbo_idx >= m_vbos.size() || m_vertex_descriptor[vbo_idx].stride <= 0)
+        {
+            return 0;
+        }
+        return static_cast<GLuint>(m_vbos[vbo_idx]->getByteSize() / m_vertex_descriptor[vbo_idx].stride);
+    }
+
+    inline std::size_t Mesh::getAttributeBufferIndex(GLuint attrib_idx) const
+    {
+        GLuint first_attrib_idx = 0;
+        for (std::size_t vertex_layout_idx = 0; vertex_layout_idx < m_vertex_descriptor.size(); ++vertex_layout_idx)
+        {
+            GLuint attrib_cnt = static_cast<GLuint>(m_vertex_descriptor[vertex_layout_idx].attributes.size());
+            if (attrib_idx < first_attrib_idx + attrib_cnt)
+            {
+                return vertex_layout_idx;
+            }
+            first_attrib_idx += attrib_cnt;
+        }
+
+        throw MeshException("Mesh::getAttributeBufferIndex - vertex attribute index out of range");
+    }
+
+    inline VertexLayout::Attribute const& Mesh::getAttribute(GLuint attrib_idx) const
+    {
+        for (auto const& vertex_layout : m_vertex_descriptor)
+        {
+            if (attrib_idx < vertex_layout.attributes.size())
+            {
+                return vertex_layout.attributes[attrib_idx];
+            }
+            attrib_idx -= static_cast<GLuint>(vertex_layout.attributes.size());
+        }
+
+        throw MeshException("Mesh::getAttribute - vertex attribute index out of range");
+    }
+
+    inline GLuint Mesh::getVertexArray() const
+    {
+        return m_vertex_arrays.get([this]() { return createVertexArray(); });
+    }
+
+    inline GLuint Mesh::createVertexArray() const
+    {
+        GLuint va_handle = getNamePool(NameType::VertexArray).acquire();
+
+        GLOWL_TRACE(Opcode::CreateVertexArray, {va_handle});
 
         GLuint attrib_idx = 0;
 
         for (std::size_t vertex_layout_idx = 0; vertex_layout_idx < m_vertex_descriptor.size(); ++vertex_layout_idx)
         {
-            glVertexArrayVertexBuffer(m_va_handle,
+            glVertexArrayVertexBuffer(va_handle,
                                       vertex_layout_idx,
                                       m_vbos[vertex_layout_idx]->getName(),
                                       0, // offset not really needed since we just created a new vbo
                                       m_vertex_descriptor[vertex_layout_idx].stride);
 
+            GLOWL_TRACE(Opcode::VertexArrayVertexBuffer,
+                        {va_handle,
+                         static_cast<std::int64_t>(vertex_layout_idx),
+                         m_vbos[vertex_layout_idx]->getName(),
+                         0,
+                         m_vertex_descriptor[vertex_layout_idx].stride});
+
             for (std::size_t local_attrib_idx = 0;
                  local_attrib_idx < m_vertex_descriptor[vertex_layout_idx].attributes.size();
                  ++local_attrib_idx)
             {
                 auto const& attribute = m_vertex_descriptor[vertex_layout_idx].attributes[local_attrib_idx];
 
-                glEnableVertexArrayAttrib(m_va_handle, attrib_idx);
+                glEnableVertexArrayAttrib(va_handle, attrib_idx);
                 switch (attribute.shader_input_type)
                 {
                 case GL_FLOAT:
-                    glVertexArrayAttribFormat(m_va_handle,
+                    glVertexArrayAttribFormat(va_handle,
                                               attrib_idx,
                                               attribute.size,
                                               attribute.type,
@@ -412,52 +959,152 @@ namespace glowl
                                               attribute.offset);
                     break;
                 case GL_INT:
-                    glVertexArrayAttribIFormat(m_va_handle,
+                    glVertexArrayAttribIFormat(va_handle,
                                                attrib_idx,
                                                attribute.size,
                                                attribute.type,
                                                attribute.offset);
                     break;
                 case GL_DOUBLE:
-                    glVertexArrayAttribLFormat(m_va_handle,
+                    glVertexArrayAttribLFormat(va_handle,
                                                attrib_idx,
                                                attribute.size,
                                                attribute.type,
                                                attribute.offset);
                     break;
                 default:
+                    getNamePool(NameType::VertexArray).release(va_handle);
                     throw MeshException(
                         "Mesh::createVertexArray - invalid vertex shader input type given (use float, double or int)");
                     break;
                 }
-                glVertexArrayAttribBinding(m_va_handle, attrib_idx, vertex_layout_idx);
+                glVertexArrayAttribBinding(va_handle, attrib_idx, vertex_layout_idx);
+
+                GLOWL_TRACE(Opcode::VertexArrayAttrib,
+                            {va_handle,
+                             attrib_idx,
+                             static_cast<std::int64_t>(vertex_layout_idx),
+                             attribute.size,
+                             attribute.type,
+                             attribute.normalized,
+                             attribute.offset,
+                             attribute.shader_input_type});
 
                 ++attrib_idx;
             }
         }
 
-        glVertexArrayElementBuffer(m_va_handle, m_ibo.getName());
+        glVertexArrayElementBuffer(va_handle, m_ibo->getName());
+
+        GLOWL_TRACE(Opcode::VertexArrayElementBuffer, {va_handle, m_ibo->getName()});
+
+        return va_handle;
     }
 
-    inline void Mesh::setIndicesCount(GLuint index_data_byte_size)
+    inline void Mesh::setIndicesCount(GLsizeiptr index_data_byte_size)
     {
         switch (m_index_type)
         {
         case GL_UNSIGNED_INT:
-            m_indices_cnt = static_cast<GLuint>(index_data_byte_size / 4);
+            m_indices_cnt = index_data_byte_size / 4;
             break;
         case GL_UNSIGNED_SHORT:
-            m_indices_cnt = static_cast<GLuint>(index_data_byte_size / 2);
+            m_indices_cnt = index_data_byte_size / 2;
             break;
         case GL_UNSIGNED_BYTE:
-            m_indices_cnt = static_cast<GLuint>(index_data_byte_size / 1);
+            m_indices_cnt = index_data_byte_size / 1;
             break;
         }
     }
 
+    inline void Mesh::drawElements(GLsizeiptr first_idx, GLsizeiptr index_cnt, GLint base_vertex, GLsizei instance_cnt)
+    {
+        // chunks consist of whole primitives, strips repeat the last vertices of the previous chunk
+        GLsizeiptr primitive_size = 0;
+        GLsizeiptr overlap = 0;
+        switch (m_primitive_type)
+        {
+        case GL_POINTS:
+            primitive_size = 1;
+            break;
+        case GL_LINES:
+            primitive_size = 2;
+            break;
+        case GL_LINES_ADJACENCY:
+            primitive_size = 4;
+            break;
+        case GL_TRIANGLES:
+            primitive_size = 3;
+            break;
+        case GL_TRIANGLES_ADJACENCY:
+            primitive_size = 6;
+            break;
+        case GL_LINE_STRIP:
+            primitive_size = 1;
+            overlap = 1;
+            break;
+        case GL_TRIANGLE_STRIP:
+            // even chunk starts keep the winding order of the strip
+            primitive_size = 2;
+            overlap = 2;
+            break;
+        default:
+            break;
+        }
+
+        GLsizeiptr chunk_size = primitive_size > 0 ? m_draw_chunk_size / primitive_size * primitive_size : 0;
+
+        if (index_cnt > m_draw_chunk_size && chunk_size <= overlap)
+        {
+            throw MeshException("Mesh::draw - primitive type " + std::to_string(m_primitive_type) +
+                                " cannot be split into draw chunks of " + std::to_string(m_draw_chunk_size) +
+                                " indices");
+        }
+
+        GLsizeiptr index_byte_size = static_cast<GLsizeiptr>(computeByteSize(m_index_type));
+        GLuint     va_handle = getVertexArray();
+
+        GLOWL_TRACE(Opcode::BindVertexArray, {va_handle});
+        glBindVertexArray(va_handle);
+
+        GLsizeiptr chunk_first_idx = first_idx;
+        GLsizeiptr end_idx = first_idx + index_cnt;
+        do
+        {
+            GLsizeiptr chunk_cnt = index_cnt > m_draw_chunk_size ? std::min(chunk_size, end_idx - chunk_first_idx)
+                                                                 : index_cnt;
+            GLsizeiptr byte_offset = chunk_first_idx * index_byte_size;
+            auto       indices = reinterpret_cast<void const*>(static_cast<std::uintptr_t>(byte_offset));
+
+            if (base_vertex == 0)
+            {
+                GLOWL_TRACE(Opcode::DrawElementsInstanced,
+                            {m_primitive_type, chunk_cnt, m_index_type, byte_offset, instance_cnt});
+                glDrawElementsInstanced(
+                    m_primitive_type, static_cast<GLsizei>(chunk_cnt), m_index_type, indices, instance_cnt);
+            }
+            else
+            {
+                GLOWL_TRACE(Opcode::DrawElementsInstancedBaseVertex,
+                            {m_primitive_type, chunk_cnt, m_index_type, byte_offset, instance_cnt, base_vertex});
+                glDrawElementsInstancedBaseVertex(m_primitive_type,
+                                                  static_cast<GLsizei>(chunk_cnt),
+                                                  m_index_type,
+                                                  indices,
+                                                  instance_cnt,
+                                                  base_vertex);
+            }
+
+            chunk_first_idx += chunk_cnt - overlap;
+        } while (chunk_first_idx + overlap < end_idx);
+
+        GLOWL_TRACE(Opcode::BindVertexArray, {0});
+        glBindVertexArray(0);
+    }
+
     inline void Mesh::checkError()
     {
-        auto err = glGetError();
+        auto err = DeferredErrorCheck::isActive() ? GL_NO_ERROR : glGetError();
         if (err != GL_NO_ERROR)
         {
             throw MeshException("Mesh::Mesh - OpenGL error " + std::to_string(err));
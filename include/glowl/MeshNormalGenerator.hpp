@@ -0,0 +1,498 @@
+/*
+ * MeshNormalGenerator.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_MESHNORMALGENERATOR_HPP
+#define GLOWL_MESHNORMALGENERATOR_HPP
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BufferObject.hpp"
+#include "Exceptions.hpp"
+#include "GLSLProgram.hpp"
+#include "MemoryBarrierTracker.hpp"
+#include "Mesh.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class MeshNormalGenerator
+     *
+     * \brief Recomputes vertex normals (and optionally tangents) of a triangle mesh on the GPU.
+     *
+     * The index buffer and the vertex buffers of the mesh are accessed as shader storage buffers, so positions
+     * updated on the GPU or through Mesh::bufferVertexSubData are used directly and the results are written
+     * into the normal (and tangent) attribute described by the vertex layout. Per vertex, the face normals of all
+     * adjacent triangles are accumulated weighted by triangle area using fixed-point integer atomics. The weights
+     * are relative to the largest adjacent triangle of each vertex, so small triangles next to large ones keep
+     * their normals independent of the size range of the mesh.
+     *
+     * Requirements: GL_TRIANGLES, float positions (3 or 4 components), float normals (3 or 4 components),
+     * float texture coordinates (at least 2 components) and float tangents (3 or 4 components, the 4th receives
+     * the handedness of the tangent frame). All strides and attribute offsets have to be multiples of 4 bytes.
+     * Meshes with submeshes (see Mesh::setSubmeshes) are processed per submesh, using its index range and base
+     * vertex. Triangles referencing vertices outside of the position buffer are skipped.
+     */
+    class MeshNormalGenerator
+    {
+    public:
+        /**
+         * \brief MeshNormalGenerator constructor.
+         *
+         * \param barrier_tracker Optional tracker that the writes to the vertex buffers are reported to. Without
+         * one, recompute() issues a vertex attribute barrier itself.
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        MeshNormalGenerator(MemoryBarrierTracker* barrier_tracker = nullptr);
+        MeshNormalGenerator(const MeshNormalGenerator&) = delete;
+        MeshNormalGenerator& operator=(const MeshNormalGenerator&) = delete;
+
+        /**
+         * \brief Recompute the normals of a mesh.
+         *
+         * \param position_attrib Vertex attribute index of the positions (as numbered in the vertex array)
+         * \param normal_attrib Vertex attribute index of the normals
+         */
+        void recompute(Mesh const& mesh, GLuint position_attrib, GLuint normal_attrib);
+
+        /**
+         * \brief Recompute normals and tangents of a mesh, tangents follow the direction of increasing u.
+         */
+        void recompute(Mesh const& mesh,
+                       GLuint      position_attrib,
+                       GLuint      normal_attrib,
+                       GLuint      texcoord_attrib,
+                       GLuint      tangent_attrib);
+
+    private:
+        /** Integers per vertex in the accumulation buffer, i.e. normal, tangent and bitangent sums and max area */
+        static constexpr GLuint accumulator_cnt = 10;
+
+        void recompute(Mesh const& mesh,
+                       GLuint      position_attrib,
+                       GLuint      normal_attrib,
+                       GLuint      texcoord_attrib,
+                       GLuint      tangent_attrib,
+                       bool        tangents);
+
+        /** Binds the vertex buffer of an attribute as storage buffer and sets its stride and offset in words */
+        void bindAttribute(Mesh const&  mesh,
+                           GLuint       attrib_idx,
+                           GLuint       binding,
+                           GLSLProgram& program,
+                           GLchar const* layout_uniform) const;
+
+        static void checkAttribute(Mesh const& mesh, GLuint attrib_idx, GLint min_size, GLint max_size);
+
+        /** Dispatches the triangles of each submesh, or of the whole index buffer for meshes without submeshes */
+        static void dispatchTriangles(Mesh const& mesh, GLSLProgram& program);
+
+        /** Dispatches at least invocation_cnt invocations, using the y dimension for very large counts */
+        static void dispatch(GLSLProgram& program, GLuint invocation_cnt);
+
+        std::unique_ptr<GLSLProgram> m_area_program;
+        std::unique_ptr<GLSLProgram> m_accumulate_program;
+        std::unique_ptr<GLSLProgram> m_resolve_program;
+
+        std::unique_ptr<BufferObject> m_accumulators;   ///< Fixed-point sums, left zeroed by the resolve pass
+        std::unique_ptr<BufferObject> m_padded_indices; ///< Copy of index buffers not sized in whole words
+
+        MemoryBarrierTracker* m_barrier_tracker;
+    };
+
+    namespace detail
+    {
+        static constexpr GLuint normal_generator_group_size = 64;
+
+        static char const* const normal_generator_triangle_source = R"(
+#version 450
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer IndexBuffer { uint indices[]; };
+layout(std430, binding = 1) readonly buffer PositionBuffer { uint positions[]; };
+layout(std430, binding = 2) readonly buffer TexcoordBuffer { uint texcoords[]; };
+layout(std430, binding = 3) buffer AccumulationBuffer { int accumulators[]; };
+
+uniform uint index_size;
+uniform uint first_index; // of the submesh
+uniform uint triangle_cnt;
+uniform int base_vertex;
+uniform uint vertex_cnt;
+uniform uvec2 position_layout; // stride and offset in words
+uniform uvec2 texcoord_layout;
+uniform int tangents;
+
+const float fixed_point_scale = 65536.0;
+
+uint getTriangle()
+{
+    return gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x;
+}
+
+uint fetchIndex(uint i)
+{
+    if (index_size == 2u) return (indices[i >> 1u] >> ((i & 1u) * 16u)) & 0xFFFFu;
+    if (index_size == 1u) return (indices[i >> 2u] >> ((i & 3u) * 8u)) & 0xFFu;
+    return indices[i];
+}
+
+vec3 fetchPosition(uint v)
+{
+    uint w = v * position_layout.x + position_layout.y;
+    return vec3(uintBitsToFloat(positions[w]), uintBitsToFloat(positions[w + 1u]), uintBitsToFloat(positions[w + 2u]));
+}
+
+vec2 fetchTexcoord(uint v)
+{
+    uint w = v * texcoord_layout.x + texcoord_layout.y;
+    return vec2(uintBitsToFloat(texcoords[w]), uintBitsToFloat(texcoords[w + 1u]));
+}
+
+void accumulate(uint v, uint component, vec3 value)
+{
+    ivec3 fixed_point = ivec3(round(value * fixed_point_scale));
+    atomicAdd(accumulators[v * 10u + component], fixed_point.x);
+    atomicAdd(accumulators[v * 10u + component + 1u], fixed_point.y);
+    atomicAdd(accumulators[v * 10u + component + 2u], fixed_point.z);
+}
+
+// weight relative to the largest triangle at the vertex, which thus always contributes with weight 1
+float weight(uint v, float area)
+{
+    return area / intBitsToFloat(accumulators[v * 10u + 9u]);
+}
+
+void main()
+{
+    uint t = getTriangle();
+    if (t >= triangle_cnt) return;
+
+    uint i = first_index + 3u * t;
+    uint v0 = uint(int(fetchIndex(i)) + base_vertex);
+    uint v1 = uint(int(fetchIndex(i + 1u)) + base_vertex);
+    uint v2 = uint(int(fetchIndex(i + 2u)) + base_vertex);
+    if (max(v0, max(v1, v2)) >= vertex_cnt) return;
+
+    vec3 e1 = fetchPosition(v1) - fetchPosition(v0);
+    vec3 e2 = fetchPosition(v2) - fetchPosition(v0);
+    vec3 face_normal = cross(e1, e2);
+    float area = length(face_normal);
+
+#ifdef AREA_PASS
+    // the bit patterns of non-negative floats are ordered like their values
+    int area_bits = floatBitsToInt(area);
+    atomicMax(accumulators[v0 * 10u + 9u], area_bits);
+    atomicMax(accumulators[v1 * 10u + 9u], area_bits);
+    atomicMax(accumulators[v2 * 10u + 9u], area_bits);
+#else
+    if (area <= 0.0) return;
+
+    // relative weights keep the fixed-point sums in range independent of the mesh scale
+    vec3 w = vec3(weight(v0, area), weight(v1, area), weight(v2, area));
+    vec3 normal = face_normal / area;
+    accumulate(v0, 0u, normal * w.x);
+    accumulate(v1, 0u, normal * w.y);
+    accumulate(v2, 0u, normal * w.z);
+
+    if (tangents != 0)
+    {
+        vec2 t0 = fetchTexcoord(v0);
+        vec2 d1 = fetchTexcoord(v1) - t0;
+        vec2 d2 = fetchTexcoord(v2) - t0;
+        float r = d1.x * d2.y - d2.x * d1.y;
+        if (r == 0.0) return;
+
+        vec3 tangent = (e1 * d2.y - e2 * d1.y) / r;
+        vec3 bitangent = (e2 * d1.x - e1 * d2.x) / r;
+        if (dot(tangent, tangent) > 0.0)
+        {
+            tangent = normalize(tangent);
+            accumulate(v0, 3u, tangent * w.x);
+            accumulate(v1, 3u, tangent * w.y);
+            accumulate(v2, 3u, tangent * w.z);
+        }
+        if (dot(bitangent, bitangent) > 0.0)
+        {
+            bitangent = normalize(bitangent);
+            accumulate(v0, 6u, bitangent * w.x);
+            accumulate(v1, 6u, bitangent * w.y);
+            accumulate(v2, 6u, bitangent * w.z);
+        }
+    }
+#endif
+}
+)";
+
+        static char const* const normal_generator_resolve_source = R"(
+#version 450
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 3) buffer AccumulationBuffer { int accumulators[]; };
+layout(std430, binding = 5) buffer NormalBuffer { uint normals[]; };
+layout(std430, binding = 6) buffer TangentBuffer { uint tangents_out[]; };
+
+uniform uint vertex_cnt;
+uniform uvec2 normal_layout; // stride and offset in words
+uniform uvec2 tangent_layout;
+uniform uint tangent_size;
+uniform int tangents;
+
+vec3 take(uint v, uint component)
+{
+    uint a = v * 10u + component;
+    vec3 value = vec3(accumulators[a], accumulators[a + 1u], accumulators[a + 2u]);
+    // leave the accumulators zeroed for the next run
+    accumulators[a] = 0;
+    accumulators[a + 1u] = 0;
+    accumulators[a + 2u] = 0;
+    return value;
+}
+
+vec3 safeNormalize(vec3 v)
+{
+    float len = length(v);
+    return len > 0.0 ? v / len : vec3(0.0);
+}
+
+void main()
+{
+    uint v = gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x;
+    if (v >= vertex_cnt) return;
+
+    accumulators[v * 10u + 9u] = 0;
+
+    vec3 normal = safeNormalize(take(v, 0u));
+
+    uint w = v * normal_layout.x + normal_layout.y;
+    normals[w] = floatBitsToUint(normal.x);
+    normals[w + 1u] = floatBitsToUint(normal.y);
+    normals[w + 2u] = floatBitsToUint(normal.z);
+
+    if (tangents != 0)
+    {
+        vec3 tangent_sum = take(v, 3u);
+        vec3 bitangent_sum = take(v, 6u);
+
+        // Gram-Schmidt orthogonalization against the normal
+        vec3 tangent = safeNormalize(tangent_sum - normal * dot(normal, tangent_sum));
+        float handedness = dot(cross(normal, tangent), bitangent_sum) < 0.0 ? -1.0 : 1.0;
+
+        w = v * tangent_layout.x + tangent_layout.y;
+        tangents_out[w] = floatBitsToUint(tangent.x);
+        tangents_out[w + 1u] = floatBitsToUint(tangent.y);
+        tangents_out[w + 2u] = floatBitsToUint(tangent.z);
+        if (tangent_size > 3u) tangents_out[w + 3u] = floatBitsToUint(handedness);
+    }
+}
+)";
+    } // namespace detail
+
+    inline MeshNormalGenerator::MeshNormalGenerator(MemoryBarrierTracker* barrier_tracker)
+        : m_barrier_tracker(barrier_tracker)
+    {
+        std::string triangle_source(detail::normal_generator_triangle_source);
+        std::string area_source = triangle_source;
+        area_source.insert(area_source.find('\n', 1) + 1, "#define AREA_PASS\n");
+
+        m_area_program = std::make_unique<GLSLProgram>(
+            GLSLProgram::ShaderSourceList{{GLSLProgram::ShaderType::Compute, area_source}});
+        m_accumulate_program = std::make_unique<GLSLProgram>(
+            GLSLProgram::ShaderSourceList{{GLSLProgram::ShaderType::Compute, triangle_source}});
+        m_resolve_program = std::make_unique<GLSLProgram>(GLSLProgram::ShaderSourceList{
+            {GLSLProgram::ShaderType::Compute, detail::normal_generator_resolve_source}});
+    }
+
+    inline void MeshNormalGenerator::recompute(Mesh const& mesh, GLuint position_attrib, GLuint normal_attrib)
+    {
+        recompute(mesh, position_attrib, normal_attrib, 0, 0, false);
+    }
+
+    inline void MeshNormalGenerator::recompute(Mesh const& mesh,
+                                               GLuint      position_attrib,
+                                               GLuint      normal_attrib,
+                                               GLuint      texcoord_attrib,
+                                               GLuint      tangent_attrib)
+    {
+        recompute(mesh, position_attrib, normal_attrib, texcoord_attrib, tangent_attrib, true);
+    }
+
+    inline void MeshNormalGenerator::recompute(Mesh const& mesh,
+                                               GLuint      position_attrib,
+                                               GLuint      normal_attrib,
+                                               GLuint      texcoord_attrib,
+                                               GLuint      tangent_attrib,
+                                               bool        tangents)
+    {
+        if (mesh.getPrimitiveType() != GL_TRIANGLES)
+        {
+            throw MeshException("MeshNormalGenerator::recompute - only GL_TRIANGLES meshes are supported");
+        }
+
+        checkAttribute(mesh, position_attrib, 3, 4);
+        checkAttribute(mesh, normal_attrib, 3, 4);
+        if (tangents)
+        {
+            checkAttribute(mesh, texcoord_attrib, 2, 4);
+            checkAttribute(mesh, tangent_attrib, 3, 4);
+        }
+
+        GLuint vertex_cnt = mesh.getVertexCount(mesh.getAttributeBufferIndex(position_attrib));
+
+        GLuint index_size = 4;
+        if (mesh.getIndexType() == GL_UNSIGNED_SHORT)
+        {
+            index_size = 2;
+        }
+        else if (mesh.getIndexType() == GL_UNSIGNED_BYTE)
+        {
+            index_size = 1;
+        }
+
+        GLsizeiptr accumulators_byte_size =
+            static_cast<GLsizeiptr>(vertex_cnt) * accumulator_cnt * static_cast<GLsizeiptr>(sizeof(GLint));
+        if (m_accumulators == nullptr || m_accumulators->getByteSize() < accumulators_byte_size)
+        {
+            m_accumulators = std::make_unique<BufferObject>(
+                GL_SHADER_STORAGE_BUFFER, std::vector<GLint>(static_cast<size_t>(vertex_cnt) * accumulator_cnt, 0));
+        }
+
+        // indices are read in whole words, so the last word of the buffer has to exist completely
+        BufferObject* ibo = mesh.getIboPtr().get();
+        if (ibo->getByteSize() % 4 != 0)
+        {
+            GLsizeiptr padded_byte_size = (ibo->getByteSize() + 3) / 4 * 4;
+            if (m_padded_indices == nullptr || m_padded_indices->getByteSize() < padded_byte_size)
+            {
+                m_padded_indices = std::make_unique<BufferObject>(
+                    GL_SHADER_STORAGE_BUFFER, static_cast<GLvoid const*>(nullptr), padded_byte_size);
+            }
+            BufferObject::copy(ibo, m_padded_indices.get(), 0, 0, ibo->getByteSize());
+            ibo = m_padded_indices.get();
+        }
+
+        ibo->bindAs(GL_SHADER_STORAGE_BUFFER, 0);
+        m_accumulators->bindAs(GL_SHADER_STORAGE_BUFFER, 3);
+
+        // largest adjacent triangle area per vertex, used to normalize the weights
+        m_area_program->use();
+        m_area_program->setUniform("index_size", index_size);
+        m_area_program->setUniform("vertex_cnt", vertex_cnt);
+        bindAttribute(mesh, position_attrib, 1, *m_area_program, "position_layout");
+        dispatchTriangles(mesh, *m_area_program);
+
+        MemoryBarrierTracker::barrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // area weighted sums of face normals (and tangents)
+        m_accumulate_program->use();
+        m_accumulate_program->setUniform("index_size", index_size);
+        m_accumulate_program->setUniform("vertex_cnt", vertex_cnt);
+        m_accumulate_program->setUniform("tangents", tangents ? 1 : 0);
+        bindAttribute(mesh, position_attrib, 1, *m_accumulate_program, "position_layout");
+        if (tangents)
+        {
+            bindAttribute(mesh, texcoord_attrib, 2, *m_accumulate_program, "texcoord_layout");
+        }
+        dispatchTriangles(mesh, *m_accumulate_program);
+
+        MemoryBarrierTracker::barrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // normalize and write to the vertex buffers
+        m_resolve_program->use();
+        m_resolve_program->setUniform("vertex_cnt", vertex_cnt);
+        m_resolve_program->setUniform("tangents", tangents ? 1 : 0);
+        bindAttribute(mesh, normal_attrib, 5, *m_resolve_program, "normal_layout");
+        if (tangents)
+        {
+            bindAttribute(mesh, tangent_attrib, 6, *m_resolve_program, "tangent_layout");
+            m_resolve_program->setUniform("tangent_size", static_cast<GLuint>(mesh.getAttribute(tangent_attrib).size));
+        }
+        dispatch(*m_resolve_program, vertex_cnt);
+
+        if (m_barrier_tracker != nullptr)
+        {
+            m_barrier_tracker->write(*mesh.getVbos()[mesh.getAttributeBufferIndex(normal_attrib)],
+                                     MemoryBarrierTracker::Write::ShaderStorage);
+            if (tangents)
+            {
+                m_barrier_tracker->write(*mesh.getVbos()[mesh.getAttributeBufferIndex(tangent_attrib)],
+                                         MemoryBarrierTracker::Write::ShaderStorage);
+            }
+        }
+        else
+        {
+            MemoryBarrierTracker::barrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        }
+    }
+
+    inline void MeshNormalGenerator::bindAttribute(Mesh const&   mesh,
+                                                   GLuint        attrib_idx,
+                                                   GLuint        binding,
+                                                   GLSLProgram&  program,
+                                                   GLchar const* layout_uniform) const
+    {
+        std::size_t vbo_idx = mesh.getAttributeBufferIndex(attrib_idx);
+
+        mesh.getVbos()[vbo_idx]->bindAs(GL_SHADER_STORAGE_BUFFER, binding);
+        program.setUniform(layout_uniform,
+                           static_cast<GLuint>(mesh.getVertexLayouts()[vbo_idx].stride / 4),
+                           static_cast<GLuint>(mesh.getAttribute(attrib_idx).offset / 4));
+    }
+
+    inline void MeshNormalGenerator::checkAttribute(Mesh const& mesh, GLuint attrib_idx, GLint min_size, GLint max_size)
+    {
+        auto const& attribute = mesh.getAttribute(attrib_idx);
+        auto const& layout = mesh.getVertexLayouts()[mesh.getAttributeBufferIndex(attrib_idx)];
+
+        if (attribute.type != GL_FLOAT || attribute.size < min_size || attribute.size > max_size)
+        {
+            throw MeshException("MeshNormalGenerator::recompute - vertex attribute " + std::to_string(attrib_idx) +
+                                " has an unsupported type or size");
+        }
+
+        if (attribute.offset % 4 != 0 || layout.stride % 4 != 0)
+        {
+            throw MeshException("MeshNormalGenerator::recompute - vertex attribute " + std::to_string(attrib_idx) +
+                                " is not 4 byte aligned");
+        }
+    }
+
+    inline void MeshNormalGenerator::dispatchTriangles(Mesh const& mesh, GLSLProgram& program)
+    {
+        auto const& submeshes = mesh.getSubmeshes();
+        if (submeshes.empty())
+        {
+            GLuint triangle_cnt = static_cast<GLuint>(mesh.getIndicesCount() / 3);
+            program.setUniform("first_index", 0u);
+            program.setUniform("triangle_cnt", triangle_cnt);
+            program.setUniform("base_vertex", 0);
+            dispatch(program, triangle_cnt);
+            return;
+        }
+
+        for (auto const& submesh : submeshes)
+        {
+            program.setUniform("first_index", submesh.first_idx);
+            program.setUniform("triangle_cnt", submesh.index_cnt / 3);
+            program.setUniform("base_vertex", submesh.base_vertex);
+            dispatch(program, submesh.index_cnt / 3);
+        }
+    }
+
+    inline void MeshNormalGenerator::dispatch(GLSLProgram& program, GLuint invocation_cnt)
+    {
+        program.dispatchComputeGroups((invocation_cnt + detail::normal_generator_group_size - 1) /
+                                      detail::normal_generator_group_size);
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_MESHNORMALGENERATOR_HPP
@@ -0,0 +1,499 @@
+/*
+ * NamePool.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_NAMEPOOL_HPP
+#define GLOWL_NAMEPOOL_HPP
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Context.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /** OpenGL object types that are handed out by name pools */
+    enum class NameType
+    {
+        Buffer,
+        Texture, ///< One pool per texture target, target 0 generates names without object (for texture views)
+        VertexArray,
+        Framebuffer,
+        Sampler
+    };
+
+    /**
+     * \class NamePool
+     *
+     * \brief Pre-creates OpenGL object names in blocks and hands them out to object constructors.
+     *
+     * With a block size of n, a single glCreate* call provides the names for the next n objects.
+     * With deferred deletion enabled, released names are queued and deleted by a single glDelete* call in
+     * collect(), e.g. once per frame. Names that are released as recyclable (objects whose storage can be
+     * respecified, i.e. mutable buffers) are not deleted but returned to the pool on collect().
+     *
+     * The defaults (block size 1, immediate deletion) behave exactly like creating and deleting every object
+     * individually. Use getNamePool() to access the pools of the current context.
+     */
+    class NamePool
+    {
+    public:
+        NamePool(NameType type, GLenum target = 0);
+        NamePool(const NamePool&) = delete;
+        NamePool& operator=(const NamePool&) = delete;
+
+        /**
+         * Note: Names still owned by the pool are not deleted, since that requires the context the pool belongs to.
+         * Call clear() beforehand (or use releaseNamePools()).
+         */
+        ~NamePool() = default;
+
+        void    setBlockSize(GLsizei block_size);
+        GLsizei getBlockSize() const;
+
+        void setDeferredDeletion(bool deferred_deletion);
+        bool getDeferredDeletion() const;
+
+        /**
+         * \brief Returns an unused name, creating a new block of names if the pool is empty.
+         */
+        GLuint acquire();
+
+        /**
+         * \brief Writes n unused names to the given array, all missing names are created by a single call.
+         */
+        void acquire(GLsizei n, GLuint* names);
+
+        /**
+         * \brief Makes sure the next n acquisitions do not create names individually.
+         */
+        void reserve(GLsizei n);
+
+        /**
+         * \brief Returns a name to the pool.
+         *
+         * \param recyclable True if the object may be handed out again instead of being deleted
+         * (only takes effect with deferred deletion)
+         */
+        void release(GLuint name, bool recyclable = false);
+
+        /**
+         * \brief Deletes all names queued for deletion and makes released recyclable names available again.
+         *
+         * Note: The context of the pool has to be current.
+         */
+        void collect();
+
+        /**
+         * \brief Deletes all names owned by the pool, including unused names.
+         *
+         * Note: The context of the pool has to be current.
+         */
+        void clear();
+
+        size_t getFreeCount() const;
+        size_t getPendingCount() const;
+
+        NameType getType() const;
+        GLenum   getTarget() const;
+
+    private:
+        /** Appends n new names to the free list, requires the lock */
+        void refill(GLsizei n);
+
+        void createNames(GLsizei n, GLuint* names) const;
+        void deleteNames(GLsizei n, GLuint const* names) const;
+
+        NameType m_type;
+        GLenum   m_target;
+        GLsizei  m_block_size;
+        bool     m_deferred_deletion;
+
+        mutable std::mutex  m_mutex;
+        std::vector<GLuint> m_free;           ///< Unused names, handed out from the back
+        std::vector<GLuint> m_pending_delete; ///< Released names waiting for collect()
+        std::vector<GLuint> m_pending_reuse;  ///< Released recyclable names waiting for collect()
+    };
+
+    namespace detail
+    {
+        struct NamePoolEntry
+        {
+            ContextId                 context;
+            std::unique_ptr<NamePool> pool;
+        };
+
+        struct NamePoolRegistry
+        {
+            std::mutex                 mutex;
+            std::vector<NamePoolEntry> entries;
+            GLsizei                    block_sizes[5] = {1, 1, 1, 1, 1};
+            bool                       deferred_deletion[5] = {false, false, false, false, false};
+        };
+
+        inline NamePoolRegistry& namePoolRegistry()
+        {
+            static NamePoolRegistry registry;
+            return registry;
+        }
+
+        inline int& deferredErrorCheckDepth()
+        {
+            static thread_local int depth = 0;
+            return depth;
+        }
+    } // namespace detail
+
+    /**
+     * \brief Returns the name pool of the given type (and texture target) for the current context.
+     */
+    inline NamePool& getNamePool(NameType type, GLenum target = 0)
+    {
+        auto&     registry = detail::namePoolRegistry();
+        ContextId context = getCurrentContext();
+
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        // only a handful of contexts and types is expected, so a linear search is the fastest lookup
+        for (auto& entry : registry.entries)
+        {
+            if (entry.context == context && entry.pool->getType() == type && entry.pool->getTarget() == target)
+            {
+                return *entry.pool;
+            }
+        }
+
+        auto pool = std::make_unique<NamePool>(type, target);
+        pool->setBlockSize(registry.block_sizes[static_cast<int>(type)]);
+        pool->setDeferredDeletion(registry.deferred_deletion[static_cast<int>(type)]);
+        registry.entries.push_back({context, std::move(pool)});
+
+        return *registry.entries.back().pool;
+    }
+
+    /**
+     * \brief Sets block size and deletion mode of all existing and future pools of the given type in all contexts.
+     */
+    inline void configureNamePools(NameType type, GLsizei block_size, bool deferred_deletion)
+    {
+        auto& registry = detail::namePoolRegistry();
+
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        registry.block_sizes[static_cast<int>(type)] = block_size;
+        registry.deferred_deletion[static_cast<int>(type)] = deferred_deletion;
+
+        for (auto& entry : registry.entries)
+        {
+            if (entry.pool->getType() == type)
+            {
+                entry.pool->setBlockSize(block_size);
+                entry.pool->setDeferredDeletion(deferred_deletion);
+            }
+        }
+    }
+
+    /**
+     * \brief Calls collect() on all pools of the current context, e.g. once per frame.
+     */
+    inline void collectNamePools()
+    {
+        auto&     registry = detail::namePoolRegistry();
+        ContextId context = getCurrentContext();
+
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        for (auto& entry : registry.entries)
+        {
+            if (entry.context == context)
+            {
+                entry.pool->collect();
+            }
+        }
+    }
+
+    /**
+     * \brief Deletes all names owned by the pools of the current context and removes the pools.
+     * Call this before destroying a context.
+     */
+    inline void releaseNamePools()
+    {
+        auto&     registry = detail::namePoolRegistry();
+        ContextId context = getCurrentContext();
+
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        for (auto it = registry.entries.begin(); it != registry.entries.end();)
+        {
+            if (it->context == context)
+            {
+                it->pool->clear();
+                it = registry.entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    /**
+     * \class DeferredErrorCheck
+     *
+     * \brief While an instance exists on the calling thread, object constructors skip their glGetError check.
+     *
+     * Used by bulk constructors (e.g. Mesh::createBatch) to validate a whole batch of objects with a single
+     * glGetError, which is a synchronization point on multithreaded drivers. The owner of the scope is
+     * responsible for checking errors afterwards.
+     */
+    class DeferredErrorCheck
+    {
+    public:
+        DeferredErrorCheck()
+        {
+            ++detail::deferredErrorCheckDepth();
+        }
+
+        ~DeferredErrorCheck()
+        {
+            --detail::deferredErrorCheckDepth();
+        }
+
+        DeferredErrorCheck(const DeferredErrorCheck&) = delete;
+        DeferredErrorCheck& operator=(const DeferredErrorCheck&) = delete;
+
+        static bool isActive()
+        {
+            return detail::deferredErrorCheckDepth() > 0;
+        }
+    };
+
+    inline NamePool::NamePool(NameType type, GLenum target)
+        : m_type(type), m_target(target), m_block_size(1), m_deferred_deletion(false)
+    {
+    }
+
+    inline void NamePool::setBlockSize(GLsizei block_size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_block_size = std::max<GLsizei>(block_size, 1);
+    }
+
+    inline GLsizei NamePool::getBlockSize() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_block_size;
+    }
+
+    inline void NamePool::setDeferredDeletion(bool deferred_deletion)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_deferred_deletion = deferred_deletion;
+    }
+
+    inline bool NamePool::getDeferredDeletion() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_deferred_deletion;
+    }
+
+    inline GLuint NamePool::acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_free.empty())
+        {
+            refill(m_block_size);
+        }
+
+        GLuint name = m_free.back();
+        m_free.pop_back();
+
+        return name;
+    }
+
+    inline void NamePool::acquire(GLsizei n, GLuint* names)
+    {
+        if (n <= 0)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_free.size() < static_cast<size_t>(n))
+        {
+            refill(std::max<GLsizei>(n - static_cast<GLsizei>(m_free.size()), m_block_size));
+        }
+
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            names[i] = m_free.back();
+            m_free.pop_back();
+        }
+    }
+
+    inline void NamePool::reserve(GLsizei n)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_free.size() < static_cast<size_t>(n))
+        {
+            refill(n - static_cast<GLsizei>(m_free.size()));
+        }
+    }
+
+    inline void NamePool::release(GLuint name, bool recyclable)
+    {
+        if (name == 0)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_deferred_deletion)
+        {
+            deleteNames(1, &name);
+        }
+        else if (recyclable)
+        {
+            m_pending_reuse.push_back(name);
+        }
+        else
+        {
+            m_pending_delete.push_back(name);
+        }
+    }
+
+    inline void NamePool::collect()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        deleteNames(static_cast<GLsizei>(m_pending_delete.size()), m_pending_delete.data());
+        m_pending_delete.clear();
+
+        if (m_type == NameType::Buffer)
+        {
+            // drop the storage of recycled buffers, the next owner respecifies it anyway
+            for (GLuint name : m_pending_reuse)
+            {
+                glNamedBufferData(name, 0, nullptr, GL_STATIC_DRAW);
+            }
+        }
+
+        m_free.insert(m_free.end(), m_pending_reuse.begin(), m_pending_reuse.end());
+        m_pending_reuse.clear();
+    }
+
+    inline void NamePool::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_pending_delete.insert(m_pending_delete.end(), m_free.begin(), m_free.end());
+        m_pending_delete.insert(m_pending_delete.end(), m_pending_reuse.begin(), m_pending_reuse.end());
+        m_free.clear();
+        m_pending_reuse.clear();
+
+        deleteNames(static_cast<GLsizei>(m_pending_delete.size()), m_pending_delete.data());
+        m_pending_delete.clear();
+    }
+
+    inline size_t NamePool::getFreeCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_free.size();
+    }
+
+    inline size_t NamePool::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pending_delete.size() + m_pending_reuse.size();
+    }
+
+    inline NameType NamePool::getType() const
+    {
+        return m_type;
+    }
+
+    inline GLenum NamePool::getTarget() const
+    {
+        return m_target;
+    }
+
+    inline void NamePool::refill(GLsizei n)
+    {
+        size_t offset = m_free.size();
+        m_free.resize(offset + static_cast<size_t>(n));
+        createNames(n, m_free.data() + offset);
+
+        // hand out names in creation order
+        std::reverse(m_free.begin() + offset, m_free.end());
+    }
+
+    inline void NamePool::createNames(GLsizei n, GLuint* names) const
+    {
+        switch (m_type)
+        {
+        case NameType::Buffer:
+            glCreateBuffers(n, names);
+            break;
+        case NameType::Texture:
+            if (m_target == 0)
+            {
+                // texture views require names that have never been bound
+                glGenTextures(n, names);
+            }
+            else
+            {
+                glCreateTextures(m_target, n, names);
+            }
+            break;
+        case NameType::VertexArray:
+            glCreateVertexArrays(n, names);
+            break;
+        case NameType::Framebuffer:
+            glCreateFramebuffers(n, names);
+            break;
+        case NameType::Sampler:
+            glCreateSamplers(n, names);
+            break;
+        }
+    }
+
+    inline void NamePool::deleteNames(GLsizei n, GLuint const* names) const
+    {
+        if (n == 0)
+        {
+            return;
+        }
+
+        switch (m_type)
+        {
+        case NameType::Buffer:
+            glDeleteBuffers(n, names);
+            break;
+        case NameType::Texture:
+            glDeleteTextures(n, names);
+            break;
+        case NameType::VertexArray:
+            glDeleteVertexArrays(n, names);
+            break;
+        case NameType::Framebuffer:
+            glDeleteFramebuffers(n, names);
+            break;
+        case NameType::Sampler:
+            glDeleteSamplers(n, names);
+            break;
+        }
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_NAMEPOOL_HPP
@@ -0,0 +1,729 @@
+/*
+ * RenderState.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_RENDERSTATE_HPP
+#define GLOWL_RENDERSTATE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include "Context.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \brief Blend state, the defaults match the initial OpenGL state.
+     */
+    struct BlendState
+    {
+        bool      enabled = false;
+        GLenum    src_rgb = GL_ONE;
+        GLenum    dst_rgb = GL_ZERO;
+        GLenum    src_alpha = GL_ONE;
+        GLenum    dst_alpha = GL_ZERO;
+        GLenum    equation_rgb = GL_FUNC_ADD;
+        GLenum    equation_alpha = GL_FUNC_ADD;
+        GLfloat   color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        GLboolean color_mask[4] = {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE};
+    };
+
+    /**
+     * \brief Depth test state, the defaults match the initial OpenGL state.
+     */
+    struct DepthState
+    {
+        bool   test = false;
+        bool   write = true;
+        GLenum func = GL_LESS;
+    };
+
+    struct StencilFaceState
+    {
+        GLenum func = GL_ALWAYS;
+        GLint  ref = 0;
+        GLuint read_mask = 0xFFFFFFFF;
+        GLuint write_mask = 0xFFFFFFFF;
+        GLenum stencil_fail = GL_KEEP;
+        GLenum depth_fail = GL_KEEP;
+        GLenum pass = GL_KEEP;
+    };
+
+    /**
+     * \brief Stencil test state, the defaults match the initial OpenGL state.
+     */
+    struct StencilState
+    {
+        bool             test = false;
+        StencilFaceState front;
+        StencilFaceState back;
+    };
+
+    /**
+     * \brief Rasterization state, the defaults match the initial OpenGL state.
+     */
+    struct RasterState
+    {
+        bool    cull = false;
+        GLenum  cull_face = GL_BACK;
+        GLenum  front_face = GL_CCW;
+        GLenum  polygon_mode = GL_FILL;
+        bool    polygon_offset = false; ///< GL_POLYGON_OFFSET_FILL
+        GLfloat offset_factor = 0.0f;
+        GLfloat offset_units = 0.0f;
+        bool    scissor = false; ///< Scissor test, the rectangle is part of the ViewportState
+        bool    depth_clamp = false;
+    };
+
+    namespace detail
+    {
+        inline std::uint64_t hashRenderState(std::uint64_t hash, std::uint32_t value)
+        {
+            return (hash ^ value) * 1099511628211ull;
+        }
+
+        inline std::uint64_t hashRenderState(std::uint64_t hash, GLfloat value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return hashRenderState(hash, bits);
+        }
+
+        /** Mixes all bits into the upper ones, which are the ones that end up in sort keys */
+        inline std::uint64_t finalizeRenderStateHash(std::uint64_t hash)
+        {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        inline bool operator==(StencilFaceState const& lhs, StencilFaceState const& rhs)
+        {
+            return lhs.func == rhs.func && lhs.ref == rhs.ref && lhs.read_mask == rhs.read_mask &&
+                   lhs.write_mask == rhs.write_mask && lhs.stencil_fail == rhs.stencil_fail &&
+                   lhs.depth_fail == rhs.depth_fail && lhs.pass == rhs.pass;
+        }
+    } // namespace detail
+
+    /**
+     * \class RenderState
+     *
+     * \brief Immutable combination of blend, depth, stencil and rasterization state.
+     *
+     * The hash is computed once on construction. Equal states have equal hashes, so the upper bits of getHash()
+     * can be used in the sort key of draw calls to group draws with the same state. States are applied with a
+     * RenderStateTracker, which only issues the calls for the parts that differ from the current state.
+     */
+    class RenderState
+    {
+    public:
+        RenderState(BlendState const&   blend = BlendState(),
+                    DepthState const&   depth = DepthState(),
+                    StencilState const& stencil = StencilState(),
+                    RasterState const&  raster = RasterState());
+
+        BlendState const&   getBlend() const;
+        DepthState const&   getDepth() const;
+        StencilState const& getStencil() const;
+        RasterState const&  getRaster() const;
+
+        std::uint64_t getHash() const;
+
+        bool operator==(RenderState const& rhs) const;
+        bool operator!=(RenderState const& rhs) const;
+
+    private:
+        BlendState    m_blend;
+        DepthState    m_depth;
+        StencilState  m_stencil;
+        RasterState   m_raster;
+        std::uint64_t m_hash;
+    };
+
+    /**
+     * \class ViewportState
+     *
+     * \brief Immutable viewport, scissor rectangle and depth range.
+     */
+    class ViewportState
+    {
+    public:
+        /**
+         * \brief Viewport with a scissor rectangle of the same size.
+         */
+        ViewportState(GLint   x,
+                      GLint   y,
+                      GLsizei width,
+                      GLsizei height,
+                      GLfloat depth_near = 0.0f,
+                      GLfloat depth_far = 1.0f);
+
+        ViewportState(GLint   x,
+                      GLint   y,
+                      GLsizei width,
+                      GLsizei height,
+                      GLint   scissor_x,
+                      GLint   scissor_y,
+                      GLsizei scissor_width,
+                      GLsizei scissor_height,
+                      GLfloat depth_near = 0.0f,
+                      GLfloat depth_far = 1.0f);
+
+        /** x, y, width and height */
+        GLint const* getViewport() const;
+
+        /** x, y, width and height */
+        GLint const* getScissor() const;
+
+        /** near and far */
+        GLfloat const* getDepthRange() const;
+
+        std::uint64_t getHash() const;
+
+        bool operator==(ViewportState const& rhs) const;
+        bool operator!=(ViewportState const& rhs) const;
+
+    private:
+        GLint         m_viewport[4];
+        GLint         m_scissor[4];
+        GLfloat       m_depth_range[2];
+        std::uint64_t m_hash;
+    };
+
+    /**
+     * \class RenderStateTracker
+     *
+     * \brief Applies RenderStates and ViewportStates with the minimal number of OpenGL calls.
+     *
+     * The tracker remembers the state it applied per context (see setCurrentContext()) and compares new states
+     * against it: states equal to the last requested one cost a hash comparison, otherwise only the calls for
+     * differing values are issued. Parts that have no effect, e.g. blend functions while blending is disabled, are not
+     * set until they are enabled, so the applied state can differ from the last requested one. Write masks are
+     * always set since they also apply to clears. The state of a context is unknown until the first apply, which
+     * sets everything.
+     *
+     * Call invalidate() after OpenGL state was changed without the tracker, e.g. by ShadowAtlas::begin() or by
+     * other libraries.
+     */
+    class RenderStateTracker
+    {
+    public:
+        struct Statistics
+        {
+            std::uint64_t apply_calls = 0;    ///< apply() calls
+            std::uint64_t skipped_states = 0; ///< apply() calls of states equal to the last requested one
+            std::uint64_t issued_calls = 0;   ///< OpenGL calls issued
+        };
+
+        RenderStateTracker() = default;
+        RenderStateTracker(const RenderStateTracker&) = delete;
+        RenderStateTracker& operator=(const RenderStateTracker&) = delete;
+
+        void apply(RenderState const& state);
+        void apply(ViewportState const& viewport);
+
+        /**
+         * \brief Forgets the state of the current context, the next apply() sets all of it.
+         */
+        void invalidate();
+
+        Statistics const& getStatistics() const;
+
+        void resetStatistics();
+
+    private:
+        struct ContextState
+        {
+            bool          state_valid = false;
+            bool          viewport_valid = false;
+            RenderState   requested; ///< Last state passed to apply()
+            RenderState   applied;   ///< OpenGL state, lazily skipped parts keep their previous values
+            ViewportState viewport = ViewportState(0, 0, 0, 0);
+        };
+
+        void setEnabled(GLenum capability, bool enabled);
+
+        void applyBlend(BlendState& current, BlendState const& blend, bool all);
+        void applyDepth(DepthState& current, DepthState const& depth, bool all);
+        void applyStencil(StencilState& current, StencilState const& stencil, bool all);
+        void applyRaster(RasterState& current, RasterState const& raster, bool all);
+
+        std::unordered_map<ContextId, ContextState> m_contexts;
+        Statistics                                  m_statistics;
+    };
+
+    inline RenderState::RenderState(BlendState const&   blend,
+                                    DepthState const&   depth,
+                                    StencilState const& stencil,
+                                    RasterState const&  raster)
+        : m_blend(blend), m_depth(depth), m_stencil(stencil), m_raster(raster), m_hash(14695981039346656037ull)
+    {
+        using detail::hashRenderState;
+
+        m_hash = hashRenderState(m_hash, std::uint32_t(blend.enabled));
+        for (GLenum value : {blend.src_rgb,
+                             blend.dst_rgb,
+                             blend.src_alpha,
+                             blend.dst_alpha,
+                             blend.equation_rgb,
+                             blend.equation_alpha})
+        {
+            m_hash = hashRenderState(m_hash, std::uint32_t(value));
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            m_hash = hashRenderState(m_hash, blend.color[i]);
+            m_hash = hashRenderState(m_hash, std::uint32_t(blend.color_mask[i]));
+        }
+
+        m_hash = hashRenderState(m_hash, std::uint32_t(depth.test));
+        m_hash = hashRenderState(m_hash, std::uint32_t(depth.write));
+        m_hash = hashRenderState(m_hash, std::uint32_t(depth.func));
+
+        m_hash = hashRenderState(m_hash, std::uint32_t(stencil.test));
+        for (auto const* face : {&stencil.front, &stencil.back})
+        {
+            m_hash = hashRenderState(m_hash, std::uint32_t(face->func));
+            m_hash = hashRenderState(m_hash, std::uint32_t(face->ref));
+            m_hash = hashRenderState(m_hash, std::uint32_t(face->read_mask));
+            m_hash = hashRenderState(m_hash, std::uint32_t(face->write_mask));
+            m_hash = hashRenderState(m_hash, std::uint32_t(face->stencil_fail));
+            m_hash = hashRenderState(m_hash, std::uint32_t(face->depth_fail));
+            m_hash = hashRenderState(m_hash, std::uint32_t(face->pass));
+        }
+
+        m_hash = hashRenderState(m_hash, std::uint32_t(raster.cull));
+        m_hash = hashRenderState(m_hash, std::uint32_t(raster.cull_face));
+        m_hash = hashRenderState(m_hash, std::uint32_t(raster.front_face));
+        m_hash = hashRenderState(m_hash, std::uint32_t(raster.polygon_mode));
+        m_hash = hashRenderState(m_hash, std::uint32_t(raster.polygon_offset));
+        m_hash = hashRenderState(m_hash, raster.offset_factor);
+        m_hash = hashRenderState(m_hash, raster.offset_units);
+        m_hash = hashRenderState(m_hash, std::uint32_t(raster.scissor));
+        m_hash = hashRenderState(m_hash, std::uint32_t(raster.depth_clamp));
+
+        m_hash = detail::finalizeRenderStateHash(m_hash);
+    }
+
+    inline BlendState const& RenderState::getBlend() const
+    {
+        return m_blend;
+    }
+
+    inline DepthState const& RenderState::getDepth() const
+    {
+        return m_depth;
+    }
+
+    inline StencilState const& RenderState::getStencil() const
+    {
+        return m_stencil;
+    }
+
+    inline RasterState const& RenderState::getRaster() const
+    {
+        return m_raster;
+    }
+
+    inline std::uint64_t RenderState::getHash() const
+    {
+        return m_hash;
+    }
+
+    inline bool RenderState::operator==(RenderState const& rhs) const
+    {
+        using detail::operator==;
+
+        BlendState const&  b0 = m_blend;
+        BlendState const&  b1 = rhs.m_blend;
+        RasterState const& r0 = m_raster;
+        RasterState const& r1 = rhs.m_raster;
+
+        return m_hash == rhs.m_hash && b0.enabled == b1.enabled && b0.src_rgb == b1.src_rgb &&
+               b0.dst_rgb == b1.dst_rgb && b0.src_alpha == b1.src_alpha && b0.dst_alpha == b1.dst_alpha &&
+               b0.equation_rgb == b1.equation_rgb && b0.equation_alpha == b1.equation_alpha &&
+               std::memcmp(b0.color, b1.color, sizeof(b0.color)) == 0 &&
+               std::memcmp(b0.color_mask, b1.color_mask, sizeof(b0.color_mask)) == 0 &&
+               m_depth.test == rhs.m_depth.test && m_depth.write == rhs.m_depth.write &&
+               m_depth.func == rhs.m_depth.func && m_stencil.test == rhs.m_stencil.test &&
+               m_stencil.front == rhs.m_stencil.front && m_stencil.back == rhs.m_stencil.back && r0.cull == r1.cull &&
+               r0.cull_face == r1.cull_face && r0.front_face == r1.front_face && r0.polygon_mode == r1.polygon_mode &&
+               r0.polygon_offset == r1.polygon_offset && r0.offset_factor == r1.offset_factor &&
+               r0.offset_units == r1.offset_units && r0.scissor == r1.scissor && r0.depth_clamp == r1.depth_clamp;
+    }
+
+    inline bool RenderState::operator!=(RenderState const& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    inline ViewportState::ViewportState(
+        GLint x, GLint y, GLsizei width, GLsizei height, GLfloat depth_near, GLfloat depth_far)
+        : ViewportState(x, y, width, height, x, y, width, height, depth_near, depth_far)
+    {
+    }
+
+    inline ViewportState::ViewportState(GLint   x,
+                                        GLint   y,
+                                        GLsizei width,
+                                        GLsizei height,
+                                        GLint   scissor_x,
+                                        GLint   scissor_y,
+                                        GLsizei scissor_width,
+                                        GLsizei scissor_height,
+                                        GLfloat depth_near,
+                                        GLfloat depth_far)
+        : m_viewport{x, y, width, height},
+          m_scissor{scissor_x, scissor_y, scissor_width, scissor_height},
+          m_depth_range{depth_near, depth_far},
+          m_hash(14695981039346656037ull)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            m_hash = detail::hashRenderState(m_hash, std::uint32_t(m_viewport[i]));
+            m_hash = detail::hashRenderState(m_hash, std::uint32_t(m_scissor[i]));
+        }
+        m_hash = detail::hashRenderState(m_hash, depth_near);
+        m_hash = detail::hashRenderState(m_hash, depth_far);
+        m_hash = detail::finalizeRenderStateHash(m_hash);
+    }
+
+    inline GLint const* ViewportState::getViewport() const
+    {
+        return m_viewport;
+    }
+
+    inline GLint const* ViewportState::getScissor() const
+    {
+        return m_scissor;
+    }
+
+    inline GLfloat const* ViewportState::getDepthRange() const
+    {
+        return m_depth_range;
+    }
+
+    inline std::uint64_t ViewportState::getHash() const
+    {
+        return m_hash;
+    }
+
+    inline bool ViewportState::operator==(ViewportState const& rhs) const
+    {
+        return m_hash == rhs.m_hash && std::memcmp(m_viewport, rhs.m_viewport, sizeof(m_viewport)) == 0 &&
+               std::memcmp(m_scissor, rhs.m_scissor, sizeof(m_scissor)) == 0 &&
+               m_depth_range[0] == rhs.m_depth_range[0] && m_depth_range[1] == rhs.m_depth_range[1];
+    }
+
+    inline bool ViewportState::operator!=(ViewportState const& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    inline void RenderStateTracker::apply(RenderState const& state)
+    {
+        ++m_statistics.apply_calls;
+
+        ContextState& context = m_contexts[getCurrentContext()];
+        if (context.state_valid && context.requested == state)
+        {
+            ++m_statistics.skipped_states;
+            return;
+        }
+
+        bool all = !context.state_valid;
+
+        // the applied state is rebuilt from the parts that were actually set
+        BlendState   blend = context.applied.getBlend();
+        DepthState   depth = context.applied.getDepth();
+        StencilState stencil = context.applied.getStencil();
+        RasterState  raster = context.applied.getRaster();
+
+        applyBlend(blend, state.getBlend(), all);
+        applyDepth(depth, state.getDepth(), all);
+        applyStencil(stencil, state.getStencil(), all);
+        applyRaster(raster, state.getRaster(), all);
+
+        context.applied = RenderState(blend, depth, stencil, raster);
+        context.requested = state;
+        context.state_valid = true;
+    }
+
+    inline void RenderStateTracker::apply(ViewportState const& viewport)
+    {
+        ++m_statistics.apply_calls;
+
+        ContextState& context = m_contexts[getCurrentContext()];
+        if (context.viewport_valid && context.viewport == viewport)
+        {
+            ++m_statistics.skipped_states;
+            return;
+        }
+
+        bool           all = !context.viewport_valid;
+        GLint const*   rect = viewport.getViewport();
+        GLint const*   scissor = viewport.getScissor();
+        GLfloat const* range = viewport.getDepthRange();
+        GLint const*   current_rect = context.viewport.getViewport();
+        GLint const*   current_scissor = context.viewport.getScissor();
+        GLfloat const* current_range = context.viewport.getDepthRange();
+
+        if (all || std::memcmp(rect, current_rect, 4 * sizeof(GLint)) != 0)
+        {
+            glViewport(rect[0], rect[1], rect[2], rect[3]);
+            GLOWL_TRACE(Opcode::Viewport, {rect[0], rect[1], rect[2], rect[3]});
+            ++m_statistics.issued_calls;
+        }
+        if (all || std::memcmp(scissor, current_scissor, 4 * sizeof(GLint)) != 0)
+        {
+            glScissor(scissor[0], scissor[1], scissor[2], scissor[3]);
+            GLOWL_TRACE(Opcode::Scissor, {scissor[0], scissor[1], scissor[2], scissor[3]});
+            ++m_statistics.issued_calls;
+        }
+        if (all || range[0] != current_range[0] || range[1] != current_range[1])
+        {
+            glDepthRangef(range[0], range[1]);
+            GLOWL_TRACE(Opcode::DepthRange, {trace::floatBits(range[0]), trace::floatBits(range[1])});
+            ++m_statistics.issued_calls;
+        }
+
+        context.viewport = viewport;
+        context.viewport_valid = true;
+    }
+
+    inline void RenderStateTracker::invalidate()
+    {
+        ContextState& context = m_contexts[getCurrentContext()];
+        context.state_valid = false;
+        context.viewport_valid = false;
+    }
+
+    inline RenderStateTracker::Statistics const& RenderStateTracker::getStatistics() const
+    {
+        return m_statistics;
+    }
+
+    inline void RenderStateTracker::resetStatistics()
+    {
+        m_statistics = Statistics();
+    }
+
+    inline void RenderStateTracker::setEnabled(GLenum capability, bool enabled)
+    {
+        if (enabled)
+        {
+            glEnable(capability);
+            GLOWL_TRACE(Opcode::Enable, {capability});
+        }
+        else
+        {
+            glDisable(capability);
+            GLOWL_TRACE(Opcode::Disable, {capability});
+        }
+        ++m_statistics.issued_calls;
+    }
+
+    inline void RenderStateTracker::applyBlend(BlendState& current, BlendState const& blend, bool all)
+    {
+        if (all || current.enabled != blend.enabled)
+        {
+            setEnabled(GL_BLEND, blend.enabled);
+            current.enabled = blend.enabled;
+        }
+
+        if (all || std::memcmp(current.color_mask, blend.color_mask, sizeof(blend.color_mask)) != 0)
+        {
+            glColorMask(blend.color_mask[0], blend.color_mask[1], blend.color_mask[2], blend.color_mask[3]);
+            GLOWL_TRACE(Opcode::ColorMask,
+                        {blend.color_mask[0], blend.color_mask[1], blend.color_mask[2], blend.color_mask[3]});
+            std::memcpy(current.color_mask, blend.color_mask, sizeof(blend.color_mask));
+            ++m_statistics.issued_calls;
+        }
+
+        if (!all && !blend.enabled)
+        {
+            return;
+        }
+
+        if (all || current.src_rgb != blend.src_rgb || current.dst_rgb != blend.dst_rgb ||
+            current.src_alpha != blend.src_alpha || current.dst_alpha != blend.dst_alpha)
+        {
+            glBlendFuncSeparate(blend.src_rgb, blend.dst_rgb, blend.src_alpha, blend.dst_alpha);
+            GLOWL_TRACE(Opcode::BlendFuncSeparate, {blend.src_rgb, blend.dst_rgb, blend.src_alpha, blend.dst_alpha});
+            current.src_rgb = blend.src_rgb;
+            current.dst_rgb = blend.dst_rgb;
+            current.src_alpha = blend.src_alpha;
+            current.dst_alpha = blend.dst_alpha;
+            ++m_statistics.issued_calls;
+        }
+
+        if (all || current.equation_rgb != blend.equation_rgb || current.equation_alpha != blend.equation_alpha)
+        {
+            glBlendEquationSeparate(blend.equation_rgb, blend.equation_alpha);
+            GLOWL_TRACE(Opcode::BlendEquationSeparate, {blend.equation_rgb, blend.equation_alpha});
+            current.equation_rgb = blend.equation_rgb;
+            current.equation_alpha = blend.equation_alpha;
+            ++m_statistics.issued_calls;
+        }
+
+        if (all || std::memcmp(current.color, blend.color, sizeof(blend.color)) != 0)
+        {
+            glBlendColor(blend.color[0], blend.color[1], blend.color[2], blend.color[3]);
+            GLOWL_TRACE(Opcode::BlendColor,
+                        {trace::floatBits(blend.color[0]),
+                         trace::floatBits(blend.color[1]),
+                         trace::floatBits(blend.color[2]),
+                         trace::floatBits(blend.color[3])});
+            std::memcpy(current.color, blend.color, sizeof(blend.color));
+            ++m_statistics.issued_calls;
+        }
+    }
+
+    inline void RenderStateTracker::applyDepth(DepthState& current, DepthState const& depth, bool all)
+    {
+        if (all || current.test != depth.test)
+        {
+            setEnabled(GL_DEPTH_TEST, depth.test);
+            current.test = depth.test;
+        }
+
+        // the mask also applies to glClear, so it is set regardless of the test
+        if (all || current.write != depth.write)
+        {
+            glDepthMask(depth.write ? GL_TRUE : GL_FALSE);
+            GLOWL_TRACE(Opcode::DepthMask, {depth.write ? GL_TRUE : GL_FALSE});
+            current.write = depth.write;
+            ++m_statistics.issued_calls;
+        }
+
+        if ((all || depth.test) && (all || current.func != depth.func))
+        {
+            glDepthFunc(depth.func);
+            GLOWL_TRACE(Opcode::DepthFunc, {depth.func});
+            current.func = depth.func;
+            ++m_statistics.issued_calls;
+        }
+    }
+
+    inline void RenderStateTracker::applyStencil(StencilState& current, StencilState const& stencil, bool all)
+    {
+        if (all || current.test != stencil.test)
+        {
+            setEnabled(GL_STENCIL_TEST, stencil.test);
+            current.test = stencil.test;
+        }
+
+        GLenum const faces[] = {GL_FRONT, GL_BACK};
+        for (int i = 0; i < 2; ++i)
+        {
+            StencilFaceState&       current_face = i == 0 ? current.front : current.back;
+            StencilFaceState const& face = i == 0 ? stencil.front : stencil.back;
+
+            // the write mask also applies to glClear, so it is set regardless of the test
+            if (all || current_face.write_mask != face.write_mask)
+            {
+                glStencilMaskSeparate(faces[i], face.write_mask);
+                GLOWL_TRACE(Opcode::StencilMaskSeparate, {faces[i], face.write_mask});
+                current_face.write_mask = face.write_mask;
+                ++m_statistics.issued_calls;
+            }
+
+            if (!all && !stencil.test)
+            {
+                continue;
+            }
+
+            if (all || current_face.func != face.func || current_face.ref != face.ref ||
+                current_face.read_mask != face.read_mask)
+            {
+                glStencilFuncSeparate(faces[i], face.func, face.ref, face.read_mask);
+                GLOWL_TRACE(Opcode::StencilFuncSeparate, {faces[i], face.func, face.ref, face.read_mask});
+                current_face.func = face.func;
+                current_face.ref = face.ref;
+                current_face.read_mask = face.read_mask;
+                ++m_statistics.issued_calls;
+            }
+
+            if (all || current_face.stencil_fail != face.stencil_fail || current_face.depth_fail != face.depth_fail ||
+                current_face.pass != face.pass)
+            {
+                glStencilOpSeparate(faces[i], face.stencil_fail, face.depth_fail, face.pass);
+                GLOWL_TRACE(Opcode::StencilOpSeparate, {faces[i], face.stencil_fail, face.depth_fail, face.pass});
+                current_face.stencil_fail = face.stencil_fail;
+                current_face.depth_fail = face.depth_fail;
+                current_face.pass = face.pass;
+                ++m_statistics.issued_calls;
+            }
+        }
+    }
+
+    inline void RenderStateTracker::applyRaster(RasterState& current, RasterState const& raster, bool all)
+    {
+        if (all || current.cull != raster.cull)
+        {
+            setEnabled(GL_CULL_FACE, raster.cull);
+            current.cull = raster.cull;
+        }
+        if ((all || raster.cull) && (all || current.cull_face != raster.cull_face))
+        {
+            glCullFace(raster.cull_face);
+            GLOWL_TRACE(Opcode::CullFace, {raster.cull_face});
+            current.cull_face = raster.cull_face;
+            ++m_statistics.issued_calls;
+        }
+        // the winding also determines gl_FrontFacing and the stencil face, so it is set without culling too
+        if (all || current.front_face != raster.front_face)
+        {
+            glFrontFace(raster.front_face);
+            GLOWL_TRACE(Opcode::FrontFace, {raster.front_face});
+            current.front_face = raster.front_face;
+            ++m_statistics.issued_calls;
+        }
+
+        if (all || current.polygon_mode != raster.polygon_mode)
+        {
+            glPolygonMode(GL_FRONT_AND_BACK, raster.polygon_mode);
+            GLOWL_TRACE(Opcode::PolygonMode, {GL_FRONT_AND_BACK, raster.polygon_mode});
+            current.polygon_mode = raster.polygon_mode;
+            ++m_statistics.issued_calls;
+        }
+
+        if (all || current.polygon_offset != raster.polygon_offset)
+        {
+            setEnabled(GL_POLYGON_OFFSET_FILL, raster.polygon_offset);
+            current.polygon_offset = raster.polygon_offset;
+        }
+        if ((all || raster.polygon_offset) &&
+            (all || current.offset_factor != raster.offset_factor || current.offset_units != raster.offset_units))
+        {
+            glPolygonOffset(raster.offset_factor, raster.offset_units);
+            GLOWL_TRACE(Opcode::PolygonOffset,
+                        {trace::floatBits(raster.offset_factor), trace::floatBits(raster.offset_units)});
+            current.offset_factor = raster.offset_factor;
+            current.offset_units = raster.offset_units;
+            ++m_statistics.issued_calls;
+        }
+
+        if (all || current.scissor != raster.scissor)
+        {
+            setEnabled(GL_SCISSOR_TEST, raster.scissor);
+            current.scissor = raster.scissor;
+        }
+
+        if (all || current.depth_clamp != raster.depth_clamp)
+        {
+            setEnabled(GL_DEPTH_CLAMP, raster.depth_clamp);
+            current.depth_clamp = raster.depth_clamp;
+        }
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_RENDERSTATE_HPP
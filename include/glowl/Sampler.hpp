@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "Exceptions.hpp"
+#include "NamePool.hpp"
 
 #include "glinclude.h"
 
@@ -82,11 +83,11 @@ namespace glowl
     class Sampler {
     public:
         Sampler(std::string id) : m_id(id) {
-            glCreateSamplers(1, &m_name);
+            m_name = getNamePool(NameType::Sampler).acquire();
         }
 
         Sampler(std::string id, SamplerLayout const& layout) : m_id(id) {
-            glCreateSamplers(1, &m_name);
+            m_name = getNamePool(NameType::Sampler).acquire();
 
             for (const auto& p : layout.int_parameters) {
                 switch (p.first) {
@@ -141,7 +142,7 @@ namespace glowl
         }
 
         Sampler(std::string id, std::vector<std::pair<GLenum, GLint>> const& int_params) : m_id(id) {
-            glCreateSamplers(1, &m_name);
+            m_name = getNamePool(NameType::Sampler).acquire();
 
             for (const auto& p : int_params) {
                 switch (p.first) {
@@ -181,7 +182,7 @@ namespace glowl
         }
 
         Sampler(std::string id, std::vector<std::pair<GLenum, GLfloat>> const& float_params) : m_id(id) {
-            glCreateSamplers(1, &m_name);
+            m_name = getNamePool(NameType::Sampler).acquire();
 
             for (const auto& p : float_params) {
                 switch (p.first) {
@@ -206,7 +207,7 @@ namespace glowl
         }
 
         ~Sampler() {
-            glDeleteSamplers(1, &m_name);
+            getNamePool(NameType::Sampler).release(m_name);
         }
 
         Sampler(const Sampler&) = delete;
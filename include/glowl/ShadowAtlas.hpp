@@ -0,0 +1,588 @@
+/*
+ * ShadowAtlas.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_SHADOWATLAS_HPP
+#define GLOWL_SHADOWATLAS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "FramebufferObject.hpp"
+#include "Texture2D.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class ShadowAtlas
+     *
+     * \brief Allocates square tiles of a single depth texture for many shadow maps (or other small render targets).
+     *
+     * Tiles have power of two sizes and are managed in a quadtree: a free tile is split into four when a smaller one
+     * is needed and four free siblings are merged again. Each shadow map is a slot that requests a resolution and an
+     * importance, update() then assigns the tiles. If the requests exceed the atlas, the least important slots are
+     * halved first (repeatedly, down to the minimum tile size) and dropped last. Slots keep their tile while its size
+     * does not change; if fragmentation prevents an allocation, all tiles are repacked by decreasing size, which
+     * always succeeds once the requested area fits.
+     *
+     * Cached slots are only scheduled for rendering when their tile changed or invalidate() was called, e.g. because
+     * the light or a shadow caster moved. Slots that are not cached are scheduled every update.
+     *
+     * Usage per frame: request() for the visible lights, update(), begin(), then beginTile() and the shadow casters
+     * for each slot in getRenderList(), end(). Shaders map shadow map coordinates into the atlas with
+     * getUvScaleOffset().
+     */
+    class ShadowAtlas
+    {
+    public:
+        using Handle = size_t;
+
+        struct Tile
+        {
+            GLint   x;
+            GLint   y;
+            GLsizei size; ///< 0 for slots without a tile
+        };
+
+        /**
+         * \param size Width and height of the depth texture, a power of two
+         * \param min_tile_size Smallest tile size, a power of two
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        ShadowAtlas(int                                 size,
+                    int                                 min_tile_size = 64,
+                    FramebufferObject::DepthStencilType depth_type = FramebufferObject::DEPTH32F);
+        ShadowAtlas(const ShadowAtlas&) = delete;
+        ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+        /**
+         * \brief Adds a slot without tile, see request().
+         *
+         * \param cached Only render the slot when its tile changed or it was invalidated
+         */
+        Handle add(bool cached = true);
+
+        /**
+         * \brief Removes a slot and frees its tile. The handle can be returned by a later add().
+         */
+        void remove(Handle handle);
+
+        /**
+         * \brief Sets the resolution a slot asks for from the next update() on. The request stays until changed,
+         * a resolution of 0 releases the tile.
+         *
+         * \param resolution Requested tile size, rounded down to a power of two
+         * \param importance Less important slots are reduced first if the atlas is full
+         */
+        void request(Handle handle, int resolution, float importance);
+
+        /**
+         * \brief Schedules a cached slot for rendering in the next update().
+         */
+        void invalidate(Handle handle);
+
+        /**
+         * \brief Assigns tiles to all slots according to their requests and collects the slots to render.
+         */
+        void update();
+
+        /**
+         * \brief Slots with a tile that need to be rendered after the last update().
+         */
+        std::vector<Handle> const& getRenderList() const;
+
+        Tile getTile(Handle handle) const;
+
+        /**
+         * \brief Scale (xy) and offset (zw) that map texture coordinates of a slot's shadow map into the atlas, e.g.
+         * for a vec4 uniform: atlas_uv = uv * scale + offset.
+         */
+        void getUvScaleOffset(Handle handle, float* scale_offset) const;
+
+        /**
+         * \brief Binds the framebuffer and enables the scissor test for beginTile().
+         */
+        void begin();
+
+        /**
+         * \brief Sets viewport and scissor rectangle to the tile of a slot and clears its depth. Leaves depth writes
+         * enabled.
+         */
+        void beginTile(Handle handle);
+
+        /**
+         * \brief Disables the scissor test.
+         */
+        void end();
+
+        FramebufferObject&         getFramebuffer();
+        std::shared_ptr<Texture2D> getDepthTexture() const;
+
+        int getSize() const;
+
+    private:
+        enum NodeState : std::uint8_t
+        {
+            Unavailable, ///< Part of a larger node
+            Free,
+            Split,
+            Used
+        };
+
+        struct Slot
+        {
+            bool  active;
+            bool  cached;
+            bool  dirty;
+            int   resolution;
+            float importance;
+
+            int           target_level; ///< Quadtree level the slot should get, -1 for none
+            int           level;        ///< Quadtree level of the assigned tile, -1 for none
+            std::uint32_t node;         ///< Index of the assigned tile within its level
+        };
+
+        Slot&       getSlot(Handle handle, char const* function);
+        Slot const& getSlot(Handle handle, char const* function) const;
+
+        /** Reduces the target sizes until their total area fits the atlas */
+        void fitTargets();
+
+        void resetTree();
+
+        /** Returns a free node of the level, splitting larger nodes as needed, or -1 */
+        std::int64_t acquireNode(int level);
+
+        /** Frees a node and merges it with its free siblings */
+        void releaseNode(int level, std::uint32_t node);
+
+        void releaseTile(Slot& slot);
+
+        /** Assigns tiles to all slots without one by decreasing size, returns false if one did not fit */
+        bool allocateTiles();
+
+        FramebufferObject m_framebuffer;
+
+        int m_size;
+        int m_level_cnt;
+
+        std::vector<Slot>                       m_slots;
+        std::vector<std::vector<NodeState>>     m_nodes;      ///< Node states per level, row-major
+        std::vector<std::vector<std::uint32_t>> m_free_nodes; ///< Free nodes per level
+        std::vector<Handle>                     m_render_list;
+    };
+
+    inline ShadowAtlas::ShadowAtlas(int size, int min_tile_size, FramebufferObject::DepthStencilType depth_type)
+        : m_framebuffer("shadow_atlas", size, size, depth_type), m_size(size), m_level_cnt(0)
+    {
+        auto isPowerOfTwo = [](int value) { return value > 0 && (value & (value - 1)) == 0; };
+        if (!isPowerOfTwo(size) || !isPowerOfTwo(min_tile_size) || min_tile_size > size)
+        {
+            throw FramebufferObjectException("ShadowAtlas::ShadowAtlas - invalid size " + std::to_string(size) +
+                                             " or minimum tile size " + std::to_string(min_tile_size));
+        }
+        if (depth_type == FramebufferObject::NONE)
+        {
+            throw FramebufferObjectException("ShadowAtlas::ShadowAtlas - depth buffer required");
+        }
+
+        while ((size >> m_level_cnt) >= min_tile_size)
+        {
+            ++m_level_cnt;
+        }
+
+        resetTree();
+    }
+
+    inline ShadowAtlas::Handle ShadowAtlas::add(bool cached)
+    {
+        Slot slot{true, cached, true, 0, 0.0f, -1, -1, 0};
+
+        for (Handle handle = 0; handle < m_slots.size(); ++handle)
+        {
+            if (!m_slots[handle].active)
+            {
+                m_slots[handle] = slot;
+                return handle;
+            }
+        }
+
+        m_slots.push_back(slot);
+        return m_slots.size() - 1;
+    }
+
+    inline void ShadowAtlas::remove(Handle handle)
+    {
+        Slot& slot = getSlot(handle, "remove");
+        releaseTile(slot);
+        slot.active = false;
+    }
+
+    inline void ShadowAtlas::request(Handle handle, int resolution, float importance)
+    {
+        Slot& slot = getSlot(handle, "request");
+        slot.resolution = resolution;
+        slot.importance = importance;
+    }
+
+    inline void ShadowAtlas::invalidate(Handle handle)
+    {
+        getSlot(handle, "invalidate").dirty = true;
+    }
+
+    inline void ShadowAtlas::update()
+    {
+        fitTargets();
+
+        // keep tiles that still have the right size
+        for (auto& slot : m_slots)
+        {
+            if (slot.active && slot.level != slot.target_level)
+            {
+                releaseTile(slot);
+            }
+        }
+
+        if (!allocateTiles())
+        {
+            for (auto& slot : m_slots)
+            {
+                slot.level = -1;
+            }
+            resetTree();
+            allocateTiles();
+        }
+
+        m_render_list.clear();
+        for (Handle handle = 0; handle < m_slots.size(); ++handle)
+        {
+            Slot& slot = m_slots[handle];
+            if (slot.active && slot.level >= 0 && (slot.dirty || !slot.cached))
+            {
+                m_render_list.push_back(handle);
+            }
+            // rendering is assumed to happen before the next update
+            slot.dirty = slot.level < 0;
+        }
+    }
+
+    inline std::vector<ShadowAtlas::Handle> const& ShadowAtlas::getRenderList() const
+    {
+        return m_render_list;
+    }
+
+    inline ShadowAtlas::Tile ShadowAtlas::getTile(Handle handle) const
+    {
+        Slot const& slot = getSlot(handle, "getTile");
+        if (slot.level < 0)
+        {
+            return {0, 0, 0};
+        }
+
+        GLsizei       size = m_size >> slot.level;
+        std::uint32_t row_length = 1u << slot.level;
+        GLint         x = static_cast<GLint>(slot.node % row_length) * size;
+        GLint         y = static_cast<GLint>(slot.node / row_length) * size;
+        return {x, y, size};
+    }
+
+    inline void ShadowAtlas::getUvScaleOffset(Handle handle, float* scale_offset) const
+    {
+        Tile  tile = getTile(handle);
+        float size = static_cast<float>(m_size);
+
+        scale_offset[0] = tile.size / size;
+        scale_offset[1] = tile.size / size;
+        scale_offset[2] = tile.x / size;
+        scale_offset[3] = tile.y / size;
+    }
+
+    inline void ShadowAtlas::begin()
+    {
+        m_framebuffer.bind();
+
+        GLOWL_TRACE(Opcode::Enable, {GL_SCISSOR_TEST});
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    inline void ShadowAtlas::beginTile(Handle handle)
+    {
+        Tile tile = getTile(handle);
+        if (tile.size == 0)
+        {
+            throw FramebufferObjectException("ShadowAtlas::beginTile - slot " + std::to_string(handle) +
+                                             " has no tile");
+        }
+
+        GLOWL_TRACE(Opcode::Viewport, {tile.x, tile.y, tile.size, tile.size});
+        glViewport(tile.x, tile.y, tile.size, tile.size);
+        GLOWL_TRACE(Opcode::Scissor, {tile.x, tile.y, tile.size, tile.size});
+        glScissor(tile.x, tile.y, tile.size, tile.size);
+
+        // the clear is masked like any other depth write
+        GLOWL_TRACE(Opcode::DepthMask, {GL_TRUE});
+        glDepthMask(GL_TRUE);
+
+        GLfloat depth = 1.0f;
+        GLOWL_TRACE(Opcode::ClearBufferfv, {GL_DEPTH, 0, trace::floatBits(depth)});
+        glClearBufferfv(GL_DEPTH, 0, &depth);
+    }
+
+    inline void ShadowAtlas::end()
+    {
+        GLOWL_TRACE(Opcode::Disable, {GL_SCISSOR_TEST});
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    inline FramebufferObject& ShadowAtlas::getFramebuffer()
+    {
+        return m_framebuffer;
+    }
+
+    inline std::shared_ptr<Texture2D> ShadowAtlas::getDepthTexture() const
+    {
+        return m_framebuffer.getDepthStencil();
+    }
+
+    inline int ShadowAtlas::getSize() const
+    {
+        return m_size;
+    }
+
+    inline ShadowAtlas::Slot& ShadowAtlas::getSlot(Handle handle, char const* function)
+    {
+        return const_cast<Slot&>(static_cast<ShadowAtlas const*>(this)->getSlot(handle, function));
+    }
+
+    inline ShadowAtlas::Slot const& ShadowAtlas::getSlot(Handle handle, char const* function) const
+    {
+        if (handle >= m_slots.size() || !m_slots[handle].active)
+        {
+            throw FramebufferObjectException(std::string("ShadowAtlas::") + function + " - invalid handle " +
+                                             std::to_string(handle));
+        }
+        return m_slots[handle];
+    }
+
+    inline void ShadowAtlas::fitTargets()
+    {
+        std::vector<Handle> order;
+        std::uint64_t       area = 0;
+
+        for (Handle handle = 0; handle < m_slots.size(); ++handle)
+        {
+            Slot& slot = m_slots[handle];
+            slot.target_level = -1;
+            if (!slot.active || slot.resolution <= 0)
+            {
+                continue;
+            }
+
+            slot.target_level = 0;
+            while (slot.target_level + 1 < m_level_cnt && (m_size >> slot.target_level) > slot.resolution)
+            {
+                ++slot.target_level;
+            }
+
+            std::uint64_t size = static_cast<std::uint64_t>(m_size >> slot.target_level);
+            area += size * size;
+            order.push_back(handle);
+        }
+
+        std::stable_sort(order.begin(), order.end(), [this](Handle lhs, Handle rhs) {
+            return m_slots[lhs].importance < m_slots[rhs].importance;
+        });
+
+        std::uint64_t const atlas_area = static_cast<std::uint64_t>(m_size) * m_size;
+
+        // halve the least important slots first, one step per slot and pass to spread the reduction
+        bool reduced = true;
+        while (area > atlas_area && reduced)
+        {
+            reduced = false;
+            for (size_t i = 0; i < order.size() && area > atlas_area; ++i)
+            {
+                Slot& slot = m_slots[order[i]];
+                if (slot.target_level + 1 < m_level_cnt)
+                {
+                    std::uint64_t size = static_cast<std::uint64_t>(m_size >> slot.target_level);
+                    area -= size * size - (size / 2) * (size / 2);
+                    ++slot.target_level;
+                    reduced = true;
+                }
+            }
+        }
+
+        // then drop them
+        for (size_t i = 0; i < order.size() && area > atlas_area; ++i)
+        {
+            Slot&         slot = m_slots[order[i]];
+            std::uint64_t size = static_cast<std::uint64_t>(m_size >> slot.target_level);
+            area -= size * size;
+            slot.target_level = -1;
+        }
+
+        // a pass can overshoot, give the space back to the most important reduced slots
+        for (size_t i = order.size(); i-- > 0;)
+        {
+            Slot& slot = m_slots[order[i]];
+            while (slot.target_level > 0 && (m_size >> (slot.target_level - 1)) <= slot.resolution)
+            {
+                std::uint64_t size = static_cast<std::uint64_t>(m_size >> slot.target_level);
+                if (area + 3 * size * size > atlas_area)
+                {
+                    break;
+                }
+                area += 3 * size * size;
+                --slot.target_level;
+            }
+        }
+    }
+
+    inline void ShadowAtlas::resetTree()
+    {
+        m_nodes.assign(m_level_cnt, {});
+        m_free_nodes.assign(m_level_cnt, {});
+        for (int level = 0; level < m_level_cnt; ++level)
+        {
+            m_nodes[level].assign(size_t(1) << (2 * level), Unavailable);
+        }
+        m_nodes[0][0] = Free;
+        m_free_nodes[0].push_back(0);
+    }
+
+    inline std::int64_t ShadowAtlas::acquireNode(int level)
+    {
+        auto& free_nodes = m_free_nodes[level];
+        if (!free_nodes.empty())
+        {
+            std::uint32_t node = free_nodes.back();
+            free_nodes.pop_back();
+            return node;
+        }
+
+        if (level == 0)
+        {
+            return -1;
+        }
+
+        std::int64_t parent = acquireNode(level - 1);
+        if (parent < 0)
+        {
+            return -1;
+        }
+        m_nodes[level - 1][parent] = Split;
+
+        std::uint32_t row_length = 1u << level;
+        std::uint32_t x = static_cast<std::uint32_t>(parent % (row_length / 2)) * 2;
+        std::uint32_t y = static_cast<std::uint32_t>(parent / (row_length / 2)) * 2;
+
+        // the first child is returned, the others are pushed such that the next acquire takes the one next to it
+        std::uint32_t children[4] = {y * row_length + x,
+                                     y * row_length + x + 1,
+                                     (y + 1) * row_length + x,
+                                     (y + 1) * row_length + x + 1};
+        for (int i = 3; i > 0; --i)
+        {
+            m_nodes[level][children[i]] = Free;
+            free_nodes.push_back(children[i]);
+        }
+
+        return children[0];
+    }
+
+    inline void ShadowAtlas::releaseNode(int level, std::uint32_t node)
+    {
+        if (level > 0)
+        {
+            std::uint32_t row_length = 1u << level;
+            std::uint32_t x = (node % row_length) & ~1u;
+            std::uint32_t y = (node / row_length) & ~1u;
+
+            std::uint32_t siblings[4] = {y * row_length + x,
+                                         y * row_length + x + 1,
+                                         (y + 1) * row_length + x,
+                                         (y + 1) * row_length + x + 1};
+
+            bool merge = true;
+            for (std::uint32_t sibling : siblings)
+            {
+                merge = merge && (sibling == node || m_nodes[level][sibling] == Free);
+            }
+
+            if (merge)
+            {
+                auto& free_nodes = m_free_nodes[level];
+                for (std::uint32_t sibling : siblings)
+                {
+                    m_nodes[level][sibling] = Unavailable;
+                    if (sibling != node)
+                    {
+                        free_nodes.erase(std::find(free_nodes.begin(), free_nodes.end(), sibling));
+                    }
+                }
+                releaseNode(level - 1, (y / 2) * (row_length / 2) + x / 2);
+                return;
+            }
+        }
+
+        m_nodes[level][node] = Free;
+        m_free_nodes[level].push_back(node);
+    }
+
+    inline void ShadowAtlas::releaseTile(Slot& slot)
+    {
+        if (slot.level >= 0)
+        {
+            releaseNode(slot.level, slot.node);
+            slot.level = -1;
+        }
+    }
+
+    inline bool ShadowAtlas::allocateTiles()
+    {
+        std::vector<Handle> pending;
+        for (Handle handle = 0; handle < m_slots.size(); ++handle)
+        {
+            Slot const& slot = m_slots[handle];
+            if (slot.active && slot.level < 0 && slot.target_level >= 0)
+            {
+                pending.push_back(handle);
+            }
+        }
+
+        std::stable_sort(pending.begin(), pending.end(), [this](Handle lhs, Handle rhs) {
+            return m_slots[lhs].target_level < m_slots[rhs].target_level;
+        });
+
+        for (Handle handle : pending)
+        {
+            Slot&        slot = m_slots[handle];
+            std::int64_t node = acquireNode(slot.target_level);
+            if (node < 0)
+            {
+                return false;
+            }
+
+            m_nodes[slot.target_level][node] = Used;
+            slot.level = slot.target_level;
+            slot.node = static_cast<std::uint32_t>(node);
+            slot.dirty = true;
+        }
+
+        return true;
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_SHADOWATLAS_HPP
@@ -0,0 +1,434 @@
+/*
+ * SkinningCache.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_SKINNINGCACHE_HPP
+#define GLOWL_SKINNINGCACHE_HPP
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BufferObject.hpp"
+#include "Exceptions.hpp"
+#include "GLSLProgram.hpp"
+#include "MemoryBarrierTracker.hpp"
+#include "Mesh.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class SkinningCache
+     *
+     * \brief Skins the instances of an animated mesh once per frame with a compute shader and caches the results.
+     *
+     * Each instance owns a vertex buffer with the skinned positions and normals (linear blend skinning with up to
+     * 4 joints per vertex) and a Mesh that draws from it. That mesh shares the index buffer and the remaining
+     * vertex buffers with the source mesh, so all render passes of a frame (shadows, depth pre-pass, ...) use the
+     * cached vertices without skinning again.
+     *
+     * The vertex attributes of an instance mesh are: 0 the skinned position (vec3), 1 the skinned normal (vec3),
+     * followed by the remaining attributes of the source mesh in their original order, without position, normal,
+     * joints and weights.
+     *
+     * Instances are only skinned by update() if they are marked dirty (new bone matrices) and visible. Invisible
+     * instances stay dirty until they become visible again.
+     *
+     * Requirements for the source mesh: float positions and normals (3 or 4 components), joint indices as 4
+     * unsigned bytes, shorts or ints and weights as 4 floats. All strides and attribute offsets have to be multiples
+     * of 4 bytes. Bone matrices are read as std430 mat4 array from the bone buffer of each instance.
+     */
+    class SkinningCache
+    {
+    public:
+        /**
+         * Vertex attribute indices of the source mesh (as numbered in its vertex array).
+         */
+        struct Attributes
+        {
+            GLuint position;
+            GLuint normal;
+            GLuint joints;
+            GLuint weights;
+        };
+
+        /**
+         * \brief SkinningCache constructor.
+         *
+         * \param barrier_tracker Optional tracker that the writes to the skinned vertex buffers are reported to.
+         * Without one, update() issues a vertex attribute barrier itself.
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        SkinningCache(Mesh const& mesh, Attributes attributes, MemoryBarrierTracker* barrier_tracker = nullptr);
+        SkinningCache(const SkinningCache&) = delete;
+        SkinningCache& operator=(const SkinningCache&) = delete;
+
+        /**
+         * \brief Adds an instance, which is dirty and visible initially.
+         *
+         * \return Index of the instance
+         */
+        size_t addInstance(std::shared_ptr<BufferObject> const& bone_matrices);
+
+        /**
+         * \brief Replaces the bone matrix buffer of an instance and marks it dirty.
+         */
+        void attachBoneBuffer(size_t instance_idx, std::shared_ptr<BufferObject> const& bone_matrices);
+
+        /**
+         * \brief Marks an instance for skinning by the next update(), e.g. after its bone matrices changed.
+         */
+        void markDirty(size_t instance_idx);
+
+        void setVisible(size_t instance_idx, bool visible);
+
+        /**
+         * \brief Skins all instances that are dirty and visible.
+         *
+         * \return Number of skinned instances
+         */
+        size_t update();
+
+        /**
+         * \brief Mesh drawing the cached vertices of an instance.
+         */
+        Mesh& getMesh(size_t instance_idx);
+
+        BufferObject const& getSkinnedBuffer(size_t instance_idx) const;
+
+        size_t getInstanceCount() const;
+
+        /**
+         * \brief Vertex layout of the skinned vertex buffers, position and normal.
+         */
+        VertexLayout const& getSkinnedLayout() const;
+
+    private:
+        struct Instance
+        {
+            std::shared_ptr<BufferObject> bone_matrices;
+            std::shared_ptr<BufferObject> skinned_vertices;
+            std::unique_ptr<Mesh>         mesh;
+            bool                          dirty;
+            bool                          visible;
+        };
+
+        /** Location of a source attribute for the compute shader */
+        struct AttributeBinding
+        {
+            size_t vbo_idx;
+            GLuint stride; ///< in 4 byte words
+            GLuint offset; ///< in 4 byte words
+        };
+
+        static AttributeBinding
+        getAttributeBinding(Mesh const& mesh, GLuint attrib_idx, GLenum type, GLint min_size, GLint max_size);
+
+        void bindAttribute(AttributeBinding const& binding, GLuint binding_idx, GLchar const* layout_uniform);
+
+        Instance& getInstance(size_t instance_idx, char const* method);
+
+        std::vector<Mesh::BufferObjectPtr> m_source_vbos;
+        Mesh::BufferObjectPtr              m_ibo;
+        GLenum                             m_index_type;
+        GLenum                             m_primitive_type;
+        GLuint                             m_vertex_cnt;
+
+        AttributeBinding m_position;
+        AttributeBinding m_normal;
+        AttributeBinding m_joints;
+        AttributeBinding m_weights;
+        GLuint           m_joint_byte_size;
+
+        std::vector<Mesh::BufferObjectPtr> m_shared_vbos;    ///< Source buffers with attributes besides skinning
+        std::vector<VertexLayout>          m_shared_layouts; ///< Their layouts, without the skinning attributes
+        VertexLayout                       m_skinned_layout;
+
+        std::unique_ptr<GLSLProgram> m_program;
+        std::vector<Instance>        m_instances;
+
+        MemoryBarrierTracker* m_barrier_tracker;
+    };
+
+    namespace detail
+    {
+        static char const* const skinning_source = R"(
+#version 450
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer PositionBuffer { uint positions[]; };
+layout(std430, binding = 1) readonly buffer NormalBuffer { uint normals[]; };
+layout(std430, binding = 2) readonly buffer JointBuffer { uint joints[]; };
+layout(std430, binding = 3) readonly buffer WeightBuffer { uint weights[]; };
+layout(std430, binding = 4) readonly buffer BoneBuffer { mat4 bones[]; };
+layout(std430, binding = 5) writeonly buffer SkinnedBuffer { float skinned[]; };
+
+uniform uint vertex_cnt;
+uniform uvec2 position_layout; // stride and offset in words
+uniform uvec2 normal_layout;
+uniform uvec2 joint_layout;
+uniform uvec2 weight_layout;
+uniform uint joint_size; // bytes per joint index
+
+uvec4 fetchJoints(uint v)
+{
+    uint w = v * joint_layout.x + joint_layout.y;
+    if (joint_size == 1u)
+    {
+        uint bytes = joints[w];
+        return uvec4(bytes & 0xFFu, (bytes >> 8u) & 0xFFu, (bytes >> 16u) & 0xFFu, bytes >> 24u);
+    }
+    if (joint_size == 2u)
+    {
+        uint lo = joints[w];
+        uint hi = joints[w + 1u];
+        return uvec4(lo & 0xFFFFu, lo >> 16u, hi & 0xFFFFu, hi >> 16u);
+    }
+    return uvec4(joints[w], joints[w + 1u], joints[w + 2u], joints[w + 3u]);
+}
+
+void main()
+{
+    uint v = gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x;
+    if (v >= vertex_cnt) return;
+
+    uint p = v * position_layout.x + position_layout.y;
+    uint n = v * normal_layout.x + normal_layout.y;
+    uint w = v * weight_layout.x + weight_layout.y;
+
+    vec3 position = uintBitsToFloat(uvec3(positions[p], positions[p + 1u], positions[p + 2u]));
+    vec3 normal = uintBitsToFloat(uvec3(normals[n], normals[n + 1u], normals[n + 2u]));
+    vec4 weight = uintBitsToFloat(uvec4(weights[w], weights[w + 1u], weights[w + 2u], weights[w + 3u]));
+    uvec4 joint = fetchJoints(v);
+
+    mat4 skin = weight.x * bones[joint.x] + weight.y * bones[joint.y] + weight.z * bones[joint.z] +
+                weight.w * bones[joint.w];
+
+    position = (skin * vec4(position, 1.0)).xyz;
+    // valid for rigid and uniformly scaled bones
+    normal = mat3(skin) * normal;
+    float len = length(normal);
+    normal = len > 0.0 ? normal / len : normal;
+
+    uint o = v * 6u;
+    skinned[o] = position.x;
+    skinned[o + 1u] = position.y;
+    skinned[o + 2u] = position.z;
+    skinned[o + 3u] = normal.x;
+    skinned[o + 4u] = normal.y;
+    skinned[o + 5u] = normal.z;
+}
+)";
+    } // namespace detail
+
+    inline SkinningCache::SkinningCache(Mesh const&           mesh,
+                                        Attributes            attributes,
+                                        MemoryBarrierTracker* barrier_tracker)
+        : m_source_vbos(mesh.getVbos()),
+          m_ibo(mesh.getIboPtr()),
+          m_index_type(mesh.getIndexType()),
+          m_primitive_type(mesh.getPrimitiveType()),
+          m_vertex_cnt(mesh.getVertexCount(mesh.getAttributeBufferIndex(attributes.position))),
+          m_position(getAttributeBinding(mesh, attributes.position, GL_FLOAT, 3, 4)),
+          m_normal(getAttributeBinding(mesh, attributes.normal, GL_FLOAT, 3, 4)),
+          m_joints(getAttributeBinding(mesh, attributes.joints, mesh.getAttribute(attributes.joints).type, 4, 4)),
+          m_weights(getAttributeBinding(mesh, attributes.weights, GL_FLOAT, 4, 4)),
+          m_joint_byte_size(4),
+          m_skinned_layout(24, {{3, GL_FLOAT, GL_FALSE, 0}, {3, GL_FLOAT, GL_FALSE, 12}}),
+          m_barrier_tracker(barrier_tracker)
+    {
+        switch (mesh.getAttribute(attributes.joints).type)
+        {
+        case GL_UNSIGNED_BYTE:
+            m_joint_byte_size = 1;
+            break;
+        case GL_UNSIGNED_SHORT:
+            m_joint_byte_size = 2;
+            break;
+        case GL_UNSIGNED_INT:
+            m_joint_byte_size = 4;
+            break;
+        default:
+            throw MeshException("SkinningCache::SkinningCache - joint indices have to be unsigned integers");
+        }
+
+        // buffers with further attributes are shared by the instance meshes, without the skinning attributes
+        GLuint attrib_idx = 0;
+        for (size_t vbo_idx = 0; vbo_idx < mesh.getVertexLayouts().size(); ++vbo_idx)
+        {
+            VertexLayout const& source_layout = mesh.getVertexLayouts()[vbo_idx];
+
+            VertexLayout layout(source_layout.stride, std::vector<VertexLayout::Attribute>());
+            for (auto const& attribute : source_layout.attributes)
+            {
+                if (attrib_idx != attributes.position && attrib_idx != attributes.normal &&
+                    attrib_idx != attributes.joints && attrib_idx != attributes.weights)
+                {
+                    layout.attributes.push_back(attribute);
+                }
+                ++attrib_idx;
+            }
+
+            if (!layout.attributes.empty())
+            {
+                m_shared_vbos.push_back(m_source_vbos[vbo_idx]);
+                m_shared_layouts.push_back(layout);
+            }
+        }
+
+        m_program = std::make_unique<GLSLProgram>(
+            GLSLProgram::ShaderSourceList{{GLSLProgram::ShaderType::Compute, detail::skinning_source}});
+    }
+
+    inline size_t SkinningCache::addInstance(std::shared_ptr<BufferObject> const& bone_matrices)
+    {
+        Instance instance;
+        instance.bone_matrices = bone_matrices;
+        instance.skinned_vertices = std::make_shared<BufferObject>(
+            GL_ARRAY_BUFFER, nullptr, static_cast<GLsizeiptr>(m_vertex_cnt) * m_skinned_layout.stride, GL_DYNAMIC_COPY);
+        instance.dirty = true;
+        instance.visible = true;
+
+        std::vector<Mesh::BufferObjectPtr> vbos{instance.skinned_vertices};
+        vbos.insert(vbos.end(), m_shared_vbos.begin(), m_shared_vbos.end());
+        std::vector<VertexLayout> layouts{m_skinned_layout};
+        layouts.insert(layouts.end(), m_shared_layouts.begin(), m_shared_layouts.end());
+
+        instance.mesh = std::make_unique<Mesh>(vbos, layouts, m_ibo, m_index_type, m_primitive_type);
+
+        m_instances.push_back(std::move(instance));
+
+        return m_instances.size() - 1;
+    }
+
+    inline void SkinningCache::attachBoneBuffer(size_t                               instance_idx,
+                                                std::shared_ptr<BufferObject> const& bone_matrices)
+    {
+        Instance& instance = getInstance(instance_idx, "attachBoneBuffer");
+        instance.bone_matrices = bone_matrices;
+        instance.dirty = true;
+    }
+
+    inline void SkinningCache::markDirty(size_t instance_idx)
+    {
+        getInstance(instance_idx, "markDirty").dirty = true;
+    }
+
+    inline void SkinningCache::setVisible(size_t instance_idx, bool visible)
+    {
+        getInstance(instance_idx, "setVisible").visible = visible;
+    }
+
+    inline size_t SkinningCache::update()
+    {
+        size_t skinned_cnt = 0;
+
+        for (auto& instance : m_instances)
+        {
+            if (!instance.dirty || !instance.visible || instance.bone_matrices == nullptr)
+            {
+                continue;
+            }
+
+            if (skinned_cnt == 0)
+            {
+                m_program->use();
+                m_program->setUniform("vertex_cnt", m_vertex_cnt);
+                m_program->setUniform("joint_size", m_joint_byte_size);
+                bindAttribute(m_position, 0, "position_layout");
+                bindAttribute(m_normal, 1, "normal_layout");
+                bindAttribute(m_joints, 2, "joint_layout");
+                bindAttribute(m_weights, 3, "weight_layout");
+            }
+
+            instance.bone_matrices->bindAs(GL_SHADER_STORAGE_BUFFER, 4);
+            instance.skinned_vertices->bindAs(GL_SHADER_STORAGE_BUFFER, 5);
+
+            m_program->dispatchComputeGroups((m_vertex_cnt + 63) / 64);
+
+            if (m_barrier_tracker != nullptr)
+            {
+                m_barrier_tracker->write(*instance.skinned_vertices, MemoryBarrierTracker::Write::ShaderStorage);
+            }
+
+            instance.dirty = false;
+            ++skinned_cnt;
+        }
+
+        if (skinned_cnt > 0 && m_barrier_tracker == nullptr)
+        {
+            MemoryBarrierTracker::barrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        }
+
+        return skinned_cnt;
+    }
+
+    inline Mesh& SkinningCache::getMesh(size_t instance_idx)
+    {
+        return *getInstance(instance_idx, "getMesh").mesh;
+    }
+
+    inline BufferObject const& SkinningCache::getSkinnedBuffer(size_t instance_idx) const
+    {
+        return *m_instances.at(instance_idx).skinned_vertices;
+    }
+
+    inline size_t SkinningCache::getInstanceCount() const
+    {
+        return m_instances.size();
+    }
+
+    inline VertexLayout const& SkinningCache::getSkinnedLayout() const
+    {
+        return m_skinned_layout;
+    }
+
+    inline SkinningCache::AttributeBinding SkinningCache::getAttributeBinding(
+        Mesh const& mesh, GLuint attrib_idx, GLenum type, GLint min_size, GLint max_size)
+    {
+        auto const& attribute = mesh.getAttribute(attrib_idx);
+        size_t      vbo_idx = mesh.getAttributeBufferIndex(attrib_idx);
+        GLsizei     stride = mesh.getVertexLayouts()[vbo_idx].stride;
+
+        if (attribute.type != type || attribute.size < min_size || attribute.size > max_size)
+        {
+            throw MeshException("SkinningCache::SkinningCache - vertex attribute " + std::to_string(attrib_idx) +
+                                " has an unsupported type or size");
+        }
+
+        if (attribute.offset % 4 != 0 || stride % 4 != 0)
+        {
+            throw MeshException("SkinningCache::SkinningCache - vertex attribute " + std::to_string(attrib_idx) +
+                                " is not 4 byte aligned");
+        }
+
+        return {vbo_idx, static_cast<GLuint>(stride / 4), static_cast<GLuint>(attribute.offset / 4)};
+    }
+
+    inline void SkinningCache::bindAttribute(AttributeBinding const& binding,
+                                             GLuint                  binding_idx,
+                                             GLchar const*           layout_uniform)
+    {
+        m_source_vbos[binding.vbo_idx]->bindAs(GL_SHADER_STORAGE_BUFFER, binding_idx);
+        m_program->setUniform(layout_uniform, binding.stride, binding.offset);
+    }
+
+    inline SkinningCache::Instance& SkinningCache::getInstance(size_t instance_idx, char const* method)
+    {
+        if (instance_idx >= m_instances.size())
+        {
+            throw BaseException(std::string("SkinningCache::") + method + " - instance index out of range");
+        }
+        return m_instances[instance_idx];
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_SKINNINGCACHE_HPP
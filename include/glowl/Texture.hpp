@@ -8,9 +8,15 @@
 #ifndef GLOWL_TEXTURE_HPP
 #define GLOWL_TEXTURE_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "Exceptions.hpp"
+#include "NamePool.hpp"
+#include "Trace.hpp"
 #include "glinclude.h"
 
 namespace glowl
@@ -109,6 +115,144 @@ namespace glowl
         std::vector<std::pair<GLenum, GLfloat>> float_parameters;
     };
 
+    /**
+     * \struct TextureCopyRegion
+     *
+     * \brief Describes a single glCopyImageSubData call between two textures.
+     *
+     * For array and cubemap array textures, z and depth address layers (layer-faces for cubemap arrays).
+     * Sizes are given in texels of the source texture, as in glCopyImageSubData.
+     */
+    struct TextureCopyRegion
+    {
+        GLint   src_level;
+        GLint   src_x;
+        GLint   src_y;
+        GLint   src_z;
+        GLint   dst_level;
+        GLint   dst_x;
+        GLint   dst_y;
+        GLint   dst_z;
+        GLsizei width;
+        GLsizei height;
+        GLsizei depth;
+    };
+
+    /**
+     * \brief Get the block size of a compressed internal format.
+     *
+     * \return Returns true for (known) compressed formats, false otherwise. Uncompressed formats have a 1x1 block.
+     */
+    inline bool getCompressedBlockSize(GLenum internal_format, GLint& block_width, GLint& block_height)
+    {
+        block_width = 1;
+        block_height = 1;
+
+        switch (internal_format)
+        {
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+        case GL_COMPRESSED_R11_EAC:
+        case GL_COMPRESSED_SIGNED_R11_EAC:
+        case GL_COMPRESSED_RG11_EAC:
+        case GL_COMPRESSED_SIGNED_RG11_EAC:
+#ifdef GL_EXT_texture_compression_s3tc
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+#endif
+#ifdef GL_KHR_texture_compression_astc_ldr
+        case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR:
+#endif
+            block_width = 4;
+            block_height = 4;
+            return true;
+#ifdef GL_KHR_texture_compression_astc_ldr
+        case GL_COMPRESSED_RGBA_ASTC_5x4_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x4_KHR:
+            block_width = 5;
+            block_height = 4;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_5x5_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_5x5_KHR:
+            block_width = 5;
+            block_height = 5;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_6x5_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x5_KHR:
+            block_width = 6;
+            block_height = 5;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_6x6_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR:
+            block_width = 6;
+            block_height = 6;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_8x5_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x5_KHR:
+            block_width = 8;
+            block_height = 5;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_8x6_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x6_KHR:
+            block_width = 8;
+            block_height = 6;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_8x8_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR:
+            block_width = 8;
+            block_height = 8;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_10x5_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x5_KHR:
+            block_width = 10;
+            block_height = 5;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_10x6_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x6_KHR:
+            block_width = 10;
+            block_height = 6;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_10x8_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x8_KHR:
+            block_width = 10;
+            block_height = 8;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_10x10_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_10x10_KHR:
+            block_width = 10;
+            block_height = 10;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_12x10_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x10_KHR:
+            block_width = 12;
+            block_height = 10;
+            return true;
+        case GL_COMPRESSED_RGBA_ASTC_12x12_KHR:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR:
+            block_width = 12;
+            block_height = 12;
+            return true;
+#endif
+        default:
+            return false;
+        }
+    }
+
     /**
      * \class Texture
      *
@@ -122,6 +266,7 @@ namespace glowl
         std::string m_id; ///< Identifier set by application to help identifying textures
 
         GLuint m_name; ///< OpenGL texture name given by glCreateTexture
+        std::uint64_t m_storage_id = 0; ///< Unique id of the current texture storage, see getStorageId()
 #ifndef GLOWL_NO_ARB_BINDLESS_TEXTURE
         GLuint64 m_texture_handle; ///< Actual OpenGL texture handle (used for bindless)
 #endif
@@ -141,14 +286,21 @@ namespace glowl
 
         virtual void bindTexture() const = 0;
 
+        /**
+         * \brief Returns the texture target, e.g. GL_TEXTURE_2D.
+         */
+        virtual GLenum getTarget() const = 0;
+
         // TODO: Deprecate simplified function in the future
         void bindImage(GLuint location, GLenum access) const
         {
+            GLOWL_TRACE(Opcode::BindImageTexture, {location, m_name, 0, GL_TRUE, 0, access, m_internal_format});
             glBindImageTexture(location, m_name, 0, GL_TRUE, 0, access, m_internal_format);
         }
 
         void bindImage(GLuint location, GLint level, GLboolean layered, GLint layer, GLenum access) const
         {
+            GLOWL_TRACE(Opcode::BindImageTexture, {location, m_name, level, layered, layer, access, m_internal_format});
             glBindImageTexture(location, m_name, level, layered, layer, access, m_internal_format);
         }
 
@@ -167,6 +319,27 @@ namespace glowl
 
         virtual TextureLayout getTextureLayout() const = 0;
 
+        /**
+         * \brief Copies all mipmap levels (and layers) that exist in both textures.
+         *
+         * \param src The texture to be copied
+         * \param tgt The target texture, requires the same size as the source texture
+         */
+        static void copy(Texture const& src, Texture const& tgt);
+
+        /**
+         * \brief Copies a list of regions between two textures.
+         *
+         * All regions are validated on the CPU before the first copy is issued, then all copies are issued
+         * back-to-back via glCopyImageSubData. Regions of compressed textures have to be block aligned,
+         * except where they end at the border of the mipmap level.
+         *
+         * \param src The texture to be copied
+         * \param tgt The target texture
+         * \param regions List of regions to copy
+         */
+        static void copy(Texture const& src, Texture const& tgt, std::vector<TextureCopyRegion> const& regions);
+
         std::string getId() const
         {
             return m_id;
@@ -176,6 +349,17 @@ namespace glowl
         {
             return m_name;
         }
+
+        /**
+         * \brief Returns an id that identifies the current storage of the texture.
+         *
+         * Unlike the OpenGL name, which is recycled by the driver and the name pool, the id is never reused and
+         * changes whenever the texture storage is recreated, e.g. by reload().
+         */
+        std::uint64_t getStorageId() const
+        {
+            return m_storage_id;
+        }
 #ifndef GLOWL_NO_ARB_BINDLESS_TEXTURE
         GLuint64 getTextureHandle() const
         {
@@ -199,8 +383,147 @@ namespace glowl
         {
             return m_type;
         }
+        GLsizei getLevels() const
+        {
+            return m_levels;
+        }
+
+    protected:
+        static std::uint64_t nextStorageId()
+        {
+            static std::atomic<std::uint64_t> storage_cnt(0);
+            return ++storage_cnt;
+        }
+
+    private:
+        /**
+         * \brief Computes the size of a mipmap level. Depth is the layer count for array textures.
+         */
+        static void getLevelSize(Texture const& texture, GLint level, GLsizei& width, GLsizei& height, GLsizei& depth);
     };
 
+    inline void Texture::getLevelSize(
+        Texture const& texture, GLint level, GLsizei& width, GLsizei& height, GLsizei& depth)
+    {
+        TextureLayout layout = texture.getTextureLayout();
+        GLenum        target = texture.getTarget();
+
+        width = std::max(1, layout.width >> level);
+        height = (target == GL_TEXTURE_1D || target == GL_TEXTURE_1D_ARRAY) ? layout.height
+                                                                             : std::max(1, layout.height >> level);
+        depth = (target == GL_TEXTURE_3D) ? std::max(1, layout.depth >> level) : std::max(1, layout.depth);
+    }
+
+    inline void Texture::copy(Texture const& src, Texture const& tgt)
+    {
+        GLsizei levels = std::min(src.getLevels(), tgt.getLevels());
+
+        std::vector<TextureCopyRegion> regions;
+        regions.reserve(levels);
+
+        for (GLint level = 0; level < levels; ++level)
+        {
+            GLsizei width, height, depth;
+            getLevelSize(src, level, width, height, depth);
+            regions.push_back({level, 0, 0, 0, level, 0, 0, 0, width, height, depth});
+        }
+
+        copy(src, tgt, regions);
+    }
+
+    inline void Texture::copy(Texture const& src, Texture const& tgt, std::vector<TextureCopyRegion> const& regions)
+    {
+        GLint src_block_width, src_block_height, tgt_block_width, tgt_block_height;
+        getCompressedBlockSize(src.getInternalFormat(), src_block_width, src_block_height);
+        getCompressedBlockSize(tgt.getInternalFormat(), tgt_block_width, tgt_block_height);
+
+        auto fail = [&src, &tgt](size_t region_idx, std::string const& reason) {
+            throw TextureException("Texture::copy - texture ids: " + src.getId() + "," + tgt.getId() + " - region " +
+                                   std::to_string(region_idx) + ": " + reason);
+        };
+
+        for (size_t i = 0; i < regions.size(); ++i)
+        {
+            auto const& r = regions[i];
+
+            if (r.src_level < 0 || r.src_level >= src.getLevels() || r.dst_level < 0 || r.dst_level >= tgt.getLevels())
+            {
+                fail(i, "mipmap level out of range");
+            }
+            if (r.src_x < 0 || r.src_y < 0 || r.src_z < 0 || r.dst_x < 0 || r.dst_y < 0 || r.dst_z < 0 ||
+                r.width <= 0 || r.height <= 0 || r.depth <= 0)
+            {
+                fail(i, "negative offset or empty region");
+            }
+
+            GLsizei src_w, src_h, src_d, tgt_w, tgt_h, tgt_d;
+            getLevelSize(src, r.src_level, src_w, src_h, src_d);
+            getLevelSize(tgt, r.dst_level, tgt_w, tgt_h, tgt_d);
+
+            if (r.src_x + r.width > src_w || r.src_y + r.height > src_h || r.src_z + r.depth > src_d)
+            {
+                fail(i, "source region out of bounds");
+            }
+
+            // region size in target texels, e.g. one texel per block when copying compressed to uncompressed data
+            GLsizei dst_width = r.width * tgt_block_width / src_block_width;
+            GLsizei dst_height = r.height * tgt_block_height / src_block_height;
+
+            if (r.dst_x + dst_width > tgt_w || r.dst_y + dst_height > tgt_h || r.dst_z + r.depth > tgt_d)
+            {
+                fail(i, "target region out of bounds");
+            }
+
+            if (r.src_x % src_block_width != 0 || r.src_y % src_block_height != 0 ||
+                r.dst_x % tgt_block_width != 0 || r.dst_y % tgt_block_height != 0)
+            {
+                fail(i, "offset not aligned to compressed block size");
+            }
+            if ((r.width % src_block_width != 0 && r.src_x + r.width != src_w) ||
+                (r.height % src_block_height != 0 && r.src_y + r.height != src_h) ||
+                (dst_width % tgt_block_width != 0 && r.dst_x + dst_width != tgt_w) ||
+                (dst_height % tgt_block_height != 0 && r.dst_y + dst_height != tgt_h))
+            {
+                fail(i, "size not aligned to compressed block size");
+            }
+        }
+
+        for (auto const& r : regions)
+        {
+            GLOWL_TRACE(Opcode::CopyImageSubData,
+                        {src.getName(),
+                         src.getTarget(),
+                         r.src_level,
+                         r.src_x,
+                         r.src_y,
+                         r.src_z,
+                         tgt.getName(),
+                         tgt.getTarget(),
+                         r.dst_level,
+                         r.dst_x,
+                         r.dst_y,
+                         r.dst_z,
+                         r.width,
+                         r.height,
+                         r.depth});
+            glCopyImageSubData(src.getName(),
+                               src.getTarget(),
+                               r.src_level,
+                               r.src_x,
+                               r.src_y,
+                               r.src_z,
+                               tgt.getName(),
+                               tgt.getTarget(),
+                               r.dst_level,
+                               r.dst_x,
+                               r.dst_y,
+                               r.dst_z,
+                               r.width,
+                               r.height,
+                               r.depth);
+        }
+    }
+
 } // namespace glowl
 
 #endif // GLOWL_TEXTURE_HPP
@@ -54,12 +54,21 @@ namespace glowl
          */
         void bindTexture() const;
 
+        GLenum getTarget() const;
+
         void updateMipmaps();
 
         /**
-         * Copies a texture. This is not the most efficient way to accomplish this.
-         * If you want to copy multiple textures or need a more efficient way to do this,
-         * consider using a simple pass through shader.
+         * \brief Update a region of the given mip level.
+         * With a buffer bound to GL_PIXEL_UNPACK_BUFFER, data is interpreted as byte offset into that buffer.
+         */
+        void subImage(GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLvoid const* data);
+
+        using Texture::copy;
+
+        /**
+         * Copies all mipmap levels that exist in both textures.
+         * See Texture::copy for copying a list of regions.
          *
          * \param src The texture to be copied
          * \param tgt The target texture
@@ -100,7 +109,8 @@ namespace glowl
           m_width(layout.width),
           m_height(layout.height)
     {
-        glCreateTextures(GL_TEXTURE_2D, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_2D).acquire();
+        m_storage_id = nextStorageId();
 
         for (auto& pname_pvalue : layout.int_parameters)
         {
@@ -129,6 +139,20 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_2D,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     1,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     layout.int_parameters,
+                                                     layout.float_parameters,
+                                                     data));
+
 #ifndef GLOWL_NO_ARB_BINDLESS_TEXTURE
         m_texture_handle = glGetTextureHandleARB(m_name);
 #endif
@@ -143,45 +167,37 @@ namespace glowl
 
     inline Texture2D::~Texture2D()
     {
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_2D).release(m_name);
     }
 
     inline void Texture2D::bindTexture() const
     {
+        GLOWL_TRACE(Opcode::BindTexture, {GL_TEXTURE_2D, m_name});
         glBindTexture(GL_TEXTURE_2D, m_name);
     }
 
+    inline GLenum Texture2D::getTarget() const
+    {
+        return GL_TEXTURE_2D;
+    }
+
     inline void Texture2D::updateMipmaps()
     {
+        GLOWL_TRACE(Opcode::GenerateTextureMipmap, {m_name});
         glGenerateTextureMipmap(m_name);
     }
 
+    inline void Texture2D::subImage(GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLvoid const* data)
+    {
+        GLOWL_TRACE_CALL(trace::traceTextureSubImage(
+            m_name, GL_TEXTURE_2D, level, x, y, 0, width, height, 1, m_format, m_type, data));
+        glTextureSubImage2D(m_name, level, x, y, width, height, m_format, m_type, data);
+    }
+
     inline void Texture2D::copy(Texture2D* src, Texture2D* tgt)
     {
-        glCopyImageSubData(src->getName(),
-                           GL_TEXTURE_2D,
-                           0,
-                           0,
-                           0,
-                           0,
-                           tgt->getName(),
-                           GL_TEXTURE_2D,
-                           0,
-                           0,
-                           0,
-                           0,
-                           src->getWidth(),
-                           src->getHeight(),
-                           1);
-
-        // because checking layout and subranges seem moderatly complex,
-        // let's check for gl errors afterwars using the oldschool appraoch
-        auto err = glGetError();
-        if (err != GL_NO_ERROR)
-        {
-            throw TextureException("Texture2D::copy - texture ids: " + src->getId() + "," + tgt->getId() +
-                                   " - OpenGL error " + std::to_string(err));
-        }
+        Texture::copy(*src, *tgt);
     }
 
     inline void Texture2D::reload(TextureLayout const& layout,
@@ -196,9 +212,11 @@ namespace glowl
         m_type = layout.type;
         m_levels = layout.levels;
 
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_2D).release(m_name);
 
-        glCreateTextures(GL_TEXTURE_2D, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_2D).acquire();
+        m_storage_id = nextStorageId();
 
         for (auto& pname_pvalue : layout.int_parameters)
         {
@@ -227,6 +245,20 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_2D,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     1,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     layout.int_parameters,
+                                                     layout.float_parameters,
+                                                     data));
+
         GLenum err = glGetError();
         if (err != GL_NO_ERROR)
         {
@@ -46,8 +46,23 @@ namespace glowl
 
         void bindTexture() const;
 
+        GLenum getTarget() const;
+
         void updateMipmaps();
 
+        /**
+         * \brief Update a region of the given mip level and layer range.
+         * With a buffer bound to GL_PIXEL_UNPACK_BUFFER, data is interpreted as byte offset into that buffer.
+         */
+        void subImage(GLint         level,
+                      GLint         x,
+                      GLint         y,
+                      GLint         layer,
+                      GLsizei       width,
+                      GLsizei       height,
+                      GLsizei       layers,
+                      GLvoid const* data);
+
         /**
          * \brief Reload the texturearray with any new format, type and size.
          *
@@ -82,7 +97,8 @@ namespace glowl
           m_height(layout.height),
           m_layers(layout.depth)
     {
-        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_2D_ARRAY).acquire();
+        m_storage_id = nextStorageId();
 
         for (auto& pname_pvalue : layout.int_parameters)
         {
@@ -111,6 +127,20 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_2D_ARRAY,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     m_layers,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     layout.int_parameters,
+                                                     layout.float_parameters,
+                                                     data));
+
 #ifndef GLOWL_NO_ARB_BINDLESS_TEXTURE
         m_texture_handle = glGetTextureHandleARB(m_name);
 #endif
@@ -124,19 +154,41 @@ namespace glowl
     }
 
     inline Texture2DArray::~Texture2DArray() {
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_2D_ARRAY).release(m_name);
     }
 
     inline void Texture2DArray::bindTexture() const
     {
+        GLOWL_TRACE(Opcode::BindTexture, {GL_TEXTURE_2D_ARRAY, m_name});
         glBindTexture(GL_TEXTURE_2D_ARRAY, m_name);
     }
 
+    inline GLenum Texture2DArray::getTarget() const
+    {
+        return GL_TEXTURE_2D_ARRAY;
+    }
+
     inline void Texture2DArray::updateMipmaps()
     {
+        GLOWL_TRACE(Opcode::GenerateTextureMipmap, {m_name});
         glGenerateTextureMipmap(m_name);
     }
 
+    inline void Texture2DArray::subImage(GLint         level,
+                                         GLint         x,
+                                         GLint         y,
+                                         GLint         layer,
+                                         GLsizei       width,
+                                         GLsizei       height,
+                                         GLsizei       layers,
+                                         GLvoid const* data)
+    {
+        GLOWL_TRACE_CALL(trace::traceTextureSubImage(
+            m_name, GL_TEXTURE_2D_ARRAY, level, x, y, layer, width, height, layers, m_format, m_type, data));
+        glTextureSubImage3D(m_name, level, x, y, layer, width, height, layers, m_format, m_type, data);
+    }
+
     inline void Texture2DArray::reload(TextureLayout const& layout,
                                        GLvoid const*        data,
                                        bool                 generateMipmap,
@@ -150,9 +202,11 @@ namespace glowl
         m_levels = layout.levels;
         m_type = layout.type;
 
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_2D_ARRAY).release(m_name);
 
-        glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_2D_ARRAY).acquire();
+        m_storage_id = nextStorageId();
 
         for (auto& pname_pvalue : layout.int_parameters)
             glTextureParameteri(m_name, pname_pvalue.first, pname_pvalue.second);
@@ -177,6 +231,20 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_2D_ARRAY,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     m_layers,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     layout.int_parameters,
+                                                     layout.float_parameters,
+                                                     data));
+
         GLenum err = glGetError();
         if (err != GL_NO_ERROR)
         {
@@ -45,6 +45,8 @@ namespace glowl
 
         void bindTexture() const;
 
+        GLenum getTarget() const;
+
         void updateMipmaps();
 
         TextureLayout getTextureLayout() const;
@@ -68,6 +70,22 @@ namespace glowl
             GLuint minlayer,
             GLuint numlayers);
 
+        /**
+         * \brief Set the channel swizzle of the view (GL_TEXTURE_SWIZZLE_RGBA).
+         *
+         * Allows to e.g. read grayscale data as RGB or BGR data as RGB without converting the source texture.
+         *
+         * \param r,g,b,a Source of each channel, one of GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO or GL_ONE
+         */
+        void setSwizzle(GLint r, GLint g, GLint b, GLint a);
+
+        /**
+         * \brief Select whether a depth/stencil view samples depth or stencil values.
+         *
+         * \param mode Either GL_DEPTH_COMPONENT or GL_STENCIL_INDEX
+         */
+        void setDepthStencilTextureMode(GLenum mode);
+
         unsigned int getWidth();
         unsigned int getHeight();
         unsigned int getDepth();
@@ -90,7 +108,8 @@ namespace glowl
                                         GLuint               numlayers)
         : Texture(id, layout.internal_format, layout.format, layout.type, layout.levels)
     {
-        glGenTextures(1, &m_name);
+        m_name = getNamePool(NameType::Texture).acquire();
+        m_storage_id = nextStorageId();
 
         glTextureView(m_name,
                       GL_TEXTURE_2D,
@@ -101,6 +120,27 @@ namespace glowl
                       minlayer,
                       numlayers);
 
+        for (auto& pname_pvalue : layout.int_parameters)
+        {
+            glTextureParameteri(m_name, pname_pvalue.first, pname_pvalue.second);
+        }
+
+        for (auto& pname_pvalue : layout.float_parameters)
+        {
+            glTextureParameterf(m_name, pname_pvalue.first, pname_pvalue.second);
+        }
+
+        GLOWL_TRACE_CALL(trace::traceTextureView(m_name,
+                                                 GL_TEXTURE_2D,
+                                                 source_texture.getName(),
+                                                 m_internal_format,
+                                                 minlevel,
+                                                 numlevels,
+                                                 minlayer,
+                                                 numlayers,
+                                                 layout.int_parameters,
+                                                 layout.float_parameters));
+
         glBindTexture(GL_TEXTURE_2D, m_name);
 
         GLint w, h, d;
@@ -121,15 +161,23 @@ namespace glowl
 
     inline Texture2DView::~Texture2DView()
     {
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture).release(m_name);
     }
 
     inline void Texture2DView::bindTexture() const
     {
+        GLOWL_TRACE(Opcode::BindTexture, {GL_TEXTURE_2D, m_name});
         glBindTexture(GL_TEXTURE_2D, m_name);
     }
 
+    inline GLenum Texture2DView::getTarget() const
+    {
+        return GL_TEXTURE_2D;
+    }
+
     inline void Texture2DView::updateMipmaps() {
+        GLOWL_TRACE(Opcode::GenerateTextureMipmap, {m_name});
         glGenerateTextureMipmap(m_name);
     }
 
@@ -154,13 +202,36 @@ namespace glowl
         m_type = layout.type;
         m_levels = layout.levels;
 
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture).release(m_name);
 
-        glGenTextures(1, &m_name);
+        m_name = getNamePool(NameType::Texture).acquire();
+        m_storage_id = nextStorageId();
 
         glTextureView(m_name, GL_TEXTURE_2D, source_texture.getName(), m_internal_format, minlevel, numlevels, minlayer,
             numlayers);
 
+        for (auto& pname_pvalue : layout.int_parameters)
+        {
+            glTextureParameteri(m_name, pname_pvalue.first, pname_pvalue.second);
+        }
+
+        for (auto& pname_pvalue : layout.float_parameters)
+        {
+            glTextureParameterf(m_name, pname_pvalue.first, pname_pvalue.second);
+        }
+
+        GLOWL_TRACE_CALL(trace::traceTextureView(m_name,
+                                                 GL_TEXTURE_2D,
+                                                 source_texture.getName(),
+                                                 m_internal_format,
+                                                 minlevel,
+                                                 numlevels,
+                                                 minlayer,
+                                                 numlayers,
+                                                 layout.int_parameters,
+                                                 layout.float_parameters));
+
         glBindTexture(GL_TEXTURE_2D, m_name);
 
         GLint w, h, d;
@@ -180,6 +251,19 @@ namespace glowl
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    inline void Texture2DView::setSwizzle(GLint r, GLint g, GLint b, GLint a)
+    {
+        GLint const swizzle[4] = {r, g, b, a};
+        glTextureParameteriv(m_name, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        GLOWL_TRACE_CALL(trace::traceSwizzle(m_name, r, g, b, a));
+    }
+
+    inline void Texture2DView::setDepthStencilTextureMode(GLenum mode)
+    {
+        GLOWL_TRACE(Opcode::TextureParameteri, {m_name, GL_DEPTH_STENCIL_TEXTURE_MODE, mode});
+        glTextureParameteri(m_name, GL_DEPTH_STENCIL_TEXTURE_MODE, static_cast<GLint>(mode));
+    }
+
     inline unsigned int Texture2DView::getWidth()
     {
         return m_width;
@@ -8,6 +8,9 @@
 #ifndef GLOWL_TEXTURE3D_HPP
 #define GLOWL_TEXTURE3D_HPP
 
+#include <algorithm>
+#include <cmath>
+
 #include "Exceptions.hpp"
 #include "Texture.hpp"
 
@@ -49,8 +52,23 @@ namespace glowl
          */
         void bindTexture() const;
 
+        GLenum getTarget() const;
+
         void updateMipmaps();
 
+        /**
+         * \brief Update a box of the given mip level.
+         * With a buffer bound to GL_PIXEL_UNPACK_BUFFER, data is interpreted as byte offset into that buffer.
+         */
+        void subImage(GLint         level,
+                      GLint         x,
+                      GLint         y,
+                      GLint         z,
+                      GLsizei       width,
+                      GLsizei       height,
+                      GLsizei       depth,
+                      GLvoid const* data);
+
         /**
          * \brief Reload the texture.
          * \param data Pointer to the new texture data.
@@ -82,7 +100,8 @@ namespace glowl
           m_height(layout.height),
           m_depth(layout.depth)
     {
-        glCreateTextures(GL_TEXTURE_3D, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_3D).acquire();
+        m_storage_id = nextStorageId();
 
         for (auto& pname_pvalue : layout.int_parameters)
         {
@@ -111,6 +130,20 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_3D,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     m_depth,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     layout.int_parameters,
+                                                     layout.float_parameters,
+                                                     data));
+
 #ifndef GLOWL_NO_ARB_BINDLESS_TEXTURE
         m_texture_handle = glGetTextureHandleARB(m_name);
 #endif
@@ -125,19 +158,41 @@ namespace glowl
 
     inline Texture3D::~Texture3D()
     {
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_3D).release(m_name);
     }
 
     inline void Texture3D::bindTexture() const
     {
+        GLOWL_TRACE(Opcode::BindTexture, {GL_TEXTURE_3D, m_name});
         glBindTexture(GL_TEXTURE_3D, m_name);
     }
 
+    inline GLenum Texture3D::getTarget() const
+    {
+        return GL_TEXTURE_3D;
+    }
+
     inline void Texture3D::updateMipmaps()
     {
+        GLOWL_TRACE(Opcode::GenerateTextureMipmap, {m_name});
         glGenerateTextureMipmap(m_name);
     }
 
+    inline void Texture3D::subImage(GLint         level,
+                                    GLint         x,
+                                    GLint         y,
+                                    GLint         z,
+                                    GLsizei       width,
+                                    GLsizei       height,
+                                    GLsizei       depth,
+                                    GLvoid const* data)
+    {
+        GLOWL_TRACE_CALL(trace::traceTextureSubImage(
+            m_name, GL_TEXTURE_3D, level, x, y, z, width, height, depth, m_format, m_type, data));
+        glTextureSubImage3D(m_name, level, x, y, z, width, height, depth, m_format, m_type, data);
+    }
+
     inline void Texture3D::reload(TextureLayout const& layout,
                                   GLvoid const*        data,
                                   bool                 generateMipmap,
@@ -149,10 +204,13 @@ namespace glowl
         m_internal_format = layout.internal_format;
         m_format = layout.format;
         m_type = layout.type;
+        m_levels = layout.levels;
 
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_3D).release(m_name);
 
-        glCreateTextures(GL_TEXTURE_3D, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_3D).acquire();
+        m_storage_id = nextStorageId();
 
         for (auto& pname_pvalue : layout.int_parameters)
         {
@@ -169,7 +227,7 @@ namespace glowl
             m_levels = 1 + static_cast<GLsizei>(std::floor(std::log2(std::max(m_depth, std::max(m_width, m_height)))));
         }
 
-        glTextureStorage3D(m_name, 1, m_internal_format, m_width, m_height, m_depth);
+        glTextureStorage3D(m_name, m_levels, m_internal_format, m_width, m_height, m_depth);
 
         if (data != nullptr)
         {
@@ -181,6 +239,20 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_3D,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     m_depth,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     layout.int_parameters,
+                                                     layout.float_parameters,
+                                                     data));
+
         GLenum err = glGetError();
         if (err != GL_NO_ERROR)
         {
@@ -42,8 +42,17 @@ namespace glowl
 
         void bindTexture() const;
 
+        GLenum getTarget() const;
+
         TextureLayout getTextureLayout() const;
 
+        /**
+         * \brief Set the channel swizzle of the view (GL_TEXTURE_SWIZZLE_RGBA).
+         *
+         * \param r,g,b,a Source of each channel, one of GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO or GL_ONE
+         */
+        void setSwizzle(GLint r, GLint g, GLint b, GLint a);
+
         unsigned int getWidth();
         unsigned int getHeight();
         unsigned int getDepth();
@@ -63,7 +72,18 @@ namespace glowl
                                         GLuint               numlayers)
         : Texture(id, layout.internal_format, layout.format, layout.type, layout.levels)
     {
-        glCreateTextures(GL_TEXTURE_3D, 1, &m_name);
+        // texture views require a name that has not been bound or initialized yet
+        m_name = getNamePool(NameType::Texture).acquire();
+        m_storage_id = nextStorageId();
+
+        glTextureView(m_name,
+                      GL_TEXTURE_3D,
+                      source_texture.getName(),
+                      m_internal_format,
+                      minlevel,
+                      numlevels,
+                      minlayer,
+                      numlayers);
 
         for (auto& pname_pvalue : layout.int_parameters)
         {
@@ -75,14 +95,24 @@ namespace glowl
             glTextureParameterf(m_name, pname_pvalue.first, pname_pvalue.second);
         }
 
-        glTextureView(m_name,
-                      GL_TEXTURE_3D,
-                      source_texture.getName(),
-                      m_internal_format,
-                      minlevel,
-                      numlevels,
-                      minlayer,
-                      numlayers);
+        GLOWL_TRACE_CALL(trace::traceTextureView(m_name,
+                                                 GL_TEXTURE_3D,
+                                                 source_texture.getName(),
+                                                 m_internal_format,
+                                                 minlevel,
+                                                 numlevels,
+                                                 minlayer,
+                                                 numlayers,
+                                                 layout.int_parameters,
+                                                 layout.float_parameters));
+
+        GLint w, h, d;
+        glGetTextureLevelParameteriv(m_name, 0, GL_TEXTURE_WIDTH, &w);
+        glGetTextureLevelParameteriv(m_name, 0, GL_TEXTURE_HEIGHT, &h);
+        glGetTextureLevelParameteriv(m_name, 0, GL_TEXTURE_DEPTH, &d);
+        m_width = (unsigned int) w;
+        m_height = (unsigned int) h;
+        m_depth = (unsigned int) d;
 
         GLenum err = glGetError();
         if (err != GL_NO_ERROR)
@@ -94,19 +124,33 @@ namespace glowl
 
     inline Texture3DView::~Texture3DView()
     {
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture).release(m_name);
     }
 
     inline void Texture3DView::bindTexture() const
     {
+        GLOWL_TRACE(Opcode::BindTexture, {GL_TEXTURE_3D, m_name});
         glBindTexture(GL_TEXTURE_3D, m_name);
     }
 
+    inline GLenum Texture3DView::getTarget() const
+    {
+        return GL_TEXTURE_3D;
+    }
+
     inline TextureLayout Texture3DView::getTextureLayout() const
     {
         return TextureLayout(m_internal_format, m_width, m_height, m_depth, m_format, m_type, m_levels);
     }
 
+    inline void Texture3DView::setSwizzle(GLint r, GLint g, GLint b, GLint a)
+    {
+        GLint const swizzle[4] = {r, g, b, a};
+        glTextureParameteriv(m_name, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        GLOWL_TRACE_CALL(trace::traceSwizzle(m_name, r, g, b, a));
+    }
+
     inline unsigned int Texture3DView::getWidth()
     {
         return m_width;
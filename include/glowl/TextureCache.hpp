@@ -0,0 +1,643 @@
+/*
+ * TextureCache.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_TEXTURECACHE_HPP
+#define GLOWL_TEXTURECACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "MappedFile.hpp"
+#include "Texture2D.hpp"
+#include "Texture2DArray.hpp"
+#include "Texture3D.hpp"
+#include "TextureCubemapArray.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    namespace detail
+    {
+        struct TextureCacheHeader
+        {
+            char          magic[8];
+            std::uint32_t version;
+            std::uint32_t target;
+            std::uint32_t internal_format;
+            std::uint32_t format;
+            std::uint32_t type;
+            std::uint32_t compressed;
+            std::int32_t  width;
+            std::int32_t  height;
+            std::int32_t  depth;
+            std::int32_t  levels;
+            std::uint32_t int_parameter_cnt;
+            std::uint32_t float_parameter_cnt;
+            std::uint32_t reserved[2];
+            std::uint64_t key;
+        };
+
+        /** Parameter value as raw bits, int or float depending on the list it belongs to */
+        struct TextureCacheParameter
+        {
+            std::uint32_t pname;
+            std::uint32_t value;
+        };
+
+        struct TextureCacheLevel
+        {
+            std::uint64_t byte_offset;
+            std::uint64_t byte_size;
+        };
+
+        static_assert(sizeof(TextureCacheHeader) == 72, "Unexpected padding in TextureCacheHeader");
+        static_assert(sizeof(TextureCacheParameter) == 8, "Unexpected padding in TextureCacheParameter");
+        static_assert(sizeof(TextureCacheLevel) == 16, "Unexpected padding in TextureCacheLevel");
+    } // namespace detail
+
+    /**
+     * \class TextureCache
+     *
+     * \brief Persistent cache of GPU-ready texture data in a directory, one file per texture.
+     *
+     * Entries are identified by a 64 bit key, usually computed from the source data and all settings that influence
+     * the conversion (see computeKey()). An entry stores the final TextureLayout and the data of all mipmap levels
+     * (and layers) exactly as uploaded, each level starting at a multiple of payload_alignment bytes. Loading maps
+     * the file and uploads the levels straight from the mapping, without any conversion on the CPU.
+     *
+     * Entries are written to a temporary file that replaces the entry once complete, so a crashed or concurrent
+     * writer never leaves a partial entry behind. Files are written in native byte order, which is checked on load.
+     * Supported targets are GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D and GL_TEXTURE_CUBE_MAP_ARRAY,
+     * compressed formats included.
+     */
+    class TextureCache
+    {
+    public:
+        static constexpr std::uint32_t version = 1;
+        static constexpr size_t        payload_alignment = 256;
+
+        /**
+         * \brief Data of one mipmap level including all layers, tightly packed.
+         */
+        struct LevelData
+        {
+            void const* data;
+            size_t      byte_size;
+        };
+
+        /**
+         * \param directory Existing directory that holds the cache files
+         */
+        explicit TextureCache(std::string const& directory);
+
+        /**
+         * \brief 64 bit hash of a byte range, use the result of a previous call as seed to hash several ranges.
+         */
+        static std::uint64_t hash(void const* data, size_t byte_size, std::uint64_t seed = 14695981039346656037ull);
+
+        /**
+         * \brief Key of an entry converted from the given source data with the given settings, e.g. a string listing
+         * the target format, mipmap filter and compression quality.
+         */
+        static std::uint64_t computeKey(void const* source, size_t byte_size, std::string const& settings);
+
+        std::string getPath(std::uint64_t key) const;
+
+        /**
+         * \brief Returns true if a valid entry exists for the key.
+         */
+        bool contains(std::uint64_t key) const;
+
+        /**
+         * \brief Loads an entry into a new texture. Returns nullptr if there is no valid entry for the key.
+         *
+         * Note: Active OpenGL context required.
+         */
+        std::unique_ptr<Texture> load(std::string const& id, std::uint64_t key) const;
+
+        /**
+         * \brief Stores texture data given on the CPU.
+         *
+         * \param target GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D or GL_TEXTURE_CUBE_MAP_ARRAY (depth counts
+         * layer-faces)
+         * \param layout Layout of the texture including its parameters
+         * \param levels Data of all levels of the layout, in its format and type or compressed in its internal format
+         */
+        void store(std::uint64_t                 key,
+                   GLenum                        target,
+                   TextureLayout const&          layout,
+                   std::vector<LevelData> const& levels) const;
+
+        /**
+         * \brief Stores the content of all levels of a texture, reading them back from the GPU.
+         * The parameters are stored with the layout and applied on load.
+         *
+         * Note: Active OpenGL context required.
+         */
+        void store(std::uint64_t                                  key,
+                   Texture const&                                 texture,
+                   std::vector<std::pair<GLenum, GLint>> const&   int_parameters = {},
+                   std::vector<std::pair<GLenum, GLfloat>> const& float_parameters = {}) const;
+
+        /**
+         * \brief Deletes the entry for the key, if any.
+         */
+        void remove(std::uint64_t key) const;
+
+    private:
+        /** Size of a level of an uncompressed texture */
+        static size_t getLevelByteSize(GLenum target, TextureLayout const& layout, GLint level);
+
+        /** Reads and validates the header, returns false for missing or invalid entries */
+        static bool readHeader(std::string const& path, std::uint64_t key, detail::TextureCacheHeader& header);
+
+        static bool isValidHeader(detail::TextureCacheHeader const& header, std::uint64_t key);
+
+        static size_t alignPayload(size_t byte_offset);
+
+        std::string m_directory;
+    };
+
+    inline TextureCache::TextureCache(std::string const& directory) : m_directory(directory)
+    {
+        if (!m_directory.empty() && m_directory.back() != '/' && m_directory.back() != '\\')
+        {
+            m_directory += '/';
+        }
+    }
+
+    inline std::uint64_t TextureCache::hash(void const* data, size_t byte_size, std::uint64_t seed)
+    {
+        // FNV-1a on 8 byte words in four independent lanes, a byte-wise FNV-1a loop is latency bound. The xorshift
+        // feeds the high bits back, the multiplication alone only propagates changes towards them.
+        std::uint64_t const prime = 1099511628211ull;
+
+        auto const*   bytes = static_cast<unsigned char const*>(data);
+        std::uint64_t lanes[4] = {seed, seed ^ 1, seed ^ 2, seed ^ 3};
+
+        size_t offset = 0;
+        for (; offset + 32 <= byte_size; offset += 32)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, bytes + offset + lane * 8, 8);
+                lanes[lane] = (lanes[lane] ^ word) * prime;
+                lanes[lane] ^= lanes[lane] >> 32;
+            }
+        }
+
+        std::uint64_t result = seed;
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            for (int shift = 0; shift < 64; shift += 8)
+            {
+                result = (result ^ ((lanes[lane] >> shift) & 0xFF)) * prime;
+            }
+        }
+        for (; offset < byte_size; ++offset)
+        {
+            result = (result ^ bytes[offset]) * prime;
+        }
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            result = (result ^ ((static_cast<std::uint64_t>(byte_size) >> shift) & 0xFF)) * prime;
+        }
+
+        return result;
+    }
+
+    inline std::uint64_t TextureCache::computeKey(void const* source, size_t byte_size, std::string const& settings)
+    {
+        return hash(settings.data(), settings.size(), hash(source, byte_size));
+    }
+
+    inline std::string TextureCache::getPath(std::uint64_t key) const
+    {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return m_directory + name + ".glowltex";
+    }
+
+    inline bool TextureCache::contains(std::uint64_t key) const
+    {
+        detail::TextureCacheHeader header;
+        return readHeader(getPath(key), key, header);
+    }
+
+    inline std::unique_ptr<Texture> TextureCache::load(std::string const& id, std::uint64_t key) const
+    {
+        std::string                path = getPath(key);
+        detail::TextureCacheHeader header;
+        if (!readHeader(path, key, header))
+        {
+            return nullptr;
+        }
+
+        std::unique_ptr<detail::MappedFile> file;
+        try
+        {
+            file = std::make_unique<detail::MappedFile>(path);
+        }
+        catch (BaseException const&)
+        {
+            return nullptr;
+        }
+
+        unsigned char const* data = file->getData();
+        size_t               parameter_cnt = header.int_parameter_cnt + header.float_parameter_cnt;
+        size_t               table_offset = sizeof(header) + parameter_cnt * sizeof(detail::TextureCacheParameter);
+        size_t               payload_offset = table_offset + header.levels * sizeof(detail::TextureCacheLevel);
+        if (file->getByteSize() < payload_offset)
+        {
+            return nullptr;
+        }
+
+        TextureLayout layout(static_cast<GLint>(header.internal_format),
+                             header.width,
+                             header.height,
+                             header.depth,
+                             header.format,
+                             header.type,
+                             header.levels);
+
+        auto const* parameters = data + sizeof(header);
+        for (size_t i = 0; i < parameter_cnt; ++i)
+        {
+            detail::TextureCacheParameter parameter;
+            std::memcpy(&parameter, parameters + i * sizeof(parameter), sizeof(parameter));
+            if (i < header.int_parameter_cnt)
+            {
+                GLint value;
+                std::memcpy(&value, &parameter.value, sizeof(value));
+                layout.int_parameters.emplace_back(parameter.pname, value);
+            }
+            else
+            {
+                GLfloat value;
+                std::memcpy(&value, &parameter.value, sizeof(value));
+                layout.float_parameters.emplace_back(parameter.pname, value);
+            }
+        }
+
+        std::vector<detail::TextureCacheLevel> levels(header.levels);
+        std::memcpy(levels.data(), data + table_offset, levels.size() * sizeof(detail::TextureCacheLevel));
+        for (GLint level = 0; level < header.levels; ++level)
+        {
+            auto const& entry = levels[level];
+            bool        valid_size = header.compressed != 0 ||
+                              entry.byte_size == getLevelByteSize(header.target, layout, level);
+            if (!valid_size || entry.byte_offset < payload_offset || entry.byte_offset > file->getByteSize() ||
+                entry.byte_size > file->getByteSize() - entry.byte_offset)
+            {
+                return nullptr;
+            }
+        }
+
+        std::unique_ptr<Texture> texture;
+        switch (header.target)
+        {
+        case GL_TEXTURE_2D:
+            texture = std::make_unique<Texture2D>(id, layout, nullptr);
+            break;
+        case GL_TEXTURE_2D_ARRAY:
+            texture = std::make_unique<Texture2DArray>(id, layout, nullptr);
+            break;
+        case GL_TEXTURE_CUBE_MAP_ARRAY:
+        {
+            auto cubemap_array = std::make_unique<TextureCubemapArray>(id,
+                                                                       layout.internal_format,
+                                                                       layout.width,
+                                                                       layout.height,
+                                                                       layout.depth,
+                                                                       layout.format,
+                                                                       layout.type,
+                                                                       layout.levels,
+                                                                       nullptr);
+            for (auto const& pname_pvalue : layout.int_parameters)
+            {
+                cubemap_array->texParameteri(pname_pvalue.first, pname_pvalue.second);
+            }
+            for (auto const& pname_pvalue : layout.float_parameters)
+            {
+                glTextureParameterf(cubemap_array->getName(), pname_pvalue.first, pname_pvalue.second);
+            }
+            texture = std::move(cubemap_array);
+            break;
+        }
+        default:
+            texture = std::make_unique<Texture3D>(id, layout, nullptr);
+            break;
+        }
+
+        GLint unpack_alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (GLint level = 0; level < header.levels; ++level)
+        {
+            GLsizei width = std::max(1, layout.width >> level);
+            GLsizei height = std::max(1, layout.height >> level);
+            GLsizei depth = header.target == GL_TEXTURE_3D ? std::max(1, layout.depth >> level) : layout.depth;
+
+            void const* level_data = data + levels[level].byte_offset;
+            GLsizei     byte_size = static_cast<GLsizei>(levels[level].byte_size);
+
+            if (header.target == GL_TEXTURE_2D)
+            {
+                if (header.compressed != 0)
+                {
+                    glCompressedTextureSubImage2D(
+                        texture->getName(), level, 0, 0, width, height, layout.internal_format, byte_size, level_data);
+                }
+                else
+                {
+                    static_cast<Texture2D&>(*texture).subImage(level, 0, 0, width, height, level_data);
+                }
+            }
+            else
+            {
+                if (header.compressed != 0)
+                {
+                    glCompressedTextureSubImage3D(texture->getName(),
+                                                  level,
+                                                  0,
+                                                  0,
+                                                  0,
+                                                  width,
+                                                  height,
+                                                  depth,
+                                                  layout.internal_format,
+                                                  byte_size,
+                                                  level_data);
+                }
+                else
+                {
+                    glTextureSubImage3D(texture->getName(),
+                                        level,
+                                        0,
+                                        0,
+                                        0,
+                                        width,
+                                        height,
+                                        depth,
+                                        layout.format,
+                                        layout.type,
+                                        level_data);
+                }
+            }
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+        auto err = glGetError();
+        if (err != GL_NO_ERROR)
+        {
+            throw TextureException("TextureCache::load - texture id: " + id + " - OpenGL error " +
+                                   std::to_string(err));
+        }
+
+        return texture;
+    }
+
+    inline void TextureCache::store(std::uint64_t                 key,
+                                    GLenum                        target,
+                                    TextureLayout const&          layout,
+                                    std::vector<LevelData> const& levels) const
+    {
+        std::string path = getPath(key);
+
+        if (target != GL_TEXTURE_2D && target != GL_TEXTURE_2D_ARRAY && target != GL_TEXTURE_3D &&
+            target != GL_TEXTURE_CUBE_MAP_ARRAY)
+        {
+            throw TextureException("TextureCache::store - " + path + " - unsupported target " + std::to_string(target));
+        }
+        if (layout.levels <= 0 || static_cast<size_t>(layout.levels) != levels.size())
+        {
+            throw TextureException("TextureCache::store - " + path + " - expected " + std::to_string(layout.levels) +
+                                   " levels, got " + std::to_string(levels.size()));
+        }
+
+        GLint block_width = 1;
+        GLint block_height = 1;
+        bool  compressed = getCompressedBlockSize(layout.internal_format, block_width, block_height);
+
+        detail::TextureCacheHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "GLOWLTEX", 8);
+        header.version = version;
+        header.target = target;
+        header.internal_format = static_cast<std::uint32_t>(layout.internal_format);
+        header.format = layout.format;
+        header.type = layout.type;
+        header.compressed = compressed ? 1 : 0;
+        header.width = layout.width;
+        header.height = layout.height;
+        header.depth = target == GL_TEXTURE_2D ? 1 : layout.depth;
+        header.levels = layout.levels;
+        header.int_parameter_cnt = static_cast<std::uint32_t>(layout.int_parameters.size());
+        header.float_parameter_cnt = static_cast<std::uint32_t>(layout.float_parameters.size());
+        header.key = key;
+
+        std::vector<detail::TextureCacheParameter> parameters;
+        for (auto const& pname_pvalue : layout.int_parameters)
+        {
+            detail::TextureCacheParameter parameter{pname_pvalue.first, 0};
+            std::memcpy(&parameter.value, &pname_pvalue.second, sizeof(parameter.value));
+            parameters.push_back(parameter);
+        }
+        for (auto const& pname_pvalue : layout.float_parameters)
+        {
+            detail::TextureCacheParameter parameter{pname_pvalue.first, 0};
+            std::memcpy(&parameter.value, &pname_pvalue.second, sizeof(parameter.value));
+            parameters.push_back(parameter);
+        }
+
+        TextureLayout stored_layout = layout;
+        stored_layout.depth = header.depth;
+
+        std::vector<detail::TextureCacheLevel> table(levels.size());
+        size_t byte_offset = sizeof(header) + parameters.size() * sizeof(detail::TextureCacheParameter) +
+                             table.size() * sizeof(detail::TextureCacheLevel);
+        for (GLint level = 0; level < layout.levels; ++level)
+        {
+            if (!compressed && levels[level].byte_size != getLevelByteSize(target, stored_layout, level))
+            {
+                throw TextureException("TextureCache::store - " + path + " - unexpected byte size of level " +
+                                       std::to_string(level));
+            }
+
+            byte_offset = alignPayload(byte_offset);
+            table[level] = {byte_offset, levels[level].byte_size};
+            byte_offset += levels[level].byte_size;
+        }
+
+        // written next to the entry and renamed at the end, readers never see partial files
+        std::string tmp_path = path + ".tmp" + std::to_string(std::random_device()());
+        std::FILE*  file = std::fopen(tmp_path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            throw TextureException("TextureCache::store - cannot open " + tmp_path);
+        }
+
+        size_t const               alignment = payload_alignment;
+        std::vector<unsigned char> padding(alignment, 0);
+        bool success = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        success = success && (parameters.empty() || std::fwrite(parameters.data(),
+                                                                sizeof(detail::TextureCacheParameter),
+                                                                parameters.size(),
+                                                                file) == parameters.size());
+        success = success &&
+                  std::fwrite(table.data(), sizeof(detail::TextureCacheLevel), table.size(), file) == table.size();
+
+        size_t written = sizeof(header) + parameters.size() * sizeof(detail::TextureCacheParameter) +
+                         table.size() * sizeof(detail::TextureCacheLevel);
+        for (size_t level = 0; success && level < levels.size(); ++level)
+        {
+            size_t padding_size = table[level].byte_offset - written;
+            success = padding_size == 0 || std::fwrite(padding.data(), 1, padding_size, file) == padding_size;
+            success = success && (levels[level].byte_size == 0 ||
+                                  std::fwrite(levels[level].data, 1, levels[level].byte_size, file) ==
+                                      levels[level].byte_size);
+            written = table[level].byte_offset + levels[level].byte_size;
+        }
+
+        success = std::fclose(file) == 0 && success;
+
+        if (success)
+        {
+            // rename does not replace existing files on all platforms
+            std::remove(path.c_str());
+            success = std::rename(tmp_path.c_str(), path.c_str()) == 0;
+        }
+
+        if (!success)
+        {
+            std::remove(tmp_path.c_str());
+            throw TextureException("TextureCache::store - cannot write " + path);
+        }
+    }
+
+    inline void TextureCache::store(std::uint64_t                                  key,
+                                    Texture const&                                 texture,
+                                    std::vector<std::pair<GLenum, GLint>> const&   int_parameters,
+                                    std::vector<std::pair<GLenum, GLfloat>> const& float_parameters) const
+    {
+        GLenum        target = texture.getTarget();
+        TextureLayout layout = texture.getTextureLayout();
+        layout.int_parameters = int_parameters;
+        layout.float_parameters = float_parameters;
+
+        if (target != GL_TEXTURE_2D && target != GL_TEXTURE_2D_ARRAY && target != GL_TEXTURE_3D &&
+            target != GL_TEXTURE_CUBE_MAP_ARRAY)
+        {
+            throw TextureException("TextureCache::store - texture id: " + texture.getId() + " - unsupported target " +
+                                   std::to_string(target));
+        }
+
+        GLint pack_alignment = 4;
+        glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        std::vector<std::vector<unsigned char>> data(layout.levels);
+        std::vector<LevelData>                  levels(layout.levels);
+        for (GLint level = 0; level < layout.levels; ++level)
+        {
+            GLint compressed = GL_FALSE;
+            glGetTextureLevelParameteriv(texture.getName(), level, GL_TEXTURE_COMPRESSED, &compressed);
+
+            if (compressed != GL_FALSE)
+            {
+                GLint byte_size = 0;
+                glGetTextureLevelParameteriv(
+                    texture.getName(), level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &byte_size);
+                data[level].resize(static_cast<size_t>(byte_size));
+                glGetCompressedTextureImage(texture.getName(), level, byte_size, data[level].data());
+            }
+            else
+            {
+                data[level].resize(getLevelByteSize(target, layout, level));
+                glGetTextureImage(texture.getName(),
+                                  level,
+                                  layout.format,
+                                  layout.type,
+                                  static_cast<GLsizei>(data[level].size()),
+                                  data[level].data());
+            }
+
+            levels[level] = {data[level].data(), data[level].size()};
+        }
+
+        glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+
+        auto err = glGetError();
+        if (err != GL_NO_ERROR)
+        {
+            throw TextureException("TextureCache::store - texture id: " + texture.getId() + " - OpenGL error " +
+                                   std::to_string(err));
+        }
+
+        store(key, target, layout, levels);
+    }
+
+    inline void TextureCache::remove(std::uint64_t key) const
+    {
+        std::remove(getPath(key).c_str());
+    }
+
+    inline size_t TextureCache::getLevelByteSize(GLenum target, TextureLayout const& layout, GLint level)
+    {
+        GLsizei depth = target == GL_TEXTURE_3D ? std::max(1, layout.depth >> level) : std::max(1, layout.depth);
+        return trace::computeImageByteSize(layout.format,
+                                           layout.type,
+                                           std::max(1, layout.width >> level),
+                                           std::max(1, layout.height >> level),
+                                           target == GL_TEXTURE_2D ? 1 : depth);
+    }
+
+    inline bool TextureCache::readHeader(std::string const&          path,
+                                         std::uint64_t               key,
+                                         detail::TextureCacheHeader& header)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+        bool success = std::fread(&header, sizeof(header), 1, file) == 1;
+        std::fclose(file);
+
+        return success && isValidHeader(header, key);
+    }
+
+    inline bool TextureCache::isValidHeader(detail::TextureCacheHeader const& header, std::uint64_t key)
+    {
+        // a file of different byte order fails the version check
+        return std::memcmp(header.magic, "GLOWLTEX", 8) == 0 && header.version == version && header.key == key &&
+               (header.target == GL_TEXTURE_2D || header.target == GL_TEXTURE_2D_ARRAY ||
+                header.target == GL_TEXTURE_3D || header.target == GL_TEXTURE_CUBE_MAP_ARRAY) &&
+               header.width > 0 && header.height > 0 && header.depth > 0 && header.levels > 0 && header.levels <= 32 &&
+               (header.target != GL_TEXTURE_CUBE_MAP_ARRAY || (header.width == header.height && header.depth % 6 == 0));
+    }
+
+    inline size_t TextureCache::alignPayload(size_t byte_offset)
+    {
+        return (byte_offset + payload_alignment - 1) / payload_alignment * payload_alignment;
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_TEXTURECACHE_HPP
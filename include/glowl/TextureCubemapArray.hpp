@@ -64,6 +64,8 @@ namespace glowl
 
         void bindTexture() const;
 
+        GLenum getTarget() const;
+
         void updateMipmaps();
 
         void texParameteri(GLenum pname, GLenum param);
@@ -92,7 +94,8 @@ namespace glowl
                                                     bool          generateMipmap)
         : Texture(id, internal_format, format, type, levels), m_width(width), m_height(height), m_layers(layers)
     {
-        glCreateTextures(GL_TEXTURE_CUBE_MAP_ARRAY, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_CUBE_MAP_ARRAY).acquire();
+        m_storage_id = nextStorageId();
 
         glTextureParameteri(m_name, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTextureParameteri(m_name, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -100,7 +103,7 @@ namespace glowl
         glTextureParameteri(m_name, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTextureParameteri(m_name, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-        glTextureStorage3D(m_name, 1, m_internal_format, m_width, m_height, m_layers);
+        glTextureStorage3D(m_name, m_levels, m_internal_format, m_width, m_height, m_layers);
 
         if (data != nullptr) {
             glTextureSubImage3D(m_name, 0, 0, 0, 0, m_width, m_height, m_layers, m_format, m_type, data);
@@ -112,6 +115,25 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_CUBE_MAP_ARRAY,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     m_layers,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     {{GL_TEXTURE_MAG_FILTER, GL_NEAREST},
+                                                      {GL_TEXTURE_MIN_FILTER,
+                                                       generateMipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST},
+                                                      {GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE},
+                                                      {GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE},
+                                                      {GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE}},
+                                                     {},
+                                                     data));
+
         auto err = glGetError();
         if (err != GL_NO_ERROR)
         {
@@ -122,7 +144,8 @@ namespace glowl
 
     inline TextureCubemapArray::~TextureCubemapArray()
     {
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_CUBE_MAP_ARRAY).release(m_name);
     }
 
     inline void TextureCubemapArray::reload(unsigned int  width,
@@ -135,9 +158,11 @@ namespace glowl
         m_height = height;
         m_layers = layers;
 
-        glDeleteTextures(1, &m_name);
+        GLOWL_TRACE(Opcode::DeleteTexture, {m_name});
+        getNamePool(NameType::Texture, GL_TEXTURE_CUBE_MAP_ARRAY).release(m_name);
 
-        glCreateTextures(GL_TEXTURE_CUBE_MAP_ARRAY, 1, &m_name);
+        m_name = getNamePool(NameType::Texture, GL_TEXTURE_CUBE_MAP_ARRAY).acquire();
+        m_storage_id = nextStorageId();
         assert(m_name > 0);
 
         glTextureParameteri(m_name, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -145,7 +170,7 @@ namespace glowl
         glTextureParameteri(m_name, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTextureParameteri(m_name, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-        glTextureStorage3D(m_name, 1, m_internal_format, m_width, m_height, m_layers);
+        glTextureStorage3D(m_name, m_levels, m_internal_format, m_width, m_height, m_layers);
 
         if (data != nullptr) {
             glTextureSubImage3D(m_name, 0, 0, 0, 0, m_width, m_height, m_layers, m_format, m_type, data);
@@ -157,6 +182,24 @@ namespace glowl
             glGenerateTextureMipmap(m_name);
         }
 
+        GLOWL_TRACE_CALL(trace::traceTextureCreation(GL_TEXTURE_CUBE_MAP_ARRAY,
+                                                     m_name,
+                                                     m_internal_format,
+                                                     m_width,
+                                                     m_height,
+                                                     m_layers,
+                                                     m_levels,
+                                                     m_format,
+                                                     m_type,
+                                                     generateMipmap,
+                                                     {{GL_TEXTURE_WRAP_S, GL_REPEAT},
+                                                      {GL_TEXTURE_WRAP_T, GL_REPEAT},
+                                                      {GL_TEXTURE_MAG_FILTER, GL_LINEAR},
+                                                      {GL_TEXTURE_MIN_FILTER,
+                                                       generateMipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR}},
+                                                     {},
+                                                     data));
+
         auto err = glGetError();
         if (err != GL_NO_ERROR)
         {
@@ -167,16 +210,24 @@ namespace glowl
 
     inline void TextureCubemapArray::bindTexture() const
     {
+        GLOWL_TRACE(Opcode::BindTexture, {GL_TEXTURE_CUBE_MAP_ARRAY, m_name});
         glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, m_name);
     }
 
+    inline GLenum TextureCubemapArray::getTarget() const
+    {
+        return GL_TEXTURE_CUBE_MAP_ARRAY;
+    }
+
     inline void TextureCubemapArray::updateMipmaps()
     {
+        GLOWL_TRACE(Opcode::GenerateTextureMipmap, {m_name});
         glGenerateTextureMipmap(m_name);
     }
 
     inline void TextureCubemapArray::texParameteri(GLenum pname, GLenum param)
     {
+        GLOWL_TRACE(Opcode::TextureParameteri, {m_name, pname, param});
         glTextureParameteri(m_name, pname, param);
     }
 
@@ -0,0 +1,525 @@
+/*
+ * TextureFormatAdvisor.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_TEXTUREFORMATADVISOR_HPP
+#define GLOWL_TEXTUREFORMATADVISOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "Texture.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    namespace detail
+    {
+        enum class TexelEncoding
+        {
+            Unorm,
+            Snorm,
+            Half,
+            Float,
+            R11F_G11F_B10F,
+            RGB9_E5
+        };
+
+        struct TexelFormat
+        {
+            GLenum        internal_format;
+            GLenum        format;
+            GLenum        type;
+            int           components;        ///< Components of the data that the format can represent
+            int           stored_components; ///< Components per texel in the converted data
+            TexelEncoding encoding;
+            int           bits;              ///< Bits per component for normalized formats
+            size_t        texel_byte_size;
+        };
+
+        /**
+         * Candidate formats by component count, each ordered by texel size. Three components use RGBA formats where
+         * implementations pad RGB to four components anyway.
+         */
+        inline std::vector<TexelFormat> const& getTexelFormats()
+        {
+            static std::vector<TexelFormat> const formats = {
+                {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, 1, TexelEncoding::Unorm, 8, 1},
+                {GL_R8_SNORM, GL_RED, GL_BYTE, 1, 1, TexelEncoding::Snorm, 8, 1},
+                {GL_R16, GL_RED, GL_UNSIGNED_SHORT, 1, 1, TexelEncoding::Unorm, 16, 2},
+                {GL_R16_SNORM, GL_RED, GL_SHORT, 1, 1, TexelEncoding::Snorm, 16, 2},
+                {GL_R16F, GL_RED, GL_HALF_FLOAT, 1, 1, TexelEncoding::Half, 16, 2},
+                {GL_R32F, GL_RED, GL_FLOAT, 1, 1, TexelEncoding::Float, 32, 4},
+                {GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, 2, TexelEncoding::Unorm, 8, 2},
+                {GL_RG8_SNORM, GL_RG, GL_BYTE, 2, 2, TexelEncoding::Snorm, 8, 2},
+                {GL_RG16, GL_RG, GL_UNSIGNED_SHORT, 2, 2, TexelEncoding::Unorm, 16, 4},
+                {GL_RG16_SNORM, GL_RG, GL_SHORT, 2, 2, TexelEncoding::Snorm, 16, 4},
+                {GL_RG16F, GL_RG, GL_HALF_FLOAT, 2, 2, TexelEncoding::Half, 16, 4},
+                {GL_RG32F, GL_RG, GL_FLOAT, 2, 2, TexelEncoding::Float, 32, 8},
+                {GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, 3, 3, TexelEncoding::R11F_G11F_B10F, 0, 4},
+                {GL_RGB9_E5, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, 3, 3, TexelEncoding::RGB9_E5, 0, 4},
+                {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 3, 4, TexelEncoding::Unorm, 8, 4},
+                {GL_RGBA8_SNORM, GL_RGBA, GL_BYTE, 3, 4, TexelEncoding::Snorm, 8, 4},
+                {GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, 3, 4, TexelEncoding::Unorm, 16, 8},
+                {GL_RGBA16_SNORM, GL_RGBA, GL_SHORT, 3, 4, TexelEncoding::Snorm, 16, 8},
+                {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 3, 4, TexelEncoding::Half, 16, 8},
+                {GL_RGB32F, GL_RGB, GL_FLOAT, 3, 3, TexelEncoding::Float, 32, 12},
+                {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, 4, TexelEncoding::Unorm, 8, 4},
+                {GL_RGBA8_SNORM, GL_RGBA, GL_BYTE, 4, 4, TexelEncoding::Snorm, 8, 4},
+                {GL_RGBA16, GL_RGBA, GL_UNSIGNED_SHORT, 4, 4, TexelEncoding::Unorm, 16, 8},
+                {GL_RGBA16_SNORM, GL_RGBA, GL_SHORT, 4, 4, TexelEncoding::Snorm, 16, 8},
+                {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 4, 4, TexelEncoding::Half, 16, 8},
+                {GL_RGBA32F, GL_RGBA, GL_FLOAT, 4, 4, TexelEncoding::Float, 32, 16}};
+            return formats;
+        }
+
+        inline int getFormatComponents(GLenum format)
+        {
+            switch (format)
+            {
+            case GL_RED:
+                return 1;
+            case GL_RG:
+                return 2;
+            case GL_RGB:
+                return 3;
+            case GL_RGBA:
+                return 4;
+            default:
+                return 0;
+            }
+        }
+
+        /**
+         * Encodes a non-negative float with a 5 bit exponent and the given number of mantissa bits, as used by half
+         * floats and the components of GL_R11F_G11F_B10F. Negative values and NaN become 0, large values the largest
+         * finite value.
+         */
+        inline std::uint32_t packUnsignedFloat(float value, int mantissa_bits)
+        {
+            if (!(value > 0.0f))
+            {
+                return 0;
+            }
+
+            std::uint32_t const mantissa_end = 1u << mantissa_bits;
+            std::uint32_t const largest = (30u << mantissa_bits) | (mantissa_end - 1);
+
+            if (std::isinf(value))
+            {
+                return largest;
+            }
+
+            int exponent = 0;
+            std::frexp(value, &exponent);
+            int biased_exponent = exponent - 1 + 15;
+
+            if (biased_exponent <= 0)
+            {
+                // denormal, rounding up to the smallest normal value yields its encoding
+                return static_cast<std::uint32_t>(std::lround(std::ldexp(value, 14 + mantissa_bits)));
+            }
+            if (biased_exponent >= 31)
+            {
+                return largest;
+            }
+
+            // a mantissa rounded up to mantissa_end carries over into the exponent
+            auto mantissa = static_cast<std::uint32_t>(std::lround(std::ldexp(value, mantissa_bits - exponent + 1)));
+            auto bits = (static_cast<std::uint32_t>(biased_exponent) << mantissa_bits) + mantissa - mantissa_end;
+
+            return std::min(bits, largest);
+        }
+
+        inline float unpackUnsignedFloat(std::uint32_t bits, int mantissa_bits)
+        {
+            std::uint32_t exponent = bits >> mantissa_bits;
+            std::uint32_t mantissa = bits & ((1u << mantissa_bits) - 1);
+
+            if (exponent == 0)
+            {
+                return std::ldexp(static_cast<float>(mantissa), -14 - mantissa_bits);
+            }
+            return std::ldexp(static_cast<float>(mantissa | (1u << mantissa_bits)),
+                              static_cast<int>(exponent) - 15 - mantissa_bits);
+        }
+
+        inline std::uint16_t packHalf(float value)
+        {
+            std::uint32_t sign = std::signbit(value) ? 0x8000u : 0u;
+            return static_cast<std::uint16_t>(sign | packUnsignedFloat(std::abs(value), 10));
+        }
+
+        inline float unpackHalf(std::uint16_t bits)
+        {
+            float magnitude = unpackUnsignedFloat(bits & 0x7FFFu, 10);
+            return (bits & 0x8000u) != 0 ? -magnitude : magnitude;
+        }
+
+        inline std::uint32_t packR11F_G11F_B10F(float const* rgb)
+        {
+            return packUnsignedFloat(rgb[0], 6) | (packUnsignedFloat(rgb[1], 6) << 11) |
+                   (packUnsignedFloat(rgb[2], 5) << 22);
+        }
+
+        inline void unpackR11F_G11F_B10F(std::uint32_t bits, float* rgb)
+        {
+            rgb[0] = unpackUnsignedFloat(bits & 0x7FFu, 6);
+            rgb[1] = unpackUnsignedFloat((bits >> 11) & 0x7FFu, 6);
+            rgb[2] = unpackUnsignedFloat(bits >> 22, 5);
+        }
+
+        /**
+         * Shared exponent encoding as specified by EXT_texture_shared_exponent.
+         */
+        inline std::uint32_t packRGB9_E5(float const* rgb)
+        {
+            float const max_value = std::ldexp(511.0f / 512.0f, 16);
+
+            float clamped[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                clamped[c] = rgb[c] > 0.0f ? std::min(rgb[c], max_value) : 0.0f;
+            }
+            float max_component = std::max(clamped[0], std::max(clamped[1], clamped[2]));
+
+            int exponent = -16;
+            if (max_component > 0.0f)
+            {
+                std::frexp(max_component, &exponent);
+                exponent = std::max(-16, exponent - 1);
+            }
+            int shared_exponent = exponent + 1 + 15;
+
+            if (std::floor(std::ldexp(max_component, 15 + 9 - shared_exponent) + 0.5f) == 512.0f)
+            {
+                ++shared_exponent;
+            }
+
+            std::uint32_t bits = static_cast<std::uint32_t>(shared_exponent) << 27;
+            for (int c = 0; c < 3; ++c)
+            {
+                float scaled = std::ldexp(clamped[c], 15 + 9 - shared_exponent);
+                auto  mantissa = static_cast<std::uint32_t>(std::floor(scaled + 0.5f));
+                bits |= std::min(mantissa, 511u) << (9 * c);
+            }
+            return bits;
+        }
+
+        inline void unpackRGB9_E5(std::uint32_t bits, float* rgb)
+        {
+            int exponent = static_cast<int>(bits >> 27) - 15 - 9;
+            for (int c = 0; c < 3; ++c)
+            {
+                rgb[c] = std::ldexp(static_cast<float>((bits >> (9 * c)) & 0x1FFu), exponent);
+            }
+        }
+
+        /**
+         * Writes one texel in the given format and returns the values it decodes to.
+         */
+        inline void encodeTexel(TexelFormat const& texel_format,
+                                float const*       values,
+                                unsigned char*     out,
+                                float*             decoded)
+        {
+            switch (texel_format.encoding)
+            {
+            case TexelEncoding::Unorm:
+            case TexelEncoding::Snorm:
+            {
+                bool  is_signed = texel_format.encoding == TexelEncoding::Snorm;
+                float scale = static_cast<float>((1u << (texel_format.bits - (is_signed ? 1 : 0))) - 1);
+                for (int c = 0; c < texel_format.stored_components; ++c)
+                {
+                    float value = std::min(std::max(values[c], is_signed ? -1.0f : 0.0f), 1.0f);
+                    long  integer = std::lround(value * scale);
+                    decoded[c] = integer / scale;
+                    if (texel_format.bits == 8)
+                    {
+                        out[c] = static_cast<unsigned char>(integer);
+                    }
+                    else
+                    {
+                        auto bits = static_cast<std::uint16_t>(integer);
+                        std::memcpy(out + 2 * c, &bits, 2);
+                    }
+                }
+                break;
+            }
+            case TexelEncoding::Half:
+                for (int c = 0; c < texel_format.stored_components; ++c)
+                {
+                    std::uint16_t bits = packHalf(values[c]);
+                    decoded[c] = unpackHalf(bits);
+                    std::memcpy(out + 2 * c, &bits, 2);
+                }
+                break;
+            case TexelEncoding::Float:
+                std::memcpy(out, values, 4 * texel_format.stored_components);
+                std::copy(values, values + texel_format.stored_components, decoded);
+                break;
+            case TexelEncoding::R11F_G11F_B10F:
+            {
+                std::uint32_t bits = packR11F_G11F_B10F(values);
+                unpackR11F_G11F_B10F(bits, decoded);
+                std::memcpy(out, &bits, 4);
+                break;
+            }
+            case TexelEncoding::RGB9_E5:
+            {
+                std::uint32_t bits = packRGB9_E5(values);
+                unpackRGB9_E5(bits, decoded);
+                std::memcpy(out, &bits, 4);
+                break;
+            }
+            }
+        }
+    } // namespace detail
+
+    /**
+     * \struct TextureFormatAdvice
+     *
+     * \brief Result of adviseTextureFormat(): the chosen format, the converted data and the analysis it is based on.
+     */
+    struct TextureFormatAdvice
+    {
+        TextureLayout              layout; ///< Layout of the converted data, including swizzles for dropped channels
+        std::vector<unsigned char> data;   ///< Converted data, tightly packed
+
+        float min[4];         ///< Smallest value per source component
+        float max[4];         ///< Largest value per source component
+        int   components;     ///< Components needed to represent the data
+        bool  constant_alpha; ///< The source has four components and alpha is constant within the tolerance
+
+        float  max_error;        ///< Largest absolute error of the converted data
+        size_t source_byte_size; ///< Size of the source data as 32 bit floats
+        size_t byte_size;        ///< Size of the converted data in the internal format
+
+        size_t getSavedByteSize() const
+        {
+            return source_byte_size > byte_size ? source_byte_size - byte_size : 0;
+        }
+    };
+
+    /**
+     * \brief Converts float data to the format of a layout, e.g. further mipmap levels of data that was analyzed by
+     * adviseTextureFormat(). Missing components are filled with 0 (alpha with 1).
+     *
+     * \param source_format GL_RED, GL_RG, GL_RGB or GL_RGBA
+     * \param layout Layout of a TextureFormatAdvice
+     */
+    inline std::vector<unsigned char> convertTextureData(GLenum               source_format,
+                                                         float const*         data,
+                                                         size_t               texel_cnt,
+                                                         TextureLayout const& layout)
+    {
+        int source_components = detail::getFormatComponents(source_format);
+
+        auto const& formats = detail::getTexelFormats();
+        auto texel_format =
+            std::find_if(formats.begin(), formats.end(), [&layout](detail::TexelFormat const& texel_format) {
+                return texel_format.internal_format == static_cast<GLenum>(layout.internal_format);
+            });
+
+        if (source_components == 0 || texel_format == formats.end())
+        {
+            throw TextureException("convertTextureData - unsupported conversion from format " +
+                                   std::to_string(source_format) + " to internal format " +
+                                   std::to_string(layout.internal_format));
+        }
+
+        size_t                     texel_byte_size = texel_format->texel_byte_size;
+        std::vector<unsigned char> converted(texel_cnt * texel_byte_size);
+
+        for (size_t i = 0; i < texel_cnt; ++i)
+        {
+            float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            std::copy(data + i * source_components, data + (i + 1) * source_components, values);
+
+            float decoded[4];
+            detail::encodeTexel(*texel_format, values, converted.data() + i * texel_byte_size, decoded);
+        }
+
+        return converted;
+    }
+
+    /**
+     * \brief Chooses the smallest internal format that represents float texture data within the given tolerance
+     * and converts the data to it.
+     *
+     * A converted value v' of a source value v is within the tolerance if |v' - v| <= absolute + relative * |v|.
+     * Trailing components that are 0 (alpha: 1 or 0) everywhere are dropped, a dropped alpha of 0 is restored with
+     * GL_TEXTURE_SWIZZLE_A. Among the candidates (normalized 8 and 16 bit formats, half floats,
+     * GL_R11F_G11F_B10F, GL_RGB9_E5 and 32 bit floats as fallback) of the smallest texel size that meet the tolerance,
+     * the one with the smallest error is taken. Values are not rescaled, i.e. normalized formats are only chosen for
+     * data within [0,1] or [-1,1].
+     *
+     * \param layout Layout of the source data, format GL_RED, GL_RG, GL_RGB or GL_RGBA with type GL_FLOAT. Size,
+     * levels and parameters are passed on to the advice. The data covers width x height x depth texels.
+     * \param data Source texels, tightly packed
+     */
+    inline TextureFormatAdvice adviseTextureFormat(TextureLayout const& layout,
+                                                   float const*         data,
+                                                   float                absolute_tolerance,
+                                                   float                relative_tolerance = 0.0f)
+    {
+        int source_components = detail::getFormatComponents(layout.format);
+        if (source_components == 0 || layout.type != GL_FLOAT)
+        {
+            throw TextureException("adviseTextureFormat - unsupported source format " + std::to_string(layout.format) +
+                                   " with type " + std::to_string(layout.type));
+        }
+
+        size_t texel_cnt = static_cast<size_t>(std::max(layout.width, 1)) * std::max(layout.height, 1) *
+                           std::max(layout.depth, 1);
+
+        TextureFormatAdvice advice;
+        advice.source_byte_size = texel_cnt * source_components * sizeof(float);
+
+        for (int c = 0; c < 4; ++c)
+        {
+            advice.min[c] = c < source_components ? std::numeric_limits<float>::max() : 0.0f;
+            advice.max[c] = c < source_components ? std::numeric_limits<float>::lowest() : 0.0f;
+        }
+        for (size_t i = 0; i < texel_cnt; ++i)
+        {
+            for (int c = 0; c < source_components; ++c)
+            {
+                advice.min[c] = std::min(advice.min[c], data[i * source_components + c]);
+                advice.max[c] = std::max(advice.max[c], data[i * source_components + c]);
+            }
+        }
+
+        auto isConstant = [&](int component, float value) {
+            for (size_t i = 0; i < texel_cnt; ++i)
+            {
+                float source = data[i * source_components + component];
+                if (!(std::abs(value - source) <= absolute_tolerance + relative_tolerance * std::abs(source)))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        std::vector<std::pair<GLenum, GLint>> int_parameters = layout.int_parameters;
+
+        advice.components = source_components;
+        advice.constant_alpha = false;
+        float dropped_alpha = 1.0f;
+        if (source_components == 4)
+        {
+            advice.constant_alpha = isConstant(3, 0.5f * (advice.min[3] + advice.max[3]));
+            if (isConstant(3, 1.0f))
+            {
+                advice.components = 3;
+            }
+            else if (isConstant(3, 0.0f))
+            {
+                advice.components = 3;
+                dropped_alpha = 0.0f;
+                int_parameters.emplace_back(GL_TEXTURE_SWIZZLE_A, GL_ZERO);
+            }
+        }
+        while (advice.components > 1 && advice.components <= 3 && isConstant(advice.components - 1, 0.0f))
+        {
+            --advice.components;
+        }
+
+        // candidates are ordered by texel size, the first size with a valid candidate wins
+        auto const&                formats = detail::getTexelFormats();
+        detail::TexelFormat const* best = nullptr;
+        float                      best_violation = std::numeric_limits<float>::max();
+
+        for (auto const& texel_format : formats)
+        {
+            if (texel_format.components != advice.components)
+            {
+                continue;
+            }
+            if (best != nullptr && texel_format.texel_byte_size > best->texel_byte_size)
+            {
+                break;
+            }
+
+            // largest error relative to its allowance, 1 is the limit
+            float         violation = 0.0f;
+            unsigned char texel[16];
+            for (size_t i = 0; i < texel_cnt && violation <= 1.0f; ++i)
+            {
+                float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+                std::copy(data + i * source_components, data + (i + 1) * source_components, values);
+
+                float decoded[4];
+                detail::encodeTexel(texel_format, values, texel, decoded);
+
+                for (int c = 0; c < advice.components; ++c)
+                {
+                    float error = std::abs(decoded[c] - values[c]);
+                    float allowance = absolute_tolerance + relative_tolerance * std::abs(values[c]);
+                    if (!(error <= allowance))
+                    {
+                        violation = std::numeric_limits<float>::infinity();
+                    }
+                    else if (allowance > 0.0f)
+                    {
+                        violation = std::max(violation, error / allowance);
+                    }
+                }
+            }
+
+            // 32 bit floats are taken in any case, e.g. for NaN in the data
+            bool fallback = best == nullptr && texel_format.encoding == detail::TexelEncoding::Float;
+            if (violation <= 1.0f ? violation < best_violation : fallback)
+            {
+                best = &texel_format;
+                best_violation = violation;
+            }
+        }
+
+        advice.layout = TextureLayout(best->internal_format,
+                                      layout.width,
+                                      layout.height,
+                                      layout.depth,
+                                      best->format,
+                                      best->type,
+                                      layout.levels,
+                                      int_parameters,
+                                      layout.float_parameters);
+        advice.data = convertTextureData(layout.format, data, texel_cnt, advice.layout);
+        advice.byte_size = texel_cnt * best->texel_byte_size;
+
+        // error of all source components, dropped ones included
+        advice.max_error = 0.0f;
+        for (size_t i = 0; i < texel_cnt; ++i)
+        {
+            float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            std::copy(data + i * source_components, data + (i + 1) * source_components, values);
+
+            float         decoded[4];
+            unsigned char texel[16];
+            detail::encodeTexel(*best, values, texel, decoded);
+
+            for (int c = 0; c < source_components; ++c)
+            {
+                float value = c < advice.components ? decoded[c] : (c == 3 ? dropped_alpha : 0.0f);
+                advice.max_error = std::max(advice.max_error, std::abs(value - values[c]));
+            }
+        }
+
+        return advice;
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_TEXTUREFORMATADVISOR_HPP
@@ -0,0 +1,689 @@
+/*
+ * TextureStreamer.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_TEXTURESTREAMER_HPP
+#define GLOWL_TEXTURESTREAMER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Exceptions.hpp"
+#include "Texture2D.hpp"
+#include "Texture2DArray.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class TextureStreamer
+     *
+     * \brief Streams the mipmap levels of 2D and 2D array textures by priority within a memory and upload budget.
+     *
+     * Adding a texture allocates and uploads only its mip tail, i.e. all levels not larger than the tail size. The
+     * finer levels are requested per frame with use() and uploaded by update(), highest priority first and never more
+     * than the upload budget per update (large levels are split into row slices over several updates). Levels that
+     * are still uploading are excluded from sampling via GL_TEXTURE_BASE_LEVEL, a completed level is faded in over a
+     * few updates via GL_TEXTURE_MIN_LOD.
+     *
+     * Immutable texture storage cannot release single levels, so the storage of each texture only covers the levels
+     * that are allocated for it: growing and shrinking recreates the texture and copies the resident levels on the
+     * GPU. Level 0 of the storage corresponds to level getLevelOffset() of the full mipmap chain. Normalized texture
+     * coordinates are unaffected, texelFetch() and textureLod() have to account for the offset. The texture name (and
+     * bindless handle) can change in every update(), query getTexture() after it.
+     *
+     * If the allocated levels exceed the memory budget, the levels with the lowest priority are dropped first. Mip
+     * tails are never dropped.
+     *
+     * Only uncompressed formats are supported, the loader provides tightly packed texels in the format and type of
+     * the texture layout.
+     */
+    class TextureStreamer
+    {
+    public:
+        /**
+         * Fills data with all texels of the given level (of the full mipmap chain), tightly packed, layer after layer.
+         */
+        using Loader = std::function<void(GLint level, void* data)>;
+
+        using Handle = size_t;
+
+        /**
+         * \param memory_budget Bytes that all streamed textures may allocate, mip tails included
+         * \param upload_budget Bytes that may be uploaded per update()
+         * \param tail_size Largest width and height of the levels that are uploaded when a texture is added
+         */
+        TextureStreamer(size_t memory_budget, size_t upload_budget, int tail_size = 128);
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+        /**
+         * \brief Adds a texture and uploads its mip tail.
+         *
+         * \param target GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
+         * \param layout Layout of the full texture, levels 0 stands for the full mipmap chain
+         * \param loader Callable that provides the texels of a level
+         *
+         * Note: Active OpenGL context required.
+         */
+        Handle add(std::string const& id, GLenum target, TextureLayout const& layout, Loader loader);
+
+        /**
+         * \brief Reports the use of a texture in the current frame.
+         *
+         * \param screen_size Largest extent of the texture on screen in pixels, selects the finest level needed
+         * \param distance Distance to the viewer, preferring near textures at equal screen size
+         */
+        void use(Handle handle, float screen_size, float distance = 0.0f);
+
+        /**
+         * \brief Drops levels that no longer fit the memory budget and uploads requested levels within the upload
+         * budget. Call once per frame.
+         */
+        void update();
+
+        Texture const& getTexture(Handle handle) const;
+
+        /**
+         * \brief Level of the full mipmap chain that corresponds to level 0 of the texture storage.
+         */
+        GLint getLevelOffset(Handle handle) const;
+
+        /**
+         * \brief Finest level of the full mipmap chain that is completely uploaded.
+         */
+        GLint getResidentLevel(Handle handle) const;
+
+        void   setMemoryBudget(size_t memory_budget);
+        size_t getMemoryBudget() const;
+
+        void   setUploadBudget(size_t upload_budget);
+        size_t getUploadBudget() const;
+
+        /**
+         * \brief Number of updates over which a newly resident level is faded in, 0 switches at once.
+         */
+        void setFadeUpdates(unsigned int fade_updates);
+
+        /**
+         * \brief Bytes allocated by all textures.
+         */
+        size_t getAllocatedByteSize() const;
+
+        /**
+         * \brief Bytes uploaded since construction.
+         */
+        std::uint64_t getUploadedByteCount() const;
+
+    private:
+        struct Entry
+        {
+            std::string              id;
+            GLenum                   target;
+            TextureLayout            layout;
+            Loader                   loader;
+            std::unique_ptr<Texture> texture;
+
+            GLint tail_level;     ///< Coarsest level that is not part of the mip tail plus one
+            GLint alloc_level;    ///< Finest allocated level
+            GLint resident_level; ///< Finest completely uploaded level
+            GLint target_level;   ///< Finest level that should be allocated
+
+            float         screen_size;
+            float         distance;
+            std::uint64_t last_use;
+            float         priority;
+            float         min_lod; ///< Current GL_TEXTURE_MIN_LOD, relative to the resident level
+        };
+
+        struct Upload
+        {
+            Handle                     handle;
+            GLint                      level;
+            GLsizei                    rows_done;
+            std::vector<unsigned char> staging; ///< Reused for all levels, only grows
+        };
+
+        Entry&       getEntry(Handle handle, char const* function);
+        Entry const& getEntry(Handle handle, char const* function) const;
+
+        /** Chooses the target level of all textures such that the most important levels fit the memory budget */
+        void computeTargetLevels();
+
+        /** Recreates the storage of a texture from the given level on, keeping the resident levels */
+        void allocate(Entry& entry, GLint level);
+
+        /** Starts uploading the next finer level of a texture */
+        void beginUpload(Handle handle);
+
+        /** Uploads rows of the current level and returns the number of bytes uploaded */
+        size_t uploadRows(size_t max_bytes);
+
+        void setSamplingLevels(Entry& entry);
+
+        static size_t getLevelByteSize(Entry const& entry, GLint level);
+        static size_t getAllocationByteSize(Entry const& entry, GLint level);
+
+        std::vector<Entry> m_entries;
+
+        size_t       m_memory_budget;
+        size_t       m_upload_budget;
+        int          m_tail_size;
+        unsigned int m_fade_updates;
+
+        Upload m_upload;
+        bool   m_upload_active;
+
+        std::uint64_t m_update_cnt;
+        std::uint64_t m_uploaded_byte_cnt;
+    };
+
+    inline TextureStreamer::TextureStreamer(size_t memory_budget, size_t upload_budget, int tail_size)
+        : m_memory_budget(memory_budget),
+          m_upload_budget(upload_budget),
+          m_tail_size(std::max(tail_size, 1)),
+          m_fade_updates(8),
+          m_upload{0, 0, 0, {}},
+          m_upload_active(false),
+          m_update_cnt(0),
+          m_uploaded_byte_cnt(0)
+    {
+    }
+
+    inline TextureStreamer::Handle TextureStreamer::add(std::string const& id,
+                                                        GLenum             target,
+                                                        TextureLayout const& layout,
+                                                        Loader             loader)
+    {
+        if (target != GL_TEXTURE_2D && target != GL_TEXTURE_2D_ARRAY)
+        {
+            throw TextureException("TextureStreamer::add - texture id: " + id + " - unsupported target " +
+                                   std::to_string(target));
+        }
+        if (!loader)
+        {
+            throw TextureException("TextureStreamer::add - texture id: " + id + " - no loader given");
+        }
+
+        GLint block_width = 1;
+        GLint block_height = 1;
+        if (getCompressedBlockSize(layout.internal_format, block_width, block_height))
+        {
+            throw TextureException("TextureStreamer::add - texture id: " + id +
+                                   " - compressed formats are not supported");
+        }
+
+        Entry entry;
+        entry.id = id;
+        entry.target = target;
+        entry.layout = layout;
+        entry.loader = loader;
+
+        GLsizei full_levels = 1 + static_cast<GLsizei>(std::floor(std::log2(std::max(layout.width, layout.height))));
+        entry.layout.levels = layout.levels > 0 ? std::min(layout.levels, full_levels) : full_levels;
+        if (target == GL_TEXTURE_2D)
+        {
+            entry.layout.depth = 1;
+        }
+
+        entry.tail_level = entry.layout.levels - 1;
+        while (entry.tail_level > 0 && std::max(layout.width >> (entry.tail_level - 1),
+                                                layout.height >> (entry.tail_level - 1)) <= m_tail_size)
+        {
+            --entry.tail_level;
+        }
+
+        entry.alloc_level = entry.layout.levels;
+        entry.resident_level = entry.layout.levels;
+        entry.target_level = entry.tail_level;
+        entry.screen_size = 0.0f;
+        entry.distance = 0.0f;
+        entry.last_use = m_update_cnt;
+        entry.priority = 0.0f;
+        entry.min_lod = 0.0f;
+
+        // the mip tail is uploaded at once, coarsest level first
+        allocate(entry, entry.tail_level);
+
+        GLint unpack_alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        std::vector<unsigned char> data;
+        for (GLint level = entry.layout.levels - 1; level >= entry.tail_level; --level)
+        {
+            data.resize(getLevelByteSize(entry, level));
+            entry.loader(level, data.data());
+
+            GLsizei width = std::max(1, entry.layout.width >> level);
+            GLsizei height = std::max(1, entry.layout.height >> level);
+            if (target == GL_TEXTURE_2D)
+            {
+                static_cast<Texture2D&>(*entry.texture)
+                    .subImage(level - entry.alloc_level, 0, 0, width, height, data.data());
+            }
+            else
+            {
+                static_cast<Texture2DArray&>(*entry.texture)
+                    .subImage(level - entry.alloc_level, 0, 0, 0, width, height, entry.layout.depth, data.data());
+            }
+            m_uploaded_byte_cnt += data.size();
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+        entry.resident_level = entry.tail_level;
+        setSamplingLevels(entry);
+
+        auto err = glGetError();
+        if (err != GL_NO_ERROR)
+        {
+            throw TextureException("TextureStreamer::add - texture id: " + id + " - OpenGL error " +
+                                   std::to_string(err));
+        }
+
+        m_entries.push_back(std::move(entry));
+
+        return m_entries.size() - 1;
+    }
+
+    inline void TextureStreamer::use(Handle handle, float screen_size, float distance)
+    {
+        Entry& entry = getEntry(handle, "use");
+
+        // several uses in one frame request the largest size
+        entry.screen_size = entry.last_use == m_update_cnt ? std::max(entry.screen_size, screen_size) : screen_size;
+        entry.distance = entry.last_use == m_update_cnt ? std::min(entry.distance, distance) : distance;
+        entry.last_use = m_update_cnt;
+    }
+
+    inline void TextureStreamer::update()
+    {
+        computeTargetLevels();
+
+        // free memory before allocating more
+        for (auto& entry : m_entries)
+        {
+            if (entry.target_level > entry.alloc_level)
+            {
+                allocate(entry, entry.target_level);
+            }
+        }
+
+        GLint unpack_alignment = 4;
+        GLint unpack_image_height = 0;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+        glGetIntegerv(GL_UNPACK_IMAGE_HEIGHT, &unpack_image_height);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        size_t budget = m_upload_budget;
+        while (budget > 0)
+        {
+            if (!m_upload_active)
+            {
+                // highest priority texture that is missing requested levels
+                Handle best = m_entries.size();
+                for (Handle handle = 0; handle < m_entries.size(); ++handle)
+                {
+                    Entry const& entry = m_entries[handle];
+                    if (entry.target_level < entry.resident_level &&
+                        (best == m_entries.size() || entry.priority > m_entries[best].priority))
+                    {
+                        best = handle;
+                    }
+                }
+
+                if (best == m_entries.size())
+                {
+                    break;
+                }
+
+                beginUpload(best);
+            }
+
+            size_t bytes = uploadRows(budget);
+            budget = bytes < budget ? budget - bytes : 0;
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, unpack_image_height);
+
+        for (auto& entry : m_entries)
+        {
+            if (entry.min_lod > 0.0f)
+            {
+                entry.min_lod = m_fade_updates > 0 ? std::max(0.0f, entry.min_lod - 1.0f / m_fade_updates) : 0.0f;
+                GLOWL_TRACE(Opcode::TextureParameterf,
+                            {entry.texture->getName(), GL_TEXTURE_MIN_LOD, trace::floatBits(entry.min_lod)});
+                glTextureParameterf(entry.texture->getName(), GL_TEXTURE_MIN_LOD, entry.min_lod);
+            }
+        }
+
+        ++m_update_cnt;
+
+        auto err = glGetError();
+        if (err != GL_NO_ERROR)
+        {
+            throw TextureException("TextureStreamer::update - OpenGL error " + std::to_string(err));
+        }
+    }
+
+    inline Texture const& TextureStreamer::getTexture(Handle handle) const
+    {
+        return *getEntry(handle, "getTexture").texture;
+    }
+
+    inline GLint TextureStreamer::getLevelOffset(Handle handle) const
+    {
+        return getEntry(handle, "getLevelOffset").alloc_level;
+    }
+
+    inline GLint TextureStreamer::getResidentLevel(Handle handle) const
+    {
+        return getEntry(handle, "getResidentLevel").resident_level;
+    }
+
+    inline void TextureStreamer::setMemoryBudget(size_t memory_budget)
+    {
+        m_memory_budget = memory_budget;
+    }
+
+    inline size_t TextureStreamer::getMemoryBudget() const
+    {
+        return m_memory_budget;
+    }
+
+    inline void TextureStreamer::setUploadBudget(size_t upload_budget)
+    {
+        m_upload_budget = upload_budget;
+    }
+
+    inline size_t TextureStreamer::getUploadBudget() const
+    {
+        return m_upload_budget;
+    }
+
+    inline void TextureStreamer::setFadeUpdates(unsigned int fade_updates)
+    {
+        m_fade_updates = fade_updates;
+    }
+
+    inline size_t TextureStreamer::getAllocatedByteSize() const
+    {
+        size_t byte_size = 0;
+        for (auto const& entry : m_entries)
+        {
+            byte_size += getAllocationByteSize(entry, entry.alloc_level);
+        }
+        return byte_size;
+    }
+
+    inline std::uint64_t TextureStreamer::getUploadedByteCount() const
+    {
+        return m_uploaded_byte_cnt;
+    }
+
+    inline TextureStreamer::Entry& TextureStreamer::getEntry(Handle handle, char const* function)
+    {
+        return const_cast<Entry&>(static_cast<TextureStreamer const*>(this)->getEntry(handle, function));
+    }
+
+    inline TextureStreamer::Entry const& TextureStreamer::getEntry(Handle handle, char const* function) const
+    {
+        if (handle >= m_entries.size())
+        {
+            throw TextureException(std::string("TextureStreamer::") + function + " - invalid handle " +
+                                   std::to_string(handle));
+        }
+        return m_entries[handle];
+    }
+
+    inline void TextureStreamer::computeTargetLevels()
+    {
+        struct Candidate
+        {
+            Handle handle;
+            GLint  level;
+            bool   needed;
+            float  priority;
+        };
+
+        size_t                 budget = m_memory_budget;
+        std::vector<Candidate> candidates;
+
+        for (Handle handle = 0; handle < m_entries.size(); ++handle)
+        {
+            Entry& entry = m_entries[handle];
+
+            size_t tail_byte_size = getAllocationByteSize(entry, entry.tail_level);
+            budget = tail_byte_size < budget ? budget - tail_byte_size : 0;
+
+            // finest level that still has at least one texel per pixel
+            GLint needed_level = entry.tail_level;
+            if (entry.screen_size > 0.0f)
+            {
+                float texel_ratio = std::max(entry.layout.width, entry.layout.height) / entry.screen_size;
+                GLint level = static_cast<GLint>(std::floor(std::log2(std::max(texel_ratio, 1.0f))));
+                needed_level = std::min(entry.tail_level, level);
+            }
+
+            std::uint64_t unused_updates = m_update_cnt - entry.last_use;
+            entry.priority = entry.screen_size / (1.0f + std::max(entry.distance, 0.0f)) / (1.0f + unused_updates);
+
+            // levels finer than needed are only kept while they are allocated and memory is left
+            for (GLint level = entry.tail_level - 1; level >= std::min(needed_level, entry.alloc_level); --level)
+            {
+                // allocated levels are preferred slightly to avoid dropping and reloading at the budget limit
+                float priority = level >= entry.alloc_level ? entry.priority * 1.25f : entry.priority;
+                candidates.push_back({handle, level, level >= needed_level, priority});
+            }
+
+            entry.target_level = entry.tail_level;
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](Candidate const& lhs, Candidate const& rhs) {
+            if (lhs.needed != rhs.needed)
+            {
+                return lhs.needed;
+            }
+            if (lhs.priority != rhs.priority)
+            {
+                return lhs.priority > rhs.priority;
+            }
+            if (lhs.handle != rhs.handle)
+            {
+                return lhs.handle < rhs.handle;
+            }
+            return lhs.level > rhs.level;
+        });
+
+        // levels of a texture are visited coarse to fine, a level is only taken if all coarser ones were
+        for (auto const& candidate : candidates)
+        {
+            Entry& entry = m_entries[candidate.handle];
+            size_t byte_size = getLevelByteSize(entry, candidate.level);
+            if (candidate.level == entry.target_level - 1 && byte_size <= budget)
+            {
+                entry.target_level = candidate.level;
+                budget -= byte_size;
+            }
+        }
+    }
+
+    inline void TextureStreamer::allocate(Entry& entry, GLint level)
+    {
+        TextureLayout layout = entry.layout;
+        layout.width = std::max(1, entry.layout.width >> level);
+        layout.height = std::max(1, entry.layout.height >> level);
+        layout.levels = entry.layout.levels - level;
+
+        std::unique_ptr<Texture> texture;
+        if (entry.target == GL_TEXTURE_2D)
+        {
+            texture = std::make_unique<Texture2D>(entry.id, layout, nullptr);
+        }
+        else
+        {
+            texture = std::make_unique<Texture2DArray>(entry.id, layout, nullptr);
+        }
+
+        // rows of a level in progress are lost with the old storage
+        if (m_upload_active && &m_entries[m_upload.handle] == &entry)
+        {
+            m_upload_active = m_upload.level >= level;
+            m_upload.rows_done = 0;
+        }
+
+        entry.resident_level = std::max(entry.resident_level, level);
+
+        if (entry.texture != nullptr)
+        {
+            std::vector<TextureCopyRegion> regions;
+            for (GLint copy_level = entry.resident_level; copy_level < entry.layout.levels; ++copy_level)
+            {
+                GLsizei width = std::max(1, entry.layout.width >> copy_level);
+                GLsizei height = std::max(1, entry.layout.height >> copy_level);
+                regions.push_back({copy_level - entry.alloc_level,
+                                   0,
+                                   0,
+                                   0,
+                                   copy_level - level,
+                                   0,
+                                   0,
+                                   0,
+                                   width,
+                                   height,
+                                   entry.layout.depth});
+            }
+            Texture::copy(*entry.texture, *texture, regions);
+        }
+
+        entry.texture = std::move(texture);
+        entry.alloc_level = level;
+
+        if (entry.resident_level < entry.layout.levels)
+        {
+            setSamplingLevels(entry);
+        }
+    }
+
+    inline void TextureStreamer::beginUpload(Handle handle)
+    {
+        Entry& entry = m_entries[handle];
+
+        if (entry.alloc_level != entry.target_level)
+        {
+            allocate(entry, entry.target_level);
+        }
+
+        m_upload.handle = handle;
+        m_upload.level = entry.resident_level - 1;
+        m_upload.rows_done = 0;
+        m_upload.staging.resize(getLevelByteSize(entry, m_upload.level));
+        entry.loader(m_upload.level, m_upload.staging.data());
+
+        m_upload_active = true;
+    }
+
+    inline size_t TextureStreamer::uploadRows(size_t max_bytes)
+    {
+        Entry& entry = m_entries[m_upload.handle];
+
+        GLsizei width = std::max(1, entry.layout.width >> m_upload.level);
+        GLsizei height = std::max(1, entry.layout.height >> m_upload.level);
+        size_t  row_byte_size = trace::computeImageByteSize(entry.layout.format, entry.layout.type, width, 1, 1);
+
+        // at least one row per call, so that levels larger than the budget finish eventually
+        size_t  slice_rows = std::max<size_t>(1, max_bytes / (row_byte_size * entry.layout.depth));
+        GLsizei rows = static_cast<GLsizei>(std::min<size_t>(slice_rows, height - m_upload.rows_done));
+
+        // rows of all layers are read from the layer after layer staging data
+        unsigned char const* data = m_upload.staging.data() + m_upload.rows_done * row_byte_size;
+        if (entry.target == GL_TEXTURE_2D)
+        {
+            static_cast<Texture2D&>(*entry.texture)
+                .subImage(m_upload.level - entry.alloc_level, 0, m_upload.rows_done, width, rows, data);
+        }
+        else
+        {
+            glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, height);
+            static_cast<Texture2DArray&>(*entry.texture)
+                .subImage(m_upload.level - entry.alloc_level,
+                          0,
+                          m_upload.rows_done,
+                          0,
+                          width,
+                          rows,
+                          entry.layout.depth,
+                          data);
+        }
+
+        size_t byte_size = rows * row_byte_size * entry.layout.depth;
+        m_uploaded_byte_cnt += byte_size;
+        m_upload.rows_done += rows;
+
+        if (m_upload.rows_done == height)
+        {
+            // keep sampling the previous level and fade towards the new one
+            entry.resident_level = m_upload.level;
+            entry.min_lod = m_fade_updates > 0 ? entry.min_lod + 1.0f : 0.0f;
+            setSamplingLevels(entry);
+
+            if (entry.resident_level > entry.alloc_level)
+            {
+                m_upload.level = entry.resident_level - 1;
+                m_upload.rows_done = 0;
+                m_upload.staging.resize(getLevelByteSize(entry, m_upload.level));
+                entry.loader(m_upload.level, m_upload.staging.data());
+            }
+            else
+            {
+                m_upload_active = false;
+            }
+        }
+
+        return byte_size;
+    }
+
+    inline void TextureStreamer::setSamplingLevels(Entry& entry)
+    {
+        GLuint name = entry.texture->getName();
+        GLint  base_level = entry.resident_level - entry.alloc_level;
+
+        GLOWL_TRACE(Opcode::TextureParameteri, {name, GL_TEXTURE_BASE_LEVEL, base_level});
+        glTextureParameteri(name, GL_TEXTURE_BASE_LEVEL, base_level);
+        GLOWL_TRACE(Opcode::TextureParameterf, {name, GL_TEXTURE_MIN_LOD, trace::floatBits(entry.min_lod)});
+        glTextureParameterf(name, GL_TEXTURE_MIN_LOD, entry.min_lod);
+    }
+
+    inline size_t TextureStreamer::getLevelByteSize(Entry const& entry, GLint level)
+    {
+        return trace::computeImageByteSize(entry.layout.format,
+                                           entry.layout.type,
+                                           std::max(1, entry.layout.width >> level),
+                                           std::max(1, entry.layout.height >> level),
+                                           entry.layout.depth);
+    }
+
+    inline size_t TextureStreamer::getAllocationByteSize(Entry const& entry, GLint level)
+    {
+        size_t byte_size = 0;
+        for (; level < entry.layout.levels; ++level)
+        {
+            byte_size += getLevelByteSize(entry, level);
+        }
+        return byte_size;
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_TEXTURESTREAMER_HPP
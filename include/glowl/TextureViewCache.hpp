@@ -0,0 +1,233 @@
+/*
+ * TextureViewCache.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_TEXTUREVIEWCACHE_HPP
+#define GLOWL_TEXTUREVIEWCACHE_HPP
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "Exceptions.hpp"
+#include "Texture2DArray.hpp"
+#include "Texture2DView.hpp"
+#include "TextureCubemapArray.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \struct TextureViewDescription
+     *
+     * \brief Describes a 2D view onto (a part of) a source texture. Used as key by TextureViewCache.
+     */
+    struct TextureViewDescription
+    {
+        GLenum               internal_format = 0; ///< View format, 0 to keep the format of the source texture
+        GLuint               minlevel = 0;
+        GLuint               numlevels = 1;
+        GLuint               minlayer = 0;
+        GLuint               numlayers = 1;
+        std::array<GLint, 4> swizzle = {{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}};
+        GLenum               depth_stencil_mode = 0; ///< GL_DEPTH_COMPONENT, GL_STENCIL_INDEX or 0 for default
+    };
+
+    inline bool operator<(TextureViewDescription const& lhs, TextureViewDescription const& rhs)
+    {
+        return std::tie(lhs.internal_format,
+                        lhs.minlevel,
+                        lhs.numlevels,
+                        lhs.minlayer,
+                        lhs.numlayers,
+                        lhs.swizzle,
+                        lhs.depth_stencil_mode) < std::tie(rhs.internal_format,
+                                                           rhs.minlevel,
+                                                           rhs.numlevels,
+                                                           rhs.minlayer,
+                                                           rhs.numlayers,
+                                                           rhs.swizzle,
+                                                           rhs.depth_stencil_mode);
+    }
+
+    /**
+     * \class TextureViewCache
+     *
+     * \brief Creates 2D texture views with swizzle and depth/stencil mode and reuses identical views.
+     *
+     * Views are keyed by the storage id of the source texture (see Texture::getStorageId), so a recreated or
+     * reloaded texture never receives a view of the previous storage, even if it reuses the OpenGL name.
+     * Views of a storage stay cached until erase() or clear() is called, which should be done before a source
+     * texture is reloaded or destroyed to release them.
+     */
+    class TextureViewCache
+    {
+    public:
+        typedef std::shared_ptr<Texture2DView> Texture2DViewPtr;
+
+        TextureViewCache() = default;
+        TextureViewCache(const TextureViewCache&) = delete;
+        TextureViewCache& operator=(const TextureViewCache&) = delete;
+
+        /**
+         * \brief Returns a 2D view of the given source texture, creating it on first request.
+         *
+         * \param source_texture Any texture that can be viewed as GL_TEXTURE_2D (2D, 2D array, cubemap array)
+         * \param description Level/layer range, format, swizzle and depth/stencil mode of the view
+         */
+        template<typename T>
+        Texture2DViewPtr getView(T const& source_texture, TextureViewDescription const& description);
+
+        /**
+         * \brief Returns a 2D view of a single layer of a 2D texture array.
+         */
+        Texture2DViewPtr getLayerView(Texture2DArray const&       source_texture,
+                                      GLuint                      layer,
+                                      std::array<GLint, 4> const& swizzle = {{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}});
+
+        /**
+         * \brief Returns a 2D view of a single face of a cubemap in a cubemap array.
+         *
+         * \param layer Index of the cubemap within the array
+         * \param face Face index in the order +X, -X, +Y, -Y, +Z, -Z
+         */
+        Texture2DViewPtr getCubeFaceView(TextureCubemapArray const&  source_texture,
+                                         GLuint                      layer,
+                                         GLuint                      face,
+                                         std::array<GLint, 4> const& swizzle = {{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}});
+
+        /**
+         * \brief Drop all cached views of the current storage of the given source texture.
+         */
+        void erase(Texture const& source_texture);
+
+        void clear();
+
+        size_t size() const;
+
+    private:
+        std::map<std::pair<std::uint64_t, TextureViewDescription>, Texture2DViewPtr> m_views;
+    };
+
+    template<typename T>
+    inline TextureViewCache::Texture2DViewPtr TextureViewCache::getView(T const&                      source_texture,
+                                                                        TextureViewDescription const& description)
+    {
+        auto key = std::make_pair(source_texture.getStorageId(), description);
+
+        auto query = m_views.find(key);
+        if (query != m_views.end())
+        {
+            return query->second;
+        }
+
+        for (auto channel : description.swizzle)
+        {
+            if (channel != GL_RED && channel != GL_GREEN && channel != GL_BLUE && channel != GL_ALPHA &&
+                channel != GL_ZERO && channel != GL_ONE)
+            {
+                throw TextureException("TextureViewCache::getView - texture id: " + source_texture.getId() +
+                                       " - invalid swizzle value " + std::to_string(channel));
+            }
+        }
+
+        TextureLayout layout(description.internal_format != 0 ? description.internal_format
+                                                              : source_texture.getInternalFormat(),
+                             0,
+                             0,
+                             1,
+                             source_texture.getFormat(),
+                             source_texture.getType(),
+                             static_cast<GLsizei>(description.numlevels));
+
+        auto view = std::make_shared<Texture2DView>(source_texture.getId() + "_view",
+                                                    source_texture,
+                                                    layout,
+                                                    description.minlevel,
+                                                    description.numlevels,
+                                                    description.minlayer,
+                                                    description.numlayers);
+
+        auto const& swizzle = description.swizzle;
+        view->setSwizzle(swizzle[0], swizzle[1], swizzle[2], swizzle[3]);
+
+        if (description.depth_stencil_mode != 0)
+        {
+            view->setDepthStencilTextureMode(description.depth_stencil_mode);
+        }
+
+        m_views.emplace(key, view);
+
+        return view;
+    }
+
+    inline TextureViewCache::Texture2DViewPtr TextureViewCache::getLayerView(Texture2DArray const&       source_texture,
+                                                                             GLuint                      layer,
+                                                                             std::array<GLint, 4> const& swizzle)
+    {
+        if (layer >= source_texture.getLayers())
+        {
+            throw TextureException("TextureViewCache::getLayerView - texture id: " + source_texture.getId() +
+                                   " - layer out of range");
+        }
+
+        TextureViewDescription description;
+        description.numlevels = static_cast<GLuint>(source_texture.getTextureLayout().levels);
+        description.minlayer = layer;
+        description.swizzle = swizzle;
+
+        return getView(source_texture, description);
+    }
+
+    inline TextureViewCache::Texture2DViewPtr TextureViewCache::getCubeFaceView(
+        TextureCubemapArray const& source_texture, GLuint layer, GLuint face, std::array<GLint, 4> const& swizzle)
+    {
+        // cubemap arrays store layer-faces, i.e. six consecutive layers per cubemap
+        if (face >= 6 || (layer * 6 + face) >= source_texture.getLayers())
+        {
+            throw TextureException("TextureViewCache::getCubeFaceView - texture id: " + source_texture.getId() +
+                                   " - layer or face out of range");
+        }
+
+        TextureViewDescription description;
+        description.numlevels = static_cast<GLuint>(source_texture.getTextureLayout().levels);
+        description.minlayer = layer * 6 + face;
+        description.swizzle = swizzle;
+
+        return getView(source_texture, description);
+    }
+
+    inline void TextureViewCache::erase(Texture const& source_texture)
+    {
+        auto const storage_id = source_texture.getStorageId();
+        for (auto it = m_views.begin(); it != m_views.end();)
+        {
+            if (it->first.first == storage_id)
+            {
+                it = m_views.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    inline void TextureViewCache::clear()
+    {
+        m_views.clear();
+    }
+
+    inline size_t TextureViewCache::size() const
+    {
+        return m_views.size();
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_TEXTUREVIEWCACHE_HPP
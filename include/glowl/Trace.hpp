@@ -0,0 +1,869 @@
+/*
+ * Trace.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_TRACE_HPP
+#define GLOWL_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glinclude.h"
+
+namespace glowl
+{
+    namespace trace
+    {
+
+        /**
+         * Commands of the glowl trace format. Names follow the OpenGL function that is replayed for a command.
+         * Append new commands at the end to keep older traces readable.
+         */
+        enum class Opcode : std::uint8_t
+        {
+            Frame = 1,                 ///< End of a frame, see glowl::trace::frame()
+            CreateBuffer,              ///< name, target
+            NamedBufferData,           ///< name, byte size, usage; payload: data
+            NamedBufferStorage,        ///< name, byte size, flags
+            NamedBufferSubData,        ///< name, byte offset; payload: data
+            NamedBufferPageCommitment, ///< name, byte offset, byte size, commit
+            CopyNamedBufferSubData,    ///< src, dst, read offset, write offset, byte size
+            DeleteBuffer,              ///< name
+            BindBuffer,                ///< target, name
+            BindBufferBase,            ///< target, index, name
+            CreateTexture,             ///< target, name, internal format, width, height, depth, levels, format, type,
+                                       ///< generate mipmap, int param cnt, (pname, value)...,
+                                       ///< float param cnt, (pname, value bits)...
+                                       ///< payload: level 0 data
+            TextureView,               ///< name, target, source, internal format,
+                                       ///< minlevel, numlevels, minlayer, numlayers
+            TextureParameteri,         ///< name, pname, value
+            TextureParameterf,         ///< name, pname, value as raw bits
+            GenerateTextureMipmap,     ///< name
+            DeleteTexture,             ///< name
+            BindTexture,               ///< target, name
+            BindImageTexture,          ///< unit, name, level, layered, layer, access, format
+            CreateVertexArray,         ///< name
+            VertexArrayVertexBuffer,   ///< vao, binding, buffer, offset, stride
+            VertexArrayAttrib,         ///< vao, attrib, binding, size, type, normalized, offset, shader input type
+            VertexArrayElementBuffer,  ///< vao, buffer
+            DeleteVertexArray,         ///< name
+            BindVertexArray,           ///< name
+            DrawElementsInstanced,     ///< mode, count, type, byte offset, instance count
+            CreateFramebuffer,         ///< name
+            NamedFramebufferTexture,   ///< fbo, attachment, texture, level
+            DeleteFramebuffer,         ///< name
+            BindFramebuffer,           ///< target, name
+            DrawBuffers,               ///< buffers...
+            ReadBuffer,                ///< buffer
+            CreateProgram,             ///< name
+            ShaderSource,              ///< program, shader type; payload: source string
+            LinkProgram,               ///< program
+            BindAttribLocation,        ///< program, location; payload: name string
+            BindFragDataLocation,      ///< program, location; payload: name string
+            Uniform,                   ///< program, UniformType, values (float values as raw bits)...
+                                       ///< payload: uniform name string
+            UseProgram,                ///< program
+            DeleteProgram,             ///< program
+            DispatchCompute,           ///< groups x, groups y, groups z
+            MemoryBarrier,             ///< barrier bits
+            DrawElementsInstancedBaseVertex, ///< mode, count, type, byte offset, instance count, base vertex
+            MultiDrawElementsIndirect,       ///< mode, type, indirect buffer, byte offset, draw count, stride
+            MapNamedBufferRange,             ///< name, byte offset, stride, element byte size;
+                                             ///< payload: tightly packed elements, scattered with the stride
+            CopyImageSubData,                ///< src, src target, src level, src x, src y, src z,
+                                             ///< dst, dst target, dst level, dst x, dst y, dst z, width, height, depth
+            TextureSubImage,                 ///< name, target, level, x, y, z, width, height, depth, format, type,
+                                             ///< unpack alignment, row length, image height,
+                                             ///< unpack buffer, byte offset into the unpack buffer
+                                             ///< payload: client memory data if no unpack buffer is bound
+            Viewport,                        ///< x, y, width, height
+            DrawArrays,                      ///< mode, first, count
+            BindTextureUnit,                 ///< unit, name
+            Enable,                          ///< capability
+            Disable,                         ///< capability
+            Scissor,                         ///< x, y, width, height
+            DepthMask,                       ///< flag
+            ClearBufferfv,                   ///< buffer, drawbuffer, values as raw bits...
+            ColorMask,                       ///< red, green, blue, alpha
+            BlendFuncSeparate,               ///< src rgb, dst rgb, src alpha, dst alpha
+            BlendEquationSeparate,           ///< mode rgb, mode alpha
+            BlendColor,                      ///< red, green, blue, alpha as raw bits
+            DepthFunc,                       ///< func
+            DepthRange,                      ///< near, far as raw bits
+            StencilFuncSeparate,             ///< face, func, ref, mask
+            StencilOpSeparate,               ///< face, stencil fail, depth fail, pass
+            StencilMaskSeparate,             ///< face, mask
+            CullFace,                        ///< mode
+            FrontFace,                       ///< mode
+            PolygonMode,                     ///< face, mode
+            PolygonOffset,                   ///< factor, units as raw bits
+            Count
+        };
+
+        /** Uniform functions, stored with Opcode::Uniform */
+        enum UniformType : std::uint8_t
+        {
+            UniformFloat,
+            UniformInt,
+            UniformUInt,
+            UniformMatrix2,
+            UniformMatrix3,
+            UniformMatrix4
+        };
+
+        enum class PayloadKind : std::uint8_t
+        {
+            None = 0,
+            Hash = 1, ///< only size and FNV-1a hash of the payload are stored
+            Blob = 2  ///< full payload is stored
+        };
+
+        inline char const* getOpcodeName(Opcode opcode)
+        {
+            static char const* names[] = {"",
+                                          "Frame",
+                                          "glCreateBuffers",
+                                          "glNamedBufferData",
+                                          "glNamedBufferStorage",
+                                          "glNamedBufferSubData",
+                                          "glNamedBufferPageCommitmentARB",
+                                          "glCopyNamedBufferSubData",
+                                          "glDeleteBuffers",
+                                          "glBindBuffer",
+                                          "glBindBufferBase",
+                                          "glCreateTextures",
+                                          "glTextureView",
+                                          "glTextureParameteri",
+                                          "glTextureParameterf",
+                                          "glGenerateTextureMipmap",
+                                          "glDeleteTextures",
+                                          "glBindTexture",
+                                          "glBindImageTexture",
+                                          "glCreateVertexArrays",
+                                          "glVertexArrayVertexBuffer",
+                                          "glVertexArrayAttribFormat",
+                                          "glVertexArrayElementBuffer",
+                                          "glDeleteVertexArrays",
+                                          "glBindVertexArray",
+                                          "glDrawElementsInstanced",
+                                          "glCreateFramebuffers",
+                                          "glNamedFramebufferTexture",
+                                          "glDeleteFramebuffers",
+                                          "glBindFramebuffer",
+                                          "glDrawBuffers",
+                                          "glReadBuffer",
+                                          "glCreateProgram",
+                                          "glShaderSource",
+                                          "glLinkProgram",
+                                          "glBindAttribLocation",
+                                          "glBindFragDataLocation",
+                                          "glUniform",
+                                          "glUseProgram",
+                                          "glDeleteProgram",
+                                          "glDispatchCompute",
+                                          "glMemoryBarrier",
+                                          "glDrawElementsInstancedBaseVertex",
+                                          "glMultiDrawElementsIndirect",
+                                          "glMapNamedBufferRange",
+                                          "glCopyImageSubData",
+                                          "glTextureSubImage",
+                                          "glViewport",
+                                          "glDrawArrays",
+                                          "glBindTextureUnit",
+                                          "glEnable",
+                                          "glDisable",
+                                          "glScissor",
+                                          "glDepthMask",
+                                          "glClearBufferfv",
+                                          "glColorMask",
+                                          "glBlendFuncSeparate",
+                                          "glBlendEquationSeparate",
+                                          "glBlendColor",
+                                          "glDepthFunc",
+                                          "glDepthRangef",
+                                          "glStencilFuncSeparate",
+                                          "glStencilOpSeparate",
+                                          "glStencilMaskSeparate",
+                                          "glCullFace",
+                                          "glFrontFace",
+                                          "glPolygonMode",
+                                          "glPolygonOffset"};
+            auto idx = static_cast<size_t>(opcode);
+            return idx < sizeof(names) / sizeof(names[0]) ? names[idx] : "unknown";
+        }
+
+        inline std::uint64_t hash(void const* data, size_t byte_size)
+        {
+            // FNV-1a
+            std::uint64_t value = 14695981039346656037ull;
+            auto          bytes = static_cast<std::uint8_t const*>(data);
+            for (size_t i = 0; i < byte_size; ++i)
+            {
+                value ^= bytes[i];
+                value *= 1099511628211ull;
+            }
+            return value;
+        }
+
+        inline std::int64_t floatBits(GLfloat value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return static_cast<std::int64_t>(bits);
+        }
+
+        inline GLfloat bitsToFloat(std::int64_t value)
+        {
+            std::uint32_t bits = static_cast<std::uint32_t>(value);
+            GLfloat       result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        /**
+         * \brief Byte size of tightly packed pixel data (GL_UNPACK_ALIGNMENT 1) for the given format and type.
+         */
+        inline size_t computeImageByteSize(GLenum format, GLenum type, GLsizei width, GLsizei height, GLsizei depth)
+        {
+            size_t components = 4;
+            switch (format)
+            {
+            case GL_RED:
+            case GL_RED_INTEGER:
+            case GL_GREEN:
+            case GL_BLUE:
+            case GL_DEPTH_COMPONENT:
+            case GL_STENCIL_INDEX:
+                components = 1;
+                break;
+            case GL_RG:
+            case GL_RG_INTEGER:
+            case GL_DEPTH_STENCIL:
+                components = 2;
+                break;
+            case GL_RGB:
+            case GL_BGR:
+            case GL_RGB_INTEGER:
+            case GL_BGR_INTEGER:
+                components = 3;
+                break;
+            default:
+                break;
+            }
+
+            size_t texel_size = 0;
+            switch (type)
+            {
+            case GL_UNSIGNED_BYTE:
+            case GL_BYTE:
+                texel_size = components;
+                break;
+            case GL_UNSIGNED_SHORT:
+            case GL_SHORT:
+            case GL_HALF_FLOAT:
+                texel_size = 2 * components;
+                break;
+            case GL_UNSIGNED_INT:
+            case GL_INT:
+            case GL_FLOAT:
+                texel_size = 4 * components;
+                break;
+            case GL_UNSIGNED_BYTE_3_3_2:
+            case GL_UNSIGNED_BYTE_2_3_3_REV:
+                texel_size = 1;
+                break;
+            case GL_UNSIGNED_SHORT_5_6_5:
+            case GL_UNSIGNED_SHORT_5_6_5_REV:
+            case GL_UNSIGNED_SHORT_4_4_4_4:
+            case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+            case GL_UNSIGNED_SHORT_5_5_5_1:
+            case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+                texel_size = 2;
+                break;
+            case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+                texel_size = 8;
+                break;
+            default: // remaining packed types (e.g. GL_UNSIGNED_INT_24_8, GL_UNSIGNED_INT_10F_11F_11F_REV)
+                texel_size = 4;
+                break;
+            }
+
+            return texel_size * static_cast<size_t>(width) * static_cast<size_t>(height) * static_cast<size_t>(depth);
+        }
+
+        /**
+         * \class TraceWriter
+         *
+         * \brief Writes glowl commands into a compact binary trace file.
+         *
+         * File layout: 8 byte magic "GLOWLTRC", followed by commands. Each command is an opcode byte,
+         * a varint argument count, zigzag varint arguments, a payload kind byte and, for payloads, the varint byte
+         * size followed by either the 64 bit hash or the payload bytes.
+         */
+        class TraceWriter
+        {
+        public:
+            TraceWriter() : m_file(nullptr), m_open(false), m_store_payloads(true), m_frame(0) {}
+            ~TraceWriter()
+            {
+                close();
+            }
+            TraceWriter(const TraceWriter&) = delete;
+            TraceWriter& operator=(const TraceWriter&) = delete;
+
+            /**
+             * \brief Start recording into the given file.
+             *
+             * \param store_payloads Store full upload data (true) or only its size and hash (false).
+             * Replaying hashed uploads uploads zeroes of the same size.
+             */
+            bool open(std::string const& path, bool store_payloads = true)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                closeFile();
+                m_file = std::fopen(path.c_str(), "wb");
+                m_store_payloads = store_payloads;
+                m_frame = 0;
+
+                if (m_file != nullptr)
+                {
+                    std::fwrite("GLOWLTRC", 1, 8, m_file);
+                }
+                m_open.store(m_file != nullptr, std::memory_order_relaxed);
+
+                return m_file != nullptr;
+            }
+
+            void close()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                closeFile();
+            }
+
+            /**
+             * \brief Returns whether a trace file is open. Lock-free, since every traced call checks it.
+             */
+            bool isOpen() const
+            {
+                return m_open.load(std::memory_order_relaxed);
+            }
+
+            std::uint64_t getFrame() const
+            {
+                return m_frame.load(std::memory_order_relaxed);
+            }
+
+            void command(Opcode                              opcode,
+                         std::initializer_list<std::int64_t> args,
+                         void const*                         payload = nullptr,
+                         size_t                              payload_byte_size = 0)
+            {
+                command(opcode, args.begin(), args.size(), payload, payload_byte_size);
+            }
+
+            void command(Opcode                           opcode,
+                         std::vector<std::int64_t> const& args,
+                         void const*                      payload = nullptr,
+                         size_t                           payload_byte_size = 0)
+            {
+                command(opcode, args.data(), args.size(), payload, payload_byte_size);
+            }
+
+            /**
+             * \brief Record a command with a string payload, which is always stored in full.
+             */
+            void command(Opcode opcode, std::initializer_list<std::int64_t> args, std::string const& payload)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                writeCommand(opcode, args.begin(), args.size(), payload.data(), payload.size(), true);
+            }
+
+            void command(Opcode opcode, std::vector<std::int64_t> const& args, std::string const& payload)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                writeCommand(opcode, args.data(), args.size(), payload.data(), payload.size(), true);
+            }
+
+        private:
+            void command(Opcode              opcode,
+                         std::int64_t const* args,
+                         size_t              arg_cnt,
+                         void const*         payload,
+                         size_t              payload_byte_size)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                writeCommand(opcode, args, arg_cnt, payload, payload_byte_size, m_store_payloads);
+
+                if (opcode == Opcode::Frame)
+                {
+                    ++m_frame;
+                }
+            }
+
+            void writeCommand(Opcode              opcode,
+                              std::int64_t const* args,
+                              size_t              arg_cnt,
+                              void const*         payload,
+                              size_t              payload_byte_size,
+                              bool                store_payload)
+            {
+                if (m_file == nullptr)
+                {
+                    return;
+                }
+
+                m_buffer.push_back(static_cast<std::uint8_t>(opcode));
+                writeVarint(arg_cnt);
+                for (size_t i = 0; i < arg_cnt; ++i)
+                {
+                    // zigzag encoding keeps small negative values small
+                    writeVarint((static_cast<std::uint64_t>(args[i]) << 1) ^ static_cast<std::uint64_t>(args[i] >> 63));
+                }
+
+                if (payload == nullptr || payload_byte_size == 0)
+                {
+                    m_buffer.push_back(static_cast<std::uint8_t>(PayloadKind::None));
+                }
+                else if (store_payload)
+                {
+                    m_buffer.push_back(static_cast<std::uint8_t>(PayloadKind::Blob));
+                    writeVarint(payload_byte_size);
+                    flushBuffer();
+                    std::fwrite(payload, 1, payload_byte_size, m_file);
+                }
+                else
+                {
+                    m_buffer.push_back(static_cast<std::uint8_t>(PayloadKind::Hash));
+                    writeVarint(payload_byte_size);
+                    std::uint64_t payload_hash = hash(payload, payload_byte_size);
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        m_buffer.push_back(static_cast<std::uint8_t>(payload_hash >> (8 * i)));
+                    }
+                }
+
+                if (m_buffer.size() > (1 << 20))
+                {
+                    flushBuffer();
+                }
+            }
+
+            void writeVarint(std::uint64_t value)
+            {
+                while (value >= 0x80)
+                {
+                    m_buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+                    value >>= 7;
+                }
+                m_buffer.push_back(static_cast<std::uint8_t>(value));
+            }
+
+            void flushBuffer()
+            {
+                if (!m_buffer.empty())
+                {
+                    std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+                    m_buffer.clear();
+                }
+            }
+
+            void closeFile()
+            {
+                if (m_file != nullptr)
+                {
+                    flushBuffer();
+                    std::fclose(m_file);
+                    m_file = nullptr;
+                    m_open.store(false, std::memory_order_relaxed);
+                }
+            }
+
+            std::mutex                m_mutex;
+            std::FILE*                 m_file;
+            std::atomic<bool>          m_open; ///< mirrors m_file != nullptr for isOpen()
+            std::vector<std::uint8_t>  m_buffer;
+            bool                       m_store_payloads;
+            std::atomic<std::uint64_t> m_frame;
+        };
+
+        /**
+         * \brief A single decoded trace command.
+         */
+        struct Command
+        {
+            Opcode                    opcode;
+            std::vector<std::int64_t> args;
+            PayloadKind               payload_kind;
+            std::uint64_t             payload_byte_size;
+            std::uint64_t             payload_hash;
+            std::vector<std::uint8_t> payload; ///< Only filled for PayloadKind::Blob
+        };
+
+        /**
+         * \class TraceReader
+         *
+         * \brief Decodes a trace file written by TraceWriter.
+         */
+        class TraceReader
+        {
+        public:
+            TraceReader() : m_pos(0) {}
+
+            /**
+             * \brief Load a complete trace file into memory.
+             */
+            bool open(std::string const& path)
+            {
+                m_data.clear();
+                m_pos = 0;
+
+                std::FILE* file = std::fopen(path.c_str(), "rb");
+                if (file == nullptr)
+                {
+                    return false;
+                }
+
+                std::uint8_t chunk[1 << 16];
+                size_t       read_cnt;
+                while ((read_cnt = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+                {
+                    m_data.insert(m_data.end(), chunk, chunk + read_cnt);
+                }
+                std::fclose(file);
+
+                if (m_data.size() < 8 || std::memcmp(m_data.data(), "GLOWLTRC", 8) != 0)
+                {
+                    m_data.clear();
+                    return false;
+                }
+
+                m_pos = 8;
+                return true;
+            }
+
+            /**
+             * \brief Decode the next command. Returns false at the end of the trace or for corrupted data.
+             */
+            bool next(Command& command)
+            {
+                if (m_pos >= m_data.size())
+                {
+                    return false;
+                }
+
+                command.opcode = static_cast<Opcode>(m_data[m_pos++]);
+                if (command.opcode == Opcode(0) || command.opcode >= Opcode::Count)
+                {
+                    return false;
+                }
+
+                std::uint64_t arg_cnt;
+                if (!readVarint(arg_cnt))
+                {
+                    return false;
+                }
+                command.args.resize(static_cast<size_t>(arg_cnt));
+                for (auto& arg : command.args)
+                {
+                    std::uint64_t value;
+                    if (!readVarint(value))
+                    {
+                        return false;
+                    }
+                    arg = static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+                }
+
+                if (m_pos >= m_data.size())
+                {
+                    return false;
+                }
+                command.payload_kind = static_cast<PayloadKind>(m_data[m_pos++]);
+                command.payload_byte_size = 0;
+                command.payload_hash = 0;
+                command.payload.clear();
+
+                if (command.payload_kind != PayloadKind::None)
+                {
+                    if (!readVarint(command.payload_byte_size))
+                    {
+                        return false;
+                    }
+
+                    size_t stored_size = command.payload_kind == PayloadKind::Blob
+                                             ? static_cast<size_t>(command.payload_byte_size)
+                                             : sizeof(std::uint64_t);
+                    if (m_pos + stored_size > m_data.size())
+                    {
+                        return false;
+                    }
+
+                    if (command.payload_kind == PayloadKind::Blob)
+                    {
+                        command.payload.assign(m_data.begin() + m_pos, m_data.begin() + m_pos + stored_size);
+                        command.payload_hash = hash(command.payload.data(), command.payload.size());
+                    }
+                    else
+                    {
+                        for (int i = 0; i < 8; ++i)
+                        {
+                            command.payload_hash |= static_cast<std::uint64_t>(m_data[m_pos + i]) << (8 * i);
+                        }
+                    }
+                    m_pos += stored_size;
+                }
+
+                return true;
+            }
+
+        private:
+            bool readVarint(std::uint64_t& value)
+            {
+                value = 0;
+                for (int shift = 0; shift < 64 && m_pos < m_data.size(); shift += 7)
+                {
+                    std::uint8_t byte = m_data[m_pos++];
+                    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            std::vector<std::uint8_t> m_data;
+            size_t                    m_pos;
+        };
+
+        /**
+         * \brief The trace writer that glowl objects record into (if compiled with GLOWL_ENABLE_TRACE).
+         */
+        inline TraceWriter& getWriter()
+        {
+            static TraceWriter writer;
+            return writer;
+        }
+
+        /**
+         * \brief Mark the end of a frame in the trace, used by the replay tool for per-frame timings.
+         */
+        inline void frame()
+        {
+            if (getWriter().isOpen())
+            {
+                getWriter().command(Opcode::Frame, {});
+            }
+        }
+
+        inline void traceTextureCreation(GLenum                                         target,
+                                         GLuint                                         name,
+                                         GLenum                                         internal_format,
+                                         GLsizei                                        width,
+                                         GLsizei                                        height,
+                                         GLsizei                                        depth,
+                                         GLsizei                                        levels,
+                                         GLenum                                         format,
+                                         GLenum                                         type,
+                                         bool                                           generate_mipmap,
+                                         std::vector<std::pair<GLenum, GLint>> const&   int_parameters,
+                                         std::vector<std::pair<GLenum, GLfloat>> const& float_parameters,
+                                         GLvoid const*                                  data)
+        {
+            std::vector<std::int64_t> args = {
+                target, name, internal_format, width, height, depth, levels, format, type, generate_mipmap ? 1 : 0};
+
+            args.push_back(static_cast<std::int64_t>(int_parameters.size()));
+            for (auto const& pname_pvalue : int_parameters)
+            {
+                args.push_back(pname_pvalue.first);
+                args.push_back(pname_pvalue.second);
+            }
+            args.push_back(static_cast<std::int64_t>(float_parameters.size()));
+            for (auto const& pname_pvalue : float_parameters)
+            {
+                args.push_back(pname_pvalue.first);
+                args.push_back(floatBits(pname_pvalue.second));
+            }
+
+            size_t data_byte_size = data != nullptr ? computeImageByteSize(format, type, width, height, depth) : 0;
+
+            getWriter().command(Opcode::CreateTexture, args, data, data_byte_size);
+        }
+
+        /**
+         * \brief Records a texture upload. Data is a byte offset if a buffer is bound to GL_PIXEL_UNPACK_BUFFER,
+         * otherwise the client memory read by OpenGL under the current unpack state is stored as payload.
+         */
+        inline void traceTextureSubImage(GLuint        name,
+                                         GLenum        target,
+                                         GLint         level,
+                                         GLint         x,
+                                         GLint         y,
+                                         GLint         z,
+                                         GLsizei       width,
+                                         GLsizei       height,
+                                         GLsizei       depth,
+                                         GLenum        format,
+                                         GLenum        type,
+                                         GLvoid const* data)
+        {
+            GLint unpack_alignment = 4;
+            GLint row_length = 0;
+            GLint image_height = 0;
+            GLint unpack_buffer = 0;
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+            glGetIntegerv(GL_UNPACK_ROW_LENGTH, &row_length);
+            glGetIntegerv(GL_UNPACK_IMAGE_HEIGHT, &image_height);
+            glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpack_buffer);
+
+            std::int64_t byte_offset =
+                unpack_buffer != 0 ? static_cast<std::int64_t>(reinterpret_cast<std::uintptr_t>(data)) : 0;
+
+            size_t data_byte_size = 0;
+            if (unpack_buffer == 0 && data != nullptr && width > 0 && height > 0 && depth > 0)
+            {
+                // all rows but the last are padded to the unpack alignment
+                size_t alignment = static_cast<size_t>(std::max(unpack_alignment, 1));
+                size_t row_byte_size = computeImageByteSize(format, type, row_length > 0 ? row_length : width, 1, 1);
+                size_t row_stride = (row_byte_size + alignment - 1) / alignment * alignment;
+                size_t image_rows = static_cast<size_t>(image_height > 0 ? image_height : height);
+                size_t row_cnt = image_rows * static_cast<size_t>(depth - 1) + static_cast<size_t>(height - 1);
+                data_byte_size = row_stride * row_cnt + computeImageByteSize(format, type, width, 1, 1);
+            }
+
+            getWriter().command(Opcode::TextureSubImage,
+                                {name,
+                                 target,
+                                 level,
+                                 x,
+                                 y,
+                                 z,
+                                 width,
+                                 height,
+                                 depth,
+                                 format,
+                                 type,
+                                 unpack_alignment,
+                                 row_length,
+                                 image_height,
+                                 unpack_buffer,
+                                 byte_offset},
+                                data_byte_size > 0 ? data : nullptr,
+                                data_byte_size);
+        }
+
+        inline void traceTextureView(GLuint                                         name,
+                                     GLenum                                         target,
+                                     GLuint                                         source,
+                                     GLenum                                         internal_format,
+                                     GLuint                                         minlevel,
+                                     GLuint                                         numlevels,
+                                     GLuint                                         minlayer,
+                                     GLuint                                         numlayers,
+                                     std::vector<std::pair<GLenum, GLint>> const&   int_parameters,
+                                     std::vector<std::pair<GLenum, GLfloat>> const& float_parameters)
+        {
+            getWriter().command(Opcode::TextureView,
+                                {name, target, source, internal_format, minlevel, numlevels, minlayer, numlayers});
+
+            for (auto const& pname_pvalue : int_parameters)
+            {
+                getWriter().command(Opcode::TextureParameteri, {name, pname_pvalue.first, pname_pvalue.second});
+            }
+            for (auto const& pname_pvalue : float_parameters)
+            {
+                getWriter().command(Opcode::TextureParameterf,
+                                    {name, pname_pvalue.first, floatBits(pname_pvalue.second)});
+            }
+        }
+
+        inline void traceSwizzle(GLuint name, GLint r, GLint g, GLint b, GLint a)
+        {
+            getWriter().command(Opcode::TextureParameteri, {name, GL_TEXTURE_SWIZZLE_R, r});
+            getWriter().command(Opcode::TextureParameteri, {name, GL_TEXTURE_SWIZZLE_G, g});
+            getWriter().command(Opcode::TextureParameteri, {name, GL_TEXTURE_SWIZZLE_B, b});
+            getWriter().command(Opcode::TextureParameteri, {name, GL_TEXTURE_SWIZZLE_A, a});
+        }
+
+        inline std::int64_t uniformValue(GLfloat value)
+        {
+            return floatBits(value);
+        }
+
+        inline std::int64_t uniformValue(GLint value)
+        {
+            return value;
+        }
+
+        inline std::int64_t uniformValue(GLuint value)
+        {
+            return value;
+        }
+
+        template<typename T>
+        inline void traceUniform(GLuint program, GLchar const* name, UniformType type, T const* values, size_t cnt)
+        {
+            std::vector<std::int64_t> args = {program, type};
+            for (size_t i = 0; i < cnt; ++i)
+            {
+                args.push_back(uniformValue(values[i]));
+            }
+
+            getWriter().command(Opcode::Uniform, args, std::string(name));
+        }
+
+        template<typename T>
+        inline void traceUniform(GLuint program, GLchar const* name, UniformType type, std::initializer_list<T> values)
+        {
+            traceUniform(program, name, type, values.begin(), values.size());
+        }
+
+    } // namespace trace
+} // namespace glowl
+
+/**
+ * Records a command into the glowl trace, e.g. GLOWL_TRACE(Opcode::BindBuffer, {target, name}).
+ * GLOWL_TRACE_CALL(statement) runs a statement that records into the trace, e.g. trace::traceUniform(...).
+ * Both compile to nothing unless GLOWL_ENABLE_TRACE is defined and only record while a trace file is open.
+ */
+#ifdef GLOWL_ENABLE_TRACE
+#define GLOWL_TRACE(opcode, ...)                                                                                       \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (::glowl::trace::getWriter().isOpen())                                                                      \
+        {                                                                                                              \
+            ::glowl::trace::getWriter().command(::glowl::trace::opcode, __VA_ARGS__);                                 \
+        }                                                                                                              \
+    } while (0)
+#define GLOWL_TRACE_CALL(...)                                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (::glowl::trace::getWriter().isOpen())                                                                      \
+        {                                                                                                              \
+            __VA_ARGS__;                                                                                               \
+        }                                                                                                              \
+    } while (0)
+#else
+#define GLOWL_TRACE(opcode, ...)                                                                                       \
+    do                                                                                                                 \
+    {                                                                                                                  \
+    } while (0)
+#define GLOWL_TRACE_CALL(...)                                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+    } while (0)
+#endif
+
+#endif // GLOWL_TRACE_HPP
@@ -164,6 +164,13 @@ namespace glowl
 
     static size_t computeAttributeByteSize(VertexLayout::Attribute attrib_desc)
     {
+        // packed types hold all components in a single value
+        if (attrib_desc.type == GL_INT_2_10_10_10_REV || attrib_desc.type == GL_UNSIGNED_INT_2_10_10_10_REV ||
+            attrib_desc.type == GL_UNSIGNED_INT_10F_11F_11F_REV)
+        {
+            return computeByteSize(attrib_desc.type);
+        }
+
         return computeByteSize(attrib_desc.type) * attrib_desc.size;
     }
 
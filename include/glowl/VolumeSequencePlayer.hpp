@@ -0,0 +1,490 @@
+/*
+ * VolumeSequencePlayer.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_VOLUMESEQUENCEPLAYER_HPP
+#define GLOWL_VOLUMESEQUENCEPLAYER_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BufferObject.hpp"
+#include "Exceptions.hpp"
+#include "MappedFile.hpp"
+#include "Texture3D.hpp"
+#include "Trace.hpp"
+#include "glinclude.h"
+
+namespace glowl
+{
+
+    /**
+     * \class VolumeSequencePlayer
+     *
+     * \brief Plays back a sequence of volumes (e.g. simulation timesteps) stored back-to-back in a raw file.
+     *
+     * The player keeps two or three Texture3D objects with identical immutable storage and streams the upcoming
+     * timesteps into the ones not on display: a worker thread copies a timestep from the memory mapped file into
+     * a mapped pixel unpack buffer (prefetching the timestep after it), the upload to the texture is then issued
+     * from the buffer and a fence marks its completion. Call update() once per frame to drive this pipeline, it
+     * swaps to the next timestep as soon as its upload has finished and never waits for the GPU or the disk.
+     *
+     * Note: All methods except the constructor's worker thread have to be called with the OpenGL context current.
+     */
+    class VolumeSequencePlayer
+    {
+    public:
+        /**
+         * \brief VolumeSequencePlayer constructor.
+         *
+         * \param layout Layout of a single timestep, only the base level is streamed
+         * \param path Raw file containing all timesteps without padding
+         * \param header_byte_size Bytes at the start of the file that precede the first timestep
+         * \param texture_cnt Number of textures (2 for double, 3 for triple buffering)
+         *
+         * Note: Active OpenGL context required for construction.
+         */
+        VolumeSequencePlayer(std::string const&   id,
+                             TextureLayout const& layout,
+                             std::string const&   path,
+                             size_t               header_byte_size = 0,
+                             unsigned int         texture_cnt = 2);
+        ~VolumeSequencePlayer();
+        VolumeSequencePlayer(const VolumeSequencePlayer&) = delete;
+        VolumeSequencePlayer& operator=(const VolumeSequencePlayer&) = delete;
+
+        /**
+         * \brief Advance the streaming pipeline without blocking.
+         *
+         * \param advance Swap to the next timestep if it is available, false keeps the current one on display
+         * (e.g. paused playback or playback at a fixed rate) while still streaming ahead.
+         * \return True if a new timestep is on display.
+         */
+        bool update(bool advance = true);
+
+        /**
+         * \brief Let the given timestep be the next one to be displayed. Timesteps already in flight are reused if
+         * they are still needed.
+         */
+        void seek(size_t timestep);
+
+        void setLooping(bool looping);
+        bool getLooping() const;
+
+        /**
+         * \brief Returns the texture of the timestep on display. Its content is undefined until hasTimestep().
+         */
+        Texture3D const& getTexture() const;
+
+        bool   hasTimestep() const;
+        size_t getTimestep() const;
+        size_t getTimestepCount() const;
+
+    private:
+        enum class SlotState
+        {
+            Free,      ///< Unused, may receive the next timestep
+            Filling,   ///< Worker thread copies data into the mapped unpack buffer
+            Filled,    ///< Copy done, upload not yet issued
+            Uploading, ///< Upload issued, waiting for the fence
+            Ready,     ///< Upload done, waiting to be displayed
+            Current    ///< On display
+        };
+
+        struct Slot
+        {
+            std::unique_ptr<Texture3D>    texture;
+            std::unique_ptr<BufferObject> unpack_buffer;
+            void*                         mapping;
+            GLsync                        fence;
+            size_t                        timestep;
+            SlotState                     state;
+        };
+
+        struct Job
+        {
+            size_t               slot;
+            unsigned char const* src;
+            void*                dst;
+            size_t               prefetch_timestep;
+        };
+
+        /** Timestep the given number of steps after the next one, or the timestep count if there is none */
+        size_t getUpcoming(size_t steps) const;
+
+        /** True if the timestep is among those that will be displayed next */
+        bool isWanted(size_t timestep) const;
+
+        void schedule();
+        void upload(Slot& slot);
+        void work();
+
+        detail::MappedFile m_file;
+        size_t             m_header_byte_size;
+        size_t             m_timestep_byte_size;
+        size_t             m_timestep_cnt;
+        TextureLayout      m_layout;
+
+        std::vector<Slot> m_slots;
+        size_t            m_current_slot;
+        size_t            m_next_timestep;
+        bool              m_looping;
+
+        std::thread             m_worker;
+        std::mutex              m_mutex;
+        std::condition_variable m_condition;
+        std::deque<Job>         m_jobs;
+        std::vector<size_t>     m_filled_slots;  ///< Written by the worker thread
+        std::vector<size_t>     m_filled_buffer; ///< Swapped with m_filled_slots to keep update() allocation free
+        bool                    m_quit;
+    };
+
+    inline VolumeSequencePlayer::VolumeSequencePlayer(std::string const&   id,
+                                                      TextureLayout const& layout,
+                                                      std::string const&   path,
+                                                      size_t               header_byte_size,
+                                                      unsigned int         texture_cnt)
+        : m_file(path),
+          m_header_byte_size(header_byte_size),
+          m_timestep_byte_size(
+              trace::computeImageByteSize(layout.format, layout.type, layout.width, layout.height, layout.depth)),
+          m_timestep_cnt(0),
+          m_layout(layout),
+          m_current_slot(0),
+          m_next_timestep(0),
+          m_looping(true),
+          m_quit(false)
+    {
+        if (texture_cnt < 2)
+        {
+            throw TextureException("VolumeSequencePlayer::VolumeSequencePlayer - at least two textures required");
+        }
+
+        if (m_file.getByteSize() > m_header_byte_size)
+        {
+            m_timestep_cnt = (m_file.getByteSize() - m_header_byte_size) / m_timestep_byte_size;
+        }
+
+        if (m_timestep_cnt == 0)
+        {
+            throw TextureException("VolumeSequencePlayer::VolumeSequencePlayer - " + path +
+                                   " does not contain a full timestep");
+        }
+
+        // only the base level is streamed
+        m_layout.levels = 1;
+
+        m_slots.resize(texture_cnt);
+        for (size_t i = 0; i < m_slots.size(); ++i)
+        {
+            m_slots[i].texture = std::make_unique<Texture3D>(id + "_" + std::to_string(i), m_layout, nullptr);
+            m_slots[i].unpack_buffer = std::make_unique<BufferObject>(GL_PIXEL_UNPACK_BUFFER,
+                                                                      static_cast<GLsizeiptr>(m_timestep_byte_size),
+                                                                      BufferObject::StorageMode::Mutable,
+                                                                      GL_STREAM_DRAW);
+            m_slots[i].mapping = nullptr;
+            m_slots[i].fence = nullptr;
+            m_slots[i].timestep = 0;
+            m_slots[i].state = SlotState::Free;
+        }
+
+        m_filled_slots.reserve(m_slots.size());
+        m_filled_buffer.reserve(m_slots.size());
+
+        m_worker = std::thread(&VolumeSequencePlayer::work, this);
+
+        schedule();
+    }
+
+    inline VolumeSequencePlayer::~VolumeSequencePlayer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+            m_jobs.clear();
+        }
+        m_condition.notify_all();
+        m_worker.join();
+
+        for (auto& slot : m_slots)
+        {
+            if (slot.mapping != nullptr)
+            {
+                slot.unpack_buffer->unmap();
+            }
+            if (slot.fence != nullptr)
+            {
+                glDeleteSync(slot.fence);
+            }
+        }
+    }
+
+    inline bool VolumeSequencePlayer::update(bool advance)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_filled_buffer.swap(m_filled_slots);
+        }
+
+        for (size_t slot_idx : m_filled_buffer)
+        {
+            Slot& slot = m_slots[slot_idx];
+            slot.unpack_buffer->unmap();
+            slot.mapping = nullptr;
+
+            if (isWanted(slot.timestep))
+            {
+                upload(slot);
+            }
+            else
+            {
+                slot.state = SlotState::Free;
+            }
+        }
+        m_filled_buffer.clear();
+
+        for (auto& slot : m_slots)
+        {
+            if (slot.state == SlotState::Uploading)
+            {
+                GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+                if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+                {
+                    glDeleteSync(slot.fence);
+                    slot.fence = nullptr;
+                    slot.state = SlotState::Ready;
+                }
+            }
+
+            if (slot.state == SlotState::Ready && !isWanted(slot.timestep))
+            {
+                slot.state = SlotState::Free;
+            }
+        }
+
+        bool swapped = false;
+
+        if (advance && m_next_timestep < m_timestep_cnt)
+        {
+            for (size_t i = 0; i < m_slots.size(); ++i)
+            {
+                if (m_slots[i].state == SlotState::Ready && m_slots[i].timestep == m_next_timestep)
+                {
+                    if (m_slots[m_current_slot].state == SlotState::Current)
+                    {
+                        m_slots[m_current_slot].state = SlotState::Free;
+                    }
+                    m_slots[i].state = SlotState::Current;
+                    m_current_slot = i;
+                    m_next_timestep = getUpcoming(1);
+                    swapped = true;
+                    break;
+                }
+            }
+        }
+
+        schedule();
+
+        return swapped;
+    }
+
+    inline void VolumeSequencePlayer::seek(size_t timestep)
+    {
+        if (timestep >= m_timestep_cnt)
+        {
+            throw TextureException("VolumeSequencePlayer::seek - timestep " + std::to_string(timestep) +
+                                   " out of range");
+        }
+
+        m_next_timestep = timestep;
+
+        for (auto& slot : m_slots)
+        {
+            if (slot.state == SlotState::Ready && !isWanted(slot.timestep))
+            {
+                slot.state = SlotState::Free;
+            }
+        }
+
+        schedule();
+    }
+
+    inline void VolumeSequencePlayer::setLooping(bool looping)
+    {
+        m_looping = looping;
+    }
+
+    inline bool VolumeSequencePlayer::getLooping() const
+    {
+        return m_looping;
+    }
+
+    inline Texture3D const& VolumeSequencePlayer::getTexture() const
+    {
+        return *m_slots[m_current_slot].texture;
+    }
+
+    inline bool VolumeSequencePlayer::hasTimestep() const
+    {
+        return m_slots[m_current_slot].state == SlotState::Current;
+    }
+
+    inline size_t VolumeSequencePlayer::getTimestep() const
+    {
+        return m_slots[m_current_slot].timestep;
+    }
+
+    inline size_t VolumeSequencePlayer::getTimestepCount() const
+    {
+        return m_timestep_cnt;
+    }
+
+    inline size_t VolumeSequencePlayer::getUpcoming(size_t steps) const
+    {
+        if (m_next_timestep >= m_timestep_cnt)
+        {
+            return m_timestep_cnt;
+        }
+
+        size_t timestep = m_next_timestep + steps;
+
+        if (timestep >= m_timestep_cnt)
+        {
+            return m_looping ? timestep % m_timestep_cnt : m_timestep_cnt;
+        }
+
+        return timestep;
+    }
+
+    inline bool VolumeSequencePlayer::isWanted(size_t timestep) const
+    {
+        // one texture is on display, the others hold the upcoming timesteps
+        for (size_t steps = 0; steps + 1 < m_slots.size(); ++steps)
+        {
+            if (getUpcoming(steps) == timestep)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline void VolumeSequencePlayer::schedule()
+    {
+        bool notify = false;
+
+        for (size_t steps = 0; steps + 1 < m_slots.size(); ++steps)
+        {
+            size_t timestep = getUpcoming(steps);
+            if (timestep >= m_timestep_cnt)
+            {
+                break;
+            }
+
+            bool in_flight = false;
+            size_t free_slot = m_slots.size();
+
+            for (size_t i = 0; i < m_slots.size(); ++i)
+            {
+                SlotState state = m_slots[i].state;
+                if (state == SlotState::Free)
+                {
+                    free_slot = std::min(free_slot, i);
+                }
+                else if (state != SlotState::Current && m_slots[i].timestep == timestep)
+                {
+                    in_flight = true;
+                }
+            }
+
+            if (in_flight || free_slot == m_slots.size())
+            {
+                continue;
+            }
+
+            Slot& slot = m_slots[free_slot];
+            slot.timestep = timestep;
+            slot.state = SlotState::Filling;
+
+            // the previous upload from this buffer has completed (fenced), so no implicit synchronization needed
+            slot.mapping = slot.unpack_buffer->map(0,
+                                                   static_cast<GLsizeiptr>(m_timestep_byte_size),
+                                                   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                                       GL_MAP_UNSYNCHRONIZED_BIT);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back({free_slot,
+                              m_file.getData() + m_header_byte_size + timestep * m_timestep_byte_size,
+                              slot.mapping,
+                              getUpcoming(steps + 1)});
+            notify = true;
+        }
+
+        if (notify)
+        {
+            m_condition.notify_one();
+        }
+    }
+
+    inline void VolumeSequencePlayer::upload(Slot& slot)
+    {
+        // time steps are stored with unpadded rows, see trace::computeImageByteSize
+        GLint unpack_alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        slot.unpack_buffer->bind();
+        slot.texture->subImage(0, 0, 0, 0, m_layout.width, m_layout.height, m_layout.depth, nullptr);
+        GLOWL_TRACE(Opcode::BindBuffer, {GL_PIXEL_UNPACK_BUFFER, 0});
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.state = SlotState::Uploading;
+    }
+
+    inline void VolumeSequencePlayer::work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        for (;;)
+        {
+            m_condition.wait(lock, [this]() { return m_quit || !m_jobs.empty(); });
+
+            if (m_quit)
+            {
+                return;
+            }
+
+            Job job = m_jobs.front();
+            m_jobs.pop_front();
+
+            lock.unlock();
+
+            if (job.prefetch_timestep < m_timestep_cnt)
+            {
+                m_file.prefetch(m_header_byte_size + job.prefetch_timestep * m_timestep_byte_size,
+                                m_timestep_byte_size);
+            }
+
+            std::memcpy(job.dst, job.src, m_timestep_byte_size);
+
+            lock.lock();
+
+            m_filled_slots.push_back(job.slot);
+        }
+    }
+
+} // namespace glowl
+
+#endif // GLOWL_VOLUMESEQUENCEPLAYER_HPP
@@ -9,6 +9,8 @@
 #include <GL/gl3w.h>
 #elif defined(GLOWL_OPENGL_INCLUDE_GLEW)
 #include <GL/glew.h>
+#elif defined(GLOWL_OPENGL_INCLUDE_MOCK)
+#include "glmock.h"
 #endif
 
 #endif // GLOWL_GLINCLUDE_H
@@ -0,0 +1,501 @@
+/*
+ * glmock.h
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_GLMOCK_H
+#define GLOWL_GLMOCK_H
+
+/*
+ * Recording OpenGL backend for GLOWL_OPENGL_INCLUDE_MOCK.
+ *
+ * Implements the OpenGL entry points used by glowl without a GPU or context. Every call is appended to the call
+ * log of glowl::mock::Recorder, object names are simulated and queries return plausible values. This allows to
+ * assert call sequences and counts of glowl objects and to benchmark the CPU overhead of glowl itself.
+ * Heap allocations of the mock calls stand in for driver work and are not counted by glowl::debug::allocationCount().
+ * Types and enums are taken from the Khronos <GL/glcorearb.h> header.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glcorearb.h>
+
+#include "AllocationCounter.hpp"
+
+namespace glowl
+{
+    namespace mock
+    {
+
+        /**
+         * \class Recorder
+         *
+         * \brief Call log and simulated state of the mock OpenGL backend.
+         */
+        class Recorder
+        {
+        public:
+            struct TextureState
+            {
+                GLenum  target;
+                GLsizei levels;
+                GLsizei width;
+                GLsizei height;
+                GLsizei depth;
+            };
+
+            /** Arguments of glDrawElementsInstanced(BaseVertex) */
+            struct DrawElementsCall
+            {
+                GLenum         mode;
+                GLsizei        count;
+                GLenum         type;
+                std::uintptr_t byte_offset;
+                GLsizei        instance_cnt;
+                GLint          base_vertex;
+            };
+
+            static Recorder& get()
+            {
+                static Recorder recorder;
+                return recorder;
+            }
+
+            void record(char const* function)
+            {
+                if (m_recording)
+                {
+                    m_calls.push_back(function);
+                }
+            }
+
+            /**
+             * \brief Enable or disable call recording, e.g. to exclude setup code from assertions.
+             */
+            void setRecording(bool recording)
+            {
+                m_recording = recording;
+            }
+
+            std::vector<char const*> const& getCalls() const
+            {
+                return m_calls;
+            }
+
+            size_t getCallCount() const
+            {
+                return m_calls.size();
+            }
+
+            size_t getCallCount(char const* function) const
+            {
+                return static_cast<size_t>(std::count_if(m_calls.begin(), m_calls.end(), [function](char const* call) {
+                    return std::strcmp(call, function) == 0;
+                }));
+            }
+
+            /**
+             * \brief Arguments of the recorded glDrawElementsInstanced(BaseVertex) calls, cleared with the call log.
+             */
+            std::vector<DrawElementsCall> const& getDrawElementsCalls() const
+            {
+                return m_draw_elements_calls;
+            }
+
+            void recordDrawElements(DrawElementsCall const& call)
+            {
+                if (m_recording)
+                {
+                    m_draw_elements_calls.push_back(call);
+                }
+            }
+
+            void clearCalls()
+            {
+                m_calls.clear();
+                m_draw_elements_calls.clear();
+            }
+
+            /**
+             * \brief Reset call log and all simulated state.
+             */
+            void reset()
+            {
+                *this = Recorder();
+            }
+
+            GLuint createName()
+            {
+                return m_next_name++;
+            }
+
+            /**
+             * \brief Let the next glGetError call return the given error.
+             */
+            void setNextError(GLenum error)
+            {
+                m_next_error = error;
+            }
+
+            GLenum popError()
+            {
+                GLenum error = m_next_error;
+                m_next_error = GL_NO_ERROR;
+                return error;
+            }
+
+            /**
+             * \brief Set the value returned by glGetIntegerv for the given parameter.
+             */
+            void setInteger(GLenum pname, GLint value)
+            {
+                m_integers[pname] = value;
+            }
+
+            GLint getInteger(GLenum pname) const
+            {
+                auto query = m_integers.find(pname);
+                return query != m_integers.end() ? query->second : 0;
+            }
+
+            std::map<GLuint, TextureState>& textures()
+            {
+                return m_textures;
+            }
+
+            std::map<GLuint, GLsizeiptr>& buffers()
+            {
+                return m_buffers;
+            }
+
+            std::map<GLuint, std::vector<char>>& bufferMemory()
+            {
+                return m_buffer_memory;
+            }
+
+            std::map<GLenum, GLuint>& boundTextures()
+            {
+                return m_bound_textures;
+            }
+
+            std::map<std::pair<GLuint, std::string>, GLint>& uniformLocations()
+            {
+                return m_uniform_locations;
+            }
+
+        private:
+            Recorder() : m_recording(true), m_next_name(1), m_next_error(GL_NO_ERROR)
+            {
+                m_integers[GL_MAX_COLOR_ATTACHMENTS] = 8;
+                m_integers[GL_MAX_ELEMENTS_INDICES] = 1 << 20;
+                m_integers[GL_SPARSE_BUFFER_PAGE_SIZE_ARB] = 65536;
+            }
+
+            bool                     m_recording;
+            std::vector<char const*> m_calls;
+            GLuint                   m_next_name;
+            GLenum                   m_next_error;
+
+            std::map<GLenum, GLint>                         m_integers;
+            std::map<GLuint, TextureState>                  m_textures;
+            std::map<GLuint, GLsizeiptr>                    m_buffers;
+            std::map<GLuint, std::vector<char>>             m_buffer_memory; ///< Client memory of mapped buffers
+            std::map<GLenum, GLuint>                        m_bound_textures;
+            std::map<std::pair<GLuint, std::string>, GLint> m_uniform_locations;
+            std::vector<DrawElementsCall>                   m_draw_elements_calls;
+        };
+
+        inline void createNames(GLsizei n, GLuint* names)
+        {
+            for (GLsizei i = 0; i < n; ++i)
+            {
+                names[i] = Recorder::get().createName();
+            }
+        }
+
+        inline void storeTexture(GLuint texture, GLsizei levels, GLsizei width, GLsizei height, GLsizei depth)
+        {
+            auto& state = Recorder::get().textures()[texture];
+            state.levels = levels;
+            state.width = width;
+            state.height = height;
+            state.depth = depth;
+        }
+
+        inline void getTextureLevelParameter(GLuint texture, GLint level, GLenum pname, GLint* params)
+        {
+            auto const& state = Recorder::get().textures()[texture];
+            switch (pname)
+            {
+            case GL_TEXTURE_WIDTH:
+                *params = std::max(1, state.width >> level);
+                break;
+            case GL_TEXTURE_HEIGHT:
+                *params = std::max(1, state.height >> level);
+                break;
+            case GL_TEXTURE_DEPTH:
+                *params = state.target == GL_TEXTURE_3D ? std::max(1, state.depth >> level) : state.depth;
+                break;
+            default:
+                *params = 0;
+                break;
+            }
+        }
+
+        /**
+         * \brief Records a call and resets the allocation count of the thread when the mock call returns.
+         */
+        class CallScope
+        {
+        public:
+            explicit CallScope(char const* function) : m_allocation_cnt(debug::allocationCount())
+            {
+                Recorder::get().record(function);
+            }
+
+            ~CallScope()
+            {
+                debug::allocationCount() = m_allocation_cnt;
+            }
+
+            CallScope(CallScope const&) = delete;
+            CallScope& operator=(CallScope const&) = delete;
+
+        private:
+            std::uint64_t m_allocation_cnt;
+        };
+
+    } // namespace mock
+} // namespace glowl
+
+#define GLOWL_MOCK_RECORD(function) ::glowl::mock::CallScope const glowl_mock_call(#function)
+
+// clang-format off
+
+// Errors, queries and debug
+inline GLenum glGetError() { GLOWL_MOCK_RECORD(glGetError); return ::glowl::mock::Recorder::get().popError(); }
+inline void glGetIntegerv(GLenum pname, GLint* data) { GLOWL_MOCK_RECORD(glGetIntegerv); *data = ::glowl::mock::Recorder::get().getInteger(pname); }
+inline void glObjectLabel(GLenum, GLuint, GLsizei, GLchar const*) { GLOWL_MOCK_RECORD(glObjectLabel); }
+inline void glMemoryBarrier(GLbitfield) { GLOWL_MOCK_RECORD(glMemoryBarrier); }
+inline void glFlush() { GLOWL_MOCK_RECORD(glFlush); }
+inline GLsync glFenceSync(GLenum, GLbitfield) { GLOWL_MOCK_RECORD(glFenceSync); return reinterpret_cast<GLsync>(static_cast<std::uintptr_t>(::glowl::mock::Recorder::get().createName())); }
+inline GLenum glClientWaitSync(GLsync, GLbitfield, GLuint64) { GLOWL_MOCK_RECORD(glClientWaitSync); return GL_ALREADY_SIGNALED; }
+inline void glDeleteSync(GLsync) { GLOWL_MOCK_RECORD(glDeleteSync); }
+inline void glCreateQueries(GLenum, GLsizei n, GLuint* ids) { GLOWL_MOCK_RECORD(glCreateQueries); ::glowl::mock::createNames(n, ids); }
+inline void glDeleteQueries(GLsizei, GLuint const*) { GLOWL_MOCK_RECORD(glDeleteQueries); }
+inline void glQueryCounter(GLuint, GLenum) { GLOWL_MOCK_RECORD(glQueryCounter); }
+inline void glGetQueryObjectiv(GLuint, GLenum pname, GLint* params) { GLOWL_MOCK_RECORD(glGetQueryObjectiv); *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0; }
+inline void glGetQueryObjectui64v(GLuint, GLenum, GLuint64* params) { GLOWL_MOCK_RECORD(glGetQueryObjectui64v); *params = 0; }
+
+// Buffers
+inline void glCreateBuffers(GLsizei n, GLuint* buffers) { GLOWL_MOCK_RECORD(glCreateBuffers); ::glowl::mock::createNames(n, buffers); }
+inline void glDeleteBuffers(GLsizei, GLuint const*) { GLOWL_MOCK_RECORD(glDeleteBuffers); }
+inline void glNamedBufferData(GLuint buffer, GLsizeiptr size, void const*, GLenum) { GLOWL_MOCK_RECORD(glNamedBufferData); ::glowl::mock::Recorder::get().buffers()[buffer] = size; }
+inline void glNamedBufferStorage(GLuint buffer, GLsizeiptr size, void const*, GLbitfield) { GLOWL_MOCK_RECORD(glNamedBufferStorage); ::glowl::mock::Recorder::get().buffers()[buffer] = size; }
+inline void glNamedBufferSubData(GLuint, GLintptr, GLsizeiptr, void const*) { GLOWL_MOCK_RECORD(glNamedBufferSubData); }
+inline void glNamedBufferPageCommitmentARB(GLuint, GLintptr, GLsizeiptr, GLboolean) { GLOWL_MOCK_RECORD(glNamedBufferPageCommitmentARB); }
+inline void glCopyNamedBufferSubData(GLuint, GLuint, GLintptr, GLintptr, GLsizeiptr) { GLOWL_MOCK_RECORD(glCopyNamedBufferSubData); }
+inline void glGetNamedBufferSubData(GLuint, GLintptr, GLsizeiptr size, void* data)
+{
+    GLOWL_MOCK_RECORD(glGetNamedBufferSubData);
+    std::memset(data, 0, static_cast<size_t>(size));
+}
+inline void* glMapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr, GLbitfield)
+{
+    GLOWL_MOCK_RECORD(glMapNamedBufferRange);
+    auto& memory = ::glowl::mock::Recorder::get().bufferMemory()[buffer];
+    memory.resize(static_cast<size_t>(::glowl::mock::Recorder::get().buffers()[buffer]));
+    return memory.data() + offset;
+}
+inline GLboolean glUnmapNamedBuffer(GLuint) { GLOWL_MOCK_RECORD(glUnmapNamedBuffer); return GL_TRUE; }
+inline void glBindBuffer(GLenum, GLuint) { GLOWL_MOCK_RECORD(glBindBuffer); }
+inline void glBindBufferBase(GLenum, GLuint, GLuint) { GLOWL_MOCK_RECORD(glBindBufferBase); }
+
+// Textures
+inline void glCreateTextures(GLenum target, GLsizei n, GLuint* textures)
+{
+    GLOWL_MOCK_RECORD(glCreateTextures);
+    ::glowl::mock::createNames(n, textures);
+    for (GLsizei i = 0; i < n; ++i) { ::glowl::mock::Recorder::get().textures()[textures[i]].target = target; }
+}
+inline void glGenTextures(GLsizei n, GLuint* textures) { GLOWL_MOCK_RECORD(glGenTextures); ::glowl::mock::createNames(n, textures); }
+inline void glDeleteTextures(GLsizei, GLuint const*) { GLOWL_MOCK_RECORD(glDeleteTextures); }
+inline void glBindTextureUnit(GLuint, GLuint) { GLOWL_MOCK_RECORD(glBindTextureUnit); }
+inline void glBindTexture(GLenum target, GLuint texture)
+{
+    GLOWL_MOCK_RECORD(glBindTexture);
+    ::glowl::mock::Recorder::get().boundTextures()[target] = texture;
+    if (texture != 0) { ::glowl::mock::Recorder::get().textures()[texture].target = target; }
+}
+inline void glTextureParameteri(GLuint, GLenum, GLint) { GLOWL_MOCK_RECORD(glTextureParameteri); }
+inline void glTextureParameterf(GLuint, GLenum, GLfloat) { GLOWL_MOCK_RECORD(glTextureParameterf); }
+inline void glTextureParameteriv(GLuint, GLenum, GLint const*) { GLOWL_MOCK_RECORD(glTextureParameteriv); }
+inline void glTextureStorage2D(GLuint texture, GLsizei levels, GLenum, GLsizei width, GLsizei height) { GLOWL_MOCK_RECORD(glTextureStorage2D); ::glowl::mock::storeTexture(texture, levels, width, height, 1); }
+inline void glTextureStorage3D(GLuint texture, GLsizei levels, GLenum, GLsizei width, GLsizei height, GLsizei depth) { GLOWL_MOCK_RECORD(glTextureStorage3D); ::glowl::mock::storeTexture(texture, levels, width, height, depth); }
+inline void glTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, void const*) { GLOWL_MOCK_RECORD(glTextureSubImage2D); }
+inline void glPixelStorei(GLenum, GLint) { GLOWL_MOCK_RECORD(glPixelStorei); }
+inline void glTextureSubImage3D(GLuint, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei, GLenum, GLenum, void const*) { GLOWL_MOCK_RECORD(glTextureSubImage3D); }
+inline void glCompressedTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei, void const*) { GLOWL_MOCK_RECORD(glCompressedTextureSubImage2D); }
+inline void glCompressedTextureSubImage3D(GLuint, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei, GLenum, GLsizei, void const*) { GLOWL_MOCK_RECORD(glCompressedTextureSubImage3D); }
+inline void glGetTextureImage(GLuint, GLint, GLenum, GLenum, GLsizei size, void* pixels)
+{
+    GLOWL_MOCK_RECORD(glGetTextureImage);
+    std::memset(pixels, 0, static_cast<size_t>(size));
+}
+inline void glGetTextureSubImage(GLuint, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei, GLenum, GLenum, GLsizei size, void* pixels)
+{
+    GLOWL_MOCK_RECORD(glGetTextureSubImage);
+    std::memset(pixels, 0, static_cast<size_t>(size));
+}
+inline void glGetCompressedTextureImage(GLuint, GLint, GLsizei size, void* pixels)
+{
+    GLOWL_MOCK_RECORD(glGetCompressedTextureImage);
+    std::memset(pixels, 0, static_cast<size_t>(size));
+}
+inline void glTextureView(GLuint texture, GLenum target, GLuint origtexture, GLenum, GLuint minlevel, GLuint numlevels, GLuint, GLuint numlayers)
+{
+    GLOWL_MOCK_RECORD(glTextureView);
+    auto& textures = ::glowl::mock::Recorder::get().textures();
+    auto  source = textures[origtexture];
+    textures[texture] = {target, static_cast<GLsizei>(numlevels), std::max(1, source.width >> minlevel), std::max(1, source.height >> minlevel), target == GL_TEXTURE_3D ? std::max(1, source.depth >> minlevel) : static_cast<GLsizei>(numlayers)};
+}
+inline void glGenerateTextureMipmap(GLuint) { GLOWL_MOCK_RECORD(glGenerateTextureMipmap); }
+inline void glClearTexImage(GLuint, GLint, GLenum, GLenum, void const*) { GLOWL_MOCK_RECORD(glClearTexImage); }
+inline void glCopyImageSubData(GLuint, GLenum, GLint, GLint, GLint, GLint, GLuint, GLenum, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei) { GLOWL_MOCK_RECORD(glCopyImageSubData); }
+inline void glGetTexLevelParameteriv(GLenum target, GLint level, GLenum pname, GLint* params) { GLOWL_MOCK_RECORD(glGetTexLevelParameteriv); ::glowl::mock::getTextureLevelParameter(::glowl::mock::Recorder::get().boundTextures()[target], level, pname, params); }
+inline void glGetTextureLevelParameteriv(GLuint texture, GLint level, GLenum pname, GLint* params) { GLOWL_MOCK_RECORD(glGetTextureLevelParameteriv); ::glowl::mock::getTextureLevelParameter(texture, level, pname, params); }
+inline void glBindImageTexture(GLuint, GLuint, GLint, GLboolean, GLint, GLenum, GLenum) { GLOWL_MOCK_RECORD(glBindImageTexture); }
+inline GLuint64 glGetTextureHandleARB(GLuint texture) { GLOWL_MOCK_RECORD(glGetTextureHandleARB); return static_cast<GLuint64>(texture) << 32; }
+inline GLuint64 glGetImageHandleARB(GLuint texture, GLint level, GLboolean, GLint layer, GLenum) { GLOWL_MOCK_RECORD(glGetImageHandleARB); return (static_cast<GLuint64>(texture) << 32) | (static_cast<GLuint64>(level) << 16) | static_cast<GLuint64>(layer); }
+inline void glMakeTextureHandleResidentARB(GLuint64) { GLOWL_MOCK_RECORD(glMakeTextureHandleResidentARB); }
+inline void glMakeTextureHandleNonResidentARB(GLuint64) { GLOWL_MOCK_RECORD(glMakeTextureHandleNonResidentARB); }
+
+// Samplers
+inline void glCreateSamplers(GLsizei n, GLuint* samplers) { GLOWL_MOCK_RECORD(glCreateSamplers); ::glowl::mock::createNames(n, samplers); }
+inline void glDeleteSamplers(GLsizei, GLuint const*) { GLOWL_MOCK_RECORD(glDeleteSamplers); }
+inline void glBindSampler(GLuint, GLuint) { GLOWL_MOCK_RECORD(glBindSampler); }
+inline void glSamplerParameteri(GLuint, GLenum, GLint) { GLOWL_MOCK_RECORD(glSamplerParameteri); }
+inline void glSamplerParameterf(GLuint, GLenum, GLfloat) { GLOWL_MOCK_RECORD(glSamplerParameterf); }
+inline void glSamplerParameterfv(GLuint, GLenum, GLfloat const*) { GLOWL_MOCK_RECORD(glSamplerParameterfv); }
+
+// Vertex arrays and drawing
+inline void glCreateVertexArrays(GLsizei n, GLuint* arrays) { GLOWL_MOCK_RECORD(glCreateVertexArrays); ::glowl::mock::createNames(n, arrays); }
+inline void glDeleteVertexArrays(GLsizei, GLuint const*) { GLOWL_MOCK_RECORD(glDeleteVertexArrays); }
+inline void glBindVertexArray(GLuint) { GLOWL_MOCK_RECORD(glBindVertexArray); }
+inline void glVertexArrayVertexBuffer(GLuint, GLuint, GLuint, GLintptr, GLsizei) { GLOWL_MOCK_RECORD(glVertexArrayVertexBuffer); }
+inline void glVertexArrayElementBuffer(GLuint, GLuint) { GLOWL_MOCK_RECORD(glVertexArrayElementBuffer); }
+inline void glEnableVertexArrayAttrib(GLuint, GLuint) { GLOWL_MOCK_RECORD(glEnableVertexArrayAttrib); }
+inline void glVertexArrayAttribFormat(GLuint, GLuint, GLint, GLenum, GLboolean, GLuint) { GLOWL_MOCK_RECORD(glVertexArrayAttribFormat); }
+inline void glVertexArrayAttribIFormat(GLuint, GLuint, GLint, GLenum, GLuint) { GLOWL_MOCK_RECORD(glVertexArrayAttribIFormat); }
+inline void glVertexArrayAttribLFormat(GLuint, GLuint, GLint, GLenum, GLuint) { GLOWL_MOCK_RECORD(glVertexArrayAttribLFormat); }
+inline void glVertexArrayAttribBinding(GLuint, GLuint, GLuint) { GLOWL_MOCK_RECORD(glVertexArrayAttribBinding); }
+inline void glDrawArrays(GLenum, GLint, GLsizei) { GLOWL_MOCK_RECORD(glDrawArrays); }
+inline void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, void const* indices, GLsizei instancecount)
+{
+    GLOWL_MOCK_RECORD(glDrawElementsInstanced);
+    ::glowl::mock::Recorder::get().recordDrawElements(
+        {mode, count, type, reinterpret_cast<std::uintptr_t>(indices), instancecount, 0});
+}
+inline void glDrawElementsInstancedBaseVertex(
+    GLenum mode, GLsizei count, GLenum type, void const* indices, GLsizei instancecount, GLint basevertex)
+{
+    GLOWL_MOCK_RECORD(glDrawElementsInstancedBaseVertex);
+    ::glowl::mock::Recorder::get().recordDrawElements(
+        {mode, count, type, reinterpret_cast<std::uintptr_t>(indices), instancecount, basevertex});
+}
+inline void glMultiDrawElementsIndirect(GLenum, GLenum, void const*, GLsizei, GLsizei)
+{
+    GLOWL_MOCK_RECORD(glMultiDrawElementsIndirect);
+}
+
+// Render state
+inline void glEnable(GLenum) { GLOWL_MOCK_RECORD(glEnable); }
+inline void glDisable(GLenum) { GLOWL_MOCK_RECORD(glDisable); }
+inline void glScissor(GLint, GLint, GLsizei, GLsizei) { GLOWL_MOCK_RECORD(glScissor); }
+inline void glBlendFuncSeparate(GLenum, GLenum, GLenum, GLenum) { GLOWL_MOCK_RECORD(glBlendFuncSeparate); }
+inline void glBlendEquationSeparate(GLenum, GLenum) { GLOWL_MOCK_RECORD(glBlendEquationSeparate); }
+inline void glBlendColor(GLfloat, GLfloat, GLfloat, GLfloat) { GLOWL_MOCK_RECORD(glBlendColor); }
+inline void glColorMask(GLboolean, GLboolean, GLboolean, GLboolean) { GLOWL_MOCK_RECORD(glColorMask); }
+inline void glDepthFunc(GLenum) { GLOWL_MOCK_RECORD(glDepthFunc); }
+inline void glDepthMask(GLboolean) { GLOWL_MOCK_RECORD(glDepthMask); }
+inline void glDepthRangef(GLfloat, GLfloat) { GLOWL_MOCK_RECORD(glDepthRangef); }
+inline void glStencilFuncSeparate(GLenum, GLenum, GLint, GLuint) { GLOWL_MOCK_RECORD(glStencilFuncSeparate); }
+inline void glStencilOpSeparate(GLenum, GLenum, GLenum, GLenum) { GLOWL_MOCK_RECORD(glStencilOpSeparate); }
+inline void glStencilMaskSeparate(GLenum, GLuint) { GLOWL_MOCK_RECORD(glStencilMaskSeparate); }
+inline void glCullFace(GLenum) { GLOWL_MOCK_RECORD(glCullFace); }
+inline void glFrontFace(GLenum) { GLOWL_MOCK_RECORD(glFrontFace); }
+inline void glPolygonMode(GLenum, GLenum) { GLOWL_MOCK_RECORD(glPolygonMode); }
+inline void glPolygonOffset(GLfloat, GLfloat) { GLOWL_MOCK_RECORD(glPolygonOffset); }
+
+// Framebuffers
+inline void glCreateFramebuffers(GLsizei n, GLuint* framebuffers) { GLOWL_MOCK_RECORD(glCreateFramebuffers); ::glowl::mock::createNames(n, framebuffers); }
+inline void glDeleteFramebuffers(GLsizei, GLuint const*) { GLOWL_MOCK_RECORD(glDeleteFramebuffers); }
+inline void glBindFramebuffer(GLenum, GLuint) { GLOWL_MOCK_RECORD(glBindFramebuffer); }
+inline void glNamedFramebufferTexture(GLuint, GLenum, GLuint, GLint) { GLOWL_MOCK_RECORD(glNamedFramebufferTexture); }
+inline GLenum glCheckNamedFramebufferStatus(GLuint, GLenum) { GLOWL_MOCK_RECORD(glCheckNamedFramebufferStatus); return GL_FRAMEBUFFER_COMPLETE; }
+inline void glViewport(GLint, GLint, GLsizei, GLsizei) { GLOWL_MOCK_RECORD(glViewport); }
+inline void glClearBufferfv(GLenum, GLint, GLfloat const*) { GLOWL_MOCK_RECORD(glClearBufferfv); }
+inline void glDrawBuffers(GLsizei, GLenum const*) { GLOWL_MOCK_RECORD(glDrawBuffers); }
+inline void glReadBuffer(GLenum) { GLOWL_MOCK_RECORD(glReadBuffer); }
+
+// Shaders and programs
+inline GLuint glCreateProgram() { GLOWL_MOCK_RECORD(glCreateProgram); return ::glowl::mock::Recorder::get().createName(); }
+inline void glDeleteProgram(GLuint) { GLOWL_MOCK_RECORD(glDeleteProgram); }
+inline GLuint glCreateShader(GLenum) { GLOWL_MOCK_RECORD(glCreateShader); return ::glowl::mock::Recorder::get().createName(); }
+inline void glDeleteShader(GLuint) { GLOWL_MOCK_RECORD(glDeleteShader); }
+inline void glShaderSource(GLuint, GLsizei, GLchar const* const*, GLint const*) { GLOWL_MOCK_RECORD(glShaderSource); }
+inline void glCompileShader(GLuint) { GLOWL_MOCK_RECORD(glCompileShader); }
+inline void glGetShaderiv(GLuint, GLenum pname, GLint* params) { GLOWL_MOCK_RECORD(glGetShaderiv); *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0; }
+inline void glGetShaderInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* info_log) { GLOWL_MOCK_RECORD(glGetShaderInfoLog); if (length) { *length = 0; } if (info_log) { *info_log = 0; } }
+inline void glAttachShader(GLuint, GLuint) { GLOWL_MOCK_RECORD(glAttachShader); }
+inline void glLinkProgram(GLuint) { GLOWL_MOCK_RECORD(glLinkProgram); }
+inline void glGetProgramiv(GLuint, GLenum pname, GLint* params) { GLOWL_MOCK_RECORD(glGetProgramiv); *params = pname == GL_LINK_STATUS ? GL_TRUE : 0; }
+inline void glGetProgramInfoLog(GLuint, GLsizei, GLsizei* length, GLchar* info_log) { GLOWL_MOCK_RECORD(glGetProgramInfoLog); if (length) { *length = 0; } if (info_log) { *info_log = 0; } }
+inline void glUseProgram(GLuint) { GLOWL_MOCK_RECORD(glUseProgram); }
+inline void glDispatchCompute(GLuint, GLuint, GLuint) { GLOWL_MOCK_RECORD(glDispatchCompute); }
+inline void glBindAttribLocation(GLuint, GLuint, GLchar const*) { GLOWL_MOCK_RECORD(glBindAttribLocation); }
+inline void glBindFragDataLocation(GLuint, GLuint, GLchar const*) { GLOWL_MOCK_RECORD(glBindFragDataLocation); }
+inline GLint glGetUniformLocation(GLuint program, GLchar const* name)
+{
+    GLOWL_MOCK_RECORD(glGetUniformLocation);
+    auto& locations = ::glowl::mock::Recorder::get().uniformLocations();
+    auto  location = locations.emplace(std::make_pair(program, std::string(name)), static_cast<GLint>(locations.size()));
+    return location.first->second;
+}
+inline GLint glGetAttribLocation(GLuint, GLchar const*) { GLOWL_MOCK_RECORD(glGetAttribLocation); return -1; }
+inline void glGetActiveUniform(GLuint, GLuint, GLsizei, GLsizei* length, GLint*, GLenum*, GLchar* name) { GLOWL_MOCK_RECORD(glGetActiveUniform); if (length) { *length = 0; } if (name) { *name = 0; } }
+inline void glGetActiveAttrib(GLuint, GLuint, GLsizei, GLsizei* length, GLint*, GLenum*, GLchar* name) { GLOWL_MOCK_RECORD(glGetActiveAttrib); if (length) { *length = 0; } if (name) { *name = 0; } }
+
+// Uniforms
+inline void glUniform1f(GLint, GLfloat) { GLOWL_MOCK_RECORD(glUniform1f); }
+inline void glUniform2f(GLint, GLfloat, GLfloat) { GLOWL_MOCK_RECORD(glUniform2f); }
+inline void glUniform3f(GLint, GLfloat, GLfloat, GLfloat) { GLOWL_MOCK_RECORD(glUniform3f); }
+inline void glUniform4f(GLint, GLfloat, GLfloat, GLfloat, GLfloat) { GLOWL_MOCK_RECORD(glUniform4f); }
+inline void glUniform1i(GLint, GLint) { GLOWL_MOCK_RECORD(glUniform1i); }
+inline void glUniform2i(GLint, GLint, GLint) { GLOWL_MOCK_RECORD(glUniform2i); }
+inline void glUniform3i(GLint, GLint, GLint, GLint) { GLOWL_MOCK_RECORD(glUniform3i); }
+inline void glUniform4i(GLint, GLint, GLint, GLint, GLint) { GLOWL_MOCK_RECORD(glUniform4i); }
+inline void glUniform1ui(GLint, GLuint) { GLOWL_MOCK_RECORD(glUniform1ui); }
+inline void glUniform2ui(GLint, GLuint, GLuint) { GLOWL_MOCK_RECORD(glUniform2ui); }
+inline void glUniform3ui(GLint, GLuint, GLuint, GLuint) { GLOWL_MOCK_RECORD(glUniform3ui); }
+inline void glUniform4ui(GLint, GLuint, GLuint, GLuint, GLuint) { GLOWL_MOCK_RECORD(glUniform4ui); }
+inline void glUniform2fv(GLint, GLsizei, GLfloat const*) { GLOWL_MOCK_RECORD(glUniform2fv); }
+inline void glUniform3fv(GLint, GLsizei, GLfloat const*) { GLOWL_MOCK_RECORD(glUniform3fv); }
+inline void glUniform4fv(GLint, GLsizei, GLfloat const*) { GLOWL_MOCK_RECORD(glUniform4fv); }
+inline void glUniform2iv(GLint, GLsizei, GLint const*) { GLOWL_MOCK_RECORD(glUniform2iv); }
+inline void glUniform3iv(GLint, GLsizei, GLint const*) { GLOWL_MOCK_RECORD(glUniform3iv); }
+inline void glUniform4iv(GLint, GLsizei, GLint const*) { GLOWL_MOCK_RECORD(glUniform4iv); }
+inline void glUniformMatrix2fv(GLint, GLsizei, GLboolean, GLfloat const*) { GLOWL_MOCK_RECORD(glUniformMatrix2fv); }
+inline void glUniformMatrix3fv(GLint, GLsizei, GLboolean, GLfloat const*) { GLOWL_MOCK_RECORD(glUniformMatrix3fv); }
+inline void glUniformMatrix4fv(GLint, GLsizei, GLboolean, GLfloat const*) { GLOWL_MOCK_RECORD(glUniformMatrix4fv); }
+
+// clang-format on
+
+#endif // GLOWL_GLMOCK_H
@@ -2,14 +2,17 @@
 #define GLOWL_GLOWL_H
 
 #include "BufferObject.hpp"
+#include "Context.hpp"
 #include "FramebufferObject.hpp"
 #include "GLSLProgram.hpp"
 #include "Mesh.hpp"
+#include "NamePool.hpp"
 #include "Texture.hpp"
 #include "Texture2D.hpp"
 #include "Texture2DArray.hpp"
 #include "Texture3D.hpp"
 #include "TextureCubemapArray.hpp"
+#include "Trace.hpp"
 #include "VertexLayout.hpp"
 
 #endif // GLOWL_GLOWL_H
@@ -0,0 +1,60 @@
+/*
+ * TestUtils.hpp
+ *
+ * MIT License
+ */
+
+#ifndef GLOWL_TESTS_TESTUTILS_HPP
+#define GLOWL_TESTS_TESTUTILS_HPP
+
+#include <cstdio>
+#include <cstring>
+
+#include <glowl/glowl.h>
+
+namespace glowl
+{
+    namespace test
+    {
+
+        inline int& failureCount()
+        {
+            static int failure_cnt = 0;
+            return failure_cnt;
+        }
+
+        /**
+         * \brief Number of recorded draw calls of any kind (glDraw*, glMultiDraw*).
+         */
+        inline size_t drawCallCount()
+        {
+            size_t draw_cnt = 0;
+            for (char const* call : mock::Recorder::get().getCalls())
+            {
+                if (std::strncmp(call, "glDraw", 6) == 0 || std::strncmp(call, "glMultiDraw", 11) == 0)
+                {
+                    ++draw_cnt;
+                }
+            }
+            return draw_cnt;
+        }
+
+    } // namespace test
+} // namespace glowl
+
+/**
+ * Reports a failed condition and continues, main returns the failure count via GLOWL_TEST_RESULT.
+ */
+#define GLOWL_CHECK(condition)                                                                                         \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                                 \
+            ++::glowl::test::failureCount();                                                                           \
+        }                                                                                                              \
+    } while (false)
+
+#define GLOWL_TEST_RESULT() (::glowl::test::failureCount() == 0 ? 0 : 1)
+
+#endif // GLOWL_TESTS_TESTUTILS_HPP
@@ -0,0 +1,179 @@
+/*
+ * clipmap_regions.cpp
+ *
+ * MIT License
+ */
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <glowl/Clipmap.hpp>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    typedef std::pair<std::int64_t, std::int64_t> Texel;
+
+    struct Region
+    {
+        std::int64_t x;
+        std::int64_t y;
+        GLsizei      width;
+        GLsizei      height;
+    };
+
+    GLsizei const window_size = 8;
+
+    std::vector<Region> g_loaded;
+
+    std::unique_ptr<Clipmap> createClipmap()
+    {
+        TextureLayout layout(GL_R8, window_size, window_size, 2, GL_RED, GL_UNSIGNED_BYTE, 1);
+        return std::make_unique<Clipmap>(
+            "clipmap", layout, [](unsigned int, std::int64_t x, std::int64_t y, GLsizei w, GLsizei h, void*) {
+                g_loaded.push_back({x, y, w, h});
+            });
+    }
+
+    std::set<Texel> window(std::int64_t x, std::int64_t y)
+    {
+        std::set<Texel> texels;
+        for (std::int64_t j = 0; j < window_size; ++j)
+        {
+            for (std::int64_t i = 0; i < window_size; ++i)
+            {
+                texels.insert({x + i, y + j});
+            }
+        }
+        return texels;
+    }
+
+    /** Checks that the loaded regions cover exactly the texels of the new window that the old window lacked */
+    void checkExposedRegion(std::set<Texel> const& old_window, std::set<Texel> const& new_window)
+    {
+        std::set<Texel> loaded;
+        size_t          loaded_cnt = 0;
+        for (auto const& region : g_loaded)
+        {
+            for (std::int64_t j = 0; j < region.height; ++j)
+            {
+                for (std::int64_t i = 0; i < region.width; ++i)
+                {
+                    loaded.insert({region.x + i, region.y + j});
+                    ++loaded_cnt;
+                }
+            }
+        }
+
+        std::set<Texel> exposed;
+        for (auto const& texel : new_window)
+        {
+            if (old_window.count(texel) == 0)
+            {
+                exposed.insert(texel);
+            }
+        }
+
+        GLOWL_CHECK(loaded == exposed);
+        GLOWL_CHECK(loaded_cnt == exposed.size()); // no texel is loaded twice
+    }
+
+    void fullUploadIsSplitAtBorders()
+    {
+        mock::Recorder::get().reset();
+        g_loaded.clear();
+
+        auto clipmap = createClipmap();
+
+        mock::Recorder::get().clearCalls();
+        clipmap->setOrigin(0, 3, -5);
+
+        checkExposedRegion({}, window(3, -5));
+        GLOWL_CHECK(g_loaded.size() == 4);
+        GLOWL_CHECK(mock::Recorder::get().getCallCount("glTextureSubImage3D") == 4);
+        GLOWL_CHECK(clipmap->getUploadedTexelCount() == window_size * window_size);
+
+        // an aligned window is a single upload
+        g_loaded.clear();
+        clipmap->setOrigin(1, 16, 8);
+        GLOWL_CHECK(g_loaded.size() == 1);
+    }
+
+    void movesUploadExposedTexelsOnly()
+    {
+        mock::Recorder::get().reset();
+        g_loaded.clear();
+
+        auto clipmap = createClipmap();
+        clipmap->setOrigin(0, 0, 0);
+
+        std::int64_t const moves[][2] = {{3, -2}, {-1, 5}, {0, 1}, {-7, 0}, {2, 2}};
+        std::int64_t       x = 0;
+        std::int64_t       y = 0;
+        for (auto const& move : moves)
+        {
+            g_loaded.clear();
+            auto old_window = window(x, y);
+            x += move[0];
+            y += move[1];
+            clipmap->setOrigin(0, x, y);
+            checkExposedRegion(old_window, window(x, y));
+            GLOWL_CHECK(clipmap->getOriginX(0) == x && clipmap->getOriginY(0) == y);
+        }
+
+        // unchanged origin, nothing to upload
+        g_loaded.clear();
+        clipmap->setOrigin(0, x, y);
+        GLOWL_CHECK(g_loaded.empty());
+
+        // jumps beyond the window size reload the whole window
+        g_loaded.clear();
+        clipmap->setOrigin(0, x + 100, y);
+        checkExposedRegion({}, window(x + 100, y));
+
+        // invalidated levels are reloaded completely
+        g_loaded.clear();
+        clipmap->invalidate();
+        clipmap->setOrigin(0, x + 101, y);
+        checkExposedRegion({}, window(x + 101, y));
+    }
+
+    void shaderOffsetsOfLargeOrigins()
+    {
+        mock::Recorder::get().reset();
+        g_loaded.clear();
+
+        auto clipmap = createClipmap();
+
+        std::int64_t const x = (std::int64_t(1) << 40) + (std::int64_t(1) << 31) + 5;
+        std::int64_t const y = -(std::int64_t(1) << 36) - 3;
+        clipmap->setOrigin(1, x, y);
+
+        auto const&  offsets = clipmap->getShaderOffsets();
+        std::int64_t period_x = clipmap->getShaderPeriodX();
+        std::int64_t period_y = clipmap->getShaderPeriodY();
+
+        GLOWL_CHECK(period_x % window_size == 0 && period_y % window_size == 0);
+        GLOWL_CHECK(offsets[4] == 5);
+        GLOWL_CHECK(offsets[5] == window_size - 3);
+        GLOWL_CHECK(offsets[6] >= 0 && offsets[6] < period_x && (x - offsets[6]) % period_x == 0);
+        GLOWL_CHECK(offsets[7] >= 0 && offsets[7] < period_y && (y - offsets[7]) % period_y == 0);
+        GLOWL_CHECK(offsets[6] % window_size == offsets[4]);
+        GLOWL_CHECK(offsets[7] % window_size == offsets[5]);
+    }
+} // namespace
+
+int main()
+{
+    fullUploadIsSplitAtBorders();
+    movesUploadExposedTexelsOnly();
+    shaderOffsetsOfLargeOrigins();
+
+    return GLOWL_TEST_RESULT();
+}
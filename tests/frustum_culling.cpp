@@ -0,0 +1,299 @@
+/*
+ * frustum_culling.cpp
+ *
+ * MIT License
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <glowl/Bounds.hpp>
+#include <glowl/FrustumCuller.hpp>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    /** Distances closer to a plane than this may be classified either way by the SIMD and the scalar path */
+    float const plane_epsilon = 1.0e-4f;
+
+    Bounds referenceBounds(std::vector<float> const& data, size_t stride, size_t offset, int components)
+    {
+        Bounds       bounds;
+        size_t const float_stride = stride / sizeof(float);
+        size_t const first = offset / sizeof(float);
+        size_t const vertex_cnt = data.size() / float_stride;
+
+        for (size_t i = 0; i < vertex_cnt; ++i)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                float v = k < components ? data[i * float_stride + first + k] : 0.0f;
+                bounds.min[k] = std::min(bounds.min[k], v);
+                bounds.max[k] = std::max(bounds.max[k], v);
+            }
+        }
+
+        double max_sq_dist = 0.0;
+        for (size_t i = 0; i < vertex_cnt; ++i)
+        {
+            double sq_dist = 0.0;
+            for (int k = 0; k < 3; ++k)
+            {
+                double v = k < components ? data[i * float_stride + first + k] : 0.0;
+                double d = v - 0.5 * (double(bounds.min[k]) + double(bounds.max[k]));
+                sq_dist += d * d;
+            }
+            max_sq_dist = std::max(max_sq_dist, sq_dist);
+        }
+        bounds.radius = static_cast<float>(std::sqrt(max_sq_dist));
+
+        return bounds;
+    }
+
+    void boundsMatchScalarReference()
+    {
+        std::mt19937                          rng(7);
+        std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+
+        int const    components[] = {2, 3, 4};
+        size_t const vertex_cnts[] = {1, 2, 3, 5, 17, 1000};
+        size_t const paddings[] = {0, 4, 8}; // bytes behind the position
+
+        for (int component_cnt : components)
+        {
+            for (size_t vertex_cnt : vertex_cnts)
+            {
+                for (size_t padding : paddings)
+                {
+                    for (size_t offset : {size_t(0), size_t(4)})
+                    {
+                        size_t             stride = offset + component_cnt * sizeof(float) + padding;
+                        std::vector<float> data(vertex_cnt * stride / sizeof(float));
+                        for (auto& v : data)
+                        {
+                            v = value(rng);
+                        }
+
+                        Bounds bounds = computeBounds(
+                            data.data(), data.size() * sizeof(float), stride, offset, component_cnt);
+                        Bounds reference = referenceBounds(data, stride, offset, component_cnt);
+
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            GLOWL_CHECK(bounds.min[k] == reference.min[k]);
+                            GLOWL_CHECK(bounds.max[k] == reference.max[k]);
+                            GLOWL_CHECK(bounds.center[k] == 0.5f * (reference.min[k] + reference.max[k]));
+                        }
+                        GLOWL_CHECK(std::abs(bounds.radius - reference.radius) <= 1.0e-5f * reference.radius);
+                    }
+                }
+            }
+        }
+
+        GLOWL_CHECK(computeBounds(nullptr, 0, 12, 0, 3).isEmpty());
+        float const single[] = {1.0f, 2.0f, 3.0f};
+        GLOWL_CHECK(!computeBounds(single, sizeof(single), sizeof(single), 0, 3).isEmpty());
+        GLOWL_CHECK(computeBounds(single, sizeof(single), sizeof(single), 0, 3).radius == 0.0f);
+    }
+
+    /** Column-major perspective projection (as glm::perspective) times a view translated by (tx, ty, tz) */
+    void viewProjection(float tx, float ty, float tz, float* m)
+    {
+        float const f = 1.0f / std::tan(0.5f * 1.0f);
+        float const aspect = 1.5f;
+        float const near_plane = 0.5f;
+        float const far_plane = 200.0f;
+
+        std::fill(m, m + 16, 0.0f);
+        m[0] = f / aspect;
+        m[5] = f;
+        m[10] = -(far_plane + near_plane) / (far_plane - near_plane);
+        m[11] = -1.0f;
+        m[14] = -2.0f * far_plane * near_plane / (far_plane - near_plane);
+
+        // projection * translation only changes the last column
+        for (int r = 0; r < 4; ++r)
+        {
+            m[12 + r] += m[r] * tx + m[4 + r] * ty + m[8 + r] * tz;
+        }
+    }
+
+    /** Plane distances as the culler computes them, the object is undecided if one is within the epsilon */
+    bool referenceVisible(float const (*planes)[4], float const* point, float radius, bool& undecided)
+    {
+        bool inside = true;
+        undecided = false;
+        for (int p = 0; p < 6; ++p)
+        {
+            float d = planes[p][0] * point[0] + planes[p][1] * point[1] + planes[p][2] * point[2] +
+                      (planes[p][3] + radius);
+            inside &= d >= 0.0f;
+            undecided |= std::abs(d) < plane_epsilon;
+        }
+        return inside;
+    }
+
+    /** Extracts normalized planes like FrustumCuller::setFrustum, in double precision */
+    void referencePlanes(float const* m, float (*planes)[4])
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            int    axis = i / 2;
+            double sign = (i % 2 == 0) ? 1.0 : -1.0;
+            double plane[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                plane[c] = double(m[c * 4 + 3]) + sign * double(m[c * 4 + axis]);
+            }
+            double length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            for (int c = 0; c < 4; ++c)
+            {
+                planes[i][c] = static_cast<float>(plane[c] / length);
+            }
+        }
+    }
+
+    void cullerMatchesScalarReference()
+    {
+        std::mt19937                          rng(11);
+        std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+        std::uniform_real_distribution<float> extent(0.0f, 5.0f);
+
+        // more than one chunk of the culler, so that the workers take part
+        size_t const cnt = 50003;
+
+        std::vector<float> x(cnt), y(cnt), z(cnt), radius(cnt);
+        std::vector<float> min_x(cnt), min_y(cnt), min_z(cnt), max_x(cnt), max_y(cnt), max_z(cnt);
+        for (size_t i = 0; i < cnt; ++i)
+        {
+            x[i] = position(rng);
+            y[i] = position(rng);
+            z[i] = position(rng);
+            radius[i] = extent(rng);
+
+            min_x[i] = x[i] - extent(rng);
+            min_y[i] = y[i] - extent(rng);
+            min_z[i] = z[i] - extent(rng);
+            max_x[i] = x[i] + extent(rng);
+            max_y[i] = y[i] + extent(rng);
+            max_z[i] = z[i] + extent(rng);
+        }
+
+        float view_projection[16];
+        viewProjection(3.0f, -2.0f, -20.0f, view_projection);
+
+        float planes[6][4];
+        referencePlanes(view_projection, planes);
+
+        for (unsigned int thread_cnt : {1u, 3u})
+        {
+            FrustumCuller culler(thread_cnt);
+            culler.setFrustum(view_projection);
+
+            std::vector<std::uint8_t> visible(cnt, 2);
+
+            // sphere culling with planes from the matrix, undecided spheres are skipped
+            size_t visible_cnt = culler.cullSpheres(x.data(), y.data(), z.data(), radius.data(), cnt, visible.data());
+            size_t reference_cnt = 0;
+            size_t undecided_cnt = 0;
+            size_t mismatch_cnt = 0;
+            size_t returned_cnt = 0;
+            for (size_t i = 0; i < cnt; ++i)
+            {
+                float const point[] = {x[i], y[i], z[i]};
+                bool        undecided = false;
+                bool        inside = referenceVisible(planes, point, radius[i], undecided);
+                GLOWL_CHECK(visible[i] == 0 || visible[i] == 1);
+                returned_cnt += visible[i];
+                reference_cnt += inside ? 1 : 0;
+                undecided_cnt += undecided ? 1 : 0;
+                mismatch_cnt += !undecided && (visible[i] == 1) != inside ? 1 : 0;
+            }
+            GLOWL_CHECK(mismatch_cnt == 0);
+            GLOWL_CHECK(visible_cnt == returned_cnt);
+            GLOWL_CHECK(reference_cnt > 0 && reference_cnt < cnt);
+            GLOWL_CHECK(visible_cnt + undecided_cnt >= reference_cnt && visible_cnt <= reference_cnt + undecided_cnt);
+
+            // with the culler's own planes the results have to match exactly
+            culler.setPlanes(planes);
+            visible.assign(cnt, 2);
+            visible_cnt = culler.cullSpheres(x.data(), y.data(), z.data(), radius.data(), cnt, visible.data());
+            reference_cnt = 0;
+            mismatch_cnt = 0;
+            for (size_t i = 0; i < cnt; ++i)
+            {
+                float const point[] = {x[i], y[i], z[i]};
+                bool        undecided = false;
+                bool        inside = referenceVisible(planes, point, radius[i], undecided);
+                reference_cnt += inside ? 1 : 0;
+                mismatch_cnt += (visible[i] == 1) != inside ? 1 : 0;
+            }
+            GLOWL_CHECK(mismatch_cnt == 0);
+            GLOWL_CHECK(visible_cnt == reference_cnt);
+
+            // boxes, the corner furthest along each plane normal decides
+            visible.assign(cnt, 2);
+            visible_cnt = culler.cullBoxes(min_x.data(),
+                                           min_y.data(),
+                                           min_z.data(),
+                                           max_x.data(),
+                                           max_y.data(),
+                                           max_z.data(),
+                                           cnt,
+                                           visible.data());
+            reference_cnt = 0;
+            mismatch_cnt = 0;
+            for (size_t i = 0; i < cnt; ++i)
+            {
+                bool inside = true;
+                for (int p = 0; p < 6; ++p)
+                {
+                    float d = planes[p][0] * (planes[p][0] >= 0.0f ? max_x[i] : min_x[i]) +
+                              planes[p][1] * (planes[p][1] >= 0.0f ? max_y[i] : min_y[i]) +
+                              planes[p][2] * (planes[p][2] >= 0.0f ? max_z[i] : min_z[i]) + planes[p][3];
+                    inside &= d >= 0.0f;
+                }
+                reference_cnt += inside ? 1 : 0;
+                mismatch_cnt += (visible[i] == 1) != inside ? 1 : 0;
+            }
+            GLOWL_CHECK(mismatch_cnt == 0);
+            GLOWL_CHECK(visible_cnt == reference_cnt);
+
+            // a box is culled no earlier than its bounding sphere
+            std::vector<std::uint8_t> box_visible = visible;
+            std::vector<float>        box_radius(cnt);
+            std::vector<float>        cx(cnt), cy(cnt), cz(cnt);
+            for (size_t i = 0; i < cnt; ++i)
+            {
+                cx[i] = 0.5f * (min_x[i] + max_x[i]);
+                cy[i] = 0.5f * (min_y[i] + max_y[i]);
+                cz[i] = 0.5f * (min_z[i] + max_z[i]);
+                float dx = max_x[i] - cx[i];
+                float dy = max_y[i] - cy[i];
+                float dz = max_z[i] - cz[i];
+                box_radius[i] = std::sqrt(dx * dx + dy * dy + dz * dz) * (1.0f + 1.0e-5f);
+            }
+            culler.cullSpheres(cx.data(), cy.data(), cz.data(), box_radius.data(), cnt, visible.data());
+            mismatch_cnt = 0;
+            for (size_t i = 0; i < cnt; ++i)
+            {
+                mismatch_cnt += box_visible[i] == 1 && visible[i] == 0 ? 1 : 0;
+            }
+            GLOWL_CHECK(mismatch_cnt == 0);
+        }
+    }
+} // namespace
+
+int main()
+{
+    boundsMatchScalarReference();
+    cullerMatchesScalarReference();
+
+    return GLOWL_TEST_RESULT();
+}
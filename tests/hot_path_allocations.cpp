@@ -0,0 +1,91 @@
+/*
+ * hot_path_allocations.cpp
+ *
+ * MIT License
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <glowl/AllocationCounter.hpp>
+
+#include "TestUtils.hpp"
+
+GLOWL_DEFINE_ALLOCATION_COUNTER;
+
+using namespace glowl;
+
+namespace
+{
+    /**
+     * Checks that the statement does not allocate, allocations of the mock OpenGL calls are not counted.
+     */
+    template<typename Callable>
+    void checkNoAllocation(char const* label, Callable&& callable)
+    {
+        try
+        {
+            debug::expectNoAllocation(label, callable);
+        }
+        catch (AllocationException const& e)
+        {
+            std::printf("%s\n", e.what());
+            ++test::failureCount();
+        }
+    }
+
+    void mesh()
+    {
+        std::vector<float>         positions = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+        std::vector<std::uint32_t> indices = {0, 1, 2};
+        VertexLayout               layout(12, {VertexLayout::Attribute(3, GL_FLOAT, GL_FALSE, 0)});
+
+        Mesh mesh(std::vector<std::vector<float>>{positions}, std::vector<VertexLayout>{layout}, indices);
+        mesh.draw();
+
+        size_t attribute_cnt = 0;
+        checkNoAllocation("Mesh::getVertexLayouts", [&]() {
+            attribute_cnt = mesh.getVertexLayouts().front().attributes.size();
+        });
+        GLOWL_CHECK(attribute_cnt == 1);
+
+        checkNoAllocation("Mesh::draw", [&]() { mesh.draw(); });
+    }
+
+    void framebufferObject()
+    {
+        FramebufferObject fbo("hot_path", 64, 64, FramebufferObject::DEPTH24);
+        fbo.createColorAttachment(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        fbo.createColorAttachment(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+
+        // the first use creates the framebuffer of the context
+        fbo.bind();
+
+        GLsizei width = 0;
+        checkNoAllocation("Texture2D::getTextureLayout", [&]() {
+            width = fbo.getColorAttachment(0)->getTextureLayout().width;
+        });
+        GLOWL_CHECK(width == 64);
+
+        GLenum const draw_buffers[] = {GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT0};
+        checkNoAllocation("FramebufferObject::bind", [&]() { fbo.bind(); });
+        checkNoAllocation("FramebufferObject::bind(initializer_list)", [&]() { fbo.bind({GL_COLOR_ATTACHMENT1}); });
+        checkNoAllocation("FramebufferObject::bind(pointer, count)", [&]() { fbo.bind(draw_buffers, 2); });
+        checkNoAllocation("FramebufferObject::bindToDraw", [&]() { fbo.bindToDraw(); });
+
+        checkNoAllocation("FramebufferObject::resize", [&]() { fbo.resize(128, 96); });
+        GLOWL_CHECK(fbo.getWidth() == 128 && fbo.getHeight() == 96);
+
+        // reattaching the resized textures on the next use does not allocate either
+        checkNoAllocation("FramebufferObject::bind after resize", [&]() { fbo.bind(); });
+    }
+} // namespace
+
+int main()
+{
+    mesh();
+    framebufferObject();
+
+    return GLOWL_TEST_RESULT();
+}
@@ -0,0 +1,230 @@
+/*
+ * mesh_draw_chunks.cpp
+ *
+ * MIT License
+ */
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    typedef std::vector<std::uint32_t> Primitive;
+
+    /** Primitives assembled from count indices starting at first, strip winding relative to the first index */
+    std::vector<Primitive> assemble(GLenum mode, std::vector<std::uint32_t> const& indices, size_t first, size_t count)
+    {
+        std::vector<Primitive> primitives;
+        auto                   at = [&](size_t i) { return indices[first + i]; };
+        switch (mode)
+        {
+        case GL_POINTS:
+            for (size_t i = 0; i < count; ++i)
+            {
+                primitives.push_back({at(i)});
+            }
+            break;
+        case GL_LINES:
+            for (size_t i = 0; i + 1 < count; i += 2)
+            {
+                primitives.push_back({at(i), at(i + 1)});
+            }
+            break;
+        case GL_LINE_STRIP:
+            for (size_t i = 0; i + 1 < count; ++i)
+            {
+                primitives.push_back({at(i), at(i + 1)});
+            }
+            break;
+        case GL_TRIANGLES:
+            for (size_t i = 0; i + 2 < count; i += 3)
+            {
+                primitives.push_back({at(i), at(i + 1), at(i + 2)});
+            }
+            break;
+        case GL_TRIANGLE_STRIP:
+            for (size_t i = 0; i + 2 < count; ++i)
+            {
+                primitives.push_back(i % 2 == 0 ? Primitive{at(i), at(i + 1), at(i + 2)}
+                                                : Primitive{at(i + 1), at(i), at(i + 2)});
+            }
+            break;
+        default:
+            break;
+        }
+        return primitives;
+    }
+
+    /** Primitives of the recorded draw calls, which have to use 32 bit indices */
+    std::vector<Primitive> assembleRecorded(std::vector<std::uint32_t> const& indices)
+    {
+        std::vector<Primitive> primitives;
+        for (auto const& call : mock::Recorder::get().getDrawElementsCalls())
+        {
+            GLOWL_CHECK(call.type == GL_UNSIGNED_INT && call.byte_offset % 4 == 0);
+            auto chunk = assemble(call.mode, indices, call.byte_offset / 4, static_cast<size_t>(call.count));
+            primitives.insert(primitives.end(), chunk.begin(), chunk.end());
+        }
+        return primitives;
+    }
+
+    std::unique_ptr<Mesh> createMesh(GLenum primitive_type, std::vector<std::uint32_t> const& indices)
+    {
+        std::vector<float> positions(indices.size() * 3, 0.0f);
+        VertexLayout       layout(12, {VertexLayout::Attribute(3, GL_FLOAT, GL_FALSE, 0)});
+        return std::make_unique<Mesh>(std::vector<std::vector<float>>{positions},
+                                      std::vector<VertexLayout>{layout},
+                                      indices,
+                                      GL_UNSIGNED_INT,
+                                      primitive_type);
+    }
+
+    std::vector<std::uint32_t> createIndices(size_t index_cnt)
+    {
+        std::vector<std::uint32_t> indices(index_cnt);
+        for (size_t i = 0; i < index_cnt; ++i)
+        {
+            indices[i] = static_cast<std::uint32_t>((i * 7) % index_cnt);
+        }
+        return indices;
+    }
+
+    void chunksMatchSingleDraw()
+    {
+        GLenum const modes[] = {GL_POINTS, GL_LINES, GL_LINE_STRIP, GL_TRIANGLES, GL_TRIANGLE_STRIP};
+        size_t const index_cnts[] = {1, 2, 3, 10, 31, 96, 97, 100};
+        GLsizeiptr const chunk_sizes[] = {3, 4, 5, 7, 8, 16, 1000};
+
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+
+        for (GLenum mode : modes)
+        {
+            for (size_t index_cnt : index_cnts)
+            {
+                auto indices = createIndices(index_cnt);
+                auto mesh = createMesh(mode, indices);
+                auto expected = assemble(mode, indices, 0, index_cnt);
+
+                for (GLsizeiptr chunk_size : chunk_sizes)
+                {
+                    if (mode == GL_TRIANGLE_STRIP && chunk_size < 4 && static_cast<GLsizeiptr>(index_cnt) > chunk_size)
+                    {
+                        continue; // no room besides the repeated vertices, see unsplittableDrawsThrow
+                    }
+
+                    mesh->setDrawChunkSize(chunk_size);
+
+                    recorder.clearCalls();
+                    mesh->draw();
+                    auto const& calls = recorder.getDrawElementsCalls();
+
+                    GLOWL_CHECK(assembleRecorded(indices) == expected);
+                    GLOWL_CHECK(!calls.empty());
+                    for (auto const& call : calls)
+                    {
+                        GLOWL_CHECK(call.count <= chunk_size && call.mode == mode);
+                    }
+                    if (static_cast<GLsizeiptr>(index_cnt) <= chunk_size)
+                    {
+                        GLOWL_CHECK(calls.size() == 1 && calls.front().count == static_cast<GLsizei>(index_cnt));
+                    }
+                    if (mode == GL_TRIANGLE_STRIP)
+                    {
+                        // odd chunk starts would flip the winding
+                        for (auto const& call : calls)
+                        {
+                            GLOWL_CHECK((call.byte_offset / 4) % 2 == 0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void rangesKeepBaseVertexAndInstances()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+
+        auto indices = createIndices(60);
+        auto mesh = createMesh(GL_TRIANGLES, indices);
+        mesh->setDrawChunkSize(10);
+
+        recorder.clearCalls();
+        mesh->drawRange(12, 30, 5, 4);
+        auto const& calls = recorder.getDrawElementsCalls();
+
+        GLOWL_CHECK(calls.size() == 4);
+        GLOWL_CHECK(recorder.getCallCount("glDrawElementsInstancedBaseVertex") == 4);
+        GLOWL_CHECK(recorder.getCallCount("glDrawElementsInstanced") == 0);
+        for (auto const& call : calls)
+        {
+            GLOWL_CHECK(call.base_vertex == 5 && call.instance_cnt == 4);
+        }
+        GLOWL_CHECK(calls.front().byte_offset == 12 * 4);
+        GLOWL_CHECK(assembleRecorded(indices) == assemble(GL_TRIANGLES, indices, 12, 30));
+
+        recorder.clearCalls();
+        mesh->draw(3);
+        GLOWL_CHECK(recorder.getCallCount("glDrawElementsInstanced") == 7); // chunks of 9 indices, whole triangles only
+        for (auto const& call : recorder.getDrawElementsCalls())
+        {
+            GLOWL_CHECK(call.base_vertex == 0 && call.instance_cnt == 3);
+        }
+    }
+
+    void unsplittableDrawsThrow()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+
+        auto fan = createMesh(GL_TRIANGLE_FAN, createIndices(12));
+        fan->setDrawChunkSize(6);
+
+        bool thrown = false;
+        try
+        {
+            fan->draw();
+        }
+        catch (MeshException const&)
+        {
+            thrown = true;
+        }
+        GLOWL_CHECK(thrown);
+
+        // fits into one chunk, drawn as is
+        fan->setDrawChunkSize(12);
+        recorder.clearCalls();
+        fan->draw();
+        GLOWL_CHECK(recorder.getDrawElementsCalls().size() == 1);
+
+        // a chunk needs room for more than the repeated vertices
+        auto strip = createMesh(GL_TRIANGLE_STRIP, createIndices(12));
+        strip->setDrawChunkSize(3);
+        thrown = false;
+        try
+        {
+            strip->draw();
+        }
+        catch (MeshException const&)
+        {
+            thrown = true;
+        }
+        GLOWL_CHECK(thrown);
+    }
+} // namespace
+
+int main()
+{
+    chunksMatchSingleDraw();
+    rangesKeepBaseVertexAndInstances();
+    unsplittableDrawsThrow();
+
+    return GLOWL_TEST_RESULT();
+}
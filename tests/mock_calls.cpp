@@ -0,0 +1,76 @@
+/*
+ * mock_calls.cpp
+ *
+ * MIT License
+ */
+
+#include <cstdint>
+#include <vector>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    void cachedUniformLocation()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+
+        GLSLProgram program({{GLSLProgram::ShaderType::Compute, "void main() {}"}});
+
+        recorder.clearCalls();
+        program.setUniform("scale", 1.0f);
+        GLOWL_CHECK(recorder.getCallCount("glGetUniformLocation") == 1);
+
+        recorder.clearCalls();
+        program.setUniform("scale", 2.0f);
+        program.setUniform("scale", 3, 4);
+        GLOWL_CHECK(recorder.getCallCount("glGetUniformLocation") == 0);
+        GLOWL_CHECK(recorder.getCallCount("glUniform1f") == 1);
+        GLOWL_CHECK(recorder.getCallCount("glUniform2i") == 1);
+
+        // relinking may move uniforms, the cache starts over
+        program.bindAttribLocation(0, "position");
+        recorder.clearCalls();
+        program.setUniform("scale", 1.0f);
+        GLOWL_CHECK(recorder.getCallCount("glGetUniformLocation") == 1);
+    }
+
+    void meshDrawIssuesOneDrawCall()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+
+        std::vector<float>         positions = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+        std::vector<std::uint32_t> indices = {0, 1, 2};
+        VertexLayout               layout(12, {VertexLayout::Attribute(3, GL_FLOAT, GL_FALSE, 0)});
+
+        Mesh mesh(std::vector<std::vector<float>>{positions}, std::vector<VertexLayout>{layout}, indices);
+
+        recorder.clearCalls();
+        mesh.draw();
+        GLOWL_CHECK(test::drawCallCount() == 1);
+        GLOWL_CHECK(recorder.getCallCount("glDrawElementsInstanced") == 1);
+
+        // the vertex array of the context is set up once, later draws only bind it
+        recorder.clearCalls();
+        mesh.draw();
+        GLOWL_CHECK(test::drawCallCount() == 1);
+        GLOWL_CHECK(recorder.getCallCount() == 3);
+        GLOWL_CHECK(recorder.getCallCount("glBindVertexArray") == 2);
+
+        recorder.clearCalls();
+        mesh.draw(16);
+        GLOWL_CHECK(test::drawCallCount() == 1);
+    }
+} // namespace
+
+int main()
+{
+    cachedUniformLocation();
+    meshDrawIssuesOneDrawCall();
+
+    return GLOWL_TEST_RESULT();
+}
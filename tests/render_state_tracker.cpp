@@ -0,0 +1,141 @@
+/*
+ * render_state_tracker.cpp
+ *
+ * MIT License
+ */
+
+#include <glowl/RenderState.hpp>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    /** Number of calls issued by the first apply() of a context, each part of the state is set once */
+    size_t const full_state_call_cnt = 23;
+
+    /** Applies the state and checks that the issued calls match the recorded ones */
+    size_t applyAndCount(RenderStateTracker& tracker, RenderState const& state)
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.clearCalls();
+        auto issued_cnt = tracker.getStatistics().issued_calls;
+        tracker.apply(state);
+        GLOWL_CHECK(tracker.getStatistics().issued_calls - issued_cnt == recorder.getCalls().size());
+        return recorder.getCalls().size();
+    }
+
+    size_t applyAndCount(RenderStateTracker& tracker, ViewportState const& viewport)
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.clearCalls();
+        auto issued_cnt = tracker.getStatistics().issued_calls;
+        tracker.apply(viewport);
+        GLOWL_CHECK(tracker.getStatistics().issued_calls - issued_cnt == recorder.getCalls().size());
+        return recorder.getCalls().size();
+    }
+
+    void onlyDifferencesAreApplied()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+        RenderStateTracker tracker;
+
+        RenderState defaults;
+        GLOWL_CHECK(applyAndCount(tracker, defaults) == full_state_call_cnt);
+        GLOWL_CHECK(recorder.getCallCount("glDisable") == 7);
+        GLOWL_CHECK(applyAndCount(tracker, defaults) == 0);
+        GLOWL_CHECK(tracker.getStatistics().skipped_states == 1);
+
+        BlendState blend;
+        blend.enabled = true;
+        blend.src_rgb = GL_SRC_ALPHA;
+        blend.dst_rgb = GL_ONE_MINUS_SRC_ALPHA;
+        GLOWL_CHECK(applyAndCount(tracker, RenderState(blend)) == 2);
+        GLOWL_CHECK(recorder.getCallCount("glEnable") == 1 && recorder.getCallCount("glBlendFuncSeparate") == 1);
+
+        DepthState depth;
+        depth.test = true;
+        depth.func = GL_LEQUAL;
+        GLOWL_CHECK(applyAndCount(tracker, RenderState(blend, depth)) == 2);
+        GLOWL_CHECK(recorder.getCallCount("glEnable") == 1 && recorder.getCallCount("glDepthFunc") == 1);
+
+        RasterState raster;
+        raster.cull = true;
+        raster.front_face = GL_CW;
+        GLOWL_CHECK(applyAndCount(tracker, RenderState(blend, depth, StencilState(), raster)) == 2);
+        GLOWL_CHECK(recorder.getCallCount("glEnable") == 1 && recorder.getCallCount("glFrontFace") == 1);
+
+        GLOWL_CHECK(tracker.getStatistics().skipped_states == 1);
+        GLOWL_CHECK(tracker.getStatistics().apply_calls == 5);
+    }
+
+    void disabledPartsAreSkippedUntilEnabled()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+        RenderStateTracker tracker;
+        tracker.apply(RenderState());
+
+        // blend functions and the stencil test state have no effect while disabled
+        BlendState blend;
+        blend.src_rgb = GL_SRC_ALPHA;
+        StencilState stencil;
+        stencil.front.func = GL_EQUAL;
+        stencil.front.ref = 1;
+        RenderState disabled(blend, DepthState(), stencil);
+        GLOWL_CHECK(applyAndCount(tracker, disabled) == 0);
+
+        // the same request again is skipped, although the applied state differs from it
+        auto skipped_cnt = tracker.getStatistics().skipped_states;
+        GLOWL_CHECK(applyAndCount(tracker, disabled) == 0);
+        GLOWL_CHECK(tracker.getStatistics().skipped_states == skipped_cnt + 1);
+
+        // enabling sets the functions that were skipped before
+        blend.enabled = true;
+        stencil.test = true;
+        GLOWL_CHECK(applyAndCount(tracker, RenderState(blend, DepthState(), stencil)) == 4);
+        GLOWL_CHECK(recorder.getCallCount("glEnable") == 2);
+        GLOWL_CHECK(recorder.getCallCount("glBlendFuncSeparate") == 1);
+        GLOWL_CHECK(recorder.getCallCount("glStencilFuncSeparate") == 1);
+
+        // write masks are set regardless of the tests, since they also apply to clears
+        DepthState depth;
+        depth.write = false;
+        GLOWL_CHECK(applyAndCount(tracker, RenderState(blend, depth, stencil)) == 1);
+        GLOWL_CHECK(recorder.getCallCount("glDepthMask") == 1);
+
+        tracker.invalidate();
+        GLOWL_CHECK(applyAndCount(tracker, RenderState(blend, depth, stencil)) == full_state_call_cnt);
+    }
+
+    void viewportsApplyChangedRectangles()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+        RenderStateTracker tracker;
+
+        GLOWL_CHECK(applyAndCount(tracker, ViewportState(0, 0, 640, 480)) == 3);
+        GLOWL_CHECK(applyAndCount(tracker, ViewportState(0, 0, 640, 480)) == 0);
+        GLOWL_CHECK(applyAndCount(tracker, ViewportState(0, 0, 640, 480, 10, 10, 100, 100)) == 1);
+        GLOWL_CHECK(recorder.getCallCount("glScissor") == 1);
+        GLOWL_CHECK(applyAndCount(tracker, ViewportState(0, 0, 640, 480, 10, 10, 100, 100, 0.5f, 1.0f)) == 1);
+        GLOWL_CHECK(recorder.getCallCount("glDepthRangef") == 1);
+        GLOWL_CHECK(tracker.getStatistics().skipped_states == 1);
+
+        // a second context starts with an unknown state
+        setCurrentContext(2);
+        GLOWL_CHECK(applyAndCount(tracker, ViewportState(0, 0, 640, 480)) == 3);
+        setCurrentContext(0);
+    }
+} // namespace
+
+int main()
+{
+    onlyDifferencesAreApplied();
+    disabledPartsAreSkippedUntilEnabled();
+    viewportsApplyChangedRectangles();
+
+    return GLOWL_TEST_RESULT();
+}
@@ -0,0 +1,267 @@
+/*
+ * shadow_atlas.cpp
+ *
+ * MIT License
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <glowl/ShadowAtlas.hpp>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    bool overlap(ShadowAtlas::Tile const& lhs, ShadowAtlas::Tile const& rhs)
+    {
+        return lhs.x < rhs.x + rhs.size && rhs.x < lhs.x + lhs.size && lhs.y < rhs.y + rhs.size &&
+               rhs.y < lhs.y + lhs.size;
+    }
+
+    /** Checks that the tiles are aligned to their size, inside the atlas and disjoint */
+    void checkTiles(ShadowAtlas const& atlas, std::vector<ShadowAtlas::Handle> const& handles)
+    {
+        std::vector<ShadowAtlas::Tile> tiles;
+        for (auto handle : handles)
+        {
+            auto tile = atlas.getTile(handle);
+            if (tile.size == 0)
+            {
+                continue;
+            }
+            GLOWL_CHECK(tile.x % tile.size == 0 && tile.y % tile.size == 0);
+            GLOWL_CHECK(tile.x + tile.size <= atlas.getSize() && tile.y + tile.size <= atlas.getSize());
+            for (auto const& other : tiles)
+            {
+                GLOWL_CHECK(!overlap(tile, other));
+            }
+            tiles.push_back(tile);
+        }
+    }
+
+    bool isRendered(ShadowAtlas const& atlas, ShadowAtlas::Handle handle)
+    {
+        auto const& list = atlas.getRenderList();
+        return std::find(list.begin(), list.end(), handle) != list.end();
+    }
+
+    void targetsRoundDownAndShrinkByImportance()
+    {
+        mock::Recorder::get().reset();
+        ShadowAtlas atlas(1024, 64);
+
+        // requests are rounded down, also when space is left
+        auto single = atlas.add();
+        atlas.request(single, 300, 1.0f);
+        atlas.update();
+        GLOWL_CHECK(atlas.getTile(single).size == 256);
+        atlas.request(single, 1000, 1.0f);
+        atlas.update();
+        GLOWL_CHECK(atlas.getTile(single).size == 512);
+        atlas.remove(single);
+
+        // 1.5 times the atlas area: the first pass halves everything, the space left goes back to the most
+        // important reduced slots
+        auto a = atlas.add();
+        auto b = atlas.add();
+        auto c = atlas.add();
+        atlas.request(a, 512, 0.0f);
+        atlas.request(b, 600, 1.0f);
+        atlas.request(c, 1024, 2.0f);
+        atlas.update();
+        GLOWL_CHECK(atlas.getTile(a).size == 512);
+        GLOWL_CHECK(atlas.getTile(b).size == 512);
+        GLOWL_CHECK(atlas.getTile(c).size == 512);
+        checkTiles(atlas, {a, b, c});
+
+        // another request that makes the atlas exactly full
+        auto d = atlas.add();
+        atlas.request(d, 512, 3.0f);
+        atlas.update();
+        for (auto handle : {a, b, c, d})
+        {
+            GLOWL_CHECK(atlas.getTile(handle).size == 512);
+        }
+        checkTiles(atlas, {a, b, c, d});
+
+        // one more, the least important slots lose
+        auto e = atlas.add();
+        atlas.request(e, 512, 4.0f);
+        atlas.update();
+        GLOWL_CHECK(atlas.getTile(a).size == 256);
+        GLOWL_CHECK(atlas.getTile(b).size == 256);
+        GLOWL_CHECK(atlas.getTile(c).size == 512);
+        GLOWL_CHECK(atlas.getTile(d).size == 512);
+        GLOWL_CHECK(atlas.getTile(e).size == 512);
+        checkTiles(atlas, {a, b, c, d, e});
+
+        // more minimum size tiles than fit, the least important ones are dropped
+        std::vector<ShadowAtlas::Handle> handles;
+        ShadowAtlas                      small(256, 64);
+        for (int i = 0; i < 20; ++i)
+        {
+            handles.push_back(small.add());
+            small.request(handles.back(), 64, static_cast<float>(i));
+        }
+        small.update();
+        for (int i = 0; i < 20; ++i)
+        {
+            GLOWL_CHECK(small.getTile(handles[i]).size == (i < 4 ? 0 : 64));
+        }
+        checkTiles(small, handles);
+    }
+
+    void tilesAreKeptAndRenderedOnChange()
+    {
+        mock::Recorder::get().reset();
+        ShadowAtlas atlas(1024, 64);
+
+        auto cached = atlas.add(true);
+        auto uncached = atlas.add(false);
+        atlas.request(cached, 256, 1.0f);
+        atlas.request(uncached, 128, 1.0f);
+
+        atlas.update();
+        GLOWL_CHECK(isRendered(atlas, cached) && isRendered(atlas, uncached));
+        auto tile = atlas.getTile(cached);
+
+        atlas.update();
+        GLOWL_CHECK(!isRendered(atlas, cached) && isRendered(atlas, uncached));
+
+        atlas.invalidate(cached);
+        atlas.update();
+        GLOWL_CHECK(isRendered(atlas, cached));
+
+        // other slots coming and going do not move a tile
+        std::vector<ShadowAtlas::Handle> others;
+        for (int i = 0; i < 10; ++i)
+        {
+            others.push_back(atlas.add());
+            atlas.request(others.back(), 64 << (i % 3), 0.5f);
+        }
+        atlas.update();
+        others.push_back(cached);
+        others.push_back(uncached);
+        checkTiles(atlas, others);
+        GLOWL_CHECK(!isRendered(atlas, cached));
+        GLOWL_CHECK(atlas.getTile(cached).x == tile.x && atlas.getTile(cached).y == tile.y);
+
+        // a new size is a new tile
+        atlas.request(cached, 512, 1.0f);
+        atlas.update();
+        GLOWL_CHECK(isRendered(atlas, cached) && atlas.getTile(cached).size == 512);
+
+        float scale_offset[4];
+        atlas.getUvScaleOffset(cached, scale_offset);
+        tile = atlas.getTile(cached);
+        GLOWL_CHECK(scale_offset[0] == 0.5f && scale_offset[1] == 0.5f);
+        GLOWL_CHECK(scale_offset[2] * 1024.0f == tile.x && scale_offset[3] * 1024.0f == tile.y);
+
+        // released requests free the tile
+        atlas.request(uncached, 0, 1.0f);
+        atlas.update();
+        GLOWL_CHECK(atlas.getTile(uncached).size == 0 && !isRendered(atlas, uncached));
+    }
+
+    void releasedTilesMergeWithTheirSiblings()
+    {
+        mock::Recorder::get().reset();
+        ShadowAtlas atlas(1024, 64);
+
+        auto kept = atlas.add();
+        atlas.request(kept, 256, 1.0f);
+        atlas.update();
+        auto tile = atlas.getTile(kept);
+
+        // fragment the rest of the atlas into minimum size tiles
+        std::vector<ShadowAtlas::Handle> small;
+        for (int i = 0; i < 240; ++i)
+        {
+            small.push_back(atlas.add());
+            atlas.request(small.back(), 64, 0.5f);
+        }
+        atlas.update();
+        small.push_back(kept);
+        checkTiles(atlas, small);
+        small.pop_back();
+        for (auto handle : small)
+        {
+            GLOWL_CHECK(atlas.getTile(handle).size == 64);
+        }
+
+        // the freed tiles have to merge back into three 512 tiles, a repack would move and rerender the kept tile
+        for (auto handle : small)
+        {
+            atlas.remove(handle);
+        }
+        std::vector<ShadowAtlas::Handle> large;
+        for (int i = 0; i < 3; ++i)
+        {
+            large.push_back(atlas.add());
+            atlas.request(large.back(), 512, 0.5f);
+        }
+        atlas.update();
+
+        GLOWL_CHECK(!isRendered(atlas, kept));
+        GLOWL_CHECK(atlas.getTile(kept).x == tile.x && atlas.getTile(kept).y == tile.y);
+        for (auto handle : large)
+        {
+            GLOWL_CHECK(atlas.getTile(handle).size == 512 && isRendered(atlas, handle));
+        }
+        large.push_back(kept);
+        checkTiles(atlas, large);
+    }
+
+    void tilesClearWithDepthWrites()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+        ShadowAtlas atlas(1024, 64);
+
+        auto slot = atlas.add();
+        atlas.request(slot, 128, 1.0f);
+        atlas.update();
+
+        recorder.clearCalls();
+        atlas.begin();
+        atlas.beginTile(slot);
+        atlas.end();
+        GLOWL_CHECK(recorder.getCallCount("glEnable") == 1 && recorder.getCallCount("glDisable") == 1);
+        GLOWL_CHECK(recorder.getCallCount("glViewport") == 1 && recorder.getCallCount("glScissor") == 1);
+        GLOWL_CHECK(recorder.getCallCount("glDepthMask") == 1 && recorder.getCallCount("glClearBufferfv") == 1);
+
+        auto const& calls = recorder.getCalls();
+        auto        find = [&calls](char const* name) {
+            return std::find_if(
+                calls.begin(), calls.end(), [name](char const* call) { return std::strcmp(call, name) == 0; });
+        };
+        GLOWL_CHECK(find("glDepthMask") < find("glClearBufferfv"));
+
+        bool thrown = false;
+        try
+        {
+            atlas.request(slot, 0, 1.0f);
+            atlas.update();
+            atlas.beginTile(slot);
+        }
+        catch (FramebufferObjectException const&)
+        {
+            thrown = true;
+        }
+        GLOWL_CHECK(thrown);
+    }
+} // namespace
+
+int main()
+{
+    targetsRoundDownAndShrinkByImportance();
+    tilesAreKeptAndRenderedOnChange();
+    releasedTilesMergeWithTheirSiblings();
+    tilesClearWithDepthWrites();
+
+    return GLOWL_TEST_RESULT();
+}
@@ -0,0 +1,230 @@
+/*
+ * texture_cache_headers.cpp
+ *
+ * MIT License
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <glowl/TextureCache.hpp>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    std::uint64_t const key = 0x123456789abcdef0ull;
+
+    std::vector<unsigned char> readFile(std::string const& path)
+    {
+        std::vector<unsigned char> bytes;
+        std::FILE*                 file = std::fopen(path.c_str(), "rb");
+        if (file != nullptr)
+        {
+            unsigned char buffer[4096];
+            size_t        read_cnt = 0;
+            while ((read_cnt = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                bytes.insert(bytes.end(), buffer, buffer + read_cnt);
+            }
+            std::fclose(file);
+        }
+        return bytes;
+    }
+
+    void writeFile(std::string const& path, std::vector<unsigned char> const& bytes)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        GLOWL_CHECK(file != nullptr);
+        if (file != nullptr)
+        {
+            GLOWL_CHECK(std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size());
+            std::fclose(file);
+        }
+    }
+
+    /** Stores a 4x2 RGBA8 texture with two levels and two parameters */
+    void storeEntry(TextureCache const& cache)
+    {
+        TextureLayout layout(GL_RGBA8,
+                             4,
+                             2,
+                             1,
+                             GL_RGBA,
+                             GL_UNSIGNED_BYTE,
+                             2,
+                             {{GL_TEXTURE_MIN_FILTER, GL_LINEAR}},
+                             {{GL_TEXTURE_MAX_ANISOTROPY, 4.0f}});
+        std::vector<unsigned char> level0(4 * 2 * 4, 1);
+        std::vector<unsigned char> level1(2 * 1 * 4, 2);
+        cache.store(key, GL_TEXTURE_2D, layout, {{level0.data(), level0.size()}, {level1.data(), level1.size()}});
+    }
+
+    /** Checks that an entry modified by the given function is rejected without touching OpenGL */
+    void checkRejected(TextureCache const&                                     cache,
+                       std::vector<unsigned char> const&                       valid,
+                       std::function<void(std::vector<unsigned char>&)> const& modify)
+    {
+        std::vector<unsigned char> bytes = valid;
+        modify(bytes);
+        writeFile(cache.getPath(key), bytes);
+
+        auto& recorder = mock::Recorder::get();
+        recorder.clearCalls();
+        GLOWL_CHECK(cache.load("cached", key) == nullptr);
+        GLOWL_CHECK(recorder.getCallCount("glCreateTextures") == 0);
+        GLOWL_CHECK(recorder.getCallCount("glTextureSubImage2D") == 0);
+    }
+
+    void modifyHeader(std::vector<unsigned char>& bytes, std::function<void(detail::TextureCacheHeader&)> const& modify)
+    {
+        detail::TextureCacheHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        modify(header);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+    }
+
+    void modifyLevel(std::vector<unsigned char>& bytes, size_t level, std::uint64_t offset, std::uint64_t byte_size)
+    {
+        // the level table follows the header and the two parameters
+        size_t table_offset = sizeof(detail::TextureCacheHeader) + 2 * sizeof(detail::TextureCacheParameter);
+        detail::TextureCacheLevel entry{offset, byte_size};
+        std::memcpy(bytes.data() + table_offset + level * sizeof(entry), &entry, sizeof(entry));
+    }
+
+    void storedEntriesRoundTrip()
+    {
+        auto& recorder = mock::Recorder::get();
+        recorder.reset();
+
+        TextureCache cache(".");
+        storeEntry(cache);
+
+        GLOWL_CHECK(cache.contains(key));
+        GLOWL_CHECK(!cache.contains(key + 1));
+        GLOWL_CHECK(cache.load("missing", key + 1) == nullptr);
+
+        auto bytes = readFile(cache.getPath(key));
+        GLOWL_CHECK(bytes.size() == TextureCache::payload_alignment * 2 + 2 * 1 * 4);
+
+        recorder.clearCalls();
+        auto texture = cache.load("cached", key);
+        GLOWL_CHECK(texture != nullptr);
+        GLOWL_CHECK(recorder.getCallCount("glTextureSubImage2D") == 2);
+        GLOWL_CHECK(recorder.getCallCount("glTextureParameteri") == 1);
+        GLOWL_CHECK(recorder.getCallCount("glTextureParameterf") == 1);
+        if (texture != nullptr)
+        {
+            auto const& texture_2d = static_cast<Texture2D const&>(*texture);
+            GLOWL_CHECK(texture_2d.getWidth() == 4 && texture_2d.getHeight() == 2);
+            GLOWL_CHECK(texture->getInternalFormat() == GL_RGBA8 && texture->getLevels() == 2);
+        }
+
+        cache.remove(key);
+        GLOWL_CHECK(!cache.contains(key));
+    }
+
+    void invalidEntriesAreRejected()
+    {
+        mock::Recorder::get().reset();
+
+        TextureCache cache(".");
+        storeEntry(cache);
+        auto const valid = readFile(cache.getPath(key));
+        size_t     payload_offset = TextureCache::payload_alignment;
+
+        typedef detail::TextureCacheHeader Header;
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            modifyHeader(b, [](Header& h) { h.magic[0] = 'X'; });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            modifyHeader(b, [](Header& h) { h.version = TextureCache::version + 1; });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            // what a file written with the other byte order looks like
+            modifyHeader(b, [](Header& h) { h.version = TextureCache::version << 24; });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            modifyHeader(b, [](Header& h) { h.key = key + 1; });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            modifyHeader(b, [](Header& h) { h.target = GL_TEXTURE_1D; });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            modifyHeader(b, [](Header& h) { h.width = 0; });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            modifyHeader(b, [](Header& h) { h.levels = 33; });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            modifyHeader(b, [](Header& h) {
+                h.target = GL_TEXTURE_CUBE_MAP_ARRAY;
+                h.depth = 5;
+            });
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            // the level table no longer fits into the file
+            modifyHeader(b, [](Header& h) { h.int_parameter_cnt = 1u << 20; });
+        });
+        checkRejected(cache, valid, [payload_offset](std::vector<unsigned char>& b) {
+            modifyLevel(b, 0, payload_offset, 4 * 2 * 4 - 1);
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) {
+            // overlaps the level table
+            modifyLevel(b, 0, 0, 4 * 2 * 4);
+        });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) { b.resize(b.size() - 1); });
+        checkRejected(cache, valid, [](std::vector<unsigned char>& b) { b.resize(sizeof(Header) - 1); });
+
+        // the unmodified entry still loads
+        writeFile(cache.getPath(key), valid);
+        GLOWL_CHECK(cache.load("cached", key) != nullptr);
+
+        cache.remove(key);
+    }
+
+    void invalidStoresThrow()
+    {
+        mock::Recorder::get().reset();
+
+        TextureCache               cache(".");
+        TextureLayout              layout(GL_RGBA8, 4, 2, 1, GL_RGBA, GL_UNSIGNED_BYTE, 1);
+        std::vector<unsigned char> data(4 * 2 * 4, 0);
+
+        auto throws = [&](GLenum target, std::vector<TextureCache::LevelData> const& levels) {
+            try
+            {
+                cache.store(key, target, layout, levels);
+            }
+            catch (TextureException const&)
+            {
+                return true;
+            }
+            return false;
+        };
+
+        GLOWL_CHECK(throws(GL_TEXTURE_1D, {{data.data(), data.size()}}));
+        GLOWL_CHECK(throws(GL_TEXTURE_2D, {}));
+        GLOWL_CHECK(throws(GL_TEXTURE_2D, {{data.data(), data.size() - 4}}));
+        GLOWL_CHECK(!cache.contains(key));
+
+        GLOWL_CHECK(!throws(GL_TEXTURE_2D, {{data.data(), data.size()}}));
+        GLOWL_CHECK(cache.contains(key));
+
+        cache.remove(key);
+    }
+} // namespace
+
+int main()
+{
+    storedEntriesRoundTrip();
+    invalidEntriesAreRejected();
+    invalidStoresThrow();
+
+    return GLOWL_TEST_RESULT();
+}
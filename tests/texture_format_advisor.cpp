@@ -0,0 +1,324 @@
+/*
+ * texture_format_advisor.cpp
+ *
+ * MIT License
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <glowl/TextureFormatAdvisor.hpp>
+
+#include "TestUtils.hpp"
+
+using namespace glowl;
+
+namespace
+{
+    /** Value of a float with a 5 bit exponent (bias 15) and the given mantissa bits, written from the definition */
+    double referenceUnsignedFloat(std::uint32_t bits, int mantissa_bits)
+    {
+        double exponent = static_cast<double>(bits >> mantissa_bits);
+        double mantissa = static_cast<double>(bits & ((1u << mantissa_bits) - 1)) / (1u << mantissa_bits);
+        return exponent == 0.0 ? std::pow(2.0, -14.0) * mantissa : std::pow(2.0, exponent - 15.0) * (1.0 + mantissa);
+    }
+
+    /** Checks decoding against the definition and encoding of every finite value for the given mantissa bits */
+    void checkUnsignedFloats(int mantissa_bits)
+    {
+        std::uint32_t const finite_end = 31u << mantissa_bits;
+        for (std::uint32_t bits = 0; bits < finite_end; ++bits)
+        {
+            float value = detail::unpackUnsignedFloat(bits, mantissa_bits);
+            GLOWL_CHECK(value == referenceUnsignedFloat(bits, mantissa_bits));
+            GLOWL_CHECK(detail::packUnsignedFloat(value, mantissa_bits) == bits);
+
+            // values between two neighbours go to the nearer one
+            if (bits + 1 < finite_end)
+            {
+                float next = detail::unpackUnsignedFloat(bits + 1, mantissa_bits);
+                GLOWL_CHECK(detail::packUnsignedFloat(value + 0.25f * (next - value), mantissa_bits) == bits);
+                GLOWL_CHECK(detail::packUnsignedFloat(value + 0.75f * (next - value), mantissa_bits) == bits + 1);
+            }
+        }
+
+        // out of range values saturate
+        GLOWL_CHECK(detail::packUnsignedFloat(1.0e10f, mantissa_bits) == finite_end - 1);
+        GLOWL_CHECK(detail::packUnsignedFloat(std::numeric_limits<float>::infinity(), mantissa_bits) == finite_end - 1);
+        GLOWL_CHECK(detail::packUnsignedFloat(-1.0f, mantissa_bits) == 0);
+        GLOWL_CHECK(detail::packUnsignedFloat(std::numeric_limits<float>::quiet_NaN(), mantissa_bits) == 0);
+    }
+
+    void smallFloatsRoundTrip()
+    {
+        checkUnsignedFloats(10); // half float magnitude
+        checkUnsignedFloats(6);  // R11F and G11F
+        checkUnsignedFloats(5);  // B10F
+
+        for (std::uint32_t bits = 0; bits < 0x10000u; ++bits)
+        {
+            if (((bits >> 10) & 0x1Fu) == 0x1Fu)
+            {
+                continue; // infinity and NaN
+            }
+            auto  half = static_cast<std::uint16_t>(bits);
+            float value = detail::unpackHalf(half);
+            GLOWL_CHECK(detail::packHalf(value) == half);
+            GLOWL_CHECK(std::signbit(value) == ((bits & 0x8000u) != 0));
+        }
+
+        float const         rgb[] = {65000.0f, 0.5f, 3.0e-5f};
+        std::uint32_t const packed = detail::packR11F_G11F_B10F(rgb);
+        float               unpacked[3];
+        detail::unpackR11F_G11F_B10F(packed, unpacked);
+        GLOWL_CHECK((packed & 0x7FFu) == detail::packUnsignedFloat(rgb[0], 6));
+        GLOWL_CHECK(((packed >> 11) & 0x7FFu) == detail::packUnsignedFloat(rgb[1], 6));
+        GLOWL_CHECK((packed >> 22) == detail::packUnsignedFloat(rgb[2], 5));
+        GLOWL_CHECK(unpacked[1] == 0.5f);
+    }
+
+    void sharedExponentRoundTrips()
+    {
+        // normalized encodings, i.e. the largest mantissa uses the top bit, decode and encode to themselves
+        std::mt19937                                 rng(3);
+        std::uniform_int_distribution<std::uint32_t> mantissa(0, 511);
+        std::uniform_int_distribution<std::uint32_t> exponent(0, 31);
+        for (int i = 0; i < 100000; ++i)
+        {
+            std::uint32_t m[3] = {mantissa(rng), mantissa(rng), mantissa(rng)};
+            m[i % 3] |= 256u;
+            std::uint32_t bits = (exponent(rng) << 27) | m[0] | (m[1] << 9) | (m[2] << 18);
+
+            float rgb[3];
+            detail::unpackRGB9_E5(bits, rgb);
+            GLOWL_CHECK(detail::packRGB9_E5(rgb) == bits);
+        }
+
+        // arbitrary values are within half a step of the shared exponent
+        std::uniform_real_distribution<float> log_value(-20.0f, 16.0f);
+        for (int i = 0; i < 100000; ++i)
+        {
+            float rgb[3];
+            for (auto& c : rgb)
+            {
+                c = std::exp2(log_value(rng));
+            }
+            rgb[i % 3] = i % 7 == 0 ? 0.0f : rgb[i % 3];
+
+            float decoded[3];
+            detail::unpackRGB9_E5(detail::packRGB9_E5(rgb), decoded);
+
+            float max_component = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+            for (int c = 0; c < 3; ++c)
+            {
+                float clamped = std::min(rgb[c], std::ldexp(511.0f / 512.0f, 16));
+                GLOWL_CHECK(std::abs(decoded[c] - clamped) <= std::max(max_component, std::ldexp(1.0f, -15)) / 511.0f);
+            }
+        }
+    }
+
+    void normalizedTexelsRoundTrip()
+    {
+        for (auto const& texel_format : detail::getTexelFormats())
+        {
+            if (texel_format.encoding != detail::TexelEncoding::Unorm &&
+                texel_format.encoding != detail::TexelEncoding::Snorm)
+            {
+                continue;
+            }
+
+            bool  is_signed = texel_format.encoding == detail::TexelEncoding::Snorm;
+            int   max_integer = (1 << (texel_format.bits - (is_signed ? 1 : 0))) - 1;
+            int   step = texel_format.bits == 8 ? 1 : 97;
+            float values[4];
+            float decoded[4];
+
+            unsigned char texel[16];
+            for (int integer = is_signed ? -max_integer : 0; integer <= max_integer; integer += step)
+            {
+                std::fill(values, values + 4, static_cast<float>(integer) / max_integer);
+                detail::encodeTexel(texel_format, values, texel, decoded);
+
+                for (int c = 0; c < texel_format.stored_components; ++c)
+                {
+                    int stored = 0;
+                    if (texel_format.bits == 8)
+                    {
+                        stored = is_signed ? static_cast<signed char>(texel[c]) : texel[c];
+                    }
+                    else
+                    {
+                        std::uint16_t bits;
+                        std::memcpy(&bits, texel + 2 * c, 2);
+                        stored = is_signed ? static_cast<std::int16_t>(bits) : bits;
+                    }
+                    GLOWL_CHECK(stored == integer);
+                    GLOWL_CHECK(decoded[c] == values[c]);
+                }
+            }
+
+            // out of range values are clamped
+            std::fill(values, values + 4, 2.0f);
+            detail::encodeTexel(texel_format, values, texel, decoded);
+            GLOWL_CHECK(decoded[0] == 1.0f);
+            std::fill(values, values + 4, -2.0f);
+            detail::encodeTexel(texel_format, values, texel, decoded);
+            GLOWL_CHECK(decoded[0] == (is_signed ? -1.0f : 0.0f));
+        }
+    }
+
+    /** Checks the advice against the source data, decoding the converted data independently of the advisor */
+    void checkAdvice(TextureFormatAdvice const& advice,
+                     std::vector<float> const&  source,
+                     int                        components,
+                     float                      tolerance)
+    {
+        auto const& formats = detail::getTexelFormats();
+        auto        texel_format = std::find_if(formats.begin(), formats.end(), [&](detail::TexelFormat const& f) {
+            return f.internal_format == static_cast<GLenum>(advice.layout.internal_format) &&
+                   f.components == advice.components;
+        });
+        GLOWL_CHECK(texel_format != formats.end());
+        if (texel_format == formats.end())
+        {
+            return;
+        }
+
+        size_t texel_cnt = source.size() / components;
+        GLOWL_CHECK(advice.data.size() == texel_cnt * texel_format->texel_byte_size);
+        GLOWL_CHECK(advice.byte_size == advice.data.size());
+        GLOWL_CHECK(advice.max_error <= tolerance);
+
+        GLenum source_format = components == 1 ? GL_RED : components == 2 ? GL_RG : components == 3 ? GL_RGB : GL_RGBA;
+        GLOWL_CHECK(convertTextureData(source_format, source.data(), texel_cnt, advice.layout) == advice.data);
+
+        for (size_t i = 0; i < texel_cnt; ++i)
+        {
+            unsigned char const* texel = advice.data.data() + i * texel_format->texel_byte_size;
+            float                decoded[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            switch (texel_format->encoding)
+            {
+            case detail::TexelEncoding::Unorm:
+                for (int c = 0; c < texel_format->stored_components; ++c)
+                {
+                    std::uint16_t bits = texel[c];
+                    if (texel_format->bits == 16)
+                    {
+                        std::memcpy(&bits, texel + 2 * c, 2);
+                    }
+                    decoded[c] = bits / static_cast<float>((1u << texel_format->bits) - 1);
+                }
+                break;
+            case detail::TexelEncoding::Half:
+                for (int c = 0; c < texel_format->stored_components; ++c)
+                {
+                    std::uint16_t bits;
+                    std::memcpy(&bits, texel + 2 * c, 2);
+                    decoded[c] = detail::unpackHalf(bits);
+                }
+                break;
+            case detail::TexelEncoding::Float:
+                std::memcpy(decoded, texel, 4 * texel_format->stored_components);
+                break;
+            case detail::TexelEncoding::R11F_G11F_B10F:
+            {
+                std::uint32_t bits;
+                std::memcpy(&bits, texel, 4);
+                detail::unpackR11F_G11F_B10F(bits, decoded);
+                break;
+            }
+            default:
+                GLOWL_CHECK(false);
+                break;
+            }
+
+            for (int c = 0; c < advice.components; ++c)
+            {
+                GLOWL_CHECK(std::abs(decoded[c] - source[i * components + c]) <= tolerance);
+            }
+        }
+    }
+
+    void advisedFormatsMeetTolerance()
+    {
+        std::mt19937                          rng(5);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        size_t const       texel_cnt = 64;
+        std::vector<float> rgba(texel_cnt * 4);
+        for (size_t i = 0; i < texel_cnt; ++i)
+        {
+            rgba[i * 4 + 0] = unit(rng);
+            rgba[i * 4 + 1] = unit(rng);
+            rgba[i * 4 + 2] = 0.0f;
+            rgba[i * 4 + 3] = 1.0f;
+        }
+        TextureLayout layout(GL_RGBA32F, 8, 8, 1, GL_RGBA, GL_FLOAT, 1);
+
+        // constant alpha and blue are dropped, 8 bit is enough for a tolerance of half a step
+        auto advice = adviseTextureFormat(layout, rgba.data(), 0.5f / 255.0f + 1.0e-6f);
+        GLOWL_CHECK(advice.components == 2 && advice.constant_alpha);
+        GLOWL_CHECK(advice.layout.internal_format == GL_RG8);
+        GLOWL_CHECK(advice.source_byte_size == texel_cnt * 16 && advice.getSavedByteSize() == texel_cnt * 14);
+        checkAdvice(advice, rgba, 4, 0.5f / 255.0f + 1.0e-6f);
+
+        // a tighter tolerance needs 16 bit
+        advice = adviseTextureFormat(layout, rgba.data(), 1.0e-4f);
+        GLOWL_CHECK(advice.layout.internal_format == GL_RG16);
+        checkAdvice(advice, rgba, 4, 1.0e-4f);
+
+        // alpha of 0 is restored by a swizzle
+        for (size_t i = 0; i < texel_cnt; ++i)
+        {
+            rgba[i * 4 + 3] = 0.0f;
+        }
+        advice = adviseTextureFormat(layout, rgba.data(), 0.01f);
+        GLOWL_CHECK(advice.components == 2);
+        GLOWL_CHECK(std::find(advice.layout.int_parameters.begin(),
+                              advice.layout.int_parameters.end(),
+                              std::pair<GLenum, GLint>(GL_TEXTURE_SWIZZLE_A, GL_ZERO)) !=
+                    advice.layout.int_parameters.end());
+        checkAdvice(advice, rgba, 4, 0.01f);
+
+        // values beyond [0,1] need floats, three components fit into GL_R11F_G11F_B10F with a relative tolerance
+        std::vector<float> rgb(texel_cnt * 3);
+        for (auto& v : rgb)
+        {
+            v = 100.0f * unit(rng) + 1.0f;
+        }
+        TextureLayout rgb_layout(GL_RGB32F, 8, 8, 1, GL_RGB, GL_FLOAT, 1);
+        advice = adviseTextureFormat(rgb_layout, rgb.data(), 0.0f, 1.0f / 32.0f);
+        GLOWL_CHECK(advice.layout.internal_format == GL_R11F_G11F_B10F || advice.layout.internal_format == GL_RGB9_E5);
+        GLOWL_CHECK(advice.byte_size == texel_cnt * 4);
+        if (advice.layout.internal_format == GL_R11F_G11F_B10F)
+        {
+            checkAdvice(advice, rgb, 3, 100.0f / 32.0f + 1.0f);
+        }
+
+        // exact data keeps 32 bit floats
+        advice = adviseTextureFormat(rgb_layout, rgb.data(), 0.0f);
+        GLOWL_CHECK(advice.layout.internal_format == GL_RGB32F && advice.max_error == 0.0f);
+        checkAdvice(advice, rgb, 3, 0.0f);
+
+        // NaN falls back to 32 bit floats as well
+        std::vector<float> red(texel_cnt, 0.5f);
+        red[3] = std::numeric_limits<float>::quiet_NaN();
+        TextureLayout red_layout(GL_R32F, 8, 8, 1, GL_RED, GL_FLOAT, 1);
+        advice = adviseTextureFormat(red_layout, red.data(), 0.1f);
+        GLOWL_CHECK(advice.layout.internal_format == GL_R32F);
+    }
+} // namespace
+
+int main()
+{
+    smallFloatsRoundTrip();
+    sharedExponentRoundTrips();
+    normalizedTexelsRoundTrip();
+    advisedFormatsMeetTolerance();
+
+    return GLOWL_TEST_RESULT();
+}
@@ -0,0 +1,927 @@
+/*
+ * glowl_replay.cpp
+ *
+ * MIT License
+ */
+
+/**
+ * Replays a trace recorded by glowl (see Trace.hpp, GLOWL_ENABLE_TRACE) on a headless EGL context
+ * and reports the CPU time spent submitting each frame as well as a histogram of the replayed GL calls.
+ *
+ * Usage: glowl_replay <trace file> [--skip <frames>] [--no-finish] [--per-frame]
+ *
+ *   --skip <frames>  Exclude the first frames (e.g. resource creation) from the summary
+ *   --no-finish      Do not call glFinish between frames, i.e. let the driver queue up work
+ *   --per-frame      Print the submission time of every frame
+ */
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/glcorearb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// OpenGL is included above, the trace decoder does not need any of the glowl loader options
+#include "glowl/Trace.hpp"
+
+namespace
+{
+    using glowl::trace::Command;
+    using glowl::trace::Opcode;
+
+    /**
+     * Maps object names of the recording to object names of the replay.
+     */
+    class NameMap
+    {
+    public:
+        GLuint get(std::int64_t traced_name) const
+        {
+            if (traced_name == 0)
+            {
+                return 0;
+            }
+            auto query = m_names.find(traced_name);
+            return query != m_names.end() ? query->second : 0;
+        }
+
+        void set(std::int64_t traced_name, GLuint name)
+        {
+            m_names[traced_name] = name;
+        }
+
+        GLuint remove(std::int64_t traced_name)
+        {
+            GLuint name = get(traced_name);
+            m_names.erase(traced_name);
+            return name;
+        }
+
+    private:
+        std::unordered_map<std::int64_t, GLuint> m_names;
+    };
+
+    /**
+     * Executes the commands of a decoded trace.
+     *
+     * Uniform locations are resolved once per (program, name) whenever the program is linked, so that replaying
+     * a uniform does not add glGetUniformLocation calls to the timings that the application did not make.
+     */
+    class Replayer
+    {
+    public:
+        explicit Replayer(std::vector<Command> const& commands);
+
+        void execute(size_t command_idx);
+
+    private:
+        struct Uniform
+        {
+            std::int64_t program;
+            std::string  name;
+            GLint        location;
+            bool         resolved;
+        };
+
+        void createTexture(Command const& cmd);
+        void textureSubImage(Command const& cmd);
+        void uniform(Command const& cmd, Uniform& uniform);
+        void resolveUniforms(std::int64_t program);
+
+        std::vector<Command> const& m_commands;
+        std::vector<Uniform>        m_uniforms;
+        std::vector<size_t>         m_command_uniforms; ///< Index into m_uniforms, only used for uniform commands
+
+        NameMap m_buffers;
+        NameMap m_textures;
+        NameMap m_vertex_arrays;
+        NameMap m_framebuffers;
+        NameMap m_programs;
+
+        PFNGLNAMEDBUFFERPAGECOMMITMENTARBPROC m_named_buffer_page_commitment;
+    };
+
+    void const* payload(Command const& cmd)
+    {
+        return cmd.payload.empty() ? nullptr : cmd.payload.data();
+    }
+
+    Replayer::Replayer(std::vector<Command> const& commands)
+        : m_commands(commands), m_command_uniforms(commands.size(), 0)
+    {
+        // extension entry points are not exported by libOpenGL
+        m_named_buffer_page_commitment = reinterpret_cast<PFNGLNAMEDBUFFERPAGECOMMITMENTARBPROC>(
+            eglGetProcAddress("glNamedBufferPageCommitmentARB"));
+
+        std::map<std::pair<std::int64_t, std::string>, size_t> uniform_indices;
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            if (commands[i].opcode == Opcode::Uniform)
+            {
+                std::int64_t program = commands[i].args[0];
+                std::string  name(commands[i].payload.begin(), commands[i].payload.end());
+
+                auto query = uniform_indices.emplace(std::make_pair(program, name), m_uniforms.size());
+                if (query.second)
+                {
+                    m_uniforms.push_back({program, name, -1, false});
+                }
+                m_command_uniforms[i] = query.first->second;
+            }
+        }
+    }
+
+    void Replayer::execute(size_t command_idx)
+    {
+        Command const& cmd = m_commands[command_idx];
+        auto const&    a = cmd.args;
+
+        switch (cmd.opcode)
+        {
+        case Opcode::Frame:
+            break;
+        case Opcode::CreateBuffer:
+        {
+            GLuint name = 0;
+            glCreateBuffers(1, &name);
+            m_buffers.set(a[0], name);
+        }
+        break;
+        case Opcode::NamedBufferData:
+            glNamedBufferData(m_buffers.get(a[0]), a[1], payload(cmd), static_cast<GLenum>(a[2]));
+            break;
+        case Opcode::NamedBufferStorage:
+            glNamedBufferStorage(m_buffers.get(a[0]), a[1], nullptr, static_cast<GLbitfield>(a[2]));
+            break;
+        case Opcode::NamedBufferSubData:
+            glNamedBufferSubData(m_buffers.get(a[0]), a[1], cmd.payload.size(), payload(cmd));
+            break;
+        case Opcode::MapNamedBufferRange:
+        {
+            // strided scatter, e.g. a single attribute of interleaved vertices
+            GLsizeiptr stride = a[2];
+            GLsizeiptr element_byte_size = a[3];
+            size_t     element_cnt =
+                element_byte_size > 0 ? cmd.payload.size() / static_cast<size_t>(element_byte_size) : 0;
+            if (element_cnt == 0)
+            {
+                break;
+            }
+
+            GLuint     buffer = m_buffers.get(a[0]);
+            GLsizeiptr byte_size = static_cast<GLsizeiptr>(element_cnt - 1) * stride + element_byte_size;
+            auto dst = static_cast<std::uint8_t*>(glMapNamedBufferRange(buffer, a[1], byte_size, GL_MAP_WRITE_BIT));
+            if (dst == nullptr)
+            {
+                std::fprintf(stderr,
+                             "Command %zu: could not map %lld bytes of buffer %u, skipped\n",
+                             command_idx,
+                             static_cast<long long>(byte_size),
+                             buffer);
+                break;
+            }
+            for (size_t i = 0; i < element_cnt; ++i)
+            {
+                std::memcpy(dst + static_cast<GLsizeiptr>(i) * stride,
+                            cmd.payload.data() + i * static_cast<size_t>(element_byte_size),
+                            static_cast<size_t>(element_byte_size));
+            }
+            glUnmapNamedBuffer(buffer);
+        }
+        break;
+        case Opcode::NamedBufferPageCommitment:
+            if (m_named_buffer_page_commitment != nullptr)
+            {
+                m_named_buffer_page_commitment(m_buffers.get(a[0]), a[1], a[2], a[3] != 0 ? GL_TRUE : GL_FALSE);
+            }
+            break;
+        case Opcode::CopyNamedBufferSubData:
+            glCopyNamedBufferSubData(m_buffers.get(a[0]), m_buffers.get(a[1]), a[2], a[3], a[4]);
+            break;
+        case Opcode::DeleteBuffer:
+        {
+            GLuint name = m_buffers.remove(a[0]);
+            glDeleteBuffers(1, &name);
+        }
+        break;
+        case Opcode::BindBuffer:
+            glBindBuffer(static_cast<GLenum>(a[0]), m_buffers.get(a[1]));
+            break;
+        case Opcode::BindBufferBase:
+            glBindBufferBase(static_cast<GLenum>(a[0]), static_cast<GLuint>(a[1]), m_buffers.get(a[2]));
+            break;
+        case Opcode::CreateTexture:
+            createTexture(cmd);
+            break;
+        case Opcode::TextureView:
+        {
+            GLuint name = 0;
+            glGenTextures(1, &name);
+            glTextureView(name,
+                          static_cast<GLenum>(a[1]),
+                          m_textures.get(a[2]),
+                          static_cast<GLenum>(a[3]),
+                          static_cast<GLuint>(a[4]),
+                          static_cast<GLuint>(a[5]),
+                          static_cast<GLuint>(a[6]),
+                          static_cast<GLuint>(a[7]));
+            m_textures.set(a[0], name);
+        }
+        break;
+        case Opcode::TextureParameteri:
+            glTextureParameteri(m_textures.get(a[0]), static_cast<GLenum>(a[1]), static_cast<GLint>(a[2]));
+            break;
+        case Opcode::TextureParameterf:
+            glTextureParameterf(m_textures.get(a[0]), static_cast<GLenum>(a[1]), glowl::trace::bitsToFloat(a[2]));
+            break;
+        case Opcode::GenerateTextureMipmap:
+            glGenerateTextureMipmap(m_textures.get(a[0]));
+            break;
+        case Opcode::DeleteTexture:
+        {
+            GLuint name = m_textures.remove(a[0]);
+            glDeleteTextures(1, &name);
+        }
+        break;
+        case Opcode::BindTexture:
+            glBindTexture(static_cast<GLenum>(a[0]), m_textures.get(a[1]));
+            break;
+        case Opcode::BindImageTexture:
+            glBindImageTexture(static_cast<GLuint>(a[0]),
+                               m_textures.get(a[1]),
+                               static_cast<GLint>(a[2]),
+                               static_cast<GLboolean>(a[3]),
+                               static_cast<GLint>(a[4]),
+                               static_cast<GLenum>(a[5]),
+                               static_cast<GLenum>(a[6]));
+            break;
+        case Opcode::CreateVertexArray:
+        {
+            GLuint name = 0;
+            glCreateVertexArrays(1, &name);
+            m_vertex_arrays.set(a[0], name);
+        }
+        break;
+        case Opcode::VertexArrayVertexBuffer:
+            glVertexArrayVertexBuffer(m_vertex_arrays.get(a[0]),
+                                      static_cast<GLuint>(a[1]),
+                                      m_buffers.get(a[2]),
+                                      a[3],
+                                      static_cast<GLsizei>(a[4]));
+            break;
+        case Opcode::VertexArrayAttrib:
+        {
+            GLuint vao = m_vertex_arrays.get(a[0]);
+            GLuint attrib = static_cast<GLuint>(a[1]);
+            glEnableVertexArrayAttrib(vao, attrib);
+            switch (a[7])
+            {
+            case GL_INT:
+                glVertexArrayAttribIFormat(
+                    vao, attrib, static_cast<GLint>(a[3]), static_cast<GLenum>(a[4]), static_cast<GLuint>(a[6]));
+                break;
+            case GL_DOUBLE:
+                glVertexArrayAttribLFormat(
+                    vao, attrib, static_cast<GLint>(a[3]), static_cast<GLenum>(a[4]), static_cast<GLuint>(a[6]));
+                break;
+            default:
+                glVertexArrayAttribFormat(vao,
+                                          attrib,
+                                          static_cast<GLint>(a[3]),
+                                          static_cast<GLenum>(a[4]),
+                                          static_cast<GLboolean>(a[5]),
+                                          static_cast<GLuint>(a[6]));
+                break;
+            }
+            glVertexArrayAttribBinding(vao, attrib, static_cast<GLuint>(a[2]));
+        }
+        break;
+        case Opcode::VertexArrayElementBuffer:
+            glVertexArrayElementBuffer(m_vertex_arrays.get(a[0]), m_buffers.get(a[1]));
+            break;
+        case Opcode::DeleteVertexArray:
+        {
+            GLuint name = m_vertex_arrays.remove(a[0]);
+            glDeleteVertexArrays(1, &name);
+        }
+        break;
+        case Opcode::BindVertexArray:
+            glBindVertexArray(m_vertex_arrays.get(a[0]));
+            break;
+        case Opcode::DrawElementsInstanced:
+            glDrawElementsInstanced(static_cast<GLenum>(a[0]),
+                                    static_cast<GLsizei>(a[1]),
+                                    static_cast<GLenum>(a[2]),
+                                    reinterpret_cast<void const*>(static_cast<std::uintptr_t>(a[3])),
+                                    static_cast<GLsizei>(a[4]));
+            break;
+        case Opcode::CreateFramebuffer:
+        {
+            GLuint name = 0;
+            glCreateFramebuffers(1, &name);
+            m_framebuffers.set(a[0], name);
+        }
+        break;
+        case Opcode::NamedFramebufferTexture:
+            glNamedFramebufferTexture(
+                m_framebuffers.get(a[0]), static_cast<GLenum>(a[1]), m_textures.get(a[2]), static_cast<GLint>(a[3]));
+            break;
+        case Opcode::DeleteFramebuffer:
+        {
+            GLuint name = m_framebuffers.remove(a[0]);
+            glDeleteFramebuffers(1, &name);
+        }
+        break;
+        case Opcode::BindFramebuffer:
+            glBindFramebuffer(static_cast<GLenum>(a[0]), m_framebuffers.get(a[1]));
+            break;
+        case Opcode::DrawBuffers:
+        {
+            GLenum buffers[32];
+            GLsizei cnt = static_cast<GLsizei>(std::min<size_t>(a.size(), 32));
+            for (GLsizei i = 0; i < cnt; ++i)
+            {
+                buffers[i] = static_cast<GLenum>(a[i]);
+            }
+            glDrawBuffers(cnt, buffers);
+        }
+        break;
+        case Opcode::ReadBuffer:
+            glReadBuffer(static_cast<GLenum>(a[0]));
+            break;
+        case Opcode::CreateProgram:
+            m_programs.set(a[0], glCreateProgram());
+            break;
+        case Opcode::ShaderSource:
+        {
+            std::string   source(cmd.payload.begin(), cmd.payload.end());
+            GLchar const* c_source = source.c_str();
+            GLuint        shader = glCreateShader(static_cast<GLenum>(a[1]));
+            glShaderSource(shader, 1, &c_source, nullptr);
+            glCompileShader(shader);
+            glAttachShader(m_programs.get(a[0]), shader);
+            glDeleteShader(shader);
+        }
+        break;
+        case Opcode::LinkProgram:
+            glLinkProgram(m_programs.get(a[0]));
+            resolveUniforms(a[0]);
+            break;
+        case Opcode::BindAttribLocation:
+        {
+            std::string name(cmd.payload.begin(), cmd.payload.end());
+            glBindAttribLocation(m_programs.get(a[0]), static_cast<GLuint>(a[1]), name.c_str());
+        }
+        break;
+        case Opcode::BindFragDataLocation:
+        {
+            std::string name(cmd.payload.begin(), cmd.payload.end());
+            glBindFragDataLocation(m_programs.get(a[0]), static_cast<GLuint>(a[1]), name.c_str());
+        }
+        break;
+        case Opcode::Uniform:
+            uniform(cmd, m_uniforms[m_command_uniforms[command_idx]]);
+            break;
+        case Opcode::UseProgram:
+            glUseProgram(m_programs.get(a[0]));
+            break;
+        case Opcode::DeleteProgram:
+            glDeleteProgram(m_programs.remove(a[0]));
+            break;
+        case Opcode::DispatchCompute:
+            glDispatchCompute(static_cast<GLuint>(a[0]), static_cast<GLuint>(a[1]), static_cast<GLuint>(a[2]));
+            break;
+        case Opcode::MemoryBarrier:
+            glMemoryBarrier(static_cast<GLbitfield>(a[0]));
+            break;
+        case Opcode::DrawElementsInstancedBaseVertex:
+            glDrawElementsInstancedBaseVertex(static_cast<GLenum>(a[0]),
+                                              static_cast<GLsizei>(a[1]),
+                                              static_cast<GLenum>(a[2]),
+                                              reinterpret_cast<void const*>(static_cast<std::uintptr_t>(a[3])),
+                                              static_cast<GLsizei>(a[4]),
+                                              static_cast<GLint>(a[5]));
+            break;
+        case Opcode::MultiDrawElementsIndirect:
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_buffers.get(a[2]));
+            glMultiDrawElementsIndirect(static_cast<GLenum>(a[0]),
+                                        static_cast<GLenum>(a[1]),
+                                        reinterpret_cast<void const*>(static_cast<std::uintptr_t>(a[3])),
+                                        static_cast<GLsizei>(a[4]),
+                                        static_cast<GLsizei>(a[5]));
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            break;
+        case Opcode::CopyImageSubData:
+            glCopyImageSubData(m_textures.get(a[0]),
+                               static_cast<GLenum>(a[1]),
+                               static_cast<GLint>(a[2]),
+                               static_cast<GLint>(a[3]),
+                               static_cast<GLint>(a[4]),
+                               static_cast<GLint>(a[5]),
+                               m_textures.get(a[6]),
+                               static_cast<GLenum>(a[7]),
+                               static_cast<GLint>(a[8]),
+                               static_cast<GLint>(a[9]),
+                               static_cast<GLint>(a[10]),
+                               static_cast<GLint>(a[11]),
+                               static_cast<GLsizei>(a[12]),
+                               static_cast<GLsizei>(a[13]),
+                               static_cast<GLsizei>(a[14]));
+            break;
+        case Opcode::TextureSubImage:
+            textureSubImage(cmd);
+            break;
+        case Opcode::Viewport:
+            glViewport(static_cast<GLint>(a[0]),
+                       static_cast<GLint>(a[1]),
+                       static_cast<GLsizei>(a[2]),
+                       static_cast<GLsizei>(a[3]));
+            break;
+        case Opcode::DrawArrays:
+            glDrawArrays(static_cast<GLenum>(a[0]), static_cast<GLint>(a[1]), static_cast<GLsizei>(a[2]));
+            break;
+        case Opcode::BindTextureUnit:
+            glBindTextureUnit(static_cast<GLuint>(a[0]), m_textures.get(a[1]));
+            break;
+        case Opcode::Enable:
+            glEnable(static_cast<GLenum>(a[0]));
+            break;
+        case Opcode::Disable:
+            glDisable(static_cast<GLenum>(a[0]));
+            break;
+        case Opcode::Scissor:
+            glScissor(static_cast<GLint>(a[0]),
+                      static_cast<GLint>(a[1]),
+                      static_cast<GLsizei>(a[2]),
+                      static_cast<GLsizei>(a[3]));
+            break;
+        case Opcode::DepthMask:
+            glDepthMask(static_cast<GLboolean>(a[0]));
+            break;
+        case Opcode::ClearBufferfv:
+        {
+            GLfloat values[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (size_t v = 2; v < a.size() && v < 6; ++v)
+            {
+                values[v - 2] = glowl::trace::bitsToFloat(a[v]);
+            }
+            glClearBufferfv(static_cast<GLenum>(a[0]), static_cast<GLint>(a[1]), values);
+            break;
+        }
+        case Opcode::ColorMask:
+            glColorMask(static_cast<GLboolean>(a[0]),
+                        static_cast<GLboolean>(a[1]),
+                        static_cast<GLboolean>(a[2]),
+                        static_cast<GLboolean>(a[3]));
+            break;
+        case Opcode::BlendFuncSeparate:
+            glBlendFuncSeparate(static_cast<GLenum>(a[0]),
+                                static_cast<GLenum>(a[1]),
+                                static_cast<GLenum>(a[2]),
+                                static_cast<GLenum>(a[3]));
+            break;
+        case Opcode::BlendEquationSeparate:
+            glBlendEquationSeparate(static_cast<GLenum>(a[0]), static_cast<GLenum>(a[1]));
+            break;
+        case Opcode::BlendColor:
+            glBlendColor(glowl::trace::bitsToFloat(a[0]),
+                         glowl::trace::bitsToFloat(a[1]),
+                         glowl::trace::bitsToFloat(a[2]),
+                         glowl::trace::bitsToFloat(a[3]));
+            break;
+        case Opcode::DepthFunc:
+            glDepthFunc(static_cast<GLenum>(a[0]));
+            break;
+        case Opcode::DepthRange:
+            glDepthRangef(glowl::trace::bitsToFloat(a[0]), glowl::trace::bitsToFloat(a[1]));
+            break;
+        case Opcode::StencilFuncSeparate:
+            glStencilFuncSeparate(static_cast<GLenum>(a[0]),
+                                  static_cast<GLenum>(a[1]),
+                                  static_cast<GLint>(a[2]),
+                                  static_cast<GLuint>(a[3]));
+            break;
+        case Opcode::StencilOpSeparate:
+            glStencilOpSeparate(static_cast<GLenum>(a[0]),
+                                static_cast<GLenum>(a[1]),
+                                static_cast<GLenum>(a[2]),
+                                static_cast<GLenum>(a[3]));
+            break;
+        case Opcode::StencilMaskSeparate:
+            glStencilMaskSeparate(static_cast<GLenum>(a[0]), static_cast<GLuint>(a[1]));
+            break;
+        case Opcode::CullFace:
+            glCullFace(static_cast<GLenum>(a[0]));
+            break;
+        case Opcode::FrontFace:
+            glFrontFace(static_cast<GLenum>(a[0]));
+            break;
+        case Opcode::PolygonMode:
+            glPolygonMode(static_cast<GLenum>(a[0]), static_cast<GLenum>(a[1]));
+            break;
+        case Opcode::PolygonOffset:
+            glPolygonOffset(glowl::trace::bitsToFloat(a[0]), glowl::trace::bitsToFloat(a[1]));
+            break;
+        default:
+            break;
+        }
+    }
+
+    void Replayer::createTexture(Command const& cmd)
+    {
+        auto const& a = cmd.args;
+
+        GLenum  target = static_cast<GLenum>(a[0]);
+        GLenum  internal_format = static_cast<GLenum>(a[2]);
+        GLsizei width = static_cast<GLsizei>(a[3]);
+        GLsizei height = static_cast<GLsizei>(a[4]);
+        GLsizei depth = static_cast<GLsizei>(a[5]);
+        GLsizei levels = static_cast<GLsizei>(a[6]);
+        GLenum  format = static_cast<GLenum>(a[7]);
+        GLenum  type = static_cast<GLenum>(a[8]);
+        bool    generate_mipmap = a[9] != 0;
+
+        GLuint name = 0;
+        glCreateTextures(target, 1, &name);
+        m_textures.set(a[1], name);
+
+        size_t idx = 10;
+        size_t int_param_cnt = static_cast<size_t>(a[idx++]);
+        for (size_t i = 0; i < int_param_cnt; ++i, idx += 2)
+        {
+            glTextureParameteri(name, static_cast<GLenum>(a[idx]), static_cast<GLint>(a[idx + 1]));
+        }
+        size_t float_param_cnt = static_cast<size_t>(a[idx++]);
+        for (size_t i = 0; i < float_param_cnt; ++i, idx += 2)
+        {
+            glTextureParameterf(name, static_cast<GLenum>(a[idx]), glowl::trace::bitsToFloat(a[idx + 1]));
+        }
+
+        if (target == GL_TEXTURE_2D)
+        {
+            glTextureStorage2D(name, levels, internal_format, width, height);
+            if (!cmd.payload.empty())
+            {
+                glTextureSubImage2D(name, 0, 0, 0, width, height, format, type, cmd.payload.data());
+            }
+        }
+        else
+        {
+            glTextureStorage3D(name, levels, internal_format, width, height, depth);
+            if (!cmd.payload.empty())
+            {
+                glTextureSubImage3D(name, 0, 0, 0, 0, width, height, depth, format, type, cmd.payload.data());
+            }
+        }
+
+        if (generate_mipmap)
+        {
+            glGenerateTextureMipmap(name);
+        }
+    }
+
+    void Replayer::textureSubImage(Command const& cmd)
+    {
+        auto const& a = cmd.args;
+
+        GLuint  name = m_textures.get(a[0]);
+        GLenum  target = static_cast<GLenum>(a[1]);
+        GLint   level = static_cast<GLint>(a[2]);
+        GLint   x = static_cast<GLint>(a[3]);
+        GLint   y = static_cast<GLint>(a[4]);
+        GLint   z = static_cast<GLint>(a[5]);
+        GLsizei width = static_cast<GLsizei>(a[6]);
+        GLsizei height = static_cast<GLsizei>(a[7]);
+        GLsizei depth = static_cast<GLsizei>(a[8]);
+        GLenum  format = static_cast<GLenum>(a[9]);
+        GLenum  type = static_cast<GLenum>(a[10]);
+        GLuint  unpack_buffer = m_buffers.get(a[14]);
+
+        // data is either an offset into the unpack buffer or the recorded client memory
+        void const* data = unpack_buffer != 0 ? reinterpret_cast<void const*>(static_cast<std::uintptr_t>(a[15]))
+                                              : payload(cmd);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, static_cast<GLint>(a[11]));
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(a[12]));
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, static_cast<GLint>(a[13]));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+
+        if (target == GL_TEXTURE_2D)
+        {
+            glTextureSubImage2D(name, level, x, y, width, height, format, type, data);
+        }
+        else
+        {
+            glTextureSubImage3D(name, level, x, y, z, width, height, depth, format, type, data);
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    }
+
+    void Replayer::resolveUniforms(std::int64_t program)
+    {
+        GLuint name = m_programs.get(program);
+        for (auto& uniform : m_uniforms)
+        {
+            if (uniform.program == program)
+            {
+                uniform.location = glGetUniformLocation(name, uniform.name.c_str());
+                uniform.resolved = true;
+            }
+        }
+    }
+
+    void Replayer::uniform(Command const& cmd, Uniform& uniform)
+    {
+        auto const& a = cmd.args;
+
+        // programs that were linked outside of the recording, e.g. wrapped existing programs
+        if (!uniform.resolved)
+        {
+            uniform.location = glGetUniformLocation(m_programs.get(a[0]), uniform.name.c_str());
+            uniform.resolved = true;
+        }
+        GLint location = uniform.location;
+
+        GLsizei cnt = static_cast<GLsizei>(a.size()) - 2;
+        GLfloat f[16];
+        GLint   i[4];
+        GLuint  u[4];
+        for (GLsizei v = 0; v < cnt && v < 16; ++v)
+        {
+            f[v] = glowl::trace::bitsToFloat(a[2 + v]);
+            if (v < 4)
+            {
+                i[v] = static_cast<GLint>(a[2 + v]);
+                u[v] = static_cast<GLuint>(a[2 + v]);
+            }
+        }
+
+        switch (a[1])
+        {
+        case glowl::trace::UniformFloat:
+            cnt == 1   ? glUniform1fv(location, 1, f)
+            : cnt == 2 ? glUniform2fv(location, 1, f)
+            : cnt == 3 ? glUniform3fv(location, 1, f)
+                       : glUniform4fv(location, 1, f);
+            break;
+        case glowl::trace::UniformInt:
+            cnt == 1   ? glUniform1iv(location, 1, i)
+            : cnt == 2 ? glUniform2iv(location, 1, i)
+            : cnt == 3 ? glUniform3iv(location, 1, i)
+                       : glUniform4iv(location, 1, i);
+            break;
+        case glowl::trace::UniformUInt:
+            cnt == 1   ? glUniform1uiv(location, 1, u)
+            : cnt == 2 ? glUniform2uiv(location, 1, u)
+            : cnt == 3 ? glUniform3uiv(location, 1, u)
+                       : glUniform4uiv(location, 1, u);
+            break;
+        case glowl::trace::UniformMatrix2:
+            glUniformMatrix2fv(location, 1, GL_FALSE, f);
+            break;
+        case glowl::trace::UniformMatrix3:
+            glUniformMatrix3fv(location, 1, GL_FALSE, f);
+            break;
+        case glowl::trace::UniformMatrix4:
+            glUniformMatrix4fv(location, 1, GL_FALSE, f);
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool createHeadlessContext()
+    {
+        EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        EGLint     major, minor;
+        if (!eglInitialize(display, &major, &minor))
+        {
+            // e.g. no X server or GPU available, fall back to Mesa's surfaceless platform (llvmpipe)
+            auto get_platform_display =
+                reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (get_platform_display == nullptr)
+            {
+                return false;
+            }
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (!eglInitialize(display, &major, &minor))
+            {
+                return false;
+            }
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API))
+        {
+            return false;
+        }
+
+        EGLint const context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                          4,
+                                          EGL_CONTEXT_MINOR_VERSION,
+                                          5,
+                                          EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                          EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                          EGL_NONE};
+
+        // surfaceless context, glowl renders into framebuffer objects anyway
+        EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attribs);
+        if (context == EGL_NO_CONTEXT)
+        {
+            return false;
+        }
+
+        return eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context) == EGL_TRUE;
+    }
+
+    double percentile(std::vector<double> sorted_values, double p)
+    {
+        if (sorted_values.empty())
+        {
+            return 0.0;
+        }
+        size_t idx = static_cast<size_t>(p * static_cast<double>(sorted_values.size() - 1) + 0.5);
+        return sorted_values[idx];
+    }
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <trace file> [--skip <frames>] [--no-finish] [--per-frame]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    size_t skip_frames = 0;
+    bool   finish = true;
+    bool   per_frame = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--skip") == 0 && i + 1 < argc)
+        {
+            skip_frames = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--no-finish") == 0)
+        {
+            finish = false;
+        }
+        else if (std::strcmp(argv[i], "--per-frame") == 0)
+        {
+            per_frame = true;
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown argument %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // decode the whole trace up front, so that file IO and decoding are not part of the timings
+    glowl::trace::TraceReader reader;
+    if (!reader.open(argv[1]))
+    {
+        std::fprintf(stderr, "Could not open trace %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Command> commands;
+    std::vector<size_t>  frame_ends;
+    size_t               hashed_payloads = 0;
+    Command              cmd;
+    while (reader.next(cmd))
+    {
+        if (cmd.payload_kind == glowl::trace::PayloadKind::Hash)
+        {
+            // only the hash was recorded, upload zeroes of the same size instead
+            cmd.payload.assign(static_cast<size_t>(cmd.payload_byte_size), 0);
+            ++hashed_payloads;
+        }
+        commands.push_back(cmd);
+        if (cmd.opcode == Opcode::Frame)
+        {
+            frame_ends.push_back(commands.size());
+        }
+    }
+    if (frame_ends.empty() || frame_ends.back() != commands.size())
+    {
+        frame_ends.push_back(commands.size());
+    }
+
+    if (!createHeadlessContext())
+    {
+        std::fprintf(stderr, "Could not create a headless OpenGL 4.5 context\n");
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Renderer: %s | %s\n",
+                reinterpret_cast<char const*>(glGetString(GL_RENDERER)),
+                reinterpret_cast<char const*>(glGetString(GL_VERSION)));
+    std::printf("Trace: %s, %zu commands, %zu frames, %zu payloads replayed as zeroes\n\n",
+                argv[1],
+                commands.size(),
+                frame_ends.size(),
+                hashed_payloads);
+
+    Replayer            replayer(commands);
+    std::vector<double> frame_times;
+    std::vector<size_t> histogram(static_cast<size_t>(Opcode::Count), 0);
+
+    size_t begin = 0;
+    for (size_t frame = 0; frame < frame_ends.size(); ++frame)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = begin; i < frame_ends[frame]; ++i)
+        {
+            replayer.execute(i);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        // wait for the GPU outside of the measured interval, so that frames do not overlap
+        if (finish)
+        {
+            glFinish();
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (per_frame)
+        {
+            std::printf("frame %6zu: %10.3f ms, %zu commands\n", frame, ms, frame_ends[frame] - begin);
+        }
+
+        if (frame >= skip_frames)
+        {
+            frame_times.push_back(ms);
+            for (size_t i = begin; i < frame_ends[frame]; ++i)
+            {
+                ++histogram[static_cast<size_t>(commands[i].opcode)];
+            }
+        }
+
+        begin = frame_ends[frame];
+    }
+
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR)
+    {
+        std::fprintf(stderr, "OpenGL error %u during replay\n", err);
+    }
+
+    std::vector<double> sorted_times = frame_times;
+    std::sort(sorted_times.begin(), sorted_times.end());
+    double total = 0.0;
+    for (double ms : sorted_times)
+    {
+        total += ms;
+    }
+
+    std::printf("CPU submission time per frame (%zu frames, first %zu skipped):\n", sorted_times.size(), skip_frames);
+    if (!sorted_times.empty())
+    {
+        std::printf("  min %.3f ms | median %.3f ms | mean %.3f ms | p95 %.3f ms | max %.3f ms\n\n",
+                    sorted_times.front(),
+                    percentile(sorted_times, 0.5),
+                    total / static_cast<double>(sorted_times.size()),
+                    percentile(sorted_times, 0.95),
+                    sorted_times.back());
+    }
+
+    std::vector<std::pair<size_t, Opcode>> calls;
+    for (size_t op = 1; op < histogram.size(); ++op)
+    {
+        if (histogram[op] > 0 && static_cast<Opcode>(op) != Opcode::Frame)
+        {
+            calls.emplace_back(histogram[op], static_cast<Opcode>(op));
+        }
+    }
+    std::sort(calls.begin(), calls.end(), [](std::pair<size_t, Opcode> const& lhs,
+                                                  std::pair<size_t, Opcode> const& rhs) {
+        return lhs.first > rhs.first;
+    });
+
+    double frame_cnt = std::max<double>(1.0, static_cast<double>(sorted_times.size()));
+    std::printf("GL calls:%*s%12s %12s\n", 24, "", "total", "per frame");
+    for (auto const& call : calls)
+    {
+        std::printf("  %-30s %12zu %12.1f\n",
+                    glowl::trace::getOpcodeName(call.second),
+                    call.first,
+                    static_cast<double>(call.first) / frame_cnt);
+    }
+
+    return err == GL_NO_ERROR ? EXIT_SUCCESS : EXIT_FAILURE;
+}